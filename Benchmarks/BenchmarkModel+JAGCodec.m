@@ -0,0 +1,311 @@
+//
+//  BenchmarkModel+JAGCodec.m
+//
+//  Generated by jagcodegen.py from BenchmarkModel.h, BenchmarkModel.m.
+//  Do not edit; regenerate it when the models change.
+//
+
+#import "JAGGeneratedCodec.h"
+#import "JAGPropertyConverter.h"
+#import "BenchmarkModel.h"
+
+#pragma mark - BenchmarkModel
+
+static const JAGGeneratedProperty JAGProperties_BenchmarkModel[] = {
+    { "testModelID", 0 },
+    { "intProperty", 0 },
+    { "doubleProperty", 0 },
+    { "stringProperty", 0 },
+    { "modelProperty", 0 },
+    { "arrayProperty", 0 },
+    { "setProperty", 0 },
+    { "dictionaryProperty", 0 },
+    { "dateProperty", 0 },
+    { "boolProperty", 0 },
+    { "urlProperty", 0 },
+    { "numberProperty", 0 },
+    { "active", 0 },
+};
+
+static void JAGEncode_BenchmarkModel(JAGPropertyConverter *converter, id object, NSMutableDictionary *values) {
+    BenchmarkModel *model = object;
+    JAGGeneratedEncodeValue(converter, values, @"testModelID", [model testModelID]);
+    JAGGeneratedEncodeValue(converter, values, @"intProperty", JAGGeneratedBox([model intProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"doubleProperty", JAGGeneratedBox([model doubleProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"stringProperty", [model stringProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"modelProperty", [model modelProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"arrayProperty", [model arrayProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"setProperty", [model setProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dictionaryProperty", [model dictionaryProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dateProperty", [model dateProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"boolProperty", JAGGeneratedBox([model boolProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"urlProperty", [model urlProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"numberProperty", [model numberProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"active", JAGGeneratedBox([model isActive]));
+}
+
+static void JAGDecode_BenchmarkModel(JAGPropertyConverter *converter, id object, NSDictionary *dictionary) {
+    BenchmarkModel *model = object;
+    id value;
+    if ((value = [dictionary objectForKey:@"testModelID"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setTestModelID:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"testModelID", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"intProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setIntProperty:JAGGeneratedUnbox([model intProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"intProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"doubleProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setDoubleProperty:JAGGeneratedUnbox([model doubleProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"doubleProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"stringProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setStringProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"stringProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"modelProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [BenchmarkModel class]);
+        if ([composed isKindOfClass:[BenchmarkModel class]]) {
+            [model setModelProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"modelProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"arrayProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSArray class]);
+        if ([composed isKindOfClass:[NSArray class]]) {
+            [model setArrayProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"arrayProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"setProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSSet class]);
+        if ([composed isKindOfClass:[NSSet class]]) {
+            [model setSetProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"setProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dictionaryProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDictionary class]);
+        if ([composed isKindOfClass:[NSDictionary class]]) {
+            [model setDictionaryProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dictionaryProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dateProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDate class]);
+        if ([composed isKindOfClass:[NSDate class]]) {
+            [model setDateProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dateProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"boolProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setBoolProperty:JAGGeneratedUnbox([model boolProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"boolProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"urlProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSURL class]);
+        if ([composed isKindOfClass:[NSURL class]]) {
+            [model setUrlProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"urlProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"numberProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSNumber class]);
+        if ([composed isKindOfClass:[NSNumber class]]) {
+            [model setNumberProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"numberProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"active"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model makeActive:JAGGeneratedUnbox([model isActive], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"active", value);
+        }
+    }
+}
+
+#pragma mark - BenchmarkModelSubclass
+
+static const JAGGeneratedProperty JAGProperties_BenchmarkModelSubclass[] = {
+    { "subclassStringProperty", 0 },
+    { "testModelID", 0 },
+    { "intProperty", 0 },
+    { "doubleProperty", 0 },
+    { "stringProperty", 0 },
+    { "modelProperty", 0 },
+    { "arrayProperty", 0 },
+    { "setProperty", 0 },
+    { "dictionaryProperty", 0 },
+    { "dateProperty", 0 },
+    { "boolProperty", 0 },
+    { "urlProperty", 0 },
+    { "numberProperty", 0 },
+    { "active", 0 },
+};
+
+static void JAGEncode_BenchmarkModelSubclass(JAGPropertyConverter *converter, id object, NSMutableDictionary *values) {
+    BenchmarkModelSubclass *model = object;
+    JAGGeneratedEncodeValue(converter, values, @"subclassStringProperty", [model subclassStringProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"testModelID", [model testModelID]);
+    JAGGeneratedEncodeValue(converter, values, @"intProperty", JAGGeneratedBox([model intProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"doubleProperty", JAGGeneratedBox([model doubleProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"stringProperty", [model stringProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"modelProperty", [model modelProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"arrayProperty", [model arrayProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"setProperty", [model setProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dictionaryProperty", [model dictionaryProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dateProperty", [model dateProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"boolProperty", JAGGeneratedBox([model boolProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"urlProperty", [model urlProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"numberProperty", [model numberProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"active", JAGGeneratedBox([model isActive]));
+}
+
+static void JAGDecode_BenchmarkModelSubclass(JAGPropertyConverter *converter, id object, NSDictionary *dictionary) {
+    BenchmarkModelSubclass *model = object;
+    id value;
+    if ((value = [dictionary objectForKey:@"subclassStringProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setSubclassStringProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"subclassStringProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"testModelID"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setTestModelID:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"testModelID", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"intProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setIntProperty:JAGGeneratedUnbox([model intProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"intProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"doubleProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setDoubleProperty:JAGGeneratedUnbox([model doubleProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"doubleProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"stringProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setStringProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"stringProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"modelProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [BenchmarkModel class]);
+        if ([composed isKindOfClass:[BenchmarkModel class]]) {
+            [model setModelProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"modelProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"arrayProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSArray class]);
+        if ([composed isKindOfClass:[NSArray class]]) {
+            [model setArrayProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"arrayProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"setProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSSet class]);
+        if ([composed isKindOfClass:[NSSet class]]) {
+            [model setSetProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"setProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dictionaryProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDictionary class]);
+        if ([composed isKindOfClass:[NSDictionary class]]) {
+            [model setDictionaryProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dictionaryProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dateProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDate class]);
+        if ([composed isKindOfClass:[NSDate class]]) {
+            [model setDateProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dateProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"boolProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setBoolProperty:JAGGeneratedUnbox([model boolProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"boolProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"urlProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSURL class]);
+        if ([composed isKindOfClass:[NSURL class]]) {
+            [model setUrlProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"urlProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"numberProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSNumber class]);
+        if ([composed isKindOfClass:[NSNumber class]]) {
+            [model setNumberProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"numberProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"active"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model makeActive:JAGGeneratedUnbox([model isActive], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"active", value);
+        }
+    }
+}
+
+#pragma mark - Registration
+
+static const JAGGeneratedCodec JAGCodecs[] = {
+    { "BenchmarkModel", JAGProperties_BenchmarkModel, 13, JAGEncode_BenchmarkModel, JAGDecode_BenchmarkModel },
+    { "BenchmarkModelSubclass", JAGProperties_BenchmarkModelSubclass, 14, JAGEncode_BenchmarkModelSubclass, JAGDecode_BenchmarkModelSubclass },
+};
+
+__attribute__((constructor)) static void JAGRegisterCodecs(void) {
+    JAGRegisterGeneratedCodecs(JAGCodecs, sizeof(JAGCodecs) / sizeof(JAGCodecs[0]));
+}
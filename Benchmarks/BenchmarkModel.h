@@ -0,0 +1,56 @@
+//
+//  BenchmarkModel.h
+//  JAGBenchmark
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A model shaped like TestModel, without the MapKit struct property,
+ * so that it builds on Linux.
+ */
+@interface BenchmarkModel : NSObject
+
+@property (copy)            NSString        *testModelID;
+@property (assign)          int             intProperty;
+@property (assign)          double          doubleProperty;
+@property (nonatomic, copy) NSString        *stringProperty;
+@property (strong)          BenchmarkModel  *modelProperty;
+@property (strong)          NSArray         *arrayProperty;
+@property (strong)          NSSet           *setProperty;
+@property (strong)          NSDictionary    *dictionaryProperty;
+@property (strong)          NSDate          *dateProperty;
+@property (assign)          BOOL            boolProperty;
+@property (strong)          NSURL           *urlProperty;
+@property (strong)          NSNumber        *numberProperty;
+@property (assign, getter = isActive, setter = makeActive:) BOOL active;
+
+///Populate the scalar and basic-type properties, with values derived from seed.
+- (void) populateWithSeed: (NSUInteger) seed;
+
+@end
+
+@interface BenchmarkModelSubclass : BenchmarkModel
+
+@property (copy)    NSString        *subclassStringProperty;
+
+@end
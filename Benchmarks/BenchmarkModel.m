@@ -0,0 +1,81 @@
+//
+//  BenchmarkModel.m
+//  JAGBenchmark
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "BenchmarkModel.h"
+
+@implementation BenchmarkModel
+
+@synthesize testModelID = _testModelID;
+@synthesize intProperty = _intProperty;
+@synthesize doubleProperty = _doubleProperty;
+@synthesize stringProperty = _stringProperty;
+@synthesize modelProperty = _modelProperty;
+@synthesize arrayProperty = _arrayProperty;
+@synthesize setProperty = _setProperty;
+@synthesize dictionaryProperty = _dictionaryProperty;
+@synthesize dateProperty = _dateProperty;
+@synthesize boolProperty = _boolProperty;
+@synthesize urlProperty = _urlProperty;
+@synthesize numberProperty = _numberProperty;
+@synthesize active = _active;
+
+- (void) populateWithSeed: (NSUInteger) seed {
+    self.testModelID = [NSString stringWithFormat:@"XYZZ%lu", (unsigned long)seed];
+    self.intProperty = (int)seed;
+    self.doubleProperty = seed * 0.25;
+    self.stringProperty = @"Hello Kitty!";
+    self.arrayProperty = [NSArray arrayWithObjects:@"red", @"green", @"blue", nil];
+    self.setProperty = [NSSet setWithObjects:@"alpha", @"beta", @"gamma", nil];
+    self.dictionaryProperty = [NSDictionary dictionaryWithObjectsAndKeys:
+                               [NSNumber numberWithInt:1], @"one",
+                               [NSNumber numberWithBool:NO], @"false",
+                               @"Harry", @"Potter",
+                               nil];
+    self.dateProperty = [NSDate dateWithTimeIntervalSince1970:1350000000 + seed];
+    self.boolProperty = (seed % 2) == 0;
+    self.urlProperty = [NSURL URLWithString:@"http://www.gooogle.com"];
+    self.numberProperty = [NSNumber numberWithUnsignedInteger:seed * 7];
+    [self makeActive:YES];
+}
+
+- (BOOL) isActive {
+    return _active;
+}
+
+- (void) makeActive: (BOOL) active {
+    _active = active;
+}
+
+@end
+
+@implementation BenchmarkModelSubclass
+
+@synthesize subclassStringProperty = _subclassStringProperty;
+
+- (void) populateWithSeed: (NSUInteger) seed {
+    [super populateWithSeed:seed];
+    self.subclassStringProperty = @"Subclass String!";
+}
+
+@end
@@ -0,0 +1,442 @@
+//
+//  JAGBenchmark.m
+//  JAGBenchmark
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+/*
+ * Times the converter's hot paths on synthetic model graphs, and prints one
+ * JSON object per measurement on stdout:
+ *
+ *   {"shape":"wide","size":100,"output":"json","op":"decomposeObject",
+ *    "iterations":812,"ops_per_sec":3240.1,"ns_per_property":257.3,
+ *    "allocations_per_op":4711,"peak_rss_kb":21344}
+ *
+ * Options:
+ *   --min-time SECONDS   Time each measurement for at least this long (default 0.25).
+ *   --sizes N,N,...      Graph sizes (default 10,100,1000).
+ *   --filter TEXT        Only run measurements whose "shape/op" contains TEXT.
+ *   --threads N          Most threads to share a frozen converter (default: the number of CPUs).
+ *
+ * allocations_per_op counts Objective-C objects, and is only available
+ * under GNUstep; elsewhere it is -1.
+ *
+ * The -frozen-threads-N ops convert the graph once on each of N threads,
+ * sharing one frozen converter, and count N graphs' properties per op; with
+ * linear scaling, ns_per_property halves each time N doubles.
+ */
+
+#import <Foundation/Foundation.h>
+#import "JAGPropertyConverter.h"
+#import "JAGPropertyFinder.h"
+#import "JAGModelPool.h"
+#import "JAGDateCodec.h"
+#import "BenchmarkModel.h"
+#ifdef GNUSTEP
+#import <Foundation/NSDebug.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <dispatch/dispatch.h>
+
+typedef void (^JAGBenchmarkOp)(void);
+
+static double gMinTime = 0.25;
+static const char *gFilter = NULL;
+static NSUInteger gMaxThreads = 0;
+
+static double JAGBenchmarkNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static long JAGBenchmarkPeakRSSKB(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+#ifdef GNUSTEP
+static long long JAGBenchmarkAllocationTotal(void) {
+    long long total = 0;
+    Class *classes = GSDebugAllocationClassList();
+    for (Class *c = classes; c && *c; c++) {
+        total += GSDebugAllocationTotal(*c);
+    }
+    return total;
+}
+#endif
+
+//The number of objects op allocates, or -1 if that can't be counted.
+static long long JAGBenchmarkAllocations(JAGBenchmarkOp op) {
+#ifdef GNUSTEP
+    GSDebugAllocationActive(YES);
+    long long before = JAGBenchmarkAllocationTotal();
+    @autoreleasepool {
+        op();
+    }
+    long long after = JAGBenchmarkAllocationTotal();
+    GSDebugAllocationActive(NO);
+    return after - before;
+#else
+    return -1;
+#endif
+}
+
+static void JAGBenchmarkRun(NSString *shape, NSUInteger size, NSString *output, NSString *opName,
+                            NSUInteger propertyCount, JAGBenchmarkOp op)
+{
+    NSString *name = [NSString stringWithFormat:@"%@/%@", shape, opName];
+    if (gFilter && !strstr([name UTF8String], gFilter)) return;
+
+    //Warm the caches, and count allocations outside the timed loop.
+    long long allocations = JAGBenchmarkAllocations(op);
+
+    NSUInteger iterations = 0;
+    double start = JAGBenchmarkNow();
+    double elapsed;
+    do {
+        @autoreleasepool {
+            op();
+        }
+        iterations++;
+        elapsed = JAGBenchmarkNow() - start;
+    } while (elapsed < gMinTime);
+
+    double secondsPerOp = elapsed / iterations;
+    printf("{\"shape\":\"%s\",\"size\":%lu,\"output\":\"%s\",\"op\":\"%s\","
+           "\"iterations\":%lu,\"ops_per_sec\":%.1f,\"ns_per_property\":%.1f,"
+           "\"allocations_per_op\":%lld,\"peak_rss_kb\":%ld}\n",
+           [shape UTF8String], (unsigned long)size, [output UTF8String], [opName UTF8String],
+           (unsigned long)iterations, 1.0 / secondsPerOp,
+           propertyCount ? secondsPerOp * 1e9 / propertyCount : 0.0,
+           allocations, JAGBenchmarkPeakRSSKB());
+    fflush(stdout);
+}
+
+#pragma mark - Graphs
+
+static BenchmarkModel *JAGBenchmarkModel(NSUInteger seed) {
+    BenchmarkModel *model = (seed % 2) ? [[BenchmarkModelSubclass alloc] init] : [[BenchmarkModel alloc] init];
+    [model populateWithSeed:seed];
+    return model;
+}
+
+//One model, with size strings in its collections.
+static BenchmarkModel *JAGBenchmarkFlatGraph(NSUInteger size) {
+    BenchmarkModel *root = JAGBenchmarkModel(0);
+    NSMutableArray *array = [NSMutableArray arrayWithCapacity:size];
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:size];
+    for (NSUInteger i = 0; i < size; i++) {
+        NSString *string = [NSString stringWithFormat:@"value %lu", (unsigned long)i];
+        [array addObject:string];
+        [dictionary setObject:[NSNumber numberWithUnsignedInteger:i] forKey:string];
+    }
+    root.arrayProperty = array;
+    root.setProperty = [NSSet setWithArray:array];
+    root.dictionaryProperty = dictionary;
+    return root;
+}
+
+//A chain of size models, linked by modelProperty.
+static BenchmarkModel *JAGBenchmarkDeepGraph(NSUInteger size) {
+    BenchmarkModel *root = JAGBenchmarkModel(0);
+    BenchmarkModel *tail = root;
+    for (NSUInteger i = 1; i < size; i++) {
+        tail.modelProperty = JAGBenchmarkModel(i);
+        tail = tail.modelProperty;
+    }
+    return root;
+}
+
+//A model with size models in its arrayProperty.
+static BenchmarkModel *JAGBenchmarkWideGraph(NSUInteger size) {
+    BenchmarkModel *root = JAGBenchmarkModel(0);
+    NSMutableArray *array = [NSMutableArray arrayWithCapacity:size];
+    for (NSUInteger i = 1; i <= size; i++) {
+        [array addObject:JAGBenchmarkModel(i)];
+    }
+    root.arrayProperty = array;
+    return root;
+}
+
+//A model with size models in its setProperty.
+static BenchmarkModel *JAGBenchmarkSetGraph(NSUInteger size) {
+    BenchmarkModel *root = JAGBenchmarkModel(0);
+    NSMutableSet *set = [NSMutableSet setWithCapacity:size];
+    for (NSUInteger i = 1; i <= size; i++) {
+        [set addObject:JAGBenchmarkModel(i)];
+    }
+    root.setProperty = set;
+    return root;
+}
+
+//The number of properties of all the models in a graph.
+static NSUInteger JAGBenchmarkPropertyCount(id object) {
+    if ([object isKindOfClass:[BenchmarkModel class]]) {
+        BenchmarkModel *model = object;
+        return [[JAGPropertyFinder propertiesForClass:[model class]] count]
+            + JAGBenchmarkPropertyCount(model.modelProperty)
+            + JAGBenchmarkPropertyCount(model.arrayProperty)
+            + JAGBenchmarkPropertyCount(model.setProperty);
+    } else if ([object isKindOfClass:[NSArray class]] || [object isKindOfClass:[NSSet class]]) {
+        NSUInteger count = 0;
+        for (id element in object) {
+            count += JAGBenchmarkPropertyCount(element);
+        }
+        return count;
+    }
+    return 0;
+}
+
+//A copy of a decomposed graph with its numbers written as strings, for numberFormatter.
+static id JAGBenchmarkStringifyNumbers(id object) {
+    if ([object isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[object count]];
+        for (id key in object) {
+            [dictionary setObject:JAGBenchmarkStringifyNumbers([object objectForKey:key]) forKey:key];
+        }
+        return dictionary;
+    } else if ([object isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [NSMutableArray arrayWithCapacity:[object count]];
+        for (id element in object) {
+            [array addObject:JAGBenchmarkStringifyNumbers(element)];
+        }
+        return array;
+    } else if ([object isKindOfClass:[NSNumber class]]) {
+        return [object stringValue];
+    }
+    return object;
+}
+
+#pragma mark - Converters
+
+static JAGPropertyConverter *JAGBenchmarkConverter(JAGOutputType outputType) {
+    JAGPropertyConverter *converter = [JAGPropertyConverter converterWithOutputType:outputType];
+    converter.classesToConvert = [NSSet setWithObject:[BenchmarkModel class]];
+    converter.identifyDict = ^ Class (NSDictionary *dictionary) {
+        if (![dictionary objectForKey:@"testModelID"]) return nil;
+        return [dictionary objectForKey:@"subclassStringProperty"]
+            ? [BenchmarkModelSubclass class]
+            : [BenchmarkModel class];
+    };
+    converter.convertFromDate = ^ id (id date) {
+        return [NSNumber numberWithDouble:[date timeIntervalSince1970]];
+    };
+    converter.convertToDate = ^ id (id value) {
+        return [value respondsToSelector:@selector(doubleValue)]
+            ? [NSDate dateWithTimeIntervalSince1970:[value doubleValue]]
+            : nil;
+    };
+    //The plain ops measure reflection; the -generated ones use BenchmarkModel+JAGCodec.m.
+    converter.shouldUseGeneratedCodecs = NO;
+    return converter;
+}
+
+static NSString *JAGBenchmarkOutputName(JAGOutputType outputType) {
+    switch (outputType) {
+        case kJAGFullOutput:            return @"full";
+        case kJAGPropertyListOutput:    return @"plist";
+        case kJAGMessagePackOutput:     return @"msgpack";
+        case kJAGJSONOutput:
+        default:                        return @"json";
+    }
+}
+
+static void JAGBenchmarkGraph(NSString *shape, NSUInteger size, BenchmarkModel *root) {
+    NSUInteger propertyCount = JAGBenchmarkPropertyCount(root);
+    JAGOutputType outputTypes[] = { kJAGFullOutput, kJAGPropertyListOutput, kJAGJSONOutput, kJAGMessagePackOutput };
+    for (size_t t = 0; t < sizeof(outputTypes) / sizeof(outputTypes[0]); t++) {
+        JAGPropertyConverter *converter = JAGBenchmarkConverter(outputTypes[t]);
+        NSString *output = JAGBenchmarkOutputName(outputTypes[t]);
+        NSDictionary *dictionary = [converter convertToDictionary:root];
+        Class rootClass = [root class];
+
+        JAGBenchmarkRun(shape, size, output, @"convertToDictionary", propertyCount, ^{
+            [converter convertToDictionary:root];
+        });
+        JAGBenchmarkRun(shape, size, output, @"decomposeObject", propertyCount, ^{
+            [converter decomposeObject:root];
+        });
+        JAGBenchmarkRun(shape, size, output, @"composeModelFromObject", propertyCount, ^{
+            [converter composeModelFromObject:dictionary];
+        });
+        JAGBenchmarkRun(shape, size, output, @"setPropertiesOf", propertyCount, ^{
+            [converter setPropertiesOf:[[rootClass alloc] init] fromDictionary:dictionary];
+        });
+        //Regenerate Benchmarks/BenchmarkModel+JAGCodec.m with Tools/jagcodegen.py when BenchmarkModel changes.
+        JAGPropertyConverter *generated = JAGBenchmarkConverter(outputTypes[t]);
+        generated.shouldUseGeneratedCodecs = YES;
+        JAGBenchmarkRun(shape, size, output, @"convertToDictionary-generated", propertyCount, ^{
+            [generated convertToDictionary:root];
+        });
+        JAGBenchmarkRun(shape, size, output, @"setPropertiesOf-generated", propertyCount, ^{
+            [generated setPropertiesOf:[[rootClass alloc] init] fromDictionary:dictionary];
+        });
+        //Compose and discard, drawing the models from a pool.
+        JAGPropertyConverter *pooled = JAGBenchmarkConverter(outputTypes[t]);
+        pooled.modelPool = [[JAGModelPool alloc] init];
+        JAGBenchmarkRun(shape, size, output, @"composeModelFromObject-pooled", propertyCount, ^{
+            [pooled recycleModel:[pooled composeModelFromObject:dictionary]];
+        });
+        if (outputTypes[t] == kJAGMessagePackOutput) {
+            NSData *messagePack = [converter messagePackDataFromObject:root];
+            JAGBenchmarkRun(shape, size, output, @"messagePackDataFromObject", propertyCount, ^{
+                [converter messagePackDataFromObject:root];
+            });
+            JAGBenchmarkRun(shape, size, output, @"composeModelFromMessagePackData", propertyCount, ^{
+                [converter composeModelFromMessagePackData:messagePack ofClass:rootClass error:NULL];
+            });
+        }
+
+        if (outputTypes[t] == kJAGJSONOutput) {
+            //ISO 8601 dates, through an NSDateFormatter in the Blocks and through a JAGDateCodec.
+            NSDateFormatter *formatter = [[NSDateFormatter alloc] init];
+            formatter.locale = [[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"];
+            formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+            formatter.dateFormat = @"yyyy-MM-dd'T'HH:mm:ss'Z'";
+            JAGPropertyConverter *blocks = JAGBenchmarkConverter(outputTypes[t]);
+            blocks.convertFromDate = ^ id (id date) { return [formatter stringFromDate:date]; };
+            blocks.convertToDate = ^ id (id value) {
+                return [value isKindOfClass:[NSString class]] ? [formatter dateFromString:value] : nil;
+            };
+            JAGPropertyConverter *codec = JAGBenchmarkConverter(outputTypes[t]);
+            codec.dateCodec = [JAGDateCodec codecWithFormat:kJAGDateFormatISO8601];
+            NSDictionary *isoDictionary = [codec convertToDictionary:root];
+
+            JAGBenchmarkRun(shape, size, output, @"convertToDictionary-iso8601-formatter", propertyCount, ^{
+                [blocks convertToDictionary:root];
+            });
+            JAGBenchmarkRun(shape, size, output, @"convertToDictionary-iso8601-dateCodec", propertyCount, ^{
+                [codec convertToDictionary:root];
+            });
+            JAGBenchmarkRun(shape, size, output, @"composeModelFromObject-iso8601-formatter", propertyCount, ^{
+                [blocks composeModelFromObject:isoDictionary];
+            });
+            JAGBenchmarkRun(shape, size, output, @"composeModelFromObject-iso8601-dateCodec", propertyCount, ^{
+                [codec composeModelFromObject:isoDictionary];
+            });
+        }
+
+        //The same, with every number arriving as a string.
+        NSString *numericShape = [shape stringByAppendingString:@"-numeric-strings"];
+        NSDictionary *stringified = JAGBenchmarkStringifyNumbers(dictionary);
+        converter.numberFormatter = [[NSNumberFormatter alloc] init];
+        JAGBenchmarkRun(numericShape, size, output, @"composeModelFromObject", propertyCount, ^{
+            [converter composeModelFromObject:stringified];
+        });
+        JAGBenchmarkRun(numericShape, size, output, @"setPropertiesOf", propertyCount, ^{
+            [converter setPropertiesOf:[[rootClass alloc] init] fromDictionary:stringified];
+        });
+
+        //The same, with the built-in parser instead of the formatter.
+        converter.shouldParseNumericStrings = YES;
+        JAGBenchmarkRun(numericShape, size, output, @"composeModelFromObject-parsed", propertyCount, ^{
+            [converter composeModelFromObject:stringified];
+        });
+        JAGBenchmarkRun(numericShape, size, output, @"setPropertiesOf-parsed", propertyCount, ^{
+            [converter setPropertiesOf:[[rootClass alloc] init] fromDictionary:stringified];
+        });
+    }
+}
+
+//Scaling from 1 to gMaxThreads threads, sharing a frozen converter.
+static void JAGBenchmarkThreads(NSString *shape, NSUInteger size, BenchmarkModel *root) {
+    NSUInteger propertyCount = JAGBenchmarkPropertyCount(root);
+    JAGPropertyConverter *frozen = [JAGBenchmarkConverter(kJAGPropertyListOutput) frozenCopy];
+    NSDictionary *dictionary = [frozen convertToDictionary:root];
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    //1, 2, 4, ... and gMaxThreads.
+    for (NSUInteger threads = 1; ; threads = MIN(threads * 2, gMaxThreads)) {
+        NSString *suffix = [NSString stringWithFormat:@"-frozen-threads-%lu", (unsigned long)threads];
+        JAGBenchmarkRun(shape, size, @"plist", [@"convertToDictionary" stringByAppendingString:suffix],
+                        propertyCount * threads, ^{
+            dispatch_apply(threads, queue, ^(size_t i) {
+                @autoreleasepool {
+                    [frozen convertToDictionary:root];
+                }
+            });
+        });
+        JAGBenchmarkRun(shape, size, @"plist", [@"composeModelFromObject" stringByAppendingString:suffix],
+                        propertyCount * threads, ^{
+            dispatch_apply(threads, queue, ^(size_t i) {
+                @autoreleasepool {
+                    [frozen composeModelFromObject:dictionary];
+                }
+            });
+        });
+        if (threads == gMaxThreads) break;
+    }
+}
+
+int main(int argc, const char *argv[]) {
+    @autoreleasepool {
+        NSMutableArray *sizes = [NSMutableArray array];
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+                gMinTime = atof(argv[++i]);
+            } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+                for (NSString *size in [[NSString stringWithUTF8String:argv[++i]] componentsSeparatedByString:@","]) {
+                    if ([size integerValue] > 0) {
+                        [sizes addObject:[NSNumber numberWithInteger:[size integerValue]]];
+                    }
+                }
+            } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+                gFilter = argv[++i];
+            } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                gMaxThreads = (NSUInteger)atoi(argv[++i]);
+            } else {
+                fprintf(stderr, "usage: %s [--min-time SECONDS] [--sizes N,N,...] [--filter TEXT] [--threads N]\n", argv[0]);
+                return 2;
+            }
+        }
+        if (!gMaxThreads) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            gMaxThreads = cpus > 0 ? (NSUInteger)cpus : 1;
+        }
+        if (![sizes count]) {
+            [sizes addObject:[NSNumber numberWithInt:10]];
+            [sizes addObject:[NSNumber numberWithInt:100]];
+            [sizes addObject:[NSNumber numberWithInt:1000]];
+        }
+
+        for (NSNumber *sizeNumber in sizes) {
+            NSUInteger size = [sizeNumber unsignedIntegerValue];
+            @autoreleasepool {
+                JAGBenchmarkGraph(@"flat", size, JAGBenchmarkFlatGraph(size));
+                JAGBenchmarkGraph(@"deep", size, JAGBenchmarkDeepGraph(size));
+                JAGBenchmarkGraph(@"wide", size, JAGBenchmarkWideGraph(size));
+                JAGBenchmarkGraph(@"set", size, JAGBenchmarkSetGraph(size));
+                JAGBenchmarkThreads(@"wide", size, JAGBenchmarkWideGraph(size));
+            }
+        }
+    }
+    return 0;
+}
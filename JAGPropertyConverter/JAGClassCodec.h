@@ -0,0 +1,178 @@
+//
+//  JAGClassCodec.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class JAGProperty;
+
+/**
+   JAGClassCodec reads and writes the properties of a model class by calling
+   the getter and setter implementations directly, instead of going through
+   Key-Value Coding.
+
+   A codec is built once per class, from the properties JAGPropertyFinder
+   returns for it.  The getter and setter selectors of each JAGProperty are
+   resolved to `IMP`s up front, and each one is called with the C signature
+   that matches the property's scalarKind.  Properties that the codec can't
+   call directly (structs, unions, pointers, or accessors that only exist
+   via message forwarding) fall back to `valueForKey:`/`setValue:forKey:`.
+
+   Properties are addressed by index, in the same order as
+   [JAGPropertyFinder propertiesForClass:].
+
+     JAGClassCodec *codec = [JAGClassCodec codecForClass:[MyClass class]];
+     NSUInteger countIndex = [codec indexOfPropertyNamed:@"count"];
+     [codec setLongLongValue:3 atIndex:countIndex ofModel:myObject];
+     NSNumber *count = [codec valueAtIndex:countIndex ofModel:myObject];
+
+   Codecs are cached and thread-safe.  Since a codec calls the accessors of
+   the exact class it was built for, look it up with `object_getClass()`
+   rather than `-class`, so that Key-Value Observing subclasses are respected.
+ */
+@interface JAGClassCodec : NSObject
+
+/**
+ * The shared codec for a class.
+ *
+ * @param aClass The model class.
+ * @return The codec for aClass, or nil if aClass is nil.
+ */
++ (JAGClassCodec *) codecForClass: (Class) aClass;
+
+/// The class this codec was built for.
+@property (nonatomic, readonly, unsafe_unretained) Class modelClass;
+
+/// The JAGProperty objects of modelClass, in index order.
+@property (nonatomic, readonly, strong) NSArray *properties;
+
+/// @return The number of properties.
+- (NSUInteger) count;
+
+/// @return The JAGProperty at index.
+- (JAGProperty *) propertyAtIndex: (NSUInteger) index;
+
+/**
+ * The index of the property with the given name.
+ *
+ * If a subclass redeclares a property, the subclass's declaration is found.
+ *
+ * @param name Name of the property.
+ * @return The index of the property, or NSNotFound.
+ */
+- (NSUInteger) indexOfPropertyNamed: (NSString *) name;
+
+/**
+ * The index of the property whose name is the given UTF-8 bytes.
+ *
+ * Names are looked up in a minimal perfect hash built with the codec, so
+ * a decoder can look up a key straight from its input without making an
+ * NSString, and a name that isn't a property is rejected after hashing it
+ * and one comparison.
+ *
+ * @param bytes The UTF-8 name, not necessarily NUL-terminated.
+ * @param length The length of the name in bytes.
+ * @return The index of the property, or NSNotFound.
+ */
+- (NSUInteger) indexOfPropertyNamedBytes: (const char *) bytes length: (NSUInteger) length;
+
+/**
+ * The property a decoder should set for a key, as setPropertiesOf:fromDictionary: finds it.
+ *
+ * Besides the codec's properties, this finds the writable properties
+ * declared on NSObject itself (by categories), which have no index.
+ * Both are in the same perfect hash, so an unknown key costs one lookup.
+ *
+ * @param bytes The UTF-8 name, not necessarily NUL-terminated.
+ * @param length The length of the name in bytes.
+ * @param index Set to the property's index, or NSNotFound.
+ * @return The property, or nil.
+ */
+- (JAGProperty *) propertyNamedBytes: (const char *) bytes length: (NSUInteger) length index: (NSUInteger *) index;
+
+/**
+ * The property a decoder should set for a key.
+ * @see propertyNamedBytes:length:index:
+ */
+- (JAGProperty *) propertyNamed: (NSString *) name index: (NSUInteger *) index;
+
+/**
+ * Whether the property's getter can be called on model.
+ *
+ * @param index Index of the property.
+ * @param model Instance of modelClass.
+ * @return YES if model responds to the property's getter.
+ */
+- (BOOL) canGetValueAtIndex: (NSUInteger) index ofModel: (id) model;
+
+/**
+ * The value of a property, boxed the same way as `valueForKey:` would.
+ *
+ * @param index Index of the property.
+ * @param model Instance of modelClass.
+ * @return The object value, or an NSNumber/NSValue for scalar properties.
+ */
+- (id) valueAtIndex: (NSUInteger) index ofModel: (id) model;
+
+/**
+ * Set the value of a property, unboxing it the same way as `setValue:forKey:` would.
+ *
+ * @param value The new value.  Numeric properties expect an NSNumber.
+ * @param index Index of the property.
+ * @param model Instance of modelClass.
+ */
+- (void) setValue: (id) value atIndex: (NSUInteger) index ofModel: (id) model;
+
+/**
+ * The value of a numeric property, without boxing it.
+ *
+ * Floating-point properties are truncated, and object properties are sent `longLongValue`.
+ */
+- (long long) longLongValueAtIndex: (NSUInteger) index ofModel: (id) model;
+
+/**
+ * The value of a numeric property, without boxing it.
+ *
+ * Object properties are sent `doubleValue`.
+ */
+- (double) doubleValueAtIndex: (NSUInteger) index ofModel: (id) model;
+
+/**
+ * Set a numeric property without boxing the value.
+ *
+ * The value is cast to the property's scalar type.  Object properties
+ * are set to an NSNumber.
+ */
+- (void) setLongLongValue: (long long) value atIndex: (NSUInteger) index ofModel: (id) model;
+
+/**
+ * Set a numeric property without boxing the value.
+ *
+ * The value is cast to the property's scalar type.  For an integer property
+ * it is first clamped to the range of long long (or unsigned long long), and
+ * NaN becomes 0; check the range beforehand to reject such values instead.
+ * Object properties are set to an NSNumber.
+ */
+- (void) setDoubleValue: (double) value atIndex: (NSUInteger) index ofModel: (id) model;
+
+@end
@@ -0,0 +1,609 @@
+//
+//  JAGClassCodec.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGClassCodec.h"
+#import "JAGProperty.h"
+#import "JAGPropertyFinder.h"
+#import "JAGClassTable.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    //Retained by the codec's properties array.
+    __unsafe_unretained JAGProperty *property;
+    JAGPropertyScalarKind kind;
+    BOOL respondsToGetter;
+    SEL getter;
+    //NULL if the getter must go through KVC.
+    IMP getterIMP;
+    SEL setter;
+    //NULL if the setter must go through KVC.
+    IMP setterIMP;
+} JAGCodecSlot;
+
+#define JAG_GET(type, slot, model) \
+    (((type (*)(id, SEL))(slot)->getterIMP)((model), (slot)->getter))
+#define JAG_SET(type, slot, model, value) \
+    (((void (*)(id, SEL, type))(slot)->setterIMP)((model), (slot)->setter, (value)))
+
+static BOOL JAGKindIsDirect(JAGPropertyScalarKind kind) {
+    return kind >= JAGPropertyScalarKindChar && kind <= JAGPropertyScalarKindBlock;
+}
+
+#pragma mark - Key Table
+
+/*
+ * Property names are found with a minimal perfect hash, built by "hash and
+ * displace": the names are hashed into count buckets, and each bucket gets
+ * a displacement that sends its names to free slots of a count-slot table.
+ * A bucket with several names is given a seed to rehash them with; a
+ * bucket with one name is given its slot directly, as -(slot + 1).
+ * Lookup hashes the name once (twice for a seeded bucket) and compares it
+ * with the one name in its slot.
+ */
+typedef struct {
+    const char *name;
+    NSUInteger length;
+    NSUInteger index;
+} JAGCodecKey;
+
+typedef struct {
+    NSUInteger bucket;
+    NSUInteger size;
+} JAGCodecBucket;
+
+//Seeds tried for a bucket before giving up, which real property sets never reach.
+#define JAGCodecMaxSeed (1u << 24)
+
+//FNV-1a, seeded, then mixed so that the low bits used for a slot depend on every bit of the seed.
+static inline uint32_t JAGCodecKeyHash(const char *bytes, NSUInteger length, uint32_t seed) {
+    uint32_t hash = seed ^ 2166136261u;
+    for (NSUInteger i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)bytes[i]) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+static int JAGCodecBucketCompare(const void *a, const void *b) {
+    NSUInteger sizeA = ((const JAGCodecBucket *)a)->size;
+    NSUInteger sizeB = ((const JAGCodecBucket *)b)->size;
+    return sizeA < sizeB ? 1 : (sizeA > sizeB ? -1 : 0);
+}
+
+/*
+ * Place count keys into keys, indexed by the perfect hash, and fill in
+ * displacements.  Returns NO if some bucket can't be placed, leaving the
+ * keys in their original order.
+ */
+static BOOL JAGCodecBuildKeyTable(JAGCodecKey *keys, int32_t *displacements, NSUInteger count) {
+    if (!count) return YES;
+    JAGCodecKey *input = malloc(count * sizeof(JAGCodecKey));
+    memcpy(input, keys, count * sizeof(JAGCodecKey));
+    NSUInteger *bucketOfKey = malloc(count * sizeof(NSUInteger));
+    JAGCodecBucket *buckets = calloc(count, sizeof(JAGCodecBucket));
+    for (NSUInteger b = 0; b < count; b++) {
+        buckets[b].bucket = b;
+    }
+    for (NSUInteger k = 0; k < count; k++) {
+        bucketOfKey[k] = JAGCodecKeyHash(input[k].name, input[k].length, 0) % count;
+        buckets[bucketOfKey[k]].size++;
+    }
+    //Place the largest buckets first, while the table is emptiest.
+    qsort(buckets, count, sizeof(JAGCodecBucket), JAGCodecBucketCompare);
+
+    BOOL *used = calloc(count, sizeof(BOOL));
+    NSUInteger *members = malloc(count * sizeof(NSUInteger));
+    NSUInteger *slots = malloc(count * sizeof(NSUInteger));
+    NSUInteger nextFree = 0;
+    BOOL succeeded = YES;
+    for (NSUInteger n = 0; n < count && buckets[n].size && succeeded; n++) {
+        NSUInteger bucket = buckets[n].bucket;
+        NSUInteger memberCount = 0;
+        for (NSUInteger k = 0; k < count; k++) {
+            if (bucketOfKey[k] == bucket) members[memberCount++] = k;
+        }
+        if (memberCount == 1) {
+            while (used[nextFree]) nextFree++;
+            slots[0] = nextFree;
+            displacements[bucket] = -(int32_t)nextFree - 1;
+        } else {
+            uint32_t seed;
+            for (seed = 1; seed < JAGCodecMaxSeed; seed++) {
+                NSUInteger m;
+                for (m = 0; m < memberCount; m++) {
+                    const JAGCodecKey *key = &input[members[m]];
+                    slots[m] = JAGCodecKeyHash(key->name, key->length, seed) % count;
+                    if (used[slots[m]]) break;
+                    NSUInteger other;
+                    for (other = 0; other < m && slots[other] != slots[m]; other++);
+                    if (other < m) break;
+                }
+                if (m == memberCount) break;
+            }
+            if (seed == JAGCodecMaxSeed) {
+                succeeded = NO;
+                break;
+            }
+            displacements[bucket] = (int32_t)seed;
+        }
+        for (NSUInteger m = 0; m < memberCount; m++) {
+            used[slots[m]] = YES;
+            keys[slots[m]] = input[members[m]];
+        }
+    }
+    if (!succeeded) {
+        memcpy(keys, input, count * sizeof(JAGCodecKey));
+    }
+    free(input);
+    free(bucketOfKey);
+    free(buckets);
+    free(used);
+    free(members);
+    free(slots);
+    return succeeded;
+}
+
+//Class to its codec, which the table holds a reference to.  Read without locking.
+static JAGClassTable gCodecTable = JAG_CLASS_TABLE_INITIALIZER;
+//Codecs replaced in gCodecTable, kept alive until no lookup can still be
+//retaining one.  Guarded by gCodecCacheLock.
+static NSMutableArray *gRetiredCodecs = nil;
+static volatile BOOL gHasRetiredCodecs = NO;
+static pthread_mutex_t gCodecCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+//Release the retired codecs and table storage, if no lookup is running.  Must hold gCodecCacheLock.
+static void JAGReclaimRetiredCodecs(void) {
+    if (JAGClassTableReclaimIfQuiescent(&gCodecTable)) {
+        [gRetiredCodecs removeAllObjects];
+        gHasRetiredCodecs = NO;
+    }
+}
+
+@implementation JAGClassCodec
+{
+@private
+    JAGCodecSlot    *_slots;
+    NSUInteger      _count;
+    //The perfect hash of the property names; see JAGCodecBuildKeyTable.
+    JAGCodecKey     *_keys;
+    int32_t         *_displacements;
+    NSUInteger      _keyCount;
+    //The UTF-8 names the keys point into.
+    char            *_keyBytes;
+    //If the hash couldn't be built, the keys are searched in order.
+    BOOL            _keysAreLinear;
+    //Writable properties of NSObject itself.  Key index _count + i is _rootProperties[i].
+    NSArray         *_rootProperties;
+}
+
+@synthesize modelClass = _modelClass;
+@synthesize properties = _properties;
+
++ (void) initialize {
+    if (self == [JAGClassCodec class]) {
+        gRetiredCodecs = [[NSMutableArray alloc] init];
+    }
+}
+
++ (JAGClassCodec *) codecForClass: (Class) aClass {
+    if (!aClass) return nil;
+    //If JAGPropertyFinder has rebuilt its metadata, so must we.
+    NSArray *properties = [JAGPropertyFinder propertiesForClass:aClass];
+
+    uintptr_t found;
+    //The codec is retained before the read ends, so it can't be released under us.
+    JAGClassTableBeginRead(&gCodecTable);
+    JAGClassCodec *codec = JAGClassTableLookup(&gCodecTable, aClass, &found)
+        ? (__bridge JAGClassCodec *)(void *)found
+        : nil;
+    if (JAGClassTableEndRead(&gCodecTable) && gHasRetiredCodecs && pthread_mutex_trylock(&gCodecCacheLock) == 0) {
+        JAGReclaimRetiredCodecs();
+        pthread_mutex_unlock(&gCodecCacheLock);
+    }
+    if (codec && codec->_properties == properties) return codec;
+
+    codec = [[JAGClassCodec alloc] initWithClass:aClass properties:properties];
+
+    pthread_mutex_lock(&gCodecCacheLock);
+    JAGClassCodec *existing = JAGClassTableLookup(&gCodecTable, aClass, &found)
+        ? (__bridge JAGClassCodec *)(void *)found
+        : nil;
+    if (existing && existing->_properties == properties) {
+        codec = existing;
+    } else {
+        JAGClassTableInsert(&gCodecTable, aClass, (uintptr_t)CFBridgingRetain(codec));
+        if (existing) {
+            //Other threads may still be retaining the codec it replaced.
+            [gRetiredCodecs addObject:CFBridgingRelease((__bridge CFTypeRef)existing)];
+        }
+        //Growing the table may have retired its storage, too.
+        gHasRetiredCodecs = YES;
+        JAGReclaimRetiredCodecs();
+    }
+    pthread_mutex_unlock(&gCodecCacheLock);
+    return codec;
+}
+
+- (id) initWithClass: (Class) aClass properties: (NSArray *) properties {
+    self = [super init];
+    if (self) {
+        _modelClass = aClass;
+        _properties = properties;
+        _count = [properties count];
+        _slots = calloc(_count ? _count : 1, sizeof(JAGCodecSlot));
+        for (NSUInteger i = 0; i < _count; i++) {
+            JAGProperty *property = [properties objectAtIndex:i];
+            JAGCodecSlot *slot = &_slots[i];
+            slot->property = property;
+            slot->kind = [property scalarKind];
+            slot->getter = [property getter];
+            slot->setter = [property setter];
+            slot->respondsToGetter = slot->getter && class_respondsToSelector(aClass, slot->getter);
+            if (JAGKindIsDirect(slot->kind)) {
+                Method getterMethod = slot->getter ? class_getInstanceMethod(aClass, slot->getter) : NULL;
+                Method setterMethod = slot->setter ? class_getInstanceMethod(aClass, slot->setter) : NULL;
+                slot->getterIMP = getterMethod ? method_getImplementation(getterMethod) : NULL;
+                slot->setterIMP = setterMethod ? method_getImplementation(setterMethod) : NULL;
+            }
+        }
+        [self buildKeyTable];
+    }
+    return self;
+}
+
+/*
+ * Hash the names of the codec's properties, and of NSObject's writable
+ * properties, which setPropertiesOf:fromDictionary: can also set.
+ */
+- (void) buildKeyTable {
+    NSMutableArray *names = [NSMutableArray arrayWithCapacity:_count];
+    NSMutableArray *indexes = [NSMutableArray arrayWithCapacity:_count];
+    NSMutableSet *seen = [NSMutableSet setWithCapacity:_count];
+    for (NSUInteger i = 0; i < _count; i++) {
+        NSString *name = [_slots[i].property name];
+        //Properties come subclass-first, so the most-derived declaration wins.
+        if ([seen containsObject:name]) continue;
+        [seen addObject:name];
+        [names addObject:name];
+        [indexes addObject:[NSNumber numberWithUnsignedInteger:i]];
+    }
+    NSMutableArray *rootProperties = [NSMutableArray array];
+    for (JAGProperty *property in [JAGPropertyFinder propertiesForSubclass:[NSObject class]]) {
+        if ([property isReadOnly] || [seen containsObject:[property name]]) continue;
+        [seen addObject:[property name]];
+        [names addObject:[property name]];
+        [indexes addObject:[NSNumber numberWithUnsignedInteger:_count + [rootProperties count]]];
+        [rootProperties addObject:property];
+    }
+    _rootProperties = [rootProperties copy];
+
+    _keyCount = [names count];
+    NSUInteger nameBytes = 0;
+    for (NSString *name in names) {
+        nameBytes += strlen([name UTF8String]);
+    }
+    _keys = calloc(_keyCount ? _keyCount : 1, sizeof(JAGCodecKey));
+    _displacements = calloc(_keyCount ? _keyCount : 1, sizeof(int32_t));
+    _keyBytes = malloc(nameBytes ? nameBytes : 1);
+    char *cursor = _keyBytes;
+    for (NSUInteger k = 0; k < _keyCount; k++) {
+        const char *utf8 = [[names objectAtIndex:k] UTF8String];
+        NSUInteger length = strlen(utf8);
+        memcpy(cursor, utf8, length);
+        _keys[k].name = cursor;
+        _keys[k].length = length;
+        _keys[k].index = [[indexes objectAtIndex:k] unsignedIntegerValue];
+        cursor += length;
+    }
+    _keysAreLinear = !JAGCodecBuildKeyTable(_keys, _displacements, _keyCount);
+}
+
+- (void) dealloc {
+    free(_slots);
+    free(_keys);
+    free(_displacements);
+    free(_keyBytes);
+}
+
+- (NSString *) description {
+    return [NSString stringWithFormat:@"<%@ %p: %@ (%lu properties)>",
+            [self class], self, _modelClass, (unsigned long)_count];
+}
+
+- (NSUInteger) count {
+    return _count;
+}
+
+- (JAGProperty *) propertyAtIndex: (NSUInteger) index {
+    return _slots[index].property;
+}
+
+//The key index of a name: a property index, _count + a root property index, or NSNotFound.
+static NSUInteger JAGCodecKeyIndex(JAGClassCodec *codec, const char *bytes, NSUInteger length) {
+    NSUInteger keyCount = codec->_keyCount;
+    if (!keyCount || !bytes) return NSNotFound;
+    const JAGCodecKey *keys = codec->_keys;
+    if (codec->_keysAreLinear) {
+        for (NSUInteger k = 0; k < keyCount; k++) {
+            if (keys[k].length == length && memcmp(keys[k].name, bytes, length) == 0) return keys[k].index;
+        }
+        return NSNotFound;
+    }
+    int32_t displacement = codec->_displacements[JAGCodecKeyHash(bytes, length, 0) % keyCount];
+    NSUInteger slot = displacement < 0
+        ? (NSUInteger)(-displacement - 1)
+        : JAGCodecKeyHash(bytes, length, (uint32_t)displacement) % keyCount;
+    const JAGCodecKey *key = &keys[slot];
+    if (key->length != length || memcmp(key->name, bytes, length) != 0) return NSNotFound;
+    return key->index;
+}
+
+//The key index of an NSString name, without copying it when it can be avoided.
+static NSUInteger JAGCodecKeyIndexOfString(JAGClassCodec *codec, NSString *name) {
+    if (!name) return NSNotFound;
+    const char *bytes = CFStringGetCStringPtr((__bridge CFStringRef)name, kCFStringEncodingUTF8);
+    if (bytes) {
+        return JAGCodecKeyIndex(codec, bytes, strlen(bytes));
+    }
+    //Property names are short, so this rarely needs more than the stack.
+    char buffer[128];
+    CFIndex length = (CFIndex)[name length];
+    CFIndex used = 0;
+    CFIndex converted = CFStringGetBytes((__bridge CFStringRef)name, CFRangeMake(0, length), kCFStringEncodingUTF8,
+                                         0, false, (UInt8 *)buffer, sizeof(buffer), &used);
+    if (converted == length) {
+        return JAGCodecKeyIndex(codec, buffer, (NSUInteger)used);
+    }
+    bytes = [name UTF8String];
+    return bytes ? JAGCodecKeyIndex(codec, bytes, strlen(bytes)) : NSNotFound;
+}
+
+- (NSUInteger) indexOfPropertyNamed: (NSString *) name {
+    NSUInteger index = JAGCodecKeyIndexOfString(self, name);
+    return index < _count ? index : NSNotFound;
+}
+
+- (NSUInteger) indexOfPropertyNamedBytes: (const char *) bytes length: (NSUInteger) length {
+    NSUInteger index = JAGCodecKeyIndex(self, bytes, length);
+    return index < _count ? index : NSNotFound;
+}
+
+//The property for a key index, setting *index to its property index.
+static JAGProperty *JAGCodecPropertyForKeyIndex(JAGClassCodec *codec, NSUInteger keyIndex, NSUInteger *index) {
+    if (keyIndex < codec->_count) {
+        *index = keyIndex;
+        return codec->_slots[keyIndex].property;
+    }
+    *index = NSNotFound;
+    return keyIndex == NSNotFound ? nil : [codec->_rootProperties objectAtIndex:keyIndex - codec->_count];
+}
+
+- (JAGProperty *) propertyNamedBytes: (const char *) bytes length: (NSUInteger) length index: (NSUInteger *) index {
+    return JAGCodecPropertyForKeyIndex(self, JAGCodecKeyIndex(self, bytes, length), index);
+}
+
+- (JAGProperty *) propertyNamed: (NSString *) name index: (NSUInteger *) index {
+    return JAGCodecPropertyForKeyIndex(self, JAGCodecKeyIndexOfString(self, name), index);
+}
+
+- (BOOL) canGetValueAtIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    return slot->respondsToGetter || (slot->getter && [model respondsToSelector:slot->getter]);
+}
+
+#pragma mark - Boxed access
+
+- (id) valueAtIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    if (!slot->getterIMP) {
+        return [model valueForKey:[slot->property name]];
+    }
+    switch (slot->kind) {
+        case JAGPropertyScalarKindObject:
+        case JAGPropertyScalarKindBlock:
+            return JAG_GET(id, slot, model);
+        case JAGPropertyScalarKindChar:
+            return [[NSNumber alloc] initWithChar:JAG_GET(char, slot, model)];
+        case JAGPropertyScalarKindInt:
+            return [[NSNumber alloc] initWithInt:JAG_GET(int, slot, model)];
+        case JAGPropertyScalarKindShort:
+            return [[NSNumber alloc] initWithShort:JAG_GET(short, slot, model)];
+        case JAGPropertyScalarKindLong:
+            return [[NSNumber alloc] initWithLong:JAG_GET(long, slot, model)];
+        case JAGPropertyScalarKindLongLong:
+            return [[NSNumber alloc] initWithLongLong:JAG_GET(long long, slot, model)];
+        case JAGPropertyScalarKindUnsignedChar:
+            return [[NSNumber alloc] initWithUnsignedChar:JAG_GET(unsigned char, slot, model)];
+        case JAGPropertyScalarKindUnsignedInt:
+            return [[NSNumber alloc] initWithUnsignedInt:JAG_GET(unsigned int, slot, model)];
+        case JAGPropertyScalarKindUnsignedShort:
+            return [[NSNumber alloc] initWithUnsignedShort:JAG_GET(unsigned short, slot, model)];
+        case JAGPropertyScalarKindUnsignedLong:
+            return [[NSNumber alloc] initWithUnsignedLong:JAG_GET(unsigned long, slot, model)];
+        case JAGPropertyScalarKindUnsignedLongLong:
+            return [[NSNumber alloc] initWithUnsignedLongLong:JAG_GET(unsigned long long, slot, model)];
+        case JAGPropertyScalarKindFloat:
+            return [[NSNumber alloc] initWithFloat:JAG_GET(float, slot, model)];
+        case JAGPropertyScalarKindDouble:
+            return [[NSNumber alloc] initWithDouble:JAG_GET(double, slot, model)];
+        case JAGPropertyScalarKindBool:
+            return [[NSNumber alloc] initWithBool:JAG_GET(_Bool, slot, model)];
+        default:
+            return [model valueForKey:[slot->property name]];
+    }
+}
+
+- (void) setValue: (id) value atIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    BOOL isObjectKind = (slot->kind == JAGPropertyScalarKindObject || slot->kind == JAGPropertyScalarKindBlock);
+    //A nil scalar goes through KVC, so that setNilValueForKey: is honored.
+    if (!slot->setterIMP || (!value && !isObjectKind)) {
+        [model setValue:value forKey:[slot->property name]];
+        return;
+    }
+    switch (slot->kind) {
+        case JAGPropertyScalarKindObject:
+        case JAGPropertyScalarKindBlock:
+            JAG_SET(id, slot, model, value); break;
+        case JAGPropertyScalarKindChar:
+            JAG_SET(char, slot, model, [value charValue]); break;
+        case JAGPropertyScalarKindInt:
+            JAG_SET(int, slot, model, [value intValue]); break;
+        case JAGPropertyScalarKindShort:
+            JAG_SET(short, slot, model, [value shortValue]); break;
+        case JAGPropertyScalarKindLong:
+            JAG_SET(long, slot, model, [value longValue]); break;
+        case JAGPropertyScalarKindLongLong:
+            JAG_SET(long long, slot, model, [value longLongValue]); break;
+        case JAGPropertyScalarKindUnsignedChar:
+            JAG_SET(unsigned char, slot, model, [value unsignedCharValue]); break;
+        case JAGPropertyScalarKindUnsignedInt:
+            JAG_SET(unsigned int, slot, model, [value unsignedIntValue]); break;
+        case JAGPropertyScalarKindUnsignedShort:
+            JAG_SET(unsigned short, slot, model, [value unsignedShortValue]); break;
+        case JAGPropertyScalarKindUnsignedLong:
+            JAG_SET(unsigned long, slot, model, [value unsignedLongValue]); break;
+        case JAGPropertyScalarKindUnsignedLongLong:
+            JAG_SET(unsigned long long, slot, model, [value unsignedLongLongValue]); break;
+        case JAGPropertyScalarKindFloat:
+            JAG_SET(float, slot, model, [value floatValue]); break;
+        case JAGPropertyScalarKindDouble:
+            JAG_SET(double, slot, model, [value doubleValue]); break;
+        case JAGPropertyScalarKindBool:
+            JAG_SET(_Bool, slot, model, [value boolValue]); break;
+        default:
+            [model setValue:value forKey:[slot->property name]]; break;
+    }
+}
+
+#pragma mark - Unboxed access
+
+- (long long) longLongValueAtIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    if (!slot->getterIMP) {
+        return [[model valueForKey:[slot->property name]] longLongValue];
+    }
+    switch (slot->kind) {
+        case JAGPropertyScalarKindChar:             return JAG_GET(char, slot, model);
+        case JAGPropertyScalarKindInt:              return JAG_GET(int, slot, model);
+        case JAGPropertyScalarKindShort:            return JAG_GET(short, slot, model);
+        case JAGPropertyScalarKindLong:             return JAG_GET(long, slot, model);
+        case JAGPropertyScalarKindLongLong:         return JAG_GET(long long, slot, model);
+        case JAGPropertyScalarKindUnsignedChar:     return JAG_GET(unsigned char, slot, model);
+        case JAGPropertyScalarKindUnsignedInt:      return JAG_GET(unsigned int, slot, model);
+        case JAGPropertyScalarKindUnsignedShort:    return JAG_GET(unsigned short, slot, model);
+        case JAGPropertyScalarKindUnsignedLong:     return (long long)JAG_GET(unsigned long, slot, model);
+        case JAGPropertyScalarKindUnsignedLongLong: return (long long)JAG_GET(unsigned long long, slot, model);
+        case JAGPropertyScalarKindFloat:            return (long long)JAG_GET(float, slot, model);
+        case JAGPropertyScalarKindDouble:           return (long long)JAG_GET(double, slot, model);
+        case JAGPropertyScalarKindBool:             return JAG_GET(_Bool, slot, model);
+        default:
+            return [[self valueAtIndex:index ofModel:model] longLongValue];
+    }
+}
+
+- (double) doubleValueAtIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    if (!slot->getterIMP) {
+        return [[model valueForKey:[slot->property name]] doubleValue];
+    }
+    switch (slot->kind) {
+        case JAGPropertyScalarKindFloat:            return JAG_GET(float, slot, model);
+        case JAGPropertyScalarKindDouble:           return JAG_GET(double, slot, model);
+        case JAGPropertyScalarKindUnsignedLongLong: return (double)JAG_GET(unsigned long long, slot, model);
+        case JAGPropertyScalarKindObject:
+        case JAGPropertyScalarKindBlock:
+        case JAGPropertyScalarKindUnknown:
+        case JAGPropertyScalarKindOther:
+            return [[self valueAtIndex:index ofModel:model] doubleValue];
+        default:
+            return (double)[self longLongValueAtIndex:index ofModel:model];
+    }
+}
+
+- (void) setLongLongValue: (long long) value atIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    if (!slot->setterIMP) {
+        [model setValue:[NSNumber numberWithLongLong:value] forKey:[slot->property name]];
+        return;
+    }
+    switch (slot->kind) {
+        case JAGPropertyScalarKindChar:             JAG_SET(char, slot, model, (char)value); break;
+        case JAGPropertyScalarKindInt:              JAG_SET(int, slot, model, (int)value); break;
+        case JAGPropertyScalarKindShort:            JAG_SET(short, slot, model, (short)value); break;
+        case JAGPropertyScalarKindLong:             JAG_SET(long, slot, model, (long)value); break;
+        case JAGPropertyScalarKindLongLong:         JAG_SET(long long, slot, model, value); break;
+        case JAGPropertyScalarKindUnsignedChar:     JAG_SET(unsigned char, slot, model, (unsigned char)value); break;
+        case JAGPropertyScalarKindUnsignedInt:      JAG_SET(unsigned int, slot, model, (unsigned int)value); break;
+        case JAGPropertyScalarKindUnsignedShort:    JAG_SET(unsigned short, slot, model, (unsigned short)value); break;
+        case JAGPropertyScalarKindUnsignedLong:     JAG_SET(unsigned long, slot, model, (unsigned long)value); break;
+        case JAGPropertyScalarKindUnsignedLongLong: JAG_SET(unsigned long long, slot, model, (unsigned long long)value); break;
+        case JAGPropertyScalarKindFloat:            JAG_SET(float, slot, model, (float)value); break;
+        case JAGPropertyScalarKindDouble:           JAG_SET(double, slot, model, (double)value); break;
+        case JAGPropertyScalarKindBool:             JAG_SET(_Bool, slot, model, value != 0); break;
+        default:
+            [self setValue:[NSNumber numberWithLongLong:value] atIndex:index ofModel:model]; break;
+    }
+}
+
+//Casting a double that is out of range to an integer is undefined, so clamp it first.
+static inline long long JAGClampToLongLong(double value) {
+    if (value != value) return 0;
+    if (value >= (double)LLONG_MAX) return LLONG_MAX;
+    if (value <= (double)LLONG_MIN) return LLONG_MIN;
+    return (long long)value;
+}
+
+static inline unsigned long long JAGClampToUnsignedLongLong(double value) {
+    if (value != value || value <= 0) return 0;
+    if (value >= (double)ULLONG_MAX) return ULLONG_MAX;
+    return (unsigned long long)value;
+}
+
+- (void) setDoubleValue: (double) value atIndex: (NSUInteger) index ofModel: (id) model {
+    JAGCodecSlot *slot = &_slots[index];
+    if (!slot->setterIMP) {
+        [model setValue:[NSNumber numberWithDouble:value] forKey:[slot->property name]];
+        return;
+    }
+    switch (slot->kind) {
+        case JAGPropertyScalarKindFloat:            JAG_SET(float, slot, model, (float)value); break;
+        case JAGPropertyScalarKindDouble:           JAG_SET(double, slot, model, value); break;
+        case JAGPropertyScalarKindUnsignedLongLong: JAG_SET(unsigned long long, slot, model, JAGClampToUnsignedLongLong(value)); break;
+        case JAGPropertyScalarKindBool:             JAG_SET(_Bool, slot, model, value != 0); break;
+        case JAGPropertyScalarKindObject:
+        case JAGPropertyScalarKindBlock:
+            [self setValue:[NSNumber numberWithDouble:value] atIndex:index ofModel:model]; break;
+        default:
+            [self setLongLongValue:JAGClampToLongLong(value) atIndex:index ofModel:model]; break;
+    }
+}
+
+@end
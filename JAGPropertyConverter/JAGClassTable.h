@@ -0,0 +1,139 @@
+//
+//  JAGClassTable.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#include <pthread.h>
+
+/*
+   A hash table from Class to a pointer-sized value, for the per-class
+   caches that every conversion consults: the converter's dispatch
+   information, JAGPropertyFinder's metadata, JAGClassCodec and the
+   generated codecs.
+
+   Lookups take no lock, so threads sharing a converter don't contend on a
+   lock word for every object they convert.  Inserts are serialized by the
+   table's mutex, and write an entry's value before publishing its key, so
+   a concurrent lookup either misses the entry or sees it whole.  When the
+   table grows, the larger copy is filled and then published atomically;
+   the old copy may still be being read, so it is retired rather than freed.
+
+   Entries are never removed one at a time.  JAGClassTableRemoveAll retires
+   the whole table, and JAGClassTableReclaim frees retired storage when the
+   owner knows no lookup can be running.
+
+   A table shared by threads that don't coordinate with its owner, such as
+   a global cache, brackets each lookup, and whatever it does to keep the
+   value it found alive, with JAGClassTableBeginRead and
+   JAGClassTableEndRead.  JAGClassTableReclaimIfQuiescent then frees
+   retired storage once none of those is running, and tells the owner that
+   values it replaced or removed before the call can be freed too.
+ */
+
+typedef struct {
+    const void *key;
+    uintptr_t value;
+} JAGClassTableEntry;
+
+typedef struct JAGClassTableStorage {
+    //A power of two; the table is at most half full, so probing always ends.
+    NSUInteger capacity;
+    NSUInteger count;
+    struct JAGClassTableStorage *nextRetired;
+    JAGClassTableEntry entries[];
+} JAGClassTableStorage;
+
+typedef struct {
+    JAGClassTableStorage *storage;
+    //Storage replaced by growth or JAGClassTableRemoveAll.
+    JAGClassTableStorage *retired;
+    pthread_mutex_t lock;
+    //Lookups between JAGClassTableBeginRead and JAGClassTableEndRead.
+    volatile int32_t readers;
+} JAGClassTable;
+
+///Initializes a static JAGClassTable, instead of JAGClassTableInit.
+#define JAG_CLASS_TABLE_INITIALIZER { NULL, NULL, PTHREAD_MUTEX_INITIALIZER, 0 }
+
+extern void JAGClassTableInit(JAGClassTable *table);
+
+///Free all of table's storage.  No lookup may be running.
+extern void JAGClassTableDestroy(JAGClassTable *table);
+
+///Set the value for cls, replacing any value it has.
+extern void JAGClassTableInsert(JAGClassTable *table, Class cls, uintptr_t value);
+
+///Remove every entry.  Lookups already running still see the old entries.
+extern void JAGClassTableRemoveAll(JAGClassTable *table);
+
+///Free retired storage.  No lookup may be running.
+extern void JAGClassTableReclaim(JAGClassTable *table);
+
+/**
+ * Free retired storage if no reader is between JAGClassTableBeginRead and
+ * JAGClassTableEndRead.
+ *
+ * @return YES if it did, in which case no reader can still hold a value
+ * that was replaced or removed before this call.
+ */
+extern BOOL JAGClassTableReclaimIfQuiescent(JAGClassTable *table);
+
+///Start a lookup that JAGClassTableReclaimIfQuiescent waits out.
+static inline void JAGClassTableBeginRead(JAGClassTable *table) {
+    //A full barrier, so either this reader sees a replacement or the reclaimer sees this reader.
+    __sync_fetch_and_add(&table->readers, 1);
+}
+
+/**
+ * End a lookup started with JAGClassTableBeginRead.
+ *
+ * @return YES if no other reader is running, so that retired storage could now be reclaimed.
+ */
+static inline BOOL JAGClassTableEndRead(JAGClassTable *table) {
+    return __sync_sub_and_fetch(&table->readers, 1) == 0;
+}
+
+static inline NSUInteger JAGClassTableHash(const void *key) {
+    uintptr_t bits = (uintptr_t)key;
+    return (NSUInteger)((bits >> 3) ^ (bits >> 11));
+}
+
+/**
+ * Find the value for cls, without taking a lock.
+ *
+ * @return YES, with *value set, if cls is in the table.
+ */
+static inline BOOL JAGClassTableLookup(JAGClassTable *table, Class cls, uintptr_t *value) {
+    JAGClassTableStorage *storage = __atomic_load_n(&table->storage, __ATOMIC_ACQUIRE);
+    if (!storage) return NO;
+    const void *key = (__bridge const void *)cls;
+    NSUInteger mask = storage->capacity - 1;
+    for (NSUInteger i = JAGClassTableHash(key) & mask; ; i = (i + 1) & mask) {
+        const void *found = __atomic_load_n(&storage->entries[i].key, __ATOMIC_ACQUIRE);
+        if (found == key) {
+            *value = __atomic_load_n(&storage->entries[i].value, __ATOMIC_ACQUIRE);
+            return YES;
+        }
+        if (!found) return NO;
+    }
+}
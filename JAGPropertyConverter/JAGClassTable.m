@@ -0,0 +1,122 @@
+//
+//  JAGClassTable.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGClassTable.h"
+#include <stdlib.h>
+
+static JAGClassTableStorage *JAGClassTableStorageCreate(NSUInteger capacity) {
+    JAGClassTableStorage *storage = calloc(1, sizeof(JAGClassTableStorage) + capacity * sizeof(JAGClassTableEntry));
+    storage->capacity = capacity;
+    return storage;
+}
+
+static void JAGClassTableStorageFree(JAGClassTableStorage *storage) {
+    while (storage) {
+        JAGClassTableStorage *next = storage->nextRetired;
+        free(storage);
+        storage = next;
+    }
+}
+
+static void JAGClassTableStorageSet(JAGClassTableStorage *storage, const void *key, uintptr_t value) {
+    NSUInteger mask = storage->capacity - 1;
+    NSUInteger i = JAGClassTableHash(key) & mask;
+    while (storage->entries[i].key && storage->entries[i].key != key) {
+        i = (i + 1) & mask;
+    }
+    __atomic_store_n(&storage->entries[i].value, value, __ATOMIC_RELEASE);
+    if (!storage->entries[i].key) {
+        storage->count++;
+        //Publish the key last, so lookups never see it without its value.
+        __atomic_store_n(&storage->entries[i].key, key, __ATOMIC_RELEASE);
+    }
+}
+
+//Must hold table->lock.
+static void JAGClassTableRetire(JAGClassTable *table, JAGClassTableStorage *storage) {
+    storage->nextRetired = table->retired;
+    table->retired = storage;
+}
+
+void JAGClassTableInit(JAGClassTable *table) {
+    table->storage = NULL;
+    table->retired = NULL;
+    pthread_mutex_init(&table->lock, NULL);
+    table->readers = 0;
+}
+
+void JAGClassTableDestroy(JAGClassTable *table) {
+    JAGClassTableStorageFree(table->storage);
+    JAGClassTableStorageFree(table->retired);
+    table->storage = NULL;
+    table->retired = NULL;
+    pthread_mutex_destroy(&table->lock);
+}
+
+void JAGClassTableInsert(JAGClassTable *table, Class cls, uintptr_t value) {
+    const void *key = (__bridge const void *)cls;
+    pthread_mutex_lock(&table->lock);
+    JAGClassTableStorage *storage = table->storage;
+    if (!storage || (storage->count + 1) * 2 > storage->capacity) {
+        JAGClassTableStorage *grown = JAGClassTableStorageCreate(storage ? storage->capacity * 2 : 32);
+        if (storage) {
+            for (NSUInteger i = 0; i < storage->capacity; i++) {
+                if (storage->entries[i].key) {
+                    JAGClassTableStorageSet(grown, storage->entries[i].key, storage->entries[i].value);
+                }
+            }
+            JAGClassTableRetire(table, storage);
+        }
+        __atomic_store_n(&table->storage, grown, __ATOMIC_RELEASE);
+        storage = grown;
+    }
+    JAGClassTableStorageSet(storage, key, value);
+    pthread_mutex_unlock(&table->lock);
+}
+
+void JAGClassTableRemoveAll(JAGClassTable *table) {
+    pthread_mutex_lock(&table->lock);
+    JAGClassTableStorage *storage = table->storage;
+    if (storage) {
+        __atomic_store_n(&table->storage, (JAGClassTableStorage *)NULL, __ATOMIC_RELEASE);
+        JAGClassTableRetire(table, storage);
+    }
+    pthread_mutex_unlock(&table->lock);
+}
+
+void JAGClassTableReclaim(JAGClassTable *table) {
+    pthread_mutex_lock(&table->lock);
+    JAGClassTableStorageFree(table->retired);
+    table->retired = NULL;
+    pthread_mutex_unlock(&table->lock);
+}
+
+BOOL JAGClassTableReclaimIfQuiescent(JAGClassTable *table) {
+    //Order the caller's retiring stores before reading the count; a reader
+    //that starts after this sees what replaced them.
+    __sync_synchronize();
+    if (table->readers != 0) return NO;
+    JAGClassTableReclaim(table);
+    return YES;
+}
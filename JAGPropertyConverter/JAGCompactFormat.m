@@ -0,0 +1,372 @@
+//
+//  JAGCompactFormat.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGPropertyConverter.h"
+#import "JAGProperty.h"
+#import "JAGClassCodec.h"
+#import "JAGMessagePackWriter.h"
+#import "JAGMessagePackReader.h"
+#import "JAGNumberParser.h"
+#import <objc/runtime.h>
+
+//The converter's private methods that the compact format is built on.
+@interface JAGPropertyConverter (JAGCompactFormatSupport)
+- (id) composeModelFromObject: (id) object withTargetClass: (Class) targetClass;
+- (BOOL) writeMessagePackFromObject: (id) object toWriter: (JAGMessagePackWriter *) writer;
+- (id) newModelOfClass: (Class) modelClass;
+- (void) assignValue: (id) value
+          toProperty: (JAGProperty *) property
+             atIndex: (NSUInteger) index
+             ofModel: (id) object
+               codec: (JAGClassCodec *) codec;
+- (BOOL) setNumber: (JAGParsedNumber) number
+        truncating: (BOOL) truncating
+        toProperty: (JAGProperty *) property
+           atIndex: (NSUInteger) index
+           ofModel: (id) object
+             codec: (JAGClassCodec *) codec;
+- (void) reportDiagnostic: (JAGDiagnosticCode) code value: (id) value context: (id) context;
+@end
+
+//Every compact payload starts with these bytes, then JAGCompactVersion.
+static const uint8_t JAGCompactMagic[4] = { 'J', 'A', 'G', 'S' };
+#define JAGCompactVersion 1
+
+/*
+ * How a schema column's values are written in each record.
+ */
+typedef enum {
+    JAGCompactSigned    = 'i',  //zigzag varint
+    JAGCompactUnsigned  = 'u',  //varint
+    JAGCompactDouble    = 'd',  //8 bytes, little-endian
+    JAGCompactBool      = 'b',  //1 byte
+    JAGCompactObject    = '@'   //MessagePack value, if the record's presence bit is set
+} JAGCompactType;
+
+//The JAGCompactType for a property, or 0 if the property can't be written.
+static JAGCompactType JAGCompactTypeForProperty(JAGProperty *property) {
+    switch ([property scalarKind]) {
+        case JAGPropertyScalarKindChar:
+        case JAGPropertyScalarKindInt:
+        case JAGPropertyScalarKindShort:
+        case JAGPropertyScalarKindLong:
+        case JAGPropertyScalarKindLongLong:
+        case JAGPropertyScalarKindUnsignedChar:
+        case JAGPropertyScalarKindUnsignedInt:
+        case JAGPropertyScalarKindUnsignedShort:
+            return JAGCompactSigned;
+        case JAGPropertyScalarKindUnsignedLong:
+        case JAGPropertyScalarKindUnsignedLongLong:
+            return JAGCompactUnsigned;
+        case JAGPropertyScalarKindFloat:
+        case JAGPropertyScalarKindDouble:
+            return JAGCompactDouble;
+        case JAGPropertyScalarKindBool:
+            return JAGCompactBool;
+        case JAGPropertyScalarKindObject:
+            return JAGCompactObject;
+        default:
+            return 0;
+    }
+}
+
+@implementation JAGPropertyConverter (JAGCompactFormat)
+
+- (NSData *) compactDataFromModels: (NSArray *) models ofClass: (Class) modelClass {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:modelClass];
+    NSUInteger propertyCount = [codec count];
+    JAGMessagePackWriter *writer = [[JAGMessagePackWriter alloc] init];
+    [writer writeRawBytes:JAGCompactMagic length:sizeof(JAGCompactMagic)];
+    [writer writeRawBytes:(uint8_t[]){ JAGCompactVersion } length:1];
+
+    //The schema: which properties are written, in what order, and how.
+    NSUInteger *columns = malloc((propertyCount + 1) * sizeof(NSUInteger));
+    uint8_t *types = malloc(propertyCount + 1);
+    NSUInteger columnCount = 0;
+    NSUInteger objectCount = 0;
+    for (NSUInteger i = 0; i < propertyCount; i++) {
+        JAGProperty *property = [codec propertyAtIndex:i];
+        JAGCompactType type = JAGCompactTypeForProperty(property);
+        if (!type || (!self.shouldConvertWeakProperties && [property isWeak])) continue;
+        columns[columnCount] = i;
+        types[columnCount++] = type;
+        if (type == JAGCompactObject) objectCount++;
+    }
+    [writer writeRawVarint:columnCount];
+    for (NSUInteger c = 0; c < columnCount; c++) {
+        NSData *name = [[[codec propertyAtIndex:columns[c]] name] dataUsingEncoding:NSUTF8StringEncoding];
+        [writer writeRawVarint:[name length]];
+        [writer writeRawBytes:[name bytes] length:[name length]];
+        [writer writeRawBytes:&types[c] length:1];
+    }
+
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:[models count]];
+    for (id model in models) {
+        if ([model isKindOfClass:modelClass]) {
+            [records addObject:model];
+        } else {
+            [self reportDiagnostic:kJAGDiagnosticTypeMismatch value:model context:modelClass];
+        }
+    }
+    [writer writeRawVarint:[records count]];
+
+    NSUInteger bitmapLength = (objectCount + 7) / 8;
+    uint8_t *bitmap = malloc(bitmapLength + 1);
+    __strong id *values = (__strong id *)calloc(objectCount + 1, sizeof(id));
+    //Subclasses (including KVO's) have their own codecs, whose indexes may differ.
+    JAGClassCodec *recordCodec = codec;
+    NSUInteger *indexes = malloc((columnCount + 1) * sizeof(NSUInteger));
+    memcpy(indexes, columns, columnCount * sizeof(NSUInteger));
+    for (id model in records) {
+        JAGClassCodec *modelCodec = [JAGClassCodec codecForClass:object_getClass(model)];
+        if (modelCodec != recordCodec) {
+            recordCodec = modelCodec;
+            for (NSUInteger c = 0; c < columnCount; c++) {
+                indexes[c] = [recordCodec indexOfPropertyNamed:[[codec propertyAtIndex:columns[c]] name]];
+            }
+        }
+        memset(bitmap, 0, bitmapLength);
+        for (NSUInteger c = 0, o = 0; c < columnCount; c++) {
+            if (types[c] != JAGCompactObject) continue;
+            if ([recordCodec canGetValueAtIndex:indexes[c] ofModel:model]) {
+                values[o] = [recordCodec valueAtIndex:indexes[c] ofModel:model];
+                if (values[o]) bitmap[o / 8] |= 1 << (o % 8);
+            }
+            o++;
+        }
+        [writer writeRawBytes:bitmap length:bitmapLength];
+        for (NSUInteger c = 0, o = 0; c < columnCount; c++) {
+            NSUInteger index = indexes[c];
+            BOOL canGet = [recordCodec canGetValueAtIndex:index ofModel:model];
+            switch (types[c]) {
+                case JAGCompactSigned: {
+                    long long value = canGet ? [recordCodec longLongValueAtIndex:index ofModel:model] : 0;
+                    [writer writeRawVarint:((uint64_t)value << 1) ^ (uint64_t)(value >> 63)];
+                    break;
+                }
+                case JAGCompactUnsigned:
+                    [writer writeRawVarint:canGet ? (uint64_t)[recordCodec longLongValueAtIndex:index ofModel:model] : 0];
+                    break;
+                case JAGCompactDouble: {
+                    double value = canGet ? [recordCodec doubleValueAtIndex:index ofModel:model] : 0;
+                    uint64_t bits;
+                    memcpy(&bits, &value, sizeof(bits));
+                    uint8_t bytes[8];
+                    for (int b = 0; b < 8; b++) bytes[b] = (uint8_t)(bits >> (8 * b));
+                    [writer writeRawBytes:bytes length:8];
+                    break;
+                }
+                case JAGCompactBool: {
+                    uint8_t value = canGet && [recordCodec longLongValueAtIndex:index ofModel:model] != 0;
+                    [writer writeRawBytes:&value length:1];
+                    break;
+                }
+                case JAGCompactObject:
+                    if (values[o] && ![self writeMessagePackFromObject:values[o] toWriter:writer]) {
+                        //The presence bit is already written, so hold the place with nil.
+                        [self reportDiagnostic:kJAGDiagnosticDroppedValue value:values[o] context:[[codec propertyAtIndex:columns[c]] name]];
+                        [writer writeNil];
+                    }
+                    values[o++] = nil;
+                    break;
+            }
+        }
+    }
+    free(indexes);
+    free(values);
+    free(bitmap);
+    free(types);
+    free(columns);
+    return [writer takeData];
+}
+
+- (NSArray *) composeModelsFromCompactData: (NSData *) data ofClass: (Class) modelClass error: (NSError **) error {
+    JAGMessagePackReader *reader = [[JAGMessagePackReader alloc] initWithData:data];
+    NSArray *models = [self composeModelsFromCompactReader:reader ofClass:modelClass];
+    if (models && !reader.atEnd) {
+        [reader failWithInvalidHeader:@"Unexpected data after records"];
+        models = nil;
+    }
+    if (!models && error) {
+        *error = reader.error;
+    }
+    return models;
+}
+
+/*
+ * Set a numeric column's value into a scalar property.  Columns are written
+ * with the property's type, so a value only fails to fit if the property's
+ * type has changed since; a fraction is then dropped, as by
+ * setPropertiesOf:fromDictionary:, but a value out of range is reported.
+ */
+- (void) setCompactNumber: (JAGParsedNumber) number
+               toProperty: (JAGProperty *) property
+                  atIndex: (NSUInteger) index
+                  ofModel: (id) model
+                    codec: (JAGClassCodec *) codec
+{
+    if (![self setNumber:number truncating:YES toProperty:property atIndex:index ofModel:model codec:codec]) {
+        [self reportDiagnostic:kJAGDiagnosticUnsettableProperty value:JAGNumberFromParsedNumber(&number) context:property];
+    }
+}
+
+- (NSArray *) composeModelsFromCompactReader: (JAGMessagePackReader *) reader ofClass: (Class) modelClass {
+    const uint8_t *header = [reader readRawBytesOfLength:sizeof(JAGCompactMagic) + 1];
+    if (!header) return nil;
+    if (memcmp(header, JAGCompactMagic, sizeof(JAGCompactMagic)) != 0) {
+        [reader failWithInvalidHeader:@"Not compact model data"];
+        return nil;
+    }
+    if (header[sizeof(JAGCompactMagic)] > JAGCompactVersion) {
+        [reader failWithInvalidHeader:@"Unsupported compact model version"];
+        return nil;
+    }
+
+    //Match the writer's schema to modelClass's properties by name.
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:modelClass];
+    uint64_t columnCount;
+    if (![reader readRawVarint:&columnCount]) return nil;
+    //Each column takes at least two bytes.
+    if (columnCount > reader.length) {
+        [reader failWithInvalidHeader:@"Too many columns"];
+        return nil;
+    }
+    NSMutableData *indexData = [NSMutableData dataWithLength:(NSUInteger)columnCount * sizeof(NSUInteger)];
+    NSMutableData *typeData = [NSMutableData dataWithLength:(NSUInteger)columnCount];
+    NSUInteger *indexes = [indexData mutableBytes];
+    uint8_t *types = [typeData mutableBytes];
+    NSUInteger objectCount = 0;
+    for (NSUInteger c = 0; c < columnCount; c++) {
+        uint64_t nameLength;
+        const void *nameBytes;
+        const uint8_t *type;
+        if (![reader readRawVarint:&nameLength]
+            || !(nameBytes = [reader readRawBytesOfLength:(NSUInteger)nameLength])
+            || !(type = [reader readRawBytesOfLength:1])) return nil;
+        types[c] = *type;
+        if (types[c] == JAGCompactObject) {
+            objectCount++;
+        } else if (types[c] != JAGCompactSigned && types[c] != JAGCompactUnsigned
+                   && types[c] != JAGCompactDouble && types[c] != JAGCompactBool) {
+            [reader failWithInvalidHeader:@"Unknown column type"];
+            return nil;
+        }
+        NSUInteger index = [codec indexOfPropertyNamedBytes:nameBytes length:(NSUInteger)nameLength];
+        //Properties modelClass no longer has, or can't set, are read and skipped.
+        if (index != NSNotFound && [[codec propertyAtIndex:index] isReadOnly]) index = NSNotFound;
+        indexes[c] = index;
+    }
+
+    uint64_t recordCount;
+    if (![reader readRawVarint:&recordCount]) return nil;
+    if (recordCount > reader.length) {
+        [reader failWithInvalidHeader:@"Too many records"];
+        return nil;
+    }
+    NSUInteger bitmapLength = (objectCount + 7) / 8;
+    NSMutableArray *models = [NSMutableArray arrayWithCapacity:(NSUInteger)recordCount];
+    for (uint64_t r = 0; r < recordCount; r++) {
+        id model = [self newModelOfClass:modelClass];
+        const uint8_t *bitmap = [reader readRawBytesOfLength:bitmapLength];
+        if (!bitmap) {
+            return nil;
+        }
+        for (NSUInteger c = 0, o = 0; c < columnCount; c++) {
+            NSUInteger index = indexes[c];
+            JAGProperty *property = index != NSNotFound ? [codec propertyAtIndex:index] : nil;
+            id value = nil;
+            switch (types[c]) {
+                case JAGCompactSigned:
+                case JAGCompactUnsigned: {
+                    uint64_t bits;
+                    if (![reader readRawVarint:&bits]) {
+                        return nil;
+                    }
+                    if (!property) break;
+                    JAGParsedNumber number = types[c] == JAGCompactSigned
+                        ? JAGParsedNumberFromLongLong((long long)((bits >> 1) ^ (~(bits & 1) + 1)))
+                        : JAGParsedNumberFromUnsignedLongLong(bits);
+                    if ([property isNumber]) {
+                        [self setCompactNumber:number toProperty:property atIndex:index ofModel:model codec:codec];
+                    } else {
+                        value = JAGNumberFromParsedNumber(&number);
+                    }
+                    break;
+                }
+                case JAGCompactDouble: {
+                    const uint8_t *bytes = [reader readRawBytesOfLength:8];
+                    if (!bytes) {
+                        return nil;
+                    }
+                    uint64_t bits = 0;
+                    for (int b = 7; b >= 0; b--) bits = (bits << 8) | bytes[b];
+                    double number;
+                    memcpy(&number, &bits, sizeof(number));
+                    if (!property) break;
+                    if ([property isNumber]) {
+                        [self setCompactNumber:JAGParsedNumberFromDouble(number) toProperty:property atIndex:index ofModel:model codec:codec];
+                    } else {
+                        value = [NSNumber numberWithDouble:number];
+                    }
+                    break;
+                }
+                case JAGCompactBool: {
+                    const uint8_t *byte = [reader readRawBytesOfLength:1];
+                    if (!byte) {
+                        return nil;
+                    }
+                    if (!property) break;
+                    if ([property isNumber]) {
+                        [self setCompactNumber:JAGParsedNumberFromLongLong(*byte != 0) toProperty:property atIndex:index ofModel:model codec:codec];
+                    } else {
+                        value = [NSNumber numberWithBool:*byte != 0];
+                    }
+                    break;
+                }
+                case JAGCompactObject: {
+                    BOOL present = (bitmap[o / 8] >> (o % 8)) & 1;
+                    o++;
+                    if (!present) break;
+                    id object = [reader readObject];
+                    if (!object) {
+                        return nil;
+                    }
+                    if (!property || object == [NSNull null]) break;
+                    value = [property isObject]
+                        ? [self composeModelFromObject:object withTargetClass:[property propertyClass]]
+                        : object;
+                    break;
+                }
+            }
+            //A property whose type changed since the data was written.
+            if (value) {
+                [self assignValue:value toProperty:property atIndex:index ofModel:model codec:codec];
+            }
+        }
+        [models addObject:model];
+    }
+    return models;
+}
+
+@end
@@ -0,0 +1,90 @@
+//
+//  JAGDateCodec.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+ * The representations of an NSDate a JAGDateCodec converts to and from.
+ */
+typedef enum {
+    ///An ISO 8601 string in UTC, like "2012-09-19T16:30:00Z".
+    kJAGDateFormatISO8601,
+    ///An ISO 8601 string in UTC with milliseconds, like "2012-09-19T16:30:00.250Z".
+    kJAGDateFormatISO8601FractionalSeconds,
+    ///An NSNumber of seconds since 1970, possibly fractional.
+    kJAGDateFormatEpochSeconds,
+    ///An NSNumber of whole milliseconds since 1970.
+    kJAGDateFormatEpochMilliseconds
+} JAGDateFormat;
+
+/**
+   JAGDateCodec converts NSDates to and from one of the common JSON
+   representations, without NSDateFormatter.
+
+   Set one as a JAGPropertyConverter's dateCodec instead of writing
+   convertToDate and convertFromDate blocks.
+
+   Both ISO 8601 formats parse strings with or without fractional seconds,
+   in the extended format (`YYYY-MM-DDTHH:MM:SS`), with a `Z` or a
+   `+HH:MM`, `+HHMM` or `+HH` offset; a date without a time is
+   midnight UTC.  They always format in UTC.  Only years 0000 to 9999 are
+   supported.  The epoch formats parse NSNumbers and numeric NSStrings.
+
+   Recently parsed strings are cached, since the same timestamps often
+   recur in a payload.  Codecs are immutable apart from the cache, and are
+   thread-safe.
+ */
+@interface JAGDateCodec : NSObject
+
+/// A codec for format.
++ (JAGDateCodec *) codecWithFormat: (JAGDateFormat) format;
+
+- (id) initWithFormat: (JAGDateFormat) format;
+
+/// The representation this codec converts to and from.
+@property (nonatomic, readonly, assign) JAGDateFormat format;
+
+/**
+ * The number of parsed strings to remember.
+ *
+ * Default is 64.  Set it to 0 to turn the cache off.  Set it before the
+ * codec is shared, since changing it isn't thread-safe.
+ */
+@property (nonatomic, assign) NSUInteger cacheCapacity;
+
+/**
+ * Convert date to an NSString or NSNumber, as given by format.
+ *
+ * @return The value, or nil if date is outside the range format can represent.
+ */
+- (id) valueFromDate: (NSDate *) date;
+
+/**
+ * Parse value as given by format.
+ *
+ * @return The date, or nil if value can't be parsed.
+ */
+- (NSDate *) dateFromValue: (id) value;
+
+@end
@@ -0,0 +1,311 @@
+//
+//  JAGDateCodec.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGDateCodec.h"
+#import "JAGNumberParser.h"
+#import <pthread.h>
+#include <math.h>
+
+#define JAGIsDigit(c) ((c) >= '0' && (c) <= '9')
+
+//Days from 1970-01-01 to the given date in the proleptic Gregorian calendar.
+static long long JAGDaysFromCivil(long long year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = (unsigned)(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (long long)dayOfEra - 719468;
+}
+
+//The inverse of JAGDaysFromCivil.
+static void JAGCivilFromDays(long long days, long long *year, unsigned *month, unsigned *day) {
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = (unsigned)(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned mp = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (long long)yearOfEra + era * 400 + (*month <= 2);
+}
+
+static unsigned JAGDaysInMonth(long long year, unsigned month) {
+    static const unsigned days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) return 29;
+    return days[month - 1];
+}
+
+//Read count digits at *p, advancing it.
+static BOOL JAGReadDigits(const char **p, const char *end, int count, unsigned *value) {
+    if (end - *p < count) return NO;
+    unsigned result = 0;
+    for (int i = 0; i < count; i++) {
+        char c = (*p)[i];
+        if (!JAGIsDigit(c)) return NO;
+        result = result * 10 + (unsigned)(c - '0');
+    }
+    *p += count;
+    *value = result;
+    return YES;
+}
+
+/*
+ * Parse an ISO 8601 date into seconds since 1970.
+ */
+static BOOL JAGParseISO8601(const char *text, size_t length, double *seconds) {
+    const char *p = text;
+    const char *end = text + length;
+    unsigned year, month, day, hour = 0, minute = 0, second = 0;
+    if (!JAGReadDigits(&p, end, 4, &year) || p == end || *p++ != '-'
+        || !JAGReadDigits(&p, end, 2, &month) || p == end || *p++ != '-'
+        || !JAGReadDigits(&p, end, 2, &day))
+    {
+        return NO;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > JAGDaysInMonth(year, month)) return NO;
+
+    double fraction = 0;
+    long offset = 0;
+    if (p < end) {
+        if (*p != 'T' && *p != 't' && *p != ' ') return NO;
+        p++;
+        if (!JAGReadDigits(&p, end, 2, &hour) || p == end || *p++ != ':'
+            || !JAGReadDigits(&p, end, 2, &minute) || p == end || *p++ != ':'
+            || !JAGReadDigits(&p, end, 2, &second))
+        {
+            return NO;
+        }
+        //A leap second is read as the first second of the next minute.
+        if (hour > 23 || minute > 59 || second > 60) return NO;
+        if (p < end && (*p == '.' || *p == ',')) {
+            p++;
+            const char *digits = p;
+            double scale = 0.1;
+            for (; p < end && JAGIsDigit(*p); p++) {
+                //Beyond nanoseconds, digits don't change the double.
+                if (p - digits < 9) {
+                    fraction += (*p - '0') * scale;
+                    scale /= 10;
+                }
+            }
+            if (p == digits) return NO;
+        }
+        if (p == end) return NO;
+        if (*p == 'Z' || *p == 'z') {
+            p++;
+        } else if (*p == '+' || *p == '-') {
+            long sign = (*p++ == '-') ? -1 : 1;
+            unsigned offsetHours, offsetMinutes = 0;
+            if (!JAGReadDigits(&p, end, 2, &offsetHours)) return NO;
+            if (p < end && *p == ':') p++;
+            if (p < end && !JAGReadDigits(&p, end, 2, &offsetMinutes)) return NO;
+            if (offsetHours > 23 || offsetMinutes > 59) return NO;
+            offset = sign * (long)(offsetHours * 3600 + offsetMinutes * 60);
+        } else {
+            return NO;
+        }
+        if (p != end) return NO;
+    }
+    long long days = JAGDaysFromCivil(year, month, day);
+    long long whole = days * 86400 + hour * 3600 + minute * 60 + second - offset;
+    *seconds = (double)whole + fraction;
+    return YES;
+}
+
+/*
+ * Format seconds since 1970 as ISO 8601 in UTC, into a buffer of at least 32 bytes.
+ */
+static BOOL JAGFormatISO8601(double seconds, BOOL includeMilliseconds, char *buffer) {
+    if (!isfinite(seconds)) return NO;
+    double total = includeMilliseconds ? floor(seconds * 1000 + 0.5) : floor(seconds);
+    //Years 0000 to 9999.
+    if (total < -62167219200.0 * (includeMilliseconds ? 1000 : 1)
+        || total >= 253402300800.0 * (includeMilliseconds ? 1000 : 1))
+    {
+        return NO;
+    }
+    long long whole = (long long)total;
+    long long milliseconds = 0;
+    if (includeMilliseconds) {
+        milliseconds = whole % 1000;
+        whole /= 1000;
+        if (milliseconds < 0) {
+            milliseconds += 1000;
+            whole -= 1;
+        }
+    }
+    long long days = whole / 86400;
+    long long secondOfDay = whole % 86400;
+    if (secondOfDay < 0) {
+        secondOfDay += 86400;
+        days -= 1;
+    }
+    long long year;
+    unsigned month, day;
+    JAGCivilFromDays(days, &year, &month, &day);
+    unsigned hour = (unsigned)(secondOfDay / 3600), minute = (unsigned)(secondOfDay / 60 % 60), second = (unsigned)(secondOfDay % 60);
+    if (includeMilliseconds) {
+        snprintf(buffer, 32, "%04lld-%02u-%02uT%02u:%02u:%02u.%03lldZ", year, month, day, hour, minute, second, milliseconds);
+    } else {
+        snprintf(buffer, 32, "%04lld-%02u-%02uT%02u:%02u:%02uZ", year, month, day, hour, minute, second);
+    }
+    return YES;
+}
+
+@interface JAGDateCodec ()
+{
+    pthread_mutex_t _cacheLock;
+    //Direct-mapped by string hash.
+    NSString * __strong *_cachedStrings;
+    NSDate * __strong *_cachedDates;
+}
+@end
+
+@implementation JAGDateCodec
+
+@synthesize format = _format;
+@synthesize cacheCapacity = _cacheCapacity;
+
++ (JAGDateCodec *) codecWithFormat: (JAGDateFormat) format {
+    return [[JAGDateCodec alloc] initWithFormat:format];
+}
+
+- (id) initWithFormat: (JAGDateFormat) format {
+    self = [super init];
+    if (self) {
+        _format = format;
+        pthread_mutex_init(&_cacheLock, NULL);
+        self.cacheCapacity = 64;
+    }
+    return self;
+}
+
+- (id) init {
+    return [self initWithFormat:kJAGDateFormatISO8601];
+}
+
+- (void) freeCache {
+    for (NSUInteger i = 0; i < _cacheCapacity; i++) {
+        _cachedStrings[i] = nil;
+        _cachedDates[i] = nil;
+    }
+    free(_cachedStrings);
+    free(_cachedDates);
+    _cachedStrings = NULL;
+    _cachedDates = NULL;
+}
+
+- (void) dealloc {
+    [self freeCache];
+    pthread_mutex_destroy(&_cacheLock);
+}
+
+- (void) setCacheCapacity: (NSUInteger) cacheCapacity {
+    pthread_mutex_lock(&_cacheLock);
+    [self freeCache];
+    _cacheCapacity = cacheCapacity;
+    if (cacheCapacity) {
+        //calloc, so that ARC sees nil in every slot.
+        _cachedStrings = (NSString * __strong *) calloc(cacheCapacity, sizeof(NSString *));
+        _cachedDates = (NSDate * __strong *) calloc(cacheCapacity, sizeof(NSDate *));
+    }
+    pthread_mutex_unlock(&_cacheLock);
+}
+
+- (id) valueFromDate: (NSDate *) date {
+    NSTimeInterval seconds = [date timeIntervalSince1970];
+    switch (_format) {
+        case kJAGDateFormatISO8601:
+        case kJAGDateFormatISO8601FractionalSeconds: {
+            char buffer[32];
+            if (!JAGFormatISO8601(seconds, _format == kJAGDateFormatISO8601FractionalSeconds, buffer)) return nil;
+            return [[NSString alloc] initWithUTF8String:buffer];
+        }
+        case kJAGDateFormatEpochSeconds:
+            return isfinite(seconds) ? [[NSNumber alloc] initWithDouble:seconds] : nil;
+        case kJAGDateFormatEpochMilliseconds: {
+            double milliseconds = floor(seconds * 1000 + 0.5);
+            if (!(fabs(milliseconds) < 9.2e18)) return nil;
+            return [[NSNumber alloc] initWithLongLong:(long long)milliseconds];
+        }
+    }
+    return nil;
+}
+
+- (NSDate *) dateFromValue: (id) value {
+    if (!value) return nil;
+    if (_format == kJAGDateFormatEpochSeconds || _format == kJAGDateFormatEpochMilliseconds) {
+        double number;
+        if ([value isKindOfClass:[NSNumber class]]) {
+            number = [value doubleValue];
+        } else if ([value isKindOfClass:[NSString class]]) {
+            JAGParsedNumber parsed;
+            if (!JAGParseNumericString(value, &parsed)) return nil;
+            number = parsed.kind == JAGParsedNumberDouble ? parsed.doubleValue : (double)parsed.longLongValue;
+        } else {
+            return nil;
+        }
+        if (!isfinite(number)) return nil;
+        if (_format == kJAGDateFormatEpochMilliseconds) number /= 1000;
+        return [[NSDate alloc] initWithTimeIntervalSince1970:number];
+    }
+
+    if (![value isKindOfClass:[NSString class]]) return nil;
+    NSString *string = value;
+    NSUInteger slot = 0;
+    if (_cacheCapacity) {
+        slot = [string hash] % _cacheCapacity;
+        pthread_mutex_lock(&_cacheLock);
+        NSString *cachedString = _cachedStrings[slot];
+        NSDate *cachedDate = _cachedDates[slot];
+        pthread_mutex_unlock(&_cacheLock);
+        if (cachedString && [cachedString isEqualToString:string]) return cachedDate;
+    }
+
+    char buffer[64];
+    CFIndex used = 0;
+    CFIndex length = CFStringGetLength((__bridge CFStringRef) string);
+    if (length >= (CFIndex)sizeof(buffer)
+        || CFStringGetBytes((__bridge CFStringRef) string, CFRangeMake(0, length), kCFStringEncodingASCII, 0, false,
+                            (UInt8 *)buffer, sizeof(buffer), &used) != length)
+    {
+        return nil;
+    }
+    double seconds;
+    if (!JAGParseISO8601(buffer, (size_t)used, &seconds)) return nil;
+    NSDate *date = [[NSDate alloc] initWithTimeIntervalSince1970:seconds];
+
+    if (_cacheCapacity) {
+        string = [string copy];
+        pthread_mutex_lock(&_cacheLock);
+        _cachedStrings[slot] = string;
+        _cachedDates[slot] = date;
+        pthread_mutex_unlock(&_cacheLock);
+    }
+    return date;
+}
+
+@end
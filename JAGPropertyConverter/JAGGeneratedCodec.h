@@ -0,0 +1,141 @@
+//
+//  JAGGeneratedCodec.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class JAGPropertyConverter;
+
+/*
+   Codecs generated ahead of time by Tools/jagcodegen.py, which reads the
+   @interface declarations of model classes and writes, for each class,
+   functions that call its accessors directly with literal keys:
+
+     python Tools/jagcodegen.py -o MyModels+JAGCodec.m MyModel.h MyOtherModel.h
+
+   Compile the output into the same target as the models.  It registers its
+   codecs when it is loaded, and JAGPropertyConverter uses them (see
+   shouldUseGeneratedCodecs) instead of looking properties up at run time.
+
+   Before a codec is first used for a class, its property table is checked
+   against the class's runtime properties, and the codec is ignored (with a
+   kJAGDiagnosticStaleGeneratedCodec diagnostic each time the converter
+   falls back to reflection) if they differ, for instance because the header
+   changed without regenerating the codec.  Properties whose types the generator
+   doesn't know, or that are declared in class extensions, go through the
+   reflective path one at a time.
+ */
+
+///Flags of a JAGGeneratedProperty.
+enum {
+    JAGGeneratedPropertyReadOnly    = 1 << 0,
+    JAGGeneratedPropertyWeak        = 1 << 1
+};
+
+///A property of a generated codec, as the generator saw it.
+typedef struct {
+    const char *name;
+    unsigned int flags;
+} JAGGeneratedProperty;
+
+///The generated functions and property table for one class.
+typedef struct {
+    const char *className;
+    const JAGGeneratedProperty *properties;
+    unsigned int propertyCount;
+    ///Fill values as convertToDictionary: would.
+    void (*encode)(JAGPropertyConverter *converter, id model, NSMutableDictionary *values);
+    ///Set model's properties as setPropertiesOf:fromDictionary: would.
+    void (*decode)(JAGPropertyConverter *converter, id model, NSDictionary *dictionary);
+} JAGGeneratedCodec;
+
+/**
+ * Register generated codecs.  Generated files call this when they are loaded.
+ *
+ * @param codecs The codecs, which must stay valid.
+ * @param count The number of codecs.
+ */
+extern void JAGRegisterGeneratedCodecs(const JAGGeneratedCodec *codecs, unsigned int count);
+
+/**
+ * The generated codec for exactly modelClass, not a superclass.
+ *
+ * @param modelClass The class to find the codec of.
+ * @param converter The converter to report kJAGDiagnosticStaleGeneratedCodec to, if the codec doesn't match modelClass; may be nil.
+ * @return The codec, or NULL if there is none or it doesn't match modelClass.
+ */
+extern const JAGGeneratedCodec *JAGGeneratedCodecForClass(Class modelClass, JAGPropertyConverter *converter);
+
+#pragma mark - Called by generated code
+
+///Decompose value and, if that isn't nil, set it in values.
+extern void JAGGeneratedEncodeValue(JAGPropertyConverter *converter, NSMutableDictionary *values, NSString *key, id value);
+
+///Decompose the property named key through the reflective path.
+extern void JAGGeneratedEncodeReflected(JAGPropertyConverter *converter, NSMutableDictionary *values, id model, NSString *key);
+
+///Whether weak properties are decomposed.
+extern BOOL JAGGeneratedShouldConvertWeakProperties(JAGPropertyConverter *converter);
+
+///Compose value for an object property of targetClass.
+extern id JAGGeneratedCompose(JAGPropertyConverter *converter, id value, Class targetClass);
+
+///Set a composed value that isn't of the property's class, through the reflective path.
+extern void JAGGeneratedAssign(JAGPropertyConverter *converter, id model, NSString *key, id value);
+
+///Set the property named key from a dictionary value, through the reflective path.
+extern void JAGGeneratedDecodeReflected(JAGPropertyConverter *converter, id model, NSString *key, id value);
+
+///Box a numeric expression the same way JAGClassCodec does for its type.
+#define JAGGeneratedBox(x) _Generic((x), \
+    char:               [[NSNumber alloc] initWithChar:(char)(x)], \
+    signed char:        [[NSNumber alloc] initWithChar:(char)(x)], \
+    unsigned char:      [[NSNumber alloc] initWithUnsignedChar:(unsigned char)(x)], \
+    short:              [[NSNumber alloc] initWithShort:(short)(x)], \
+    unsigned short:     [[NSNumber alloc] initWithUnsignedShort:(unsigned short)(x)], \
+    int:                [[NSNumber alloc] initWithInt:(int)(x)], \
+    unsigned int:       [[NSNumber alloc] initWithUnsignedInt:(unsigned int)(x)], \
+    long:               [[NSNumber alloc] initWithLong:(long)(x)], \
+    unsigned long:      [[NSNumber alloc] initWithUnsignedLong:(unsigned long)(x)], \
+    long long:          [[NSNumber alloc] initWithLongLong:(long long)(x)], \
+    unsigned long long: [[NSNumber alloc] initWithUnsignedLongLong:(unsigned long long)(x)], \
+    float:              [[NSNumber alloc] initWithFloat:(float)(x)], \
+    double:             [[NSNumber alloc] initWithDouble:(double)(x)], \
+    _Bool:              [[NSNumber alloc] initWithBool:(_Bool)(x)])
+
+///Unbox number for a property of the type of x, the same way JAGClassCodec does.
+#define JAGGeneratedUnbox(x, number) _Generic((x), \
+    char:               [(number) charValue], \
+    signed char:        [(number) charValue], \
+    unsigned char:      [(number) unsignedCharValue], \
+    short:              [(number) shortValue], \
+    unsigned short:     [(number) unsignedShortValue], \
+    int:                [(number) intValue], \
+    unsigned int:       [(number) unsignedIntValue], \
+    long:               [(number) longValue], \
+    unsigned long:      [(number) unsignedLongValue], \
+    long long:          [(number) longLongValue], \
+    unsigned long long: [(number) unsignedLongLongValue], \
+    float:              [(number) floatValue], \
+    double:             [(number) doubleValue], \
+    _Bool:              [(number) boolValue])
@@ -0,0 +1,171 @@
+//
+//  JAGGeneratedCodec.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGGeneratedCodec.h"
+#import "JAGPropertyConverter.h"
+#import "JAGPropertyFinder.h"
+#import "JAGProperty.h"
+#import "JAGClassCodec.h"
+#import "JAGClassTable.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+
+//The converter's private methods that generated code falls back on.
+@interface JAGPropertyConverter (JAGGeneratedCodec)
+- (id) composeModelFromObject: (id) object withTargetClass: (Class) targetClass;
+- (void) assignValue: (id) value
+          toProperty: (JAGProperty *) property
+             atIndex: (NSUInteger) index
+             ofModel: (id) object
+               codec: (JAGClassCodec *) codec;
+- (void) setPropertyNamed: (NSString *) key ofModel: (id) object toValue: (id) value codec: (JAGClassCodec *) codec;
+- (void) reportDiagnostic: (JAGDiagnosticCode) code value: (id) value context: (id) context;
+@end
+
+//Guards the registered codecs.
+static pthread_rwlock_t gGeneratedLock = PTHREAD_RWLOCK_INITIALIZER;
+//Every registered codec, to be matched to classes by name.
+static const JAGGeneratedCodec **gRegisteredCodecs = NULL;
+static unsigned int gRegisteredCount = 0;
+//Class to its checked codec, or to &gNoCodec or &gStaleCodec, read without locking.
+static JAGClassTable gCodecsByClass = JAG_CLASS_TABLE_INITIALIZER;
+static const JAGGeneratedCodec gNoCodec;
+//Stands for a codec that doesn't match its class, which is reported on every use.
+static const JAGGeneratedCodec gStaleCodec;
+
+void JAGRegisterGeneratedCodecs(const JAGGeneratedCodec *codecs, unsigned int count) {
+    pthread_rwlock_wrlock(&gGeneratedLock);
+    gRegisteredCodecs = realloc(gRegisteredCodecs, (gRegisteredCount + count) * sizeof(JAGGeneratedCodec *));
+    for (unsigned int i = 0; i < count; i++) {
+        gRegisteredCodecs[gRegisteredCount++] = &codecs[i];
+    }
+    //Classes found to have no codec may have one now.
+    JAGClassTableRemoveAll(&gCodecsByClass);
+    JAGClassTableReclaimIfQuiescent(&gCodecsByClass);
+    pthread_rwlock_unlock(&gGeneratedLock);
+}
+
+/*
+ * Whether generated describes the properties of modelClass as the runtime sees them.
+ */
+static BOOL JAGGeneratedCodecMatchesClass(const JAGGeneratedCodec *generated, Class modelClass) {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:modelClass];
+    NSMutableSet *names = [NSMutableSet setWithCapacity:[codec count]];
+    for (NSUInteger i = 0; i < [codec count]; i++) {
+        [names addObject:[[codec propertyAtIndex:i] name]];
+    }
+    if ([names count] != generated->propertyCount) return NO;
+    for (unsigned int i = 0; i < generated->propertyCount; i++) {
+        const JAGGeneratedProperty *generatedProperty = &generated->properties[i];
+        NSUInteger index = [codec indexOfPropertyNamedBytes:generatedProperty->name length:strlen(generatedProperty->name)];
+        if (index == NSNotFound) return NO;
+        JAGProperty *property = [codec propertyAtIndex:index];
+        if ([property isReadOnly] != ((generatedProperty->flags & JAGGeneratedPropertyReadOnly) != 0)
+            || [property isWeak] != ((generatedProperty->flags & JAGGeneratedPropertyWeak) != 0)
+            || ![property getter] || !class_respondsToSelector(modelClass, [property getter]))
+        {
+            return NO;
+        }
+    }
+    return YES;
+}
+
+const JAGGeneratedCodec *JAGGeneratedCodecForClass(Class modelClass, JAGPropertyConverter *converter) {
+    if (!modelClass) return NULL;
+    uintptr_t found;
+    JAGClassTableBeginRead(&gCodecsByClass);
+    BOOL isCached = JAGClassTableLookup(&gCodecsByClass, modelClass, &found);
+    JAGClassTableEndRead(&gCodecsByClass);
+    if (isCached) {
+        const JAGGeneratedCodec *generated = (const JAGGeneratedCodec *)found;
+        if (generated == &gStaleCodec) {
+            [converter reportDiagnostic:kJAGDiagnosticStaleGeneratedCodec value:modelClass context:nil];
+            return NULL;
+        }
+        return generated == &gNoCodec ? NULL : generated;
+    }
+
+    const char *className = class_getName(modelClass);
+    const JAGGeneratedCodec *generated = NULL;
+    pthread_rwlock_rdlock(&gGeneratedLock);
+    unsigned int registeredCount = gRegisteredCount;
+    for (unsigned int i = 0; i < registeredCount; i++) {
+        if (strcmp(gRegisteredCodecs[i]->className, className) == 0) {
+            generated = gRegisteredCodecs[i];
+        }
+    }
+    pthread_rwlock_unlock(&gGeneratedLock);
+    //Check it outside the lock; two threads may both do it, but they agree.
+    const JAGGeneratedCodec *entry = generated ? generated : &gNoCodec;
+    if (generated && !JAGGeneratedCodecMatchesClass(generated, modelClass)) {
+        [converter reportDiagnostic:kJAGDiagnosticStaleGeneratedCodec value:modelClass context:nil];
+        entry = &gStaleCodec;
+        generated = NULL;
+    }
+
+    //Unless codecs were registered meanwhile, which would make this answer stale.
+    pthread_rwlock_rdlock(&gGeneratedLock);
+    if (gRegisteredCount == registeredCount) {
+        JAGClassTableInsert(&gCodecsByClass, modelClass, (uintptr_t)entry);
+        JAGClassTableReclaimIfQuiescent(&gCodecsByClass);
+    }
+    pthread_rwlock_unlock(&gGeneratedLock);
+    return generated;
+}
+
+#pragma mark - Called by generated code
+
+void JAGGeneratedEncodeValue(JAGPropertyConverter *converter, NSMutableDictionary *values, NSString *key, id value) {
+    id decomposed = [converter decomposeObject:value];
+    if (decomposed) {
+        [values setObject:decomposed forKey:key];
+    }
+}
+
+void JAGGeneratedEncodeReflected(JAGPropertyConverter *converter, NSMutableDictionary *values, id model, NSString *key) {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    NSUInteger index = [codec indexOfPropertyNamed:key];
+    if (index == NSNotFound || ![codec canGetValueAtIndex:index ofModel:model]) return;
+    JAGGeneratedEncodeValue(converter, values, key, [codec valueAtIndex:index ofModel:model]);
+}
+
+BOOL JAGGeneratedShouldConvertWeakProperties(JAGPropertyConverter *converter) {
+    return converter.shouldConvertWeakProperties;
+}
+
+id JAGGeneratedCompose(JAGPropertyConverter *converter, id value, Class targetClass) {
+    return [converter composeModelFromObject:value withTargetClass:targetClass];
+}
+
+void JAGGeneratedAssign(JAGPropertyConverter *converter, id model, NSString *key, id value) {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    NSUInteger index = [codec indexOfPropertyNamed:key];
+    if (index == NSNotFound) return;
+    [converter assignValue:value toProperty:[codec propertyAtIndex:index] atIndex:index ofModel:model codec:codec];
+}
+
+void JAGGeneratedDecodeReflected(JAGPropertyConverter *converter, id model, NSString *key, id value) {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    [converter setPropertyNamed:key ofModel:model toValue:value codec:codec];
+}
@@ -0,0 +1,180 @@
+//
+//  JAGJSONReader.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "JAGNumberParser.h"
+
+/**
+ * The tokens returned by [JAGJSONReader nextToken].
+ */
+typedef enum {
+    JAGJSONTokenError = 0,
+    JAGJSONTokenEnd,
+    JAGJSONTokenBeginObject,
+    JAGJSONTokenEndObject,
+    JAGJSONTokenBeginArray,
+    JAGJSONTokenEndArray,
+    JAGJSONTokenKey,
+    JAGJSONTokenString,
+    JAGJSONTokenNumber,
+    JAGJSONTokenTrue,
+    JAGJSONTokenFalse,
+    JAGJSONTokenNull
+} JAGJSONToken;
+
+///The error domain for malformed JSON.  Stream errors are passed through unchanged.
+extern NSString * const JAGJSONReaderErrorDomain;
+
+typedef enum {
+    JAGJSONReaderErrorSyntax = 1,
+    JAGJSONReaderErrorUnexpectedEnd,
+    JAGJSONReaderErrorInvalidString,
+    JAGJSONReaderErrorTooDeep
+} JAGJSONReaderErrorCode;
+
+/**
+   JAGJSONReader is a pull tokenizer for UTF-8 JSON text.
+
+   It reads from an NSData or a memory-mapped file without copying it, or
+   from an NSInputStream through a fixed-size buffer, and returns one token
+   at a time.  Only the
+   current string or number is held in memory, so a document never has to be
+   materialized as a whole.  Strings inside an object are returned as
+   JAGJSONTokenKey when they are keys, and JAGJSONTokenString when they are values.
+
+     JAGJSONReader *reader = [[JAGJSONReader alloc] initWithData:data];
+     JAGJSONToken token;
+     while ((token = [reader nextToken]) > JAGJSONTokenEnd) {
+         if (token == JAGJSONTokenKey && [[reader stringValue] isEqualToString:@"userID"]) {
+             token = [reader nextToken];
+             NSLog(@"userID: %lld", [reader longLongValue]);
+         }
+     }
+
+   The reader checks the structure of the document as it goes.  At the first
+   problem it returns JAGJSONTokenError, sets error, and returns
+   JAGJSONTokenError from then on.  After a complete top-level value, it returns
+   JAGJSONTokenEnd if the rest of the input is whitespace.
+
+   JAGPropertyConverter uses a JAGJSONReader to compose models directly from JSON;
+   see [JAGPropertyConverter composeModelFromJSONData:ofClass:error:].
+ */
+@interface JAGJSONReader : NSObject
+
+/**
+ * A reader over data, which is retained but not copied.
+ */
+- (id) initWithData: (NSData *) data;
+
+/**
+ * A reader over the memory-mapped contents of a file.
+ *
+ * Pages are read in as the reader reaches them, and given back by
+ * discardConsumedInput, so a large file never has to be resident at once.
+ *
+ * @param path The path of a UTF-8 JSON file.
+ * @param error Set if the file can't be opened or mapped.
+ * @return The reader, or nil on error.
+ */
+- (id) initWithContentsOfMappedFile: (NSString *) path error: (NSError **) error;
+
+/**
+ * A reader that pulls from stream as it needs to.
+ *
+ * @param stream An open NSInputStream.
+ * @param bufferSize Number of bytes to read from the stream at a time.  If 0, 64KB.
+ */
+- (id) initWithInputStream: (NSInputStream *) stream bufferSize: (NSUInteger) bufferSize;
+
+/// The reason for the last JAGJSONTokenError, or nil.
+@property (nonatomic, readonly, strong) NSError *error;
+
+/// The number of objects and arrays the reader is currently inside.
+@property (nonatomic, readonly) NSUInteger depth;
+
+/// The number of bytes of input consumed so far.
+@property (nonatomic, readonly) NSUInteger offset;
+
+/**
+ * Let the system reclaim the pages of a mapped file that have been read.
+ *
+ * Does nothing for other input.  Cheap enough to call after every value,
+ * since pages are only given back a megabyte at a time.
+ */
+- (void) discardConsumedInput;
+
+/**
+ * Read the next token.
+ *
+ * After JAGJSONTokenKey, JAGJSONTokenString or JAGJSONTokenNumber, the token's
+ * value is available from stringValue or the number accessors until the next call.
+ *
+ * @return The next token, JAGJSONTokenEnd after the top-level value, or JAGJSONTokenError.
+ */
+- (JAGJSONToken) nextToken;
+
+/// The decoded value of the current JAGJSONTokenKey or JAGJSONTokenString, or nil if it isn't valid UTF-8.
+- (NSString *) stringValue;
+
+/// The decoded UTF-8 bytes of the current key or string, not NUL-terminated.  They may point into the input.
+- (const char *) stringBytes;
+
+/// The length of stringBytes.
+- (NSUInteger) stringLength;
+
+/// Whether the current JAGJSONTokenNumber was written as an integer that fits in 64 bits.
+- (BOOL) numberIsInteger;
+
+/// The current number, cast to long long.  Unsigned integers above LLONG_MAX keep their bits, and other numbers out of range are clamped.
+- (long long) longLongValue;
+
+/// The current number as a double.
+- (double) doubleValue;
+
+/// The current number as JAGParseNumberBytes parses it, without regard to locale.
+- (const JAGParsedNumber *) parsedNumber;
+
+/// The current number, boxed as a long long, unsigned long long, or double NSNumber.
+- (NSNumber *) numberValue;
+
+/**
+ * Read the whole value that starts with token into Foundation objects.
+ *
+ * Objects become NSMutableDictionaries, arrays NSMutableArrays, and
+ * true, false and null become boolean NSNumbers and NSNull.
+ *
+ * @param token The token just returned by nextToken.
+ * @return The value, or nil if token doesn't start a value or the value is malformed.
+ */
+- (id) objectValueForToken: (JAGJSONToken) token;
+
+/**
+ * Skip past the value that starts with token.
+ *
+ * @param token The token just returned by nextToken.
+ * @return NO if token doesn't start a value or the value is malformed.
+ */
+- (BOOL) skipValueForToken: (JAGJSONToken) token;
+
+@end
@@ -0,0 +1,627 @@
+//
+//  JAGJSONReader.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGJSONReader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NSString * const JAGJSONReaderErrorDomain = @"JAGJSONReaderErrorDomain";
+
+#define JAGJSONReaderInitialCapacity    256
+#define JAGJSONReaderMaxDepth           512
+//Consumed pages of a mapped file are given back this many bytes at a time.
+#define JAGJSONReaderDiscardSize        (1024 * 1024)
+
+typedef enum {
+    //Expecting a value: at the top level, after a colon, or after a comma in an array.
+    JAGReaderStateValue,
+    JAGReaderStateObjectStart,
+    JAGReaderStateArrayStart,
+    //Expecting a key, after a comma in an object.
+    JAGReaderStateKey,
+    JAGReaderStateAfterValue
+} JAGReaderState;
+
+@implementation JAGJSONReader
+{
+@private
+    NSData              *_data;
+    NSInputStream       *_stream;
+    //A mapped file, and how much of it has been given back.
+    void                *_mapping;
+    size_t              _mappingLength;
+    size_t              _discarded;
+    uint8_t             *_buffer;
+    NSUInteger          _bufferSize;
+    const uint8_t       *_start;
+    const uint8_t       *_pos;
+    const uint8_t       *_end;
+    NSUInteger          _consumed;
+
+    JAGReaderState      _state;
+    //One byte per open container, '{' or '['.
+    uint8_t             *_stack;
+    NSUInteger          _stackCapacity;
+
+    //The decoded bytes of the current string, or the text of the current number.
+    char                *_string;
+    //_string, or the string's bytes in the input when it needed no decoding.
+    const char          *_stringBytes;
+    NSUInteger          _stringLength;
+    NSUInteger          _stringCapacity;
+
+    JAGParsedNumber     _number;
+}
+
+@synthesize error = _error;
+@synthesize depth = _depth;
+
+- (id) initWithData: (NSData *) data {
+    self = [self initWithInputStream:nil bufferSize:0];
+    if (self) {
+        _data = data;
+        _start = _pos = [data bytes];
+        _end = _start + [data length];
+    }
+    return self;
+}
+
+- (id) initWithContentsOfMappedFile: (NSString *) path error: (NSError **) error {
+    self = [self initWithInputStream:nil bufferSize:0];
+    if (self) {
+        int fd = open([path fileSystemRepresentation], O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            if (error) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            if (fd >= 0) close(fd);
+            return nil;
+        }
+        //An empty file can't be mapped, and reads as unexpected end of input.
+        if (info.st_size > 0) {
+            _mappingLength = (size_t) info.st_size;
+            _mapping = mmap(NULL, _mappingLength, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (_mapping == MAP_FAILED) {
+                _mapping = NULL;
+                if (error) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+                close(fd);
+                return nil;
+            }
+            madvise(_mapping, _mappingLength, MADV_SEQUENTIAL);
+        }
+        close(fd);
+        _start = _pos = _mapping;
+        _end = _start + _mappingLength;
+    }
+    return self;
+}
+
+- (id) initWithInputStream: (NSInputStream *) stream bufferSize: (NSUInteger) bufferSize {
+    self = [super init];
+    if (self) {
+        _stream = stream;
+        if (stream) {
+            _bufferSize = bufferSize ? bufferSize : 64 * 1024;
+            _buffer = malloc(_bufferSize);
+            _start = _pos = _end = _buffer;
+        }
+        _state = JAGReaderStateValue;
+        _stackCapacity = 16;
+        _stack = malloc(_stackCapacity);
+        _stringCapacity = JAGJSONReaderInitialCapacity;
+        _string = malloc(_stringCapacity);
+        _stringBytes = _string;
+    }
+    return self;
+}
+
+- (void) dealloc {
+    if (_mapping) munmap(_mapping, _mappingLength);
+    free(_buffer);
+    free(_stack);
+    free(_string);
+}
+
+- (NSUInteger) offset {
+    return _consumed + (NSUInteger)(_pos - _start);
+}
+
+#pragma mark - Input
+
+- (void) discardConsumedInput {
+    if (!_mapping) return;
+    size_t consumed = (size_t)(_pos - _start);
+    if (consumed - _discarded < JAGJSONReaderDiscardSize) return;
+    //Whole pages only; the page under _pos may still be needed.
+    size_t page = (size_t) getpagesize();
+    size_t end = consumed & ~(page - 1);
+    madvise((uint8_t *) _mapping + _discarded, end - _discarded, MADV_DONTNEED);
+    _discarded = end;
+}
+
+/*
+ * Refill the buffer from the stream.  Returns NO at the end of input or on a stream error.
+ */
+static BOOL JAGReaderFill(JAGJSONReader *reader) {
+    if (!reader->_stream || reader->_error) return NO;
+    reader->_consumed += (NSUInteger)(reader->_end - reader->_start);
+    reader->_start = reader->_pos = reader->_end = reader->_buffer;
+    NSInteger count = [reader->_stream read:reader->_buffer maxLength:reader->_bufferSize];
+    if (count < 0) {
+        reader->_error = [reader->_stream streamError];
+        if (!reader->_error) {
+            reader->_error = [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil];
+        }
+        return NO;
+    }
+    reader->_end = reader->_buffer + count;
+    return count > 0;
+}
+
+//The next byte without consuming it, or -1 at the end of input.
+static inline int JAGReaderPeek(JAGJSONReader *reader) {
+    if (reader->_pos == reader->_end && !JAGReaderFill(reader)) return -1;
+    return *reader->_pos;
+}
+
+static inline int JAGReaderNextByte(JAGJSONReader *reader) {
+    if (reader->_pos == reader->_end && !JAGReaderFill(reader)) return -1;
+    return *reader->_pos++;
+}
+
+static inline int JAGReaderPeekNonWhitespace(JAGJSONReader *reader) {
+    for (;;) {
+        int c = JAGReaderPeek(reader);
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return c;
+        reader->_pos++;
+    }
+}
+
+static JAGJSONToken JAGReaderFail(JAGJSONReader *reader, JAGJSONReaderErrorCode code, NSString *reason) {
+    //Keep the first error, which may be the stream's.
+    if (!reader->_error) {
+        NSString *description = [NSString stringWithFormat:@"%@ at byte %lu.", reason, (unsigned long)[reader offset]];
+        reader->_error = [NSError errorWithDomain:JAGJSONReaderErrorDomain
+                                             code:code
+                                         userInfo:[NSDictionary dictionaryWithObject:description
+                                                                              forKey:NSLocalizedDescriptionKey]];
+    }
+    return JAGJSONTokenError;
+}
+
+#pragma mark - Strings
+
+static inline void JAGReaderAppend(JAGJSONReader *reader, const void *bytes, NSUInteger length) {
+    if (reader->_stringLength + length > reader->_stringCapacity) {
+        NSUInteger capacity = reader->_stringCapacity;
+        while (reader->_stringLength + length > capacity) capacity *= 2;
+        reader->_string = realloc(reader->_string, capacity);
+        reader->_stringBytes = reader->_string;
+        reader->_stringCapacity = capacity;
+    }
+    memcpy(reader->_string + reader->_stringLength, bytes, length);
+    reader->_stringLength += length;
+}
+
+static int JAGReaderHexQuad(JAGJSONReader *reader) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = JAGReaderNextByte(reader);
+        if (c >= '0' && c <= '9') value = value * 16 + (c - '0');
+        else if (c >= 'a' && c <= 'f') value = value * 16 + (c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') value = value * 16 + (c - 'A' + 10);
+        else return -1;
+    }
+    return value;
+}
+
+static void JAGReaderAppendCodePoint(JAGJSONReader *reader, uint32_t code) {
+    uint8_t utf8[4];
+    NSUInteger length;
+    if (code < 0x80) {
+        utf8[0] = (uint8_t)code;
+        length = 1;
+    } else if (code < 0x800) {
+        utf8[0] = (uint8_t)(0xc0 | (code >> 6));
+        utf8[1] = (uint8_t)(0x80 | (code & 0x3f));
+        length = 2;
+    } else if (code < 0x10000) {
+        utf8[0] = (uint8_t)(0xe0 | (code >> 12));
+        utf8[1] = (uint8_t)(0x80 | ((code >> 6) & 0x3f));
+        utf8[2] = (uint8_t)(0x80 | (code & 0x3f));
+        length = 3;
+    } else {
+        utf8[0] = (uint8_t)(0xf0 | (code >> 18));
+        utf8[1] = (uint8_t)(0x80 | ((code >> 12) & 0x3f));
+        utf8[2] = (uint8_t)(0x80 | ((code >> 6) & 0x3f));
+        utf8[3] = (uint8_t)(0x80 | (code & 0x3f));
+        length = 4;
+    }
+    JAGReaderAppend(reader, utf8, length);
+}
+
+/*
+ * Decode a string into _string, unless it can be used in place.  The opening quote has been consumed.
+ */
+static BOOL JAGReaderScanString(JAGJSONReader *reader) {
+    reader->_stringLength = 0;
+    reader->_stringBytes = reader->_string;
+    if (!reader->_stream) {
+        //In memory, a string without escapes can be used where it is.
+        const uint8_t *p = reader->_pos;
+        while (p < reader->_end && *p != '"' && *p != '\\' && *p >= 0x20) p++;
+        if (p < reader->_end && *p == '"') {
+            reader->_stringBytes = (const char *) reader->_pos;
+            reader->_stringLength = (NSUInteger)(p - reader->_pos);
+            reader->_pos = p + 1;
+            return YES;
+        }
+    }
+    for (;;) {
+        if (reader->_pos == reader->_end && !JAGReaderFill(reader)) {
+            JAGReaderFail(reader, JAGJSONReaderErrorUnexpectedEnd, @"Unterminated string");
+            return NO;
+        }
+        //Copy the run of plain bytes in one go.
+        const uint8_t *run = reader->_pos;
+        const uint8_t *p = run;
+        while (p < reader->_end && *p != '"' && *p != '\\' && *p >= 0x20) p++;
+        JAGReaderAppend(reader, run, (NSUInteger)(p - run));
+        reader->_pos = p;
+        if (p == reader->_end) continue;
+
+        uint8_t c = *reader->_pos++;
+        if (c == '"') return YES;
+        if (c != '\\') {
+            JAGReaderFail(reader, JAGJSONReaderErrorInvalidString, @"Unescaped control character in string");
+            return NO;
+        }
+        int escape = JAGReaderNextByte(reader);
+        char decoded;
+        switch (escape) {
+            case '"':   decoded = '"'; break;
+            case '\\':  decoded = '\\'; break;
+            case '/':   decoded = '/'; break;
+            case 'b':   decoded = '\b'; break;
+            case 'f':   decoded = '\f'; break;
+            case 'n':   decoded = '\n'; break;
+            case 'r':   decoded = '\r'; break;
+            case 't':   decoded = '\t'; break;
+            case 'u': {
+                int code = JAGReaderHexQuad(reader);
+                if (code >= 0xdc00 && code <= 0xdfff) code = -1;
+                if (code >= 0xd800 && code <= 0xdbff) {
+                    //A high surrogate must be followed by an escaped low surrogate.
+                    int low = -1;
+                    if (JAGReaderNextByte(reader) == '\\' && JAGReaderNextByte(reader) == 'u') {
+                        low = JAGReaderHexQuad(reader);
+                    }
+                    code = (low >= 0xdc00 && low <= 0xdfff)
+                        ? 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00)
+                        : -1;
+                }
+                if (code < 0) {
+                    JAGReaderFail(reader, JAGJSONReaderErrorInvalidString, @"Invalid \\u escape in string");
+                    return NO;
+                }
+                JAGReaderAppendCodePoint(reader, (uint32_t)code);
+                continue;
+            }
+            default:
+                JAGReaderFail(reader, JAGJSONReaderErrorInvalidString, @"Invalid escape in string");
+                return NO;
+        }
+        JAGReaderAppend(reader, &decoded, 1);
+    }
+}
+
+#pragma mark - Numbers and Literals
+
+static BOOL JAGReaderIsNumberByte(int c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+#define JAGIsDigit(c) ((c) >= '0' && (c) <= '9')
+
+//Whether text follows the JSON number grammar, which is stricter than strtod's.
+static BOOL JAGReaderNumberTextIsValid(const char *p) {
+    if (*p == '-') p++;
+    if (*p == '0') {
+        p++;
+    } else if (JAGIsDigit(*p)) {
+        while (JAGIsDigit(*p)) p++;
+    } else {
+        return NO;
+    }
+    if (*p == '.') {
+        p++;
+        if (!JAGIsDigit(*p)) return NO;
+        while (JAGIsDigit(*p)) p++;
+    }
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        if (*p == '+' || *p == '-') p++;
+        if (!JAGIsDigit(*p)) return NO;
+        while (JAGIsDigit(*p)) p++;
+    }
+    return *p == '\0';
+}
+
+/*
+ * Read the text of a number into _string and parse it.
+ */
+static BOOL JAGReaderScanNumber(JAGJSONReader *reader) {
+    reader->_stringLength = 0;
+    reader->_stringBytes = reader->_string;
+    int c;
+    while ((c = JAGReaderPeek(reader)) >= 0 && JAGReaderIsNumberByte(c)) {
+        char byte = (char)c;
+        JAGReaderAppend(reader, &byte, 1);
+        reader->_pos++;
+    }
+    char terminator = '\0';
+    JAGReaderAppend(reader, &terminator, 1);
+    reader->_stringLength--;
+
+    const char *text = reader->_string;
+    if (!JAGReaderNumberTextIsValid(text)) {
+        JAGReaderFail(reader, JAGJSONReaderErrorSyntax, @"Invalid number");
+        return NO;
+    }
+    //The grammar is checked, so this can't fail.  It doesn't depend on the locale.
+    JAGParseNumberBytes(text, reader->_stringLength, &reader->_number);
+    return YES;
+}
+
+static BOOL JAGReaderScanLiteral(JAGJSONReader *reader, const char *literal) {
+    for (const char *p = literal; *p; p++) {
+        if (JAGReaderNextByte(reader) != *p) {
+            JAGReaderFail(reader, JAGJSONReaderErrorSyntax, @"Invalid literal");
+            return NO;
+        }
+    }
+    return YES;
+}
+
+#pragma mark - Tokens
+
+static JAGJSONToken JAGReaderPush(JAGJSONReader *reader, uint8_t container) {
+    if (reader->_depth >= JAGJSONReaderMaxDepth) {
+        return JAGReaderFail(reader, JAGJSONReaderErrorTooDeep, @"Too many nested objects and arrays");
+    }
+    if (reader->_depth == reader->_stackCapacity) {
+        reader->_stackCapacity *= 2;
+        reader->_stack = realloc(reader->_stack, reader->_stackCapacity);
+    }
+    reader->_stack[reader->_depth++] = container;
+    reader->_pos++;
+    if (container == '{') {
+        reader->_state = JAGReaderStateObjectStart;
+        return JAGJSONTokenBeginObject;
+    } else {
+        reader->_state = JAGReaderStateArrayStart;
+        return JAGJSONTokenBeginArray;
+    }
+}
+
+static JAGJSONToken JAGReaderPop(JAGJSONReader *reader) {
+    reader->_pos++;
+    reader->_state = JAGReaderStateAfterValue;
+    return reader->_stack[--reader->_depth] == '{' ? JAGJSONTokenEndObject : JAGJSONTokenEndArray;
+}
+
+static JAGJSONToken JAGReaderScanValue(JAGJSONReader *reader, int c) {
+    switch (c) {
+        case '{':
+        case '[':
+            return JAGReaderPush(reader, (uint8_t)c);
+        case '"':
+            reader->_pos++;
+            if (!JAGReaderScanString(reader)) return JAGJSONTokenError;
+            reader->_state = JAGReaderStateAfterValue;
+            return JAGJSONTokenString;
+        case 't':
+            if (!JAGReaderScanLiteral(reader, "true")) return JAGJSONTokenError;
+            reader->_state = JAGReaderStateAfterValue;
+            return JAGJSONTokenTrue;
+        case 'f':
+            if (!JAGReaderScanLiteral(reader, "false")) return JAGJSONTokenError;
+            reader->_state = JAGReaderStateAfterValue;
+            return JAGJSONTokenFalse;
+        case 'n':
+            if (!JAGReaderScanLiteral(reader, "null")) return JAGJSONTokenError;
+            reader->_state = JAGReaderStateAfterValue;
+            return JAGJSONTokenNull;
+        case -1:
+            return JAGReaderFail(reader, JAGJSONReaderErrorUnexpectedEnd, @"Unexpected end of input");
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                if (!JAGReaderScanNumber(reader)) return JAGJSONTokenError;
+                reader->_state = JAGReaderStateAfterValue;
+                return JAGJSONTokenNumber;
+            }
+            return JAGReaderFail(reader, JAGJSONReaderErrorSyntax, @"Unexpected character");
+    }
+}
+
+static JAGJSONToken JAGReaderScanKey(JAGJSONReader *reader, int c) {
+    if (c != '"') {
+        return c < 0
+            ? JAGReaderFail(reader, JAGJSONReaderErrorUnexpectedEnd, @"Unexpected end of input")
+            : JAGReaderFail(reader, JAGJSONReaderErrorSyntax, @"Expected a string key");
+    }
+    reader->_pos++;
+    if (!JAGReaderScanString(reader)) return JAGJSONTokenError;
+    if (JAGReaderPeekNonWhitespace(reader) != ':') {
+        return JAGReaderFail(reader, JAGJSONReaderErrorSyntax, @"Expected ':' after key");
+    }
+    reader->_pos++;
+    reader->_state = JAGReaderStateValue;
+    return JAGJSONTokenKey;
+}
+
+- (JAGJSONToken) nextToken {
+    if (_error) return JAGJSONTokenError;
+    int c = JAGReaderPeekNonWhitespace(self);
+    switch (_state) {
+        case JAGReaderStateValue:
+            return JAGReaderScanValue(self, c);
+        case JAGReaderStateObjectStart:
+            return c == '}' ? JAGReaderPop(self) : JAGReaderScanKey(self, c);
+        case JAGReaderStateArrayStart:
+            return c == ']' ? JAGReaderPop(self) : JAGReaderScanValue(self, c);
+        case JAGReaderStateKey:
+            return JAGReaderScanKey(self, c);
+        case JAGReaderStateAfterValue:
+        default: {
+            if (_depth == 0) {
+                if (c < 0) return _error ? JAGJSONTokenError : JAGJSONTokenEnd;
+                return JAGReaderFail(self, JAGJSONReaderErrorSyntax, @"Unexpected data after JSON value");
+            }
+            uint8_t container = _stack[_depth - 1];
+            if (c == ',') {
+                _pos++;
+                c = JAGReaderPeekNonWhitespace(self);
+                return container == '{' ? JAGReaderScanKey(self, c) : JAGReaderScanValue(self, c);
+            }
+            if ((container == '{' && c == '}') || (container == '[' && c == ']')) {
+                return JAGReaderPop(self);
+            }
+            if (c < 0) {
+                return JAGReaderFail(self, JAGJSONReaderErrorUnexpectedEnd, @"Unexpected end of input");
+            }
+            return JAGReaderFail(self, JAGJSONReaderErrorSyntax,
+                                 container == '{' ? @"Expected ',' or '}'" : @"Expected ',' or ']'");
+        }
+    }
+}
+
+#pragma mark - Values
+
+- (NSString *) stringValue {
+    return [[NSString alloc] initWithBytes:_stringBytes length:_stringLength encoding:NSUTF8StringEncoding];
+}
+
+- (const char *) stringBytes {
+    return _stringBytes;
+}
+
+- (NSUInteger) stringLength {
+    return _stringLength;
+}
+
+- (BOOL) numberIsInteger {
+    return _number.kind == JAGParsedNumberLongLong || _number.kind == JAGParsedNumberUnsignedLongLong;
+}
+
+- (long long) longLongValue {
+    return _number.longLongValue;
+}
+
+- (double) doubleValue {
+    return _number.doubleValue;
+}
+
+- (const JAGParsedNumber *) parsedNumber {
+    return &_number;
+}
+
+- (NSNumber *) numberValue {
+    return JAGNumberFromParsedNumber(&_number);
+}
+
+- (id) objectValueForToken: (JAGJSONToken) token {
+    switch (token) {
+        case JAGJSONTokenBeginObject: {
+            NSMutableDictionary *dictionary = [NSMutableDictionary dictionary];
+            for (;;) {
+                token = [self nextToken];
+                if (token == JAGJSONTokenEndObject) return dictionary;
+                if (token != JAGJSONTokenKey) return nil;
+                NSString *key = [self objectValueForToken:token];
+                if (!key) return nil;
+                id value = [self objectValueForToken:[self nextToken]];
+                if (!value) return nil;
+                [dictionary setObject:value forKey:key];
+            }
+        }
+        case JAGJSONTokenBeginArray: {
+            NSMutableArray *array = [NSMutableArray array];
+            for (;;) {
+                token = [self nextToken];
+                if (token == JAGJSONTokenEndArray) return array;
+                id value = [self objectValueForToken:token];
+                if (!value) return nil;
+                [array addObject:value];
+            }
+        }
+        case JAGJSONTokenKey:
+        case JAGJSONTokenString: {
+            NSString *string = [self stringValue];
+            if (!string) {
+                JAGReaderFail(self, JAGJSONReaderErrorInvalidString, @"String is not valid UTF-8");
+            }
+            return string;
+        }
+        case JAGJSONTokenNumber:
+            return [self numberValue];
+        case JAGJSONTokenTrue:
+            return [NSNumber numberWithBool:YES];
+        case JAGJSONTokenFalse:
+            return [NSNumber numberWithBool:NO];
+        case JAGJSONTokenNull:
+            return [NSNull null];
+        default:
+            return nil;
+    }
+}
+
+- (BOOL) skipValueForToken: (JAGJSONToken) token {
+    switch (token) {
+        case JAGJSONTokenBeginObject:
+        case JAGJSONTokenBeginArray: {
+            //The container is open, so we're done when depth drops below it.
+            NSUInteger depth = _depth;
+            while (_depth >= depth) {
+                token = [self nextToken];
+                if (token == JAGJSONTokenError || token == JAGJSONTokenEnd) return NO;
+            }
+            return YES;
+        }
+        case JAGJSONTokenString:
+        case JAGJSONTokenNumber:
+        case JAGJSONTokenTrue:
+        case JAGJSONTokenFalse:
+        case JAGJSONTokenNull:
+            return YES;
+        default:
+            return NO;
+    }
+}
+
+@end
@@ -0,0 +1,141 @@
+//
+//  JAGJSONWriter.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "JAGStructuredWriter.h"
+
+///The error domain for objects that can't be written as JSON.  Stream errors are passed through unchanged.
+extern NSString * const JAGJSONWriterErrorDomain;
+
+typedef enum {
+    JAGJSONWriterErrorInvalidObject = 1
+} JAGJSONWriterErrorCode;
+
+/**
+   JAGJSONWriter writes UTF-8 JSON text into a growable byte buffer,
+   optionally flushing it to an NSOutputStream in chunks.
+
+   It is a low-level writer: it handles separators and string escaping,
+   but not validity, so callers are responsible for balancing
+   beginObject/endObject and beginArray/endArray, and for writing a key
+   before each value inside an object.  Keys are written lazily, along with
+   the next value or container, so a caller can write a key and then decide
+   not to write a value for it.
+
+     JAGJSONWriter *writer = [[JAGJSONWriter alloc] init];
+     [writer beginObject];
+     [writer writeKey:@"name"];
+     [writer writeString:@"Jane Smith"];
+     [writer writeKey:@"skipped"];
+     [writer writeKey:@"userID"];
+     [writer writeLongLong:1234];
+     [writer endObject];
+     NSData *json = [writer takeData];
+     // {"name":"Jane Smith","userID":1234}
+
+   JAGPropertyConverter uses a JAGJSONWriter to encode models directly to JSON;
+   see [JAGPropertyConverter JSONDataFromObject:].
+ */
+@interface JAGJSONWriter : NSObject <JAGStructuredWriter>
+
+/**
+ * A writer that accumulates the whole document in memory.
+ * Use takeData to get the result.
+ */
+- (id) init;
+
+/**
+ * A writer that flushes to stream whenever at least chunkSize bytes are buffered.
+ *
+ * @param stream An open NSOutputStream.
+ * @param chunkSize Number of bytes to buffer before writing to the stream.
+ */
+- (id) initWithOutputStream: (NSOutputStream *) stream chunkSize: (NSUInteger) chunkSize;
+
+/// The error from the output stream, if writing to it failed.
+@property (nonatomic, readonly, strong) NSError *error;
+
+/// Number of bytes written so far, whether buffered or flushed.
+@property (nonatomic, readonly) NSUInteger bytesWritten;
+
+- (void) beginObject;
+- (void) endObject;
+/// The same as beginObject, for JAGStructuredWriter.
+- (void) beginMap;
+/// The same as endObject, for JAGStructuredWriter.
+- (void) endMap;
+- (void) beginArray;
+- (void) endArray;
+
+/**
+ * Set the key for the next value in the current object.
+ *
+ * Nothing is written until the next value or container is begun;
+ * another call to writeKey: replaces the pending key.
+ */
+- (void) writeKey: (NSString *) key;
+
+- (void) writeString: (NSString *) string;
+- (void) writeNull;
+- (void) writeBool: (BOOL) value;
+- (void) writeLongLong: (long long) value;
+- (void) writeUnsignedLongLong: (unsigned long long) value;
+
+/**
+ * Write a float, using the shortest representation that reads back as the
+ * same float, as NSJSONSerialization does for a float NSNumber.
+ *
+ * @return NO (writing nothing) if value is NaN or infinite, which JSON can't represent.
+ */
+- (BOOL) writeFloat: (float) value;
+
+/**
+ * Write a double, using the shortest representation that round-trips.
+ *
+ * @return NO (writing nothing) if value is NaN or infinite, which JSON can't represent.
+ */
+- (BOOL) writeDouble: (double) value;
+
+/**
+ * Write an NSNumber as a JSON boolean, integer, or floating-point number.
+ *
+ * @return NO (writing nothing) if number is NaN or infinite.
+ */
+- (BOOL) writeNumber: (NSNumber *) number;
+
+/**
+ * Write any buffered bytes to the output stream.
+ *
+ * @return NO if the stream reported an error; see error.
+ */
+- (BOOL) flush;
+
+/**
+ * The buffered bytes, handed over without copying.  The writer's buffer is emptied.
+ *
+ * @return The JSON text written since the last takeData or flush.
+ */
+- (NSData *) takeData;
+
+@end
@@ -0,0 +1,344 @@
+//
+//  JAGJSONWriter.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGJSONWriter.h"
+#import "JAGNumberParser.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+NSString * const JAGJSONWriterErrorDomain = @"JAGJSONWriterErrorDomain";
+
+#define JAGJSONWriterInitialCapacity    4096
+#define JAGJSONWriterScratchCapacity    4096
+
+static const char JAGHexDigits[] = "0123456789abcdef";
+
+@implementation JAGJSONWriter
+{
+@private
+    uint8_t         *_bytes;
+    NSUInteger      _length;
+    NSUInteger      _capacity;
+    uint8_t         *_scratch;
+    NSOutputStream  *_stream;
+    NSUInteger      _chunkSize;
+    NSUInteger      _flushedLength;
+    NSString        *_pendingKey;
+    BOOL            _needsComma;
+}
+
+@synthesize error = _error;
+
+- (id) init {
+    return [self initWithOutputStream:nil chunkSize:0];
+}
+
+- (id) initWithOutputStream: (NSOutputStream *) stream chunkSize: (NSUInteger) chunkSize {
+    self = [super init];
+    if (self) {
+        _stream = stream;
+        _chunkSize = chunkSize ? chunkSize : 64 * 1024;
+        _capacity = JAGJSONWriterInitialCapacity;
+        _bytes = malloc(_capacity);
+        _scratch = malloc(JAGJSONWriterScratchCapacity);
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_bytes);
+    free(_scratch);
+}
+
+- (NSUInteger) bytesWritten {
+    return _flushedLength + _length;
+}
+
+#pragma mark - Buffer
+
+static inline void JAGWriterReserve(JAGJSONWriter *writer, NSUInteger extra) {
+    if (writer->_length + extra <= writer->_capacity) return;
+    NSUInteger capacity = writer->_capacity ? writer->_capacity : JAGJSONWriterInitialCapacity;
+    while (writer->_length + extra > capacity) capacity *= 2;
+    writer->_bytes = realloc(writer->_bytes, capacity);
+    writer->_capacity = capacity;
+}
+
+static inline void JAGWriterAppend(JAGJSONWriter *writer, const void *bytes, NSUInteger length) {
+    JAGWriterReserve(writer, length);
+    memcpy(writer->_bytes + writer->_length, bytes, length);
+    writer->_length += length;
+}
+
+static inline void JAGWriterAppendByte(JAGJSONWriter *writer, uint8_t byte) {
+    JAGWriterReserve(writer, 1);
+    writer->_bytes[writer->_length++] = byte;
+}
+
+- (BOOL) flush {
+    if (!_stream || _error) return _error == nil;
+    NSUInteger offset = 0;
+    while (offset < _length) {
+        NSInteger written = [_stream write:_bytes + offset maxLength:_length - offset];
+        if (written <= 0) {
+            _error = [_stream streamError];
+            if (!_error) {
+                _error = [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil];
+            }
+            break;
+        }
+        offset += written;
+    }
+    _flushedLength += offset;
+    _length = 0;
+    return _error == nil;
+}
+
+- (NSData *) takeData {
+    NSData *data = [[NSData alloc] initWithBytesNoCopy:_bytes length:_length freeWhenDone:YES];
+    _flushedLength += _length;
+    _length = 0;
+    _capacity = JAGJSONWriterInitialCapacity;
+    _bytes = malloc(_capacity);
+    return data;
+}
+
+/*
+ * Write the comma and pending key (if any) that precede a value.
+ */
+- (void) beginValue {
+    if (_needsComma) {
+        JAGWriterAppendByte(self, ',');
+    }
+    if (_pendingKey) {
+        NSString *key = _pendingKey;
+        _pendingKey = nil;
+        [self appendQuotedString:key];
+        JAGWriterAppendByte(self, ':');
+    }
+    _needsComma = NO;
+}
+
+- (void) endValue {
+    _needsComma = YES;
+    if (_stream && _length >= _chunkSize) {
+        [self flush];
+    }
+}
+
+#pragma mark - Containers
+
+- (void) beginObject {
+    [self beginValue];
+    JAGWriterAppendByte(self, '{');
+}
+
+- (void) endObject {
+    _pendingKey = nil;
+    JAGWriterAppendByte(self, '}');
+    [self endValue];
+}
+
+- (void) beginMap {
+    [self beginObject];
+}
+
+- (void) endMap {
+    [self endObject];
+}
+
+- (void) beginArray {
+    [self beginValue];
+    JAGWriterAppendByte(self, '[');
+}
+
+- (void) endArray {
+    JAGWriterAppendByte(self, ']');
+    [self endValue];
+}
+
+- (void) writeKey: (NSString *) key {
+    _pendingKey = key;
+}
+
+#pragma mark - Scalars
+
+/*
+ * Copy UTF-8 bytes into the buffer, escaping them for a JSON string.
+ */
+- (void) appendEscapedUTF8: (const uint8_t *) bytes length: (NSUInteger) length {
+    NSUInteger runStart = 0;
+    for (NSUInteger i = 0; i < length; i++) {
+        uint8_t c = bytes[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        JAGWriterAppend(self, bytes + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':  JAGWriterAppend(self, "\\\"", 2); break;
+            case '\\': JAGWriterAppend(self, "\\\\", 2); break;
+            case '\n': JAGWriterAppend(self, "\\n", 2); break;
+            case '\r': JAGWriterAppend(self, "\\r", 2); break;
+            case '\t': JAGWriterAppend(self, "\\t", 2); break;
+            case '\b': JAGWriterAppend(self, "\\b", 2); break;
+            case '\f': JAGWriterAppend(self, "\\f", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', JAGHexDigits[c >> 4], JAGHexDigits[c & 0xf] };
+                JAGWriterAppend(self, escape, 6);
+                break;
+            }
+        }
+    }
+    JAGWriterAppend(self, bytes + runStart, length - runStart);
+}
+
+- (void) appendQuotedString: (NSString *) string {
+    JAGWriterAppendByte(self, '"');
+    NSRange range = NSMakeRange(0, [string length]);
+    while (range.length > 0) {
+        NSUInteger used = 0;
+        NSRange remaining;
+        BOOL converted = [string getBytes:_scratch
+                                maxLength:JAGJSONWriterScratchCapacity
+                               usedLength:&used
+                                 encoding:NSUTF8StringEncoding
+                                  options:NSStringEncodingConversionAllowLossy
+                                    range:range
+                           remainingRange:&remaining];
+        if (!converted || used == 0) break;
+        [self appendEscapedUTF8:_scratch length:used];
+        range = remaining;
+    }
+    JAGWriterAppendByte(self, '"');
+}
+
+- (void) writeString: (NSString *) string {
+    [self beginValue];
+    [self appendQuotedString:string];
+    [self endValue];
+}
+
+- (void) writeNull {
+    [self beginValue];
+    JAGWriterAppend(self, "null", 4);
+    [self endValue];
+}
+
+- (void) writeBool: (BOOL) value {
+    [self beginValue];
+    if (value) {
+        JAGWriterAppend(self, "true", 4);
+    } else {
+        JAGWriterAppend(self, "false", 5);
+    }
+    [self endValue];
+}
+
+- (void) writeLongLong: (long long) value {
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%lld", value);
+    [self beginValue];
+    JAGWriterAppend(self, digits, length);
+    [self endValue];
+}
+
+- (void) writeUnsignedLongLong: (unsigned long long) value {
+    char digits[24];
+    int length = snprintf(digits, sizeof(digits), "%llu", value);
+    [self beginValue];
+    JAGWriterAppend(self, digits, length);
+    [self endValue];
+}
+
+- (BOOL) writeFloat: (float) value {
+    if (!isfinite(value)) return NO;
+    char digits[32];
+    locale_t previous = uselocale(JAGCLocale());
+    //FLT_DECIMAL_DIG (9) digits always read back exactly, but usually fewer do.
+    int length = snprintf(digits, sizeof(digits), "%.7g", value);
+    if (strtof(digits, NULL) != value) {
+        length = snprintf(digits, sizeof(digits), "%.9g", value);
+    }
+    uselocale(previous);
+    [self beginValue];
+    JAGWriterAppend(self, digits, length);
+    [self endValue];
+    return YES;
+}
+
+- (BOOL) writeDouble: (double) value {
+    if (!isfinite(value)) return NO;
+    char digits[32];
+    //JSON's decimal point is always '.', whatever the user's locale says.
+    locale_t previous = uselocale(JAGCLocale());
+    //Use the shortest of the usual precisions that reads back exactly.
+    int length = snprintf(digits, sizeof(digits), "%.15g", value);
+    if (strtod(digits, NULL) != value) {
+        length = snprintf(digits, sizeof(digits), "%.17g", value);
+    }
+    uselocale(previous);
+    [self beginValue];
+    JAGWriterAppend(self, digits, length);
+    [self endValue];
+    return YES;
+}
+
+- (BOOL) writeNumber: (NSNumber *) number {
+    static NSNumber *trueNumber = nil;
+    static NSNumber *falseNumber = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        trueNumber = [NSNumber numberWithBool:YES];
+        falseNumber = [NSNumber numberWithBool:NO];
+    });
+    //Boolean NSNumbers are singletons; anything else created from a BOOL is just an integer.
+    if (number == trueNumber || number == falseNumber) {
+        [self writeBool:[number boolValue]];
+        return YES;
+    }
+    if ([number isKindOfClass:[NSDecimalNumber class]]) {
+        if ([number isEqualToNumber:[NSDecimalNumber notANumber]]) return NO;
+        const char *digits = [[number stringValue] UTF8String];
+        [self beginValue];
+        JAGWriterAppend(self, digits, strlen(digits));
+        [self endValue];
+        return YES;
+    }
+    switch ([number objCType][0]) {
+        case 'f':
+            return [self writeFloat:[number floatValue]];
+        case 'd':
+            return [self writeDouble:[number doubleValue]];
+        case 'Q':
+        case 'L':
+            [self writeUnsignedLongLong:[number unsignedLongLongValue]];
+            return YES;
+        default:
+            [self writeLongLong:[number longLongValue]];
+            return YES;
+    }
+}
+
+@end
@@ -0,0 +1,68 @@
+//
+//  JAGLazyHydrator.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class JAGProperty;
+
+/**
+   JAGLazyHydrator defers setting a model's object properties until their
+   getters are first called.
+
+   The first time a property of a model is deferred, the model's class is
+   changed to a subclass (named `JAGLazy_` followed by the original class name)
+   whose object getters and setters check for deferred work, in the same way
+   Key-Value Observing changes the class of observed objects.  `-class` still
+   returns the original class.  Each deferred property holds a block which
+   sets the property; it is run, once, by the first call to the getter, and
+   discarded if the setter is called first.  Once no properties are deferred,
+   the model is changed back to its original class, so its getters cost no
+   more than they did before, unless something else has changed its class
+   since.
+
+   Hydration is thread-safe: a getter called on several threads at once
+   runs the block on one of them while the others wait for it.
+
+   JAGPropertyConverter uses a JAGLazyHydrator when shouldComposeLazily is set.
+ */
+@interface JAGLazyHydrator : NSObject
+
+/**
+ * Defer setting a property of model until its getter is called.
+ *
+ * @param property An object property of model, with a setter.
+ * @param model The model.  Models whose class was already changed by
+ *     Key-Value Observing can't be made lazy.
+ * @param block Sets the property of the model it is passed.
+ * @return NO if the property can't be deferred; the caller should set it now.
+ */
++ (BOOL) deferProperty: (JAGProperty *) property ofModel: (id) model withBlock: (void (^)(id model)) block;
+
+/// Whether model has properties that are still deferred.
++ (BOOL) hasDeferredProperties: (id) model;
+
+/// Set all of model's deferred properties now, as if each getter had been called.
++ (void) hydrateModel: (id) model;
+
+@end
@@ -0,0 +1,258 @@
+//
+//  JAGLazyHydrator.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGLazyHydrator.h"
+#import "JAGProperty.h"
+#import "JAGClassCodec.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+
+#define JAGLazyClassPrefix "JAGLazy_"
+
+//The key of each lazy model's JAGLazyState associated object.
+static char JAGLazyStateKey;
+
+static pthread_mutex_t gLazyClassLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * The deferred properties of one lazy model.
+ */
+@interface JAGLazyState : NSObject
+{
+@public
+    Class _originalClass;
+    //Recursive, since a block sets its property through the lazy setter.
+    pthread_mutex_t _lock;
+    //Read without the lock, so getters of hydrated models stay cheap.
+    volatile int _pendingCount;
+    //Getter selector to the block that sets the property.
+    CFMutableDictionaryRef _blocksByGetter;
+    //Setter selector to getter selector, for the deferred properties.
+    CFMutableDictionaryRef _gettersBySetter;
+    //Set, under the lock, once the model is back in its original class.
+    BOOL _restored;
+}
+@end
+
+@implementation JAGLazyState
+
+- (id) initWithOriginalClass: (Class) originalClass {
+    self = [super init];
+    if (self) {
+        _originalClass = originalClass;
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&_lock, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+        _blocksByGetter = CFDictionaryCreateMutable(NULL, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        _gettersBySetter = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+    }
+    return self;
+}
+
+- (void) dealloc {
+    CFRelease(_blocksByGetter);
+    CFRelease(_gettersBySetter);
+    pthread_mutex_destroy(&_lock);
+}
+
+/*
+ * Once nothing is deferred, put model back in its original class and drop
+ * the receiver, so its getters no longer pay for laziness.  Left alone if
+ * something else (Key-Value Observing) has since changed its class.  The
+ * caller holds the lock, and a strong reference to the receiver.
+ */
+- (void) restoreIfHydrated: (id) model lazyClass: (Class) lazyClass {
+    if (_pendingCount || _restored || object_getClass(model) != lazyClass) return;
+    _restored = YES;
+    object_setClass(model, _originalClass);
+    objc_setAssociatedObject(model, &JAGLazyStateKey, nil, OBJC_ASSOCIATION_RETAIN);
+}
+
+/*
+ * Run the block deferred for getter, if any.  The lock is held while it
+ * runs, so that other threads calling the getter wait for its value.
+ */
+- (void) hydrate: (id) model getter: (SEL) getter {
+    pthread_mutex_lock(&_lock);
+    void (^block)(id) = (__bridge void (^)(id))CFDictionaryGetValue(_blocksByGetter, getter);
+    if (block) {
+        Class lazyClass = object_getClass(model);
+        CFDictionaryRemoveValue(_blocksByGetter, getter);
+        __sync_fetch_and_sub(&_pendingCount, 1);
+        block(model);
+        [self restoreIfHydrated:model lazyClass:lazyClass];
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+//Forget the block deferred for the property with setter, which is being set.
+- (void) discard: (id) model setter: (SEL) setter {
+    pthread_mutex_lock(&_lock);
+    const void *getter = CFDictionaryGetValue(_gettersBySetter, setter);
+    if (getter && CFDictionaryContainsKey(_blocksByGetter, getter)) {
+        CFDictionaryRemoveValue(_blocksByGetter, getter);
+        __sync_fetch_and_sub(&_pendingCount, 1);
+        [self restoreIfHydrated:model lazyClass:object_getClass(model)];
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+@end
+
+static inline JAGLazyState *JAGLazyStateOf(id model) {
+    return objc_getAssociatedObject(model, &JAGLazyStateKey);
+}
+
+#pragma mark - Lazy Accessors
+
+/*
+ * A model is put back in its original class once hydrated, so these only
+ * see a model without state if another thread restored it after dispatch;
+ * its class is then the original one.
+ */
+
+static id JAGLazyGetter(id self, SEL _cmd) {
+    JAGLazyState *state = JAGLazyStateOf(self);
+    if (!state) {
+        return ((id (*)(id, SEL))class_getMethodImplementation(object_getClass(self), _cmd))(self, _cmd);
+    }
+    if (state->_pendingCount) {
+        [state hydrate:self getter:_cmd];
+    }
+    return ((id (*)(id, SEL))class_getMethodImplementation(state->_originalClass, _cmd))(self, _cmd);
+}
+
+static void JAGLazySetter(id self, SEL _cmd, id value) {
+    JAGLazyState *state = JAGLazyStateOf(self);
+    if (!state) {
+        ((void (*)(id, SEL, id))class_getMethodImplementation(object_getClass(self), _cmd))(self, _cmd, value);
+        return;
+    }
+    if (state->_pendingCount) {
+        [state discard:self setter:_cmd];
+    }
+    ((void (*)(id, SEL, id))class_getMethodImplementation(state->_originalClass, _cmd))(self, _cmd, value);
+}
+
+static Class JAGLazyClass(id self, SEL _cmd) {
+    JAGLazyState *state = JAGLazyStateOf(self);
+    return state ? state->_originalClass : object_getClass(self);
+}
+
+/*
+ * The lazy subclass of originalClass, created the first time it's needed.
+ * It overrides the accessors of every object property up front, so that
+ * codecs built for it call the overrides.
+ */
+static Class JAGLazySubclass(Class originalClass) {
+    const char *originalName = class_getName(originalClass);
+    size_t length = strlen(JAGLazyClassPrefix) + strlen(originalName) + 1;
+    char *name = malloc(length);
+    snprintf(name, length, "%s%s", JAGLazyClassPrefix, originalName);
+
+    pthread_mutex_lock(&gLazyClassLock);
+    Class lazyClass = objc_getClass(name);
+    if (!lazyClass) {
+        lazyClass = objc_allocateClassPair(originalClass, name, 0);
+        if (lazyClass) {
+            for (JAGProperty *property in [[JAGClassCodec codecForClass:originalClass] properties]) {
+                if ([property scalarKind] != JAGPropertyScalarKindObject) continue;
+                SEL getter = [property getter];
+                if (getter && class_respondsToSelector(originalClass, getter)) {
+                    class_addMethod(lazyClass, getter, (IMP)JAGLazyGetter, "@@:");
+                }
+                SEL setter = [property setter];
+                if (![property isReadOnly] && setter && class_respondsToSelector(originalClass, setter)) {
+                    class_addMethod(lazyClass, setter, (IMP)JAGLazySetter, "v@:@");
+                }
+            }
+            class_addMethod(lazyClass, @selector(class), (IMP)JAGLazyClass, "#@:");
+            objc_registerClassPair(lazyClass);
+        }
+    }
+    pthread_mutex_unlock(&gLazyClassLock);
+    free(name);
+    return lazyClass;
+}
+
+#pragma mark - JAGLazyHydrator
+
+@implementation JAGLazyHydrator
+
++ (BOOL) deferProperty: (JAGProperty *) property ofModel: (id) model withBlock: (void (^)(id model)) block {
+    SEL getter = [property getter];
+    SEL setter = [property setter];
+    if (!model || !getter || !setter || [property isReadOnly]) return NO;
+
+    JAGLazyState *state = JAGLazyStateOf(model);
+    if (!state) {
+        Class originalClass = object_getClass(model);
+        //Don't fight Key-Value Observing (or anything else) for the isa.
+        if (originalClass != [model class]) return NO;
+        Class lazyClass = JAGLazySubclass(originalClass);
+        if (!lazyClass || !class_getInstanceMethod(lazyClass, getter)) return NO;
+        state = [[JAGLazyState alloc] initWithOriginalClass:originalClass];
+        objc_setAssociatedObject(model, &JAGLazyStateKey, state, OBJC_ASSOCIATION_RETAIN);
+        object_setClass(model, lazyClass);
+    } else if (!class_getInstanceMethod(object_getClass(model), getter)) {
+        return NO;
+    }
+
+    pthread_mutex_lock(&state->_lock);
+    if (state->_restored) {
+        //Hydrated and restored on another thread since it was looked up.
+        pthread_mutex_unlock(&state->_lock);
+        return [self deferProperty:property ofModel:model withBlock:block];
+    }
+    if (!CFDictionaryContainsKey(state->_blocksByGetter, getter)) {
+        __sync_fetch_and_add(&state->_pendingCount, 1);
+    }
+    CFDictionarySetValue(state->_blocksByGetter, getter, (__bridge const void *)[block copy]);
+    CFDictionarySetValue(state->_gettersBySetter, setter, getter);
+    pthread_mutex_unlock(&state->_lock);
+    return YES;
+}
+
++ (BOOL) hasDeferredProperties: (id) model {
+    JAGLazyState *state = model ? JAGLazyStateOf(model) : nil;
+    return state && state->_pendingCount > 0;
+}
+
++ (void) hydrateModel: (id) model {
+    JAGLazyState *state = model ? JAGLazyStateOf(model) : nil;
+    if (!state) return;
+    pthread_mutex_lock(&state->_lock);
+    CFIndex count = CFDictionaryGetCount(state->_blocksByGetter);
+    const void **getters = malloc((count + 1) * sizeof(void *));
+    CFDictionaryGetKeysAndValues(state->_blocksByGetter, getters, NULL);
+    for (CFIndex i = 0; i < count; i++) {
+        [state hydrate:model getter:(SEL)getters[i]];
+    }
+    free(getters);
+    pthread_mutex_unlock(&state->_lock);
+}
+
+@end
@@ -0,0 +1,109 @@
+//
+//  JAGMessagePackReader.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+///The error domain for malformed MessagePack.
+extern NSString * const JAGMessagePackReaderErrorDomain;
+
+typedef enum {
+    JAGMessagePackReaderErrorInvalidType = 1,
+    JAGMessagePackReaderErrorUnexpectedEnd,
+    JAGMessagePackReaderErrorInvalidString,
+    JAGMessagePackReaderErrorInvalidKey,
+    JAGMessagePackReaderErrorTooDeep,
+    JAGMessagePackReaderErrorTrailingData,
+    JAGMessagePackReaderErrorInvalidHeader
+} JAGMessagePackReaderErrorCode;
+
+/**
+   JAGMessagePackReader decodes MessagePack into Foundation objects.
+
+   Maps become NSMutableDictionaries, arrays NSMutableArrays, binary NSData,
+   timestamps NSDates, and nil NSNull.  Integers and floats become NSNumbers
+   of the same width, so NaN and infinities survive.  Extension types other
+   than timestamps are read as NSNull.
+
+     JAGMessagePackReader *reader = [[JAGMessagePackReader alloc] initWithData:data];
+     NSDictionary *dict = [reader readObject];
+     if (!dict) NSLog(@"Bad MessagePack: %@", reader.error);
+
+   JAGPropertyConverter uses a JAGMessagePackReader to compose models from MessagePack;
+   see [JAGPropertyConverter composeModelFromMessagePackData:ofClass:error:].
+ */
+@interface JAGMessagePackReader : NSObject
+
+/**
+ * A reader over data, which is retained but not copied.
+ */
+- (id) initWithData: (NSData *) data;
+
+/// The reason readObject last returned nil, or nil.
+@property (nonatomic, readonly, strong) NSError *error;
+
+/// The number of bytes of input.
+@property (nonatomic, readonly) NSUInteger length;
+
+/// The number of bytes of input consumed so far.
+@property (nonatomic, readonly) NSUInteger offset;
+
+/// Whether all of the input has been read.
+@property (nonatomic, readonly, getter = isAtEnd) BOOL atEnd;
+
+/**
+ * Read the next whole value.
+ *
+ * @return The value, or nil if the input is malformed or at its end; then error is set.
+ */
+- (id) readObject;
+
+/**
+ * Read a value that makes up the rest of the input.
+ *
+ * @return The value, or nil if the input is malformed or has bytes after the value.
+ */
+- (id) readEntireObject;
+
+/**
+ * Read bytes written by [JAGMessagePackWriter writeRawBytes:length:].
+ *
+ * @return A pointer to length bytes of the input, or NULL if there aren't that many.
+ */
+- (const void *) readRawBytesOfLength: (NSUInteger) length;
+
+/**
+ * Read a varint written by [JAGMessagePackWriter writeRawVarint:].
+ *
+ * @return NO if the input ends first or the varint is longer than 64 bits.
+ */
+- (BOOL) readRawVarint: (uint64_t *) value;
+
+/**
+ * Stop reading because a framing format found bad input.
+ *
+ * @param reason Why, for the error's description.
+ */
+- (void) failWithInvalidHeader: (NSString *) reason;
+
+@end
@@ -0,0 +1,331 @@
+//
+//  JAGMessagePackReader.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGMessagePackReader.h"
+#include <limits.h>
+#include <string.h>
+
+NSString * const JAGMessagePackReaderErrorDomain = @"JAGMessagePackReaderErrorDomain";
+
+#define JAGMessagePackReaderMaxDepth    512
+
+//The type of the timestamp extension.
+#define JAGMessagePackTimestampType     (-1)
+
+@implementation JAGMessagePackReader
+{
+@private
+    NSData          *_data;
+    const uint8_t   *_bytes;
+    NSUInteger      _length;
+    NSUInteger      _pos;
+    NSUInteger      _depth;
+}
+
+@synthesize error = _error;
+
+- (id) initWithData: (NSData *) data {
+    self = [super init];
+    if (self) {
+        _data = data;
+        _bytes = [data bytes];
+        _length = [data length];
+    }
+    return self;
+}
+
+- (NSUInteger) length {
+    return _length;
+}
+
+- (NSUInteger) offset {
+    return _pos;
+}
+
+- (BOOL) isAtEnd {
+    return _pos >= _length;
+}
+
+static id JAGMPReaderFail(JAGMessagePackReader *reader, JAGMessagePackReaderErrorCode code, NSString *reason) {
+    if (!reader->_error) {
+        NSString *description = [NSString stringWithFormat:@"%@ at byte %lu.", reason, (unsigned long)reader->_pos];
+        reader->_error = [NSError errorWithDomain:JAGMessagePackReaderErrorDomain
+                                             code:code
+                                         userInfo:[NSDictionary dictionaryWithObject:description
+                                                                              forKey:NSLocalizedDescriptionKey]];
+    }
+    return nil;
+}
+
+//Whether length more bytes are available.
+static inline BOOL JAGMPReaderHas(JAGMessagePackReader *reader, NSUInteger length) {
+    return length <= reader->_length - reader->_pos;
+}
+
+//Read a size-byte big-endian integer; the caller has checked it is there.
+static inline uint64_t JAGMPReaderBigEndian(JAGMessagePackReader *reader, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value = (value << 8) | reader->_bytes[reader->_pos++];
+    }
+    return value;
+}
+
+#pragma mark - Values
+
+- (id) readObject {
+    if (_error) return nil;
+    if (!JAGMPReaderHas(self, 1)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    uint8_t type = _bytes[_pos++];
+
+    if (type <= 0x7f) return [NSNumber numberWithInt:type];
+    if (type >= 0xe0) return [NSNumber numberWithInt:(int8_t)type];
+    if ((type & 0xf0) == 0x80) return [self readMapOfCount:type & 0x0f];
+    if ((type & 0xf0) == 0x90) return [self readArrayOfCount:type & 0x0f];
+    if ((type & 0xe0) == 0xa0) return [self readStringOfLength:type & 0x1f];
+
+    //Sizes of the fixed-width types, indexed by type - 0xc0.  0 means variable.
+    static const uint8_t widths[] = {
+        0, 0, 0, 0,         //nil, (never used), false, true
+        1, 2, 4,            //bin 8/16/32: length widths
+        1, 2, 4,            //ext 8/16/32: length widths
+        4, 8,               //float 32/64
+        1, 2, 4, 8,         //uint 8/16/32/64
+        1, 2, 4, 8,         //int 8/16/32/64
+        1, 2, 4, 8, 16,     //fixext 1/2/4/8/16: data widths (after the type byte)
+        1, 2, 4,            //str 8/16/32: length widths
+        2, 4,               //array 16/32: count widths
+        2, 4                //map 16/32: count widths
+    };
+    int width = widths[type - 0xc0];
+    if (!JAGMPReaderHas(self, width)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    switch (type) {
+        case 0xc0: return [NSNull null];
+        case 0xc2: return [NSNumber numberWithBool:NO];
+        case 0xc3: return [NSNumber numberWithBool:YES];
+        case 0xc4:
+        case 0xc5:
+        case 0xc6:
+            return [self readDataOfLength:JAGMPReaderBigEndian(self, width)];
+        case 0xc7:
+        case 0xc8:
+        case 0xc9: {
+            NSUInteger length = JAGMPReaderBigEndian(self, width);
+            return [self readExtensionOfLength:length];
+        }
+        case 0xca: {
+            uint32_t bits = (uint32_t)JAGMPReaderBigEndian(self, 4);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return [NSNumber numberWithFloat:value];
+        }
+        case 0xcb: {
+            uint64_t bits = JAGMPReaderBigEndian(self, 8);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return [NSNumber numberWithDouble:value];
+        }
+        case 0xcc:
+        case 0xcd:
+        case 0xce:
+            return [NSNumber numberWithLongLong:(long long)JAGMPReaderBigEndian(self, width)];
+        case 0xcf: {
+            uint64_t value = JAGMPReaderBigEndian(self, 8);
+            if (value > LLONG_MAX) return [NSNumber numberWithUnsignedLongLong:value];
+            return [NSNumber numberWithLongLong:(long long)value];
+        }
+        case 0xd0: return [NSNumber numberWithLongLong:(int8_t)JAGMPReaderBigEndian(self, 1)];
+        case 0xd1: return [NSNumber numberWithLongLong:(int16_t)JAGMPReaderBigEndian(self, 2)];
+        case 0xd2: return [NSNumber numberWithLongLong:(int32_t)JAGMPReaderBigEndian(self, 4)];
+        case 0xd3: return [NSNumber numberWithLongLong:(int64_t)JAGMPReaderBigEndian(self, 8)];
+        case 0xd4:
+        case 0xd5:
+        case 0xd6:
+        case 0xd7:
+        case 0xd8:
+            return [self readExtensionOfLength:width];
+        case 0xd9:
+        case 0xda:
+        case 0xdb:
+            return [self readStringOfLength:JAGMPReaderBigEndian(self, width)];
+        case 0xdc:
+        case 0xdd:
+            return [self readArrayOfCount:JAGMPReaderBigEndian(self, width)];
+        case 0xde:
+        case 0xdf:
+            return [self readMapOfCount:JAGMPReaderBigEndian(self, width)];
+        default:
+            _pos--;
+            return JAGMPReaderFail(self, JAGMessagePackReaderErrorInvalidType, @"Invalid type byte");
+    }
+}
+
+- (id) readEntireObject {
+    id object = [self readObject];
+    if (object && !self.atEnd) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorTrailingData, @"Unexpected data after value");
+    }
+    return object;
+}
+
+- (const void *) readRawBytesOfLength: (NSUInteger) length {
+    if (_error) return NULL;
+    if (!JAGMPReaderHas(self, length)) {
+        JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+        return NULL;
+    }
+    const void *bytes = _bytes + _pos;
+    _pos += length;
+    return bytes;
+}
+
+- (BOOL) readRawVarint: (uint64_t *) value {
+    if (_error) return NO;
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (!JAGMPReaderHas(self, 1)) {
+            JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+            return NO;
+        }
+        uint8_t byte = _bytes[_pos++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return YES;
+        }
+    }
+    JAGMPReaderFail(self, JAGMessagePackReaderErrorInvalidHeader, @"Varint is too long");
+    return NO;
+}
+
+- (void) failWithInvalidHeader: (NSString *) reason {
+    JAGMPReaderFail(self, JAGMessagePackReaderErrorInvalidHeader, reason);
+}
+
+- (NSString *) readStringOfLength: (NSUInteger) length {
+    if (!JAGMPReaderHas(self, length)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    NSString *string = [[NSString alloc] initWithBytes:_bytes + _pos length:length encoding:NSUTF8StringEncoding];
+    if (!string) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorInvalidString, @"Invalid UTF-8 in string");
+    }
+    _pos += length;
+    return string;
+}
+
+- (NSData *) readDataOfLength: (NSUInteger) length {
+    if (!JAGMPReaderHas(self, length)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    NSData *data = [NSData dataWithBytes:_bytes + _pos length:length];
+    _pos += length;
+    return data;
+}
+
+/*
+ * Read an extension's type byte and length bytes of data.  Timestamps become
+ * NSDates; other extensions are skipped and read as NSNull.
+ */
+- (id) readExtensionOfLength: (NSUInteger) length {
+    if (!JAGMPReaderHas(self, 1 + length)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    int8_t extensionType = (int8_t)_bytes[_pos++];
+    if (extensionType != JAGMessagePackTimestampType) {
+        _pos += length;
+        return [NSNull null];
+    }
+    uint64_t nanoseconds = 0;
+    int64_t seconds = 0;
+    switch (length) {
+        case 4:
+            seconds = (int64_t)JAGMPReaderBigEndian(self, 4);
+            break;
+        case 8: {
+            uint64_t value = JAGMPReaderBigEndian(self, 8);
+            nanoseconds = value >> 34;
+            seconds = (int64_t)(value & 0x3ffffffffULL);
+            break;
+        }
+        case 12:
+            nanoseconds = JAGMPReaderBigEndian(self, 4);
+            seconds = (int64_t)JAGMPReaderBigEndian(self, 8);
+            break;
+        default:
+            return JAGMPReaderFail(self, JAGMessagePackReaderErrorInvalidType, @"Invalid timestamp length");
+    }
+    return [NSDate dateWithTimeIntervalSince1970:(NSTimeInterval)seconds + nanoseconds / 1e9];
+}
+
+- (NSMutableArray *) readArrayOfCount: (NSUInteger) count {
+    if (_depth >= JAGMessagePackReaderMaxDepth) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorTooDeep, @"Too deeply nested");
+    }
+    //Every element takes at least a byte, so a count larger than the input is malformed.
+    if (!JAGMPReaderHas(self, count)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    _depth++;
+    NSMutableArray *array = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        id value = [self readObject];
+        if (!value) return nil;
+        [array addObject:value];
+    }
+    _depth--;
+    return array;
+}
+
+- (NSMutableDictionary *) readMapOfCount: (NSUInteger) count {
+    if (_depth >= JAGMessagePackReaderMaxDepth) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorTooDeep, @"Too deeply nested");
+    }
+    if (!JAGMPReaderHas(self, count) || !JAGMPReaderHas(self, 2 * count)) {
+        return JAGMPReaderFail(self, JAGMessagePackReaderErrorUnexpectedEnd, @"Unexpected end of input");
+    }
+    _depth++;
+    NSMutableDictionary *dict = [NSMutableDictionary dictionaryWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSUInteger keyOffset = _pos;
+        id key = [self readObject];
+        if (!key) return nil;
+        if (![key conformsToProtocol:@protocol(NSCopying)] || [key isKindOfClass:[NSArray class]]
+            || [key isKindOfClass:[NSDictionary class]]) {
+            _pos = keyOffset;
+            return JAGMPReaderFail(self, JAGMessagePackReaderErrorInvalidKey, @"Map key is a container");
+        }
+        id value = [self readObject];
+        if (!value) return nil;
+        [dict setObject:value forKey:key];
+    }
+    _depth--;
+    return dict;
+}
+
+@end
@@ -0,0 +1,122 @@
+//
+//  JAGMessagePackWriter.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "JAGStructuredWriter.h"
+
+/**
+   JAGMessagePackWriter writes MessagePack into a growable byte buffer.
+
+   Unlike JSON, MessagePack keeps NSDates (as timestamp extensions), NSData
+   (as raw bytes), and NaN and infinite doubles.
+
+   Like JAGJSONWriter, it is a low-level writer: callers are responsible
+   for balancing beginMap/endMap and beginArray/endArray, and for writing
+   a key before each value inside a map.  Keys are written lazily, along
+   with the next value or container, so a caller can write a key and then
+   decide not to write a value for it.  Containers don't need their size
+   up front; it is filled in when they end.
+
+     JAGMessagePackWriter *writer = [[JAGMessagePackWriter alloc] init];
+     [writer beginMap];
+     [writer writeKey:@"name"];
+     [writer writeString:@"Jane Smith"];
+     [writer writeKey:@"skipped"];
+     [writer writeKey:@"joined"];
+     [writer writeDate:[NSDate date]];
+     [writer endMap];
+     NSData *messagePack = [writer takeData];
+
+   JAGPropertyConverter uses a JAGMessagePackWriter to encode models directly;
+   see [JAGPropertyConverter messagePackDataFromObject:].
+ */
+@interface JAGMessagePackWriter : NSObject <JAGStructuredWriter>
+
+/// Number of bytes written so far.
+@property (nonatomic, readonly) NSUInteger bytesWritten;
+
+- (void) beginMap;
+- (void) endMap;
+- (void) beginArray;
+- (void) endArray;
+
+/**
+ * Set the key for the next value in the current map.
+ *
+ * Nothing is written until the next value or container is begun;
+ * another call to writeKey: replaces the pending key.
+ */
+- (void) writeKey: (NSString *) key;
+
+- (void) writeString: (NSString *) string;
+- (void) writeNil;
+- (void) writeBool: (BOOL) value;
+- (void) writeLongLong: (long long) value;
+- (void) writeUnsignedLongLong: (unsigned long long) value;
+
+/**
+ * Write a 32-bit float.  NaN and infinities are kept.
+ *
+ * @return YES; every float can be written.
+ */
+- (BOOL) writeFloat: (float) value;
+
+/**
+ * Write a 64-bit float.  NaN and infinities are kept.
+ *
+ * @return YES; every double can be written.
+ */
+- (BOOL) writeDouble: (double) value;
+
+/// Write an NSNumber as a MessagePack boolean, integer, or float.
+- (void) writeNumber: (NSNumber *) number;
+
+/// Write NSData as MessagePack binary.
+- (void) writeData: (NSData *) data;
+
+/// Write an NSDate as a MessagePack timestamp, to the nanosecond.
+- (void) writeDate: (NSDate *) date;
+
+/**
+ * Append bytes as they are, outside of any MessagePack value.
+ *
+ * For formats that frame MessagePack values with their own data, such as
+ * [JAGPropertyConverter compactDataFromModels:ofClass:].  Raw bytes are not
+ * counted as a value of the current container.
+ */
+- (void) writeRawBytes: (const void *) bytes length: (NSUInteger) length;
+
+/// Append an unsigned LEB128 varint, outside of any MessagePack value.
+- (void) writeRawVarint: (uint64_t) value;
+
+/**
+ * The written bytes, handed over without copying.  The writer's buffer is emptied.
+ *
+ * Any containers still open are left unfinished.
+ *
+ * @return The MessagePack written since the last takeData.
+ */
+- (NSData *) takeData;
+
+@end
@@ -0,0 +1,384 @@
+//
+//  JAGMessagePackWriter.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGMessagePackWriter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JAGMessagePackWriterInitialCapacity 4096
+
+//The type of the timestamp extension.
+#define JAGMessagePackTimestampType     (-1)
+
+typedef struct {
+    //Offset of the container's header, which is written at full size and shrunk when it ends.
+    NSUInteger offset;
+    NSUInteger count;
+} JAGMessagePackContainer;
+
+@implementation JAGMessagePackWriter
+{
+@private
+    uint8_t                 *_bytes;
+    NSUInteger              _length;
+    NSUInteger              _capacity;
+    NSUInteger              _takenLength;
+    NSString                *_pendingKey;
+    JAGMessagePackContainer *_containers;
+    NSUInteger              _depth;
+    NSUInteger              _containerCapacity;
+}
+
+- (id) init {
+    self = [super init];
+    if (self) {
+        _capacity = JAGMessagePackWriterInitialCapacity;
+        _bytes = malloc(_capacity);
+        _containerCapacity = 16;
+        _containers = malloc(_containerCapacity * sizeof(JAGMessagePackContainer));
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_bytes);
+    free(_containers);
+}
+
+- (NSUInteger) bytesWritten {
+    return _takenLength + _length;
+}
+
+- (NSData *) takeData {
+    NSData *data = [[NSData alloc] initWithBytesNoCopy:_bytes length:_length freeWhenDone:YES];
+    _takenLength += _length;
+    _length = 0;
+    _depth = 0;
+    _capacity = JAGMessagePackWriterInitialCapacity;
+    _bytes = malloc(_capacity);
+    return data;
+}
+
+#pragma mark - Buffer
+
+static inline void JAGMPReserve(JAGMessagePackWriter *writer, NSUInteger extra) {
+    if (writer->_length + extra <= writer->_capacity) return;
+    NSUInteger capacity = writer->_capacity ? writer->_capacity : JAGMessagePackWriterInitialCapacity;
+    while (writer->_length + extra > capacity) capacity *= 2;
+    writer->_bytes = realloc(writer->_bytes, capacity);
+    writer->_capacity = capacity;
+}
+
+static inline void JAGMPAppendByte(JAGMessagePackWriter *writer, uint8_t byte) {
+    JAGMPReserve(writer, 1);
+    writer->_bytes[writer->_length++] = byte;
+}
+
+static inline void JAGMPAppend(JAGMessagePackWriter *writer, const void *bytes, NSUInteger length) {
+    JAGMPReserve(writer, length);
+    memcpy(writer->_bytes + writer->_length, bytes, length);
+    writer->_length += length;
+}
+
+//Append value as a size-byte big-endian integer.
+static inline void JAGMPAppendBigEndian(JAGMessagePackWriter *writer, uint64_t value, int size) {
+    JAGMPReserve(writer, size);
+    uint8_t *p = writer->_bytes + writer->_length;
+    for (int i = size - 1; i >= 0; i--) {
+        *p++ = (uint8_t)(value >> (8 * i));
+    }
+    writer->_length += size;
+}
+
+//Append a type byte followed by value as a size-byte big-endian integer.
+static inline void JAGMPAppendTyped(JAGMessagePackWriter *writer, uint8_t type, uint64_t value, int size) {
+    JAGMPAppendByte(writer, type);
+    JAGMPAppendBigEndian(writer, value, size);
+}
+
+/*
+ * Write the header for a str, bin or container of length items.  fixType
+ * and fixLimit are the fix-size form, if there is one (else fixLimit is 0),
+ * and types8/16/32 the others (type8 0 if there is none).
+ */
+static void JAGMPAppendLengthHeader(JAGMessagePackWriter *writer, NSUInteger length,
+                                    uint8_t fixType, NSUInteger fixLimit,
+                                    uint8_t type8, uint8_t type16, uint8_t type32)
+{
+    if (length < fixLimit) {
+        JAGMPAppendByte(writer, (uint8_t)(fixType | length));
+    } else if (type8 && length <= 0xff) {
+        JAGMPAppendTyped(writer, type8, length, 1);
+    } else if (length <= 0xffff) {
+        JAGMPAppendTyped(writer, type16, length, 2);
+    } else {
+        JAGMPAppendTyped(writer, type32, length, 4);
+    }
+}
+
+#pragma mark - Containers
+
+static void JAGMPAppendString(JAGMessagePackWriter *writer, NSString *string);
+
+/*
+ * Write the pending key (if any) that precedes a value, and count the value
+ * in its container.
+ */
+static inline void JAGMPBeginValue(JAGMessagePackWriter *writer) {
+    if (writer->_pendingKey) {
+        NSString *key = writer->_pendingKey;
+        writer->_pendingKey = nil;
+        JAGMPAppendString(writer, key);
+    }
+    if (writer->_depth) {
+        writer->_containers[writer->_depth - 1].count++;
+    }
+}
+
+- (void) beginContainer: (uint8_t) type32 {
+    JAGMPBeginValue(self);
+    if (_depth == _containerCapacity) {
+        _containerCapacity *= 2;
+        _containers = realloc(_containers, _containerCapacity * sizeof(JAGMessagePackContainer));
+    }
+    _containers[_depth].offset = _length;
+    _containers[_depth].count = 0;
+    _depth++;
+    JAGMPAppendTyped(self, type32, 0, 4);
+}
+
+/*
+ * Fill in the size of the innermost container, shrinking its header
+ * (and moving its contents back) if a smaller form fits.
+ */
+- (void) endContainer: (uint8_t) fixType type16: (uint8_t) type16 type32: (uint8_t) type32 {
+    if (!_depth) return;
+    JAGMessagePackContainer container = _containers[--_depth];
+    NSUInteger contentsOffset = container.offset + 5;
+    NSUInteger contentsLength = _length - contentsOffset;
+    NSUInteger headerLength = container.count < 16 ? 1 : (container.count <= 0xffff ? 3 : 5);
+    _length = container.offset;
+    if (headerLength < 5) {
+        memmove(_bytes + container.offset + headerLength, _bytes + contentsOffset, contentsLength);
+    }
+    JAGMPAppendLengthHeader(self, container.count, fixType, 16, 0, type16, type32);
+    _length += contentsLength;
+}
+
+- (void) beginMap {
+    [self beginContainer:0xdf];
+}
+
+- (void) endMap {
+    _pendingKey = nil;
+    [self endContainer:0x80 type16:0xde type32:0xdf];
+}
+
+- (void) beginArray {
+    [self beginContainer:0xdd];
+}
+
+- (void) endArray {
+    [self endContainer:0x90 type16:0xdc type32:0xdd];
+}
+
+- (void) writeKey: (NSString *) key {
+    _pendingKey = key;
+}
+
+#pragma mark - Scalars
+
+static void JAGMPAppendString(JAGMessagePackWriter *writer, NSString *string) {
+    NSUInteger characters = [string length];
+    NSUInteger maxLength = [string maxLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    //Write the bytes after a header big enough for maxLength, then shrink the header to fit.
+    NSUInteger headerLength = maxLength < 32 ? 1 : (maxLength <= 0xff ? 2 : (maxLength <= 0xffff ? 3 : 5));
+    JAGMPReserve(writer, headerLength + maxLength);
+    NSUInteger offset = writer->_length;
+    NSUInteger used = 0;
+    [string getBytes:writer->_bytes + offset + headerLength
+           maxLength:maxLength
+          usedLength:&used
+            encoding:NSUTF8StringEncoding
+             options:NSStringEncodingConversionAllowLossy
+               range:NSMakeRange(0, characters)
+      remainingRange:NULL];
+    NSUInteger fittedLength = used < 32 ? 1 : (used <= 0xff ? 2 : (used <= 0xffff ? 3 : 5));
+    if (fittedLength < headerLength) {
+        memmove(writer->_bytes + offset + fittedLength, writer->_bytes + offset + headerLength, used);
+    }
+    JAGMPAppendLengthHeader(writer, used, 0xa0, 32, 0xd9, 0xda, 0xdb);
+    writer->_length += used;
+}
+
+- (void) writeString: (NSString *) string {
+    JAGMPBeginValue(self);
+    JAGMPAppendString(self, string);
+}
+
+- (void) writeNil {
+    JAGMPBeginValue(self);
+    JAGMPAppendByte(self, 0xc0);
+}
+
+- (void) writeBool: (BOOL) value {
+    JAGMPBeginValue(self);
+    JAGMPAppendByte(self, value ? 0xc3 : 0xc2);
+}
+
+static void JAGMPAppendUnsigned(JAGMessagePackWriter *writer, unsigned long long value) {
+    if (value < 0x80) {
+        JAGMPAppendByte(writer, (uint8_t)value);
+    } else if (value <= 0xff) {
+        JAGMPAppendTyped(writer, 0xcc, value, 1);
+    } else if (value <= 0xffff) {
+        JAGMPAppendTyped(writer, 0xcd, value, 2);
+    } else if (value <= 0xffffffffULL) {
+        JAGMPAppendTyped(writer, 0xce, value, 4);
+    } else {
+        JAGMPAppendTyped(writer, 0xcf, value, 8);
+    }
+}
+
+- (void) writeLongLong: (long long) value {
+    JAGMPBeginValue(self);
+    if (value >= 0) {
+        JAGMPAppendUnsigned(self, (unsigned long long)value);
+    } else if (value >= -32) {
+        JAGMPAppendByte(self, (uint8_t)(int8_t)value);
+    } else if (value >= INT8_MIN) {
+        JAGMPAppendTyped(self, 0xd0, (uint64_t)value, 1);
+    } else if (value >= INT16_MIN) {
+        JAGMPAppendTyped(self, 0xd1, (uint64_t)value, 2);
+    } else if (value >= INT32_MIN) {
+        JAGMPAppendTyped(self, 0xd2, (uint64_t)value, 4);
+    } else {
+        JAGMPAppendTyped(self, 0xd3, (uint64_t)value, 8);
+    }
+}
+
+- (void) writeUnsignedLongLong: (unsigned long long) value {
+    JAGMPBeginValue(self);
+    JAGMPAppendUnsigned(self, value);
+}
+
+- (BOOL) writeFloat: (float) value {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    JAGMPBeginValue(self);
+    JAGMPAppendTyped(self, 0xca, bits, 4);
+    return YES;
+}
+
+- (BOOL) writeDouble: (double) value {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    JAGMPBeginValue(self);
+    JAGMPAppendTyped(self, 0xcb, bits, 8);
+    return YES;
+}
+
+- (void) writeNumber: (NSNumber *) number {
+    static NSNumber *trueNumber = nil;
+    static NSNumber *falseNumber = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        trueNumber = [NSNumber numberWithBool:YES];
+        falseNumber = [NSNumber numberWithBool:NO];
+    });
+    //Boolean NSNumbers are singletons; anything else created from a BOOL is just an integer.
+    if (number == trueNumber || number == falseNumber) {
+        [self writeBool:[number boolValue]];
+        return;
+    }
+    switch ([number objCType][0]) {
+        case 'f':
+            [self writeFloat:[number floatValue]];
+            break;
+        case 'd':
+            [self writeDouble:[number doubleValue]];
+            break;
+        case 'Q':
+        case 'L':
+            [self writeUnsignedLongLong:[number unsignedLongLongValue]];
+            break;
+        default:
+            [self writeLongLong:[number longLongValue]];
+            break;
+    }
+}
+
+- (void) writeData: (NSData *) data {
+    NSUInteger length = [data length];
+    JAGMPBeginValue(self);
+    JAGMPAppendLengthHeader(self, length, 0, 0, 0xc4, 0xc5, 0xc6);
+    JAGMPAppend(self, [data bytes], length);
+}
+
+- (void) writeRawBytes: (const void *) bytes length: (NSUInteger) length {
+    JAGMPAppend(self, bytes, length);
+}
+
+- (void) writeRawVarint: (uint64_t) value {
+    JAGMPReserve(self, 10);
+    while (value >= 0x80) {
+        _bytes[_length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    _bytes[_length++] = (uint8_t)value;
+}
+
+- (void) writeDate: (NSDate *) date {
+    NSTimeInterval interval = [date timeIntervalSince1970];
+    double seconds = floor(interval);
+    uint64_t nanoseconds = (uint64_t)llround((interval - seconds) * 1e9);
+    if (nanoseconds >= 1000000000ULL) {
+        seconds += 1;
+        nanoseconds -= 1000000000ULL;
+    }
+    JAGMPBeginValue(self);
+    if (seconds >= 0 && seconds < 17179869184.0) {
+        uint64_t wholeSeconds = (uint64_t)seconds;
+        if (nanoseconds == 0 && wholeSeconds <= 0xffffffffULL) {
+            //timestamp 32
+            JAGMPAppendTyped(self, 0xd6, (uint8_t)JAGMessagePackTimestampType, 1);
+            JAGMPAppendBigEndian(self, wholeSeconds, 4);
+        } else {
+            //timestamp 64: 30 bits of nanoseconds, 34 bits of seconds.
+            uint64_t value = (nanoseconds << 34) | wholeSeconds;
+            JAGMPAppendTyped(self, 0xd7, (uint8_t)JAGMessagePackTimestampType, 1);
+            JAGMPAppendBigEndian(self, value, 8);
+        }
+    } else {
+        //timestamp 96: 32 bits of nanoseconds, then 64 bits of signed seconds.
+        int64_t wholeSeconds = (int64_t)seconds;
+        JAGMPAppendTyped(self, 0xc7, 12, 1);
+        JAGMPAppendByte(self, (uint8_t)JAGMessagePackTimestampType);
+        JAGMPAppendBigEndian(self, nanoseconds, 4);
+        JAGMPAppendBigEndian(self, (uint64_t)wholeSeconds, 8);
+    }
+}
+
+@end
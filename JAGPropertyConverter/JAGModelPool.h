@@ -0,0 +1,77 @@
+//
+//  JAGModelPool.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+   JAGModelPool keeps released models for reuse, so that composing many
+   short-lived models doesn't allocate each one anew.
+
+   Give a pool to JAGPropertyConverter as its modelPool, and the converter
+   takes models from it instead of calling `alloc`/`init`.  Return models
+   to the pool with recycleModel:, or [JAGPropertyConverter recycleModel:]
+   to return their nested models as well, once nothing else refers to them.
+
+   A recycled model is reset as it enters the pool: each settable property
+   is set to nil, or to 0 if it is numeric.  Properties that are read-only
+   or of struct types keep their values, and values set by `-init` are not
+   restored, so models with such defaults should not be pooled.  Models are
+   pooled by `-class`, and reset through the setters of their actual class.
+
+   Pools are thread-safe.
+ */
+@interface JAGModelPool : NSObject
+
+/**
+ * The most models the pool keeps of each class.
+ *
+ * Models recycled when their class is full are released.  Default is 1024.
+ */
+@property (nonatomic, assign) NSUInteger capacity;
+
+/**
+ * A recycled model of the given class.
+ *
+ * @param modelClass The class of the model.
+ * @return A reset model, or nil if none of modelClass are pooled.
+ */
+- (id) dequeueModelOfClass: (Class) modelClass;
+
+/**
+ * Reset model and keep it for reuse.
+ *
+ * The caller must not use model afterwards.  Recycling a model that is
+ * already pooled has no effect.
+ *
+ * @param model The model to recycle.
+ */
+- (void) recycleModel: (id) model;
+
+/// @return The number of models of modelClass in the pool.
+- (NSUInteger) countOfModelsOfClass: (Class) modelClass;
+
+/// Release every pooled model.
+- (void) removeAllModels;
+
+@end
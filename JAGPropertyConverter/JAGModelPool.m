@@ -0,0 +1,146 @@
+//
+//  JAGModelPool.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGModelPool.h"
+#import "JAGProperty.h"
+#import "JAGClassCodec.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+
+@interface JAGModelPool ()
+{
+    pthread_mutex_t _lock;
+    //Class to NSMutableArray of reset models.
+    CFMutableDictionaryRef _modelsByClass;
+    //Every pooled model, so that recycling one twice doesn't pool it twice.
+    CFMutableSetRef _pooledModels;
+}
+@end
+
+@implementation JAGModelPool
+
+@synthesize capacity = _capacity;
+
+- (id) init {
+    self = [super init];
+    if (self) {
+        _capacity = 1024;
+        pthread_mutex_init(&_lock, NULL);
+        _modelsByClass = CFDictionaryCreateMutable(NULL, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+        _pooledModels = CFSetCreateMutable(NULL, 0, NULL);
+    }
+    return self;
+}
+
+- (void) dealloc {
+    CFRelease(_pooledModels);
+    CFRelease(_modelsByClass);
+    pthread_mutex_destroy(&_lock);
+}
+
+/*
+ * Set each settable property of model to nil or 0.
+ */
+static void JAGModelPoolReset(id model) {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    NSUInteger count = [codec count];
+    for (NSUInteger i = 0; i < count; i++) {
+        JAGProperty *property = [codec propertyAtIndex:i];
+        if ([property isReadOnly] || ![model respondsToSelector:[property setter]]) continue;
+        switch ([property scalarKind]) {
+            case JAGPropertyScalarKindObject:
+            case JAGPropertyScalarKindBlock:
+                [codec setValue:nil atIndex:i ofModel:model];
+                break;
+            case JAGPropertyScalarKindFloat:
+            case JAGPropertyScalarKindDouble:
+                [codec setDoubleValue:0 atIndex:i ofModel:model];
+                break;
+            case JAGPropertyScalarKindUnknown:
+            case JAGPropertyScalarKindOther:
+                break;
+            default:
+                [codec setLongLongValue:0 atIndex:i ofModel:model];
+                break;
+        }
+    }
+}
+
+- (id) dequeueModelOfClass: (Class) modelClass {
+    if (!modelClass) return nil;
+    id model = nil;
+    pthread_mutex_lock(&_lock);
+    NSMutableArray *models = (__bridge NSMutableArray *) CFDictionaryGetValue(_modelsByClass, (__bridge void *) modelClass);
+    if ([models count]) {
+        model = [models lastObject];
+        [models removeLastObject];
+        CFSetRemoveValue(_pooledModels, (__bridge void *) model);
+    }
+    pthread_mutex_unlock(&_lock);
+    return model;
+}
+
+- (void) recycleModel: (id) model {
+    if (!model) return;
+    pthread_mutex_lock(&_lock);
+    BOOL isPooled = CFSetContainsValue(_pooledModels, (__bridge void *) model);
+    pthread_mutex_unlock(&_lock);
+    if (isPooled) return;
+
+    //Reset outside the lock, since setters release the old values.
+    JAGModelPoolReset(model);
+
+    Class modelClass = [model class];
+    pthread_mutex_lock(&_lock);
+    NSMutableArray *models = (__bridge NSMutableArray *) CFDictionaryGetValue(_modelsByClass, (__bridge void *) modelClass);
+    if (!models) {
+        models = [[NSMutableArray alloc] init];
+        CFDictionarySetValue(_modelsByClass, (__bridge void *) modelClass, (__bridge void *) models);
+    }
+    if ([models count] < _capacity && !CFSetContainsValue(_pooledModels, (__bridge void *) model)) {
+        [models addObject:model];
+        CFSetAddValue(_pooledModels, (__bridge void *) model);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+- (NSUInteger) countOfModelsOfClass: (Class) modelClass {
+    if (!modelClass) return 0;
+    pthread_mutex_lock(&_lock);
+    NSUInteger count = [(__bridge NSMutableArray *) CFDictionaryGetValue(_modelsByClass, (__bridge void *) modelClass) count];
+    pthread_mutex_unlock(&_lock);
+    return count;
+}
+
+- (void) removeAllModels {
+    pthread_mutex_lock(&_lock);
+    //Release the models after unlocking, in case their dealloc recycles.
+    NSArray *models = [(__bridge NSDictionary *) _modelsByClass allValues];
+    CFDictionaryRemoveAllValues(_modelsByClass);
+    CFSetRemoveAllValues(_pooledModels);
+    pthread_mutex_unlock(&_lock);
+    models = nil;
+}
+
+@end
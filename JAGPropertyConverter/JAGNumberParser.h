@@ -0,0 +1,92 @@
+//
+//  JAGNumberParser.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+#import "JAGProperty.h"
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+
+/*
+   Locale-independent parsing of numeric strings, for
+   JAGPropertyConverter's shouldParseNumericStrings.
+
+   The accepted grammar is an optional sign, one or more digits, an optional
+   fraction (`.` and one or more digits), and an optional exponent, with
+   no whitespace or grouping separators.  Integers without a fraction or
+   exponent are parsed exactly into a long long, or an unsigned long long
+   if they are too large; other numbers are parsed into the nearest double.
+ */
+
+typedef enum {
+    JAGParsedNumberInvalid = 0,
+    JAGParsedNumberLongLong,
+    JAGParsedNumberUnsignedLongLong,
+    JAGParsedNumberDouble
+} JAGParsedNumberKind;
+
+typedef struct {
+    JAGParsedNumberKind kind;
+    long long longLongValue;
+    unsigned long long unsignedLongLongValue;
+    double doubleValue;
+} JAGParsedNumber;
+
+/**
+ * Parse length bytes of text, which needn't be NUL-terminated.
+ *
+ * @return NO, with number's kind set to JAGParsedNumberInvalid, if text isn't a number.
+ */
+extern BOOL JAGParseNumberBytes(const char *text, size_t length, JAGParsedNumber *number);
+
+/// Parse an NSString, with JAGParseNumberBytes.
+extern BOOL JAGParseNumericString(NSString *string, JAGParsedNumber *number);
+
+/**
+ * Parse each NSString in strings into numbers, which must have room for [strings count].
+ *
+ * Elements that aren't NSStrings, or aren't numbers, are JAGParsedNumberInvalid.
+ *
+ * @return The number of elements that were parsed.
+ */
+extern NSUInteger JAGParseNumericStrings(NSArray *strings, JAGParsedNumber *numbers);
+
+/// A long long as a JAGParsedNumber, as JAGParseNumberBytes would parse it.
+extern JAGParsedNumber JAGParsedNumberFromLongLong(long long value);
+
+/// An unsigned long long as a JAGParsedNumber; values up to LLONG_MAX are JAGParsedNumberLongLong.
+extern JAGParsedNumber JAGParsedNumberFromUnsignedLongLong(unsigned long long value);
+
+/// A double as a JAGParsedNumber, with its longLongValue clamped to the range of long long.
+extern JAGParsedNumber JAGParsedNumberFromDouble(double value);
+
+/// Whether number can be stored in a property of the given kind without overflowing or being truncated.
+extern BOOL JAGParsedNumberFitsScalarKind(const JAGParsedNumber *number, JAGPropertyScalarKind kind);
+
+/// number as an NSNumber, or nil if it is invalid.
+extern NSNumber *JAGNumberFromParsedNumber(const JAGParsedNumber *number);
+
+/// The "C" locale, for reading and writing numbers the same way whatever the user's locale.
+extern locale_t JAGCLocale(void);
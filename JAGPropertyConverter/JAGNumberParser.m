@@ -0,0 +1,311 @@
+//
+//  JAGNumberParser.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//For strtod_l.
+#define _GNU_SOURCE
+#import "JAGNumberParser.h"
+#include <float.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define JAGIsDigit(c) ((c) >= '0' && (c) <= '9')
+
+//The powers of ten that are exact doubles.
+static const double JAGExactPowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define JAGMaxExactPowerOfTen 22
+#define JAGMaxExactMantissa (1ULL << 53)
+
+static locale_t gCLocale;
+static pthread_once_t gCLocaleOnce = PTHREAD_ONCE_INIT;
+
+static void JAGCreateCLocale(void) {
+    gCLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+locale_t JAGCLocale(void) {
+    pthread_once(&gCLocaleOnce, JAGCreateCLocale);
+    return gCLocale;
+}
+
+/*
+ * Parse text the slow way, for doubles whose mantissa or exponent is too
+ * large to compute exactly with one multiplication or division.
+ */
+static double JAGStrtod(const char *text, size_t length) {
+    char stackBuffer[64];
+    char *buffer = length < sizeof(stackBuffer) ? stackBuffer : malloc(length + 1);
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+    double value = strtod_l(buffer, NULL, JAGCLocale());
+    if (buffer != stackBuffer) free(buffer);
+    return value;
+}
+
+BOOL JAGParseNumberBytes(const char *text, size_t length, JAGParsedNumber *number) {
+    number->kind = JAGParsedNumberInvalid;
+    const char *p = text;
+    const char *end = text + length;
+    BOOL negative = NO;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    //The leading digits that fit, and the power of ten they are scaled by.
+    unsigned long long mantissa = 0;
+    long exponent = 0;
+    BOOL truncated = NO;
+    const char *digits = p;
+    for (; p < end && JAGIsDigit(*p); p++) {
+        unsigned d = (unsigned)(*p - '0');
+        if (!truncated && mantissa <= (ULLONG_MAX - d) / 10) {
+            mantissa = mantissa * 10 + d;
+        } else {
+            truncated = YES;
+            exponent++;
+        }
+    }
+    if (p == digits) return NO;
+
+    BOOL isInteger = YES;
+    if (p < end && *p == '.') {
+        isInteger = NO;
+        digits = ++p;
+        for (; p < end && JAGIsDigit(*p); p++) {
+            unsigned d = (unsigned)(*p - '0');
+            if (!truncated && mantissa <= (ULLONG_MAX - d) / 10) {
+                mantissa = mantissa * 10 + d;
+                exponent--;
+            } else {
+                truncated = YES;
+            }
+        }
+        if (p == digits) return NO;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        isInteger = NO;
+        p++;
+        BOOL negativeExponent = NO;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = (*p == '-');
+            p++;
+        }
+        long explicitExponent = 0;
+        digits = p;
+        for (; p < end && JAGIsDigit(*p); p++) {
+            //Anything this large is 0 or infinity anyway.
+            if (explicitExponent < 100000) explicitExponent = explicitExponent * 10 + (*p - '0');
+        }
+        if (p == digits) return NO;
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (p != end) return NO;
+
+    if (isInteger && !truncated) {
+        if (!negative && mantissa <= (unsigned long long)LLONG_MAX) {
+            number->kind = JAGParsedNumberLongLong;
+            number->longLongValue = (long long)mantissa;
+            number->unsignedLongLongValue = mantissa;
+            number->doubleValue = (double)mantissa;
+            return YES;
+        } else if (!negative) {
+            number->kind = JAGParsedNumberUnsignedLongLong;
+            number->unsignedLongLongValue = mantissa;
+            number->longLongValue = (long long)mantissa;
+            number->doubleValue = (double)mantissa;
+            return YES;
+        } else if (mantissa <= (unsigned long long)LLONG_MAX + 1) {
+            number->kind = JAGParsedNumberLongLong;
+            number->longLongValue = mantissa == (unsigned long long)LLONG_MAX + 1 ? LLONG_MIN : -(long long)mantissa;
+            number->unsignedLongLongValue = (unsigned long long)number->longLongValue;
+            number->doubleValue = (double)number->longLongValue;
+            return YES;
+        }
+        //Too negative for a long long; parse it as a double.
+    }
+
+    double value;
+    if (!truncated && mantissa <= JAGMaxExactMantissa
+        && exponent >= -JAGMaxExactPowerOfTen && exponent <= JAGMaxExactPowerOfTen)
+    {
+        //Both operands are exact, so the one rounding is correct.
+        value = (double)mantissa;
+        value = exponent >= 0 ? value * JAGExactPowersOfTen[exponent] : value / JAGExactPowersOfTen[-exponent];
+        if (negative) value = -value;
+    } else {
+        value = JAGStrtod(text, length);
+    }
+    *number = JAGParsedNumberFromDouble(value);
+    return YES;
+}
+
+JAGParsedNumber JAGParsedNumberFromLongLong(long long value) {
+    JAGParsedNumber number;
+    number.kind = JAGParsedNumberLongLong;
+    number.longLongValue = value;
+    number.unsignedLongLongValue = (unsigned long long)value;
+    number.doubleValue = (double)value;
+    return number;
+}
+
+JAGParsedNumber JAGParsedNumberFromUnsignedLongLong(unsigned long long value) {
+    JAGParsedNumber number = JAGParsedNumberFromLongLong((long long)value);
+    if (value > (unsigned long long)LLONG_MAX) {
+        number.kind = JAGParsedNumberUnsignedLongLong;
+        number.doubleValue = (double)value;
+    }
+    return number;
+}
+
+JAGParsedNumber JAGParsedNumberFromDouble(double value) {
+    JAGParsedNumber number;
+    number.kind = JAGParsedNumberDouble;
+    number.doubleValue = value;
+    //Casting a double that is out of range is undefined, so clamp it.
+    if (value != value) {
+        number.longLongValue = 0;
+    } else if (value >= (double)LLONG_MAX) {
+        number.longLongValue = LLONG_MAX;
+    } else if (value <= (double)LLONG_MIN) {
+        number.longLongValue = LLONG_MIN;
+    } else {
+        number.longLongValue = (long long)value;
+    }
+    number.unsignedLongLongValue = (unsigned long long)number.longLongValue;
+    return number;
+}
+
+BOOL JAGParseNumericString(NSString *string, JAGParsedNumber *number) {
+    CFStringRef cfString = (__bridge CFStringRef) string;
+    const char *text = CFStringGetCStringPtr(cfString, kCFStringEncodingASCII);
+    if (text) {
+        return JAGParseNumberBytes(text, strlen(text), number);
+    }
+    //Anything that isn't ASCII can't be a number, so copy at most a little more than the longest useful one.
+    char buffer[512];
+    CFIndex used = 0;
+    CFIndex length = CFStringGetLength(cfString);
+    if (length >= (CFIndex)sizeof(buffer)
+        || CFStringGetBytes(cfString, CFRangeMake(0, length), kCFStringEncodingASCII, 0, false,
+                            (UInt8 *)buffer, sizeof(buffer), &used) != length)
+    {
+        number->kind = JAGParsedNumberInvalid;
+        return NO;
+    }
+    return JAGParseNumberBytes(buffer, (size_t)used, number);
+}
+
+NSUInteger JAGParseNumericStrings(NSArray *strings, JAGParsedNumber *numbers) {
+    NSUInteger count = [strings count];
+    NSUInteger parsed = 0;
+    Class stringClass = [NSString class];
+    //Fetch the elements in chunks, rather than messaging the array for each.
+    id chunk[64];
+    for (NSUInteger start = 0; start < count; start += 64) {
+        NSUInteger length = MIN((NSUInteger)64, count - start);
+        [strings getObjects:chunk range:NSMakeRange(start, length)];
+        for (NSUInteger i = 0; i < length; i++) {
+            JAGParsedNumber *number = &numbers[start + i];
+            if ([chunk[i] isKindOfClass:stringClass] && JAGParseNumericString(chunk[i], number)) {
+                parsed++;
+            } else {
+                number->kind = JAGParsedNumberInvalid;
+            }
+        }
+    }
+    return parsed;
+}
+
+/*
+ * Whether number is an integer from min to max.  Doubles count if they
+ * have no fraction.
+ */
+static BOOL JAGParsedNumberIsInSignedRange(const JAGParsedNumber *number, long long min, long long max) {
+    switch (number->kind) {
+        case JAGParsedNumberLongLong:
+            return number->longLongValue >= min && number->longLongValue <= max;
+        case JAGParsedNumberUnsignedLongLong:
+            return NO;
+        case JAGParsedNumberDouble:
+            return number->doubleValue >= (double)min && number->doubleValue < (double)max + 1.0
+                && number->doubleValue == (double)number->longLongValue
+                && number->longLongValue >= min && number->longLongValue <= max;
+        default:
+            return NO;
+    }
+}
+
+static BOOL JAGParsedNumberIsInUnsignedRange(const JAGParsedNumber *number, unsigned long long max) {
+    switch (number->kind) {
+        case JAGParsedNumberLongLong:
+            return number->longLongValue >= 0 && (unsigned long long)number->longLongValue <= max;
+        case JAGParsedNumberUnsignedLongLong:
+            return number->unsignedLongLongValue <= max;
+        case JAGParsedNumberDouble:
+            return number->doubleValue >= 0 && number->doubleValue < (double)LLONG_MAX
+                && number->doubleValue == (double)number->longLongValue
+                && (unsigned long long)number->longLongValue <= max;
+        default:
+            return NO;
+    }
+}
+
+BOOL JAGParsedNumberFitsScalarKind(const JAGParsedNumber *number, JAGPropertyScalarKind kind) {
+    if (number->kind == JAGParsedNumberInvalid) return NO;
+    switch (kind) {
+        case JAGPropertyScalarKindChar:             return JAGParsedNumberIsInSignedRange(number, SCHAR_MIN, SCHAR_MAX);
+        case JAGPropertyScalarKindShort:            return JAGParsedNumberIsInSignedRange(number, SHRT_MIN, SHRT_MAX);
+        case JAGPropertyScalarKindInt:              return JAGParsedNumberIsInSignedRange(number, INT_MIN, INT_MAX);
+        case JAGPropertyScalarKindLong:             return JAGParsedNumberIsInSignedRange(number, LONG_MIN, LONG_MAX);
+        case JAGPropertyScalarKindLongLong:         return JAGParsedNumberIsInSignedRange(number, LLONG_MIN, LLONG_MAX);
+        case JAGPropertyScalarKindUnsignedChar:     return JAGParsedNumberIsInUnsignedRange(number, UCHAR_MAX);
+        case JAGPropertyScalarKindUnsignedShort:    return JAGParsedNumberIsInUnsignedRange(number, USHRT_MAX);
+        case JAGPropertyScalarKindUnsignedInt:      return JAGParsedNumberIsInUnsignedRange(number, UINT_MAX);
+        case JAGPropertyScalarKindUnsignedLong:     return JAGParsedNumberIsInUnsignedRange(number, ULONG_MAX);
+        case JAGPropertyScalarKindUnsignedLongLong: return JAGParsedNumberIsInUnsignedRange(number, ULLONG_MAX);
+        case JAGPropertyScalarKindBool:             return JAGParsedNumberIsInUnsignedRange(number, 1);
+        case JAGPropertyScalarKindFloat:
+            return number->kind != JAGParsedNumberDouble || number->doubleValue != number->doubleValue
+                || (number->doubleValue >= -FLT_MAX && number->doubleValue <= FLT_MAX);
+        default:
+            return YES;
+    }
+}
+
+NSNumber *JAGNumberFromParsedNumber(const JAGParsedNumber *number) {
+    switch (number->kind) {
+        case JAGParsedNumberLongLong:
+            return [[NSNumber alloc] initWithLongLong:number->longLongValue];
+        case JAGParsedNumberUnsignedLongLong:
+            return [[NSNumber alloc] initWithUnsignedLongLong:number->unsignedLongLongValue];
+        case JAGParsedNumberDouble:
+            return [[NSNumber alloc] initWithDouble:number->doubleValue];
+        default:
+            return nil;
+    }
+}
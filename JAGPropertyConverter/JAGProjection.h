@@ -0,0 +1,107 @@
+//
+//  JAGProjection.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class JAGClassCodec;
+@class JAGProjection;
+
+typedef struct {
+    ///The codec index of the property.
+    NSUInteger index;
+    ///What to select within the property's value.
+    __unsafe_unretained JAGProjection *projection;
+} JAGProjectedProperty;
+
+/**
+ * The properties of one class that a JAGProjection selects, in codec order.
+ */
+typedef struct {
+    ///The codec the indexes are for, which the projection retains.
+    __unsafe_unretained JAGClassCodec *codec;
+    NSUInteger count;
+    JAGProjectedProperty properties[];
+} JAGProjectedProperties;
+
+/**
+   JAGProjection selects part of a model graph, so that
+   [JAGPropertyConverter convertToDictionary:projection:] and
+   [JAGPropertyConverter setPropertiesOf:fromDictionary:projection:] can
+   leave the rest alone.
+
+   A projection is compiled once from a set of key paths into a tree:
+
+     JAGProjection *projection = [JAGProjection projectionWithKeyPaths:
+         [NSArray arrayWithObjects:@"name", @"invitedBy.userID", @"friends.*.name", nil]];
+
+   A key path selects the whole value at its end, so `invitedBy` alone
+   would select every property of invitedBy.  Where a value is an NSArray
+   or NSSet, a `*` component stands for its elements (`friends.name` means
+   the same as `friends.*.name`); elsewhere `*` matches any key.
+
+   Projections are immutable and thread-safe.  The properties a projection
+   selects from each class are worked out the first time, and cached.
+ */
+@interface JAGProjection : NSObject
+
+/**
+ * The projection selecting keyPaths.
+ *
+ * Projections are cached by their set of key paths, so calling this
+ * again with the same paths usually returns the same compiled projection.
+ * The cache holds a few hundred; when it is full it is emptied, so code
+ * that builds key paths on the fly doesn't grow it without bound.
+ *
+ * @param keyPaths NSStrings of property names or dictionary keys, separated by dots.
+ */
++ (JAGProjection *) projectionWithKeyPaths: (NSArray *) keyPaths;
+
+/// The key paths this projection was compiled from.
+@property (nonatomic, readonly, strong) NSSet *keyPaths;
+
+/// Whether everything is selected, as at the end of a key path.
+@property (nonatomic, readonly, getter = isFull) BOOL full;
+
+/**
+ * What is selected within the value of key.
+ *
+ * @return The projection for key's value, or nil if key isn't selected.
+ */
+- (JAGProjection *) projectionForKey: (NSString *) key;
+
+/// What is selected within each element of a collection.
+- (JAGProjection *) elementProjection;
+
+/**
+ * The properties selected from the models codec is for.
+ *
+ * @param codec The codec of the model's class.
+ * @return The selected properties, valid as long as this projection.  The
+ *     projection retains each codec it is asked about, so a codec rebuilt
+ *     after the property cache is invalidated is never mistaken for one
+ *     whose memory it reuses.
+ */
+- (const JAGProjectedProperties *) propertiesForCodec: (JAGClassCodec *) codec;
+
+@end
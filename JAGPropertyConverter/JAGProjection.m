@@ -0,0 +1,211 @@
+//
+//  JAGProjection.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGProjection.h"
+#import "JAGClassCodec.h"
+#import "JAGClassTable.h"
+#import "JAGProperty.h"
+#import <pthread.h>
+
+//The key that matches any key, or stands for the elements of a collection.
+static NSString * const JAGProjectionWildcard = @"*";
+
+//How many compiled projections are kept before the cache is emptied.
+#define JAGProjectionCacheCapacity 256
+
+//Compiled projections, by their set of key paths.  Guarded by gProjectionCacheLock.
+static NSMutableDictionary *gProjections = nil;
+static pthread_mutex_t gProjectionCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+@interface JAGProjection ()
+
+- (void) addKeyPathComponents: (NSArray *) components fromIndex: (NSUInteger) index;
+- (void) addProjection: (JAGProjection *) other;
+- (void) expandWildcards;
+
+@end
+
+@implementation JAGProjection
+{
+@private
+    //Only changed while compiling.
+    NSMutableDictionary *_children;
+    //JAGProjectedProperties by class, and the NSData that hold them, each
+    //followed by its codec, so that no later codec can reuse the address.
+    JAGClassTable _classTable;
+    NSMutableArray *_classProperties;
+    pthread_mutex_t _lock;
+}
+
+@synthesize keyPaths = _keyPaths;
+@synthesize full = _full;
+
++ (JAGProjection *) projectionWithKeyPaths: (NSArray *) keyPaths {
+    NSSet *key = [NSSet setWithArray:keyPaths];
+    pthread_mutex_lock(&gProjectionCacheLock);
+    if (!gProjections) {
+        gProjections = [[NSMutableDictionary alloc] init];
+    }
+    JAGProjection *projection = [gProjections objectForKey:key];
+    if (!projection) {
+        projection = [[JAGProjection alloc] init];
+        projection->_keyPaths = key;
+        for (NSString *keyPath in key) {
+            [projection addKeyPathComponents:[keyPath componentsSeparatedByString:@"."] fromIndex:0];
+        }
+        [projection expandWildcards];
+        if ([gProjections count] >= JAGProjectionCacheCapacity) {
+            //Callers keep the projections they hold; they just aren't shared any more.
+            [gProjections removeAllObjects];
+        }
+        [gProjections setObject:projection forKey:key];
+    }
+    pthread_mutex_unlock(&gProjectionCacheLock);
+    return projection;
+}
+
+- (id) init {
+    self = [super init];
+    if (self) {
+        _children = [[NSMutableDictionary alloc] init];
+        JAGClassTableInit(&_classTable);
+        _classProperties = [[NSMutableArray alloc] init];
+        pthread_mutex_init(&_lock, NULL);
+    }
+    return self;
+}
+
+- (void) dealloc {
+    JAGClassTableDestroy(&_classTable);
+    pthread_mutex_destroy(&_lock);
+}
+
+#pragma mark - Compiling
+
+- (JAGProjection *) childForKey: (NSString *) key {
+    JAGProjection *child = [_children objectForKey:key];
+    if (!child) {
+        child = [[JAGProjection alloc] init];
+        [_children setObject:child forKey:key];
+    }
+    return child;
+}
+
+- (void) addKeyPathComponents: (NSArray *) components fromIndex: (NSUInteger) index {
+    if (_full) return;
+    if (index == [components count]) {
+        //A path ending here selects everything below.
+        _full = YES;
+        [_children removeAllObjects];
+        return;
+    }
+    NSString *component = [components objectAtIndex:index];
+    if (![component length]) {
+        //Ignore empty components, as from "a..b" or a trailing dot.
+        [self addKeyPathComponents:components fromIndex:index + 1];
+        return;
+    }
+    [[self childForKey:component] addKeyPathComponents:components fromIndex:index + 1];
+}
+
+//Select whatever other selects too.  Copies other's nodes, so it can be merged into more than one place.
+- (void) addProjection: (JAGProjection *) other {
+    if (_full) return;
+    if (other->_full) {
+        _full = YES;
+        [_children removeAllObjects];
+        return;
+    }
+    [other->_children enumerateKeysAndObjectsUsingBlock:^(NSString *key, JAGProjection *child, BOOL *stop) {
+        [[self childForKey:key] addProjection:child];
+    }];
+}
+
+/*
+ * Merge the wildcard's selection into each named sibling, so that
+ * projectionForKey: needn't combine them when it is asked.
+ */
+- (void) expandWildcards {
+    JAGProjection *wildcard = [_children objectForKey:JAGProjectionWildcard];
+    [_children enumerateKeysAndObjectsUsingBlock:^(NSString *key, JAGProjection *child, BOOL *stop) {
+        if (wildcard && child != wildcard) {
+            [child addProjection:wildcard];
+        }
+        [child expandWildcards];
+    }];
+}
+
+#pragma mark - Selecting
+
+- (JAGProjection *) projectionForKey: (NSString *) key {
+    if (_full) return self;
+    JAGProjection *child = [_children objectForKey:key];
+    return child ? child : [_children objectForKey:JAGProjectionWildcard];
+}
+
+- (JAGProjection *) elementProjection {
+    JAGProjection *child = _full ? nil : [_children objectForKey:JAGProjectionWildcard];
+    return child ? child : self;
+}
+
+- (const JAGProjectedProperties *) propertiesForCodec: (JAGClassCodec *) codec {
+    Class modelClass = codec.modelClass;
+    uintptr_t found;
+    if (JAGClassTableLookup(&_classTable, modelClass, &found)
+        && ((const JAGProjectedProperties *)found)->codec == codec) {
+        return (const JAGProjectedProperties *)found;
+    }
+    pthread_mutex_lock(&_lock);
+    //Codecs are rebuilt if the class gains properties, so check it is the same one.
+    if (!JAGClassTableLookup(&_classTable, modelClass, &found)
+        || ((const JAGProjectedProperties *)found)->codec != codec) {
+        NSUInteger count = [codec count];
+        NSMutableData *data = [[NSMutableData alloc] initWithLength:sizeof(JAGProjectedProperties)
+                                                                    + count * sizeof(JAGProjectedProperty)];
+        JAGProjectedProperties *selected = [data mutableBytes];
+        selected->codec = codec;
+        for (NSUInteger i = 0; i < count; i++) {
+            JAGProjection *child = [self projectionForKey:[[codec propertyAtIndex:i] name]];
+            if (child) {
+                selected->properties[selected->count].index = i;
+                selected->properties[selected->count].projection = child;
+                selected->count++;
+            }
+        }
+        //A replaced entry stays in _classProperties, since other threads may still be reading it.
+        [_classProperties addObject:data];
+        [_classProperties addObject:codec];
+        found = (uintptr_t)selected;
+        JAGClassTableInsert(&_classTable, modelClass, found);
+    }
+    pthread_mutex_unlock(&_lock);
+    return (const JAGProjectedProperties *)found;
+}
+
+- (NSString *) description {
+    return [NSString stringWithFormat:@"<%@: %@>", NSStringFromClass([self class]),
+            [[_keyPaths allObjects] componentsJoinedByString:@", "]];
+}
+
+@end
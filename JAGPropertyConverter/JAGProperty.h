@@ -42,6 +42,32 @@ typedef enum
 }
 JAGPropertySetterSemantics;
 
+/**
+ * The C type of a property, decoded from its type encoding.
+ * @see scalarKind for more explanation.
+ */
+typedef enum
+{
+    JAGPropertyScalarKindUnknown,
+    JAGPropertyScalarKindChar,
+    JAGPropertyScalarKindInt,
+    JAGPropertyScalarKindShort,
+    JAGPropertyScalarKindLong,
+    JAGPropertyScalarKindLongLong,
+    JAGPropertyScalarKindUnsignedChar,
+    JAGPropertyScalarKindUnsignedInt,
+    JAGPropertyScalarKindUnsignedShort,
+    JAGPropertyScalarKindUnsignedLong,
+    JAGPropertyScalarKindUnsignedLongLong,
+    JAGPropertyScalarKindFloat,
+    JAGPropertyScalarKindDouble,
+    JAGPropertyScalarKindBool,
+    JAGPropertyScalarKindObject,
+    JAGPropertyScalarKindBlock,
+    JAGPropertyScalarKindOther
+}
+JAGPropertyScalarKind;
+
 /**
    JAGProperty is an Objective-C wrapper for a class's properties that
    allows dynamic access to information about the property.
@@ -86,6 +112,9 @@ JAGPropertySetterSemantics;
         property.getter == @selector(getCount);
         property.setterSemantics == JAGPropertySetterSemanticsAssign;
   
+   The attributes are decoded once, when the JAGProperty is created, so all
+   of these methods are cheap to call repeatedly.
+
    You can construct a JAGProperty with the appropriate `objc_property_t` object, but
    JAGPropertyFinder provides the suggested ways to find properties for a given class.
  */
@@ -155,6 +184,19 @@ JAGPropertySetterSemantics;
 
 - (NSString *)oldTypeEncoding;
 
+/**
+ * The C type of the property, as a JAGPropertyScalarKind.
+ *
+ * The numeric kinds correspond to the single-character type encodings
+ * `c`, `i`, `s`, `l`, `q`, `C`, `I`, `S`, `L`, `Q`, `f`, `d` and `B`.
+ * Objects (including `id`) are JAGPropertyScalarKindObject, blocks are
+ * JAGPropertyScalarKindBlock, and structs, unions, pointers and the like
+ * are JAGPropertyScalarKindOther.
+ *
+ * @return The JAGPropertyScalarKind for the typeEncoding.
+ */
+- (JAGPropertyScalarKind)scalarKind;
+
 /// @return Name of ivar backing the property.
 - (NSString *)ivarName;
 
@@ -239,7 +281,9 @@ JAGPropertySetterSemantics;
 /**
  * The class of the property, if it is a defined object.
  *
- * If it is an `id` or not an object, return nil.
+ * If it is an `id` or not an object, return nil.  The class is looked up
+ * by name when first asked for, and again while it isn't loaded, so a
+ * class from a bundle loaded later is found then.
  * @return The Class of the property, or nil if undefined.  
  */
 - (Class) propertyClass;
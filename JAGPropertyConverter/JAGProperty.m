@@ -26,12 +26,85 @@
 // THE SOFTWARE.
 
 #import "JAGProperty.h"
+#import <pthread.h>
+
+enum {
+    JAGPropertyFlagReadOnly             = 1 << 0,
+    JAGPropertyFlagCopy                 = 1 << 1,
+    JAGPropertyFlagRetain               = 1 << 2,
+    JAGPropertyFlagNonAtomic            = 1 << 3,
+    JAGPropertyFlagDynamic              = 1 << 4,
+    JAGPropertyFlagWeakReference        = 1 << 5,
+    JAGPropertyFlagGarbageCollection    = 1 << 6,
+    JAGPropertyFlagWeak                 = 1 << 7,
+    JAGPropertyFlagId                   = 1 << 8,
+    JAGPropertyFlagCollection           = 1 << 9
+};
+
+//Property names are shared between every class that inherits them,
+//so keep a single NSString for each.
+static NSMutableSet *gInternedNames = nil;
+static pthread_mutex_t gInternedNamesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static NSString *JAGInternedName(const char *cName) {
+    NSString *name = [NSString stringWithUTF8String:cName];
+    pthread_mutex_lock(&gInternedNamesLock);
+    if (!gInternedNames) {
+        gInternedNames = [[NSMutableSet alloc] init];
+    }
+    NSString *interned = [gInternedNames member:name];
+    if (interned) {
+        name = interned;
+    } else {
+        [gInternedNames addObject:name];
+    }
+    pthread_mutex_unlock(&gInternedNamesLock);
+    return name;
+}
+
+static JAGPropertyScalarKind JAGScalarKindForEncoding(const char *encoding) {
+    if (!encoding || !encoding[0]) return JAGPropertyScalarKindUnknown;
+    if (encoding[0] == '@') {
+        return strcmp(encoding, "@?") == 0 ? JAGPropertyScalarKindBlock : JAGPropertyScalarKindObject;
+    }
+    //Numbers are only single-character encodings.
+    if (encoding[1] != '\0') return JAGPropertyScalarKindOther;
+    switch (encoding[0]) {
+        case 'c': return JAGPropertyScalarKindChar;
+        case 'i': return JAGPropertyScalarKindInt;
+        case 's': return JAGPropertyScalarKindShort;
+        case 'l': return JAGPropertyScalarKindLong;
+        case 'q': return JAGPropertyScalarKindLongLong;
+        case 'C': return JAGPropertyScalarKindUnsignedChar;
+        case 'I': return JAGPropertyScalarKindUnsignedInt;
+        case 'S': return JAGPropertyScalarKindUnsignedShort;
+        case 'L': return JAGPropertyScalarKindUnsignedLong;
+        case 'Q': return JAGPropertyScalarKindUnsignedLongLong;
+        case 'f': return JAGPropertyScalarKindFloat;
+        case 'd': return JAGPropertyScalarKindDouble;
+        case 'B': return JAGPropertyScalarKindBool;
+        default:  return JAGPropertyScalarKindOther;
+    }
+}
 
 @implementation JAGProperty
 {
 @private
-    objc_property_t     _property;
-    NSArray             *_attributes;
+    objc_property_t         _property;
+    NSString                *_name;
+    NSString                *_attributeEncodings;
+    NSString                *_typeEncoding;
+    NSString                *_oldTypeEncoding;
+    NSString                *_ivarName;
+    NSString                *_propertyClassName;
+    //Resolved from _propertyClassName on first use, since the class may be loaded later.
+    __unsafe_unretained Class _propertyClass;
+    SEL                     _customGetter;
+    SEL                     _getter;
+    SEL                     _customSetter;
+    SEL                     _setter;
+    JAGPropertyScalarKind   _scalarKind;
+    unsigned int            _flags;
 }
 
 + (id)propertyWithObjCProperty: (objc_property_t)property
@@ -44,11 +117,85 @@
     if((self = [self init]))
     {
         _property = property;
-        _attributes = [[[NSString stringWithUTF8String: property_getAttributes(property)] componentsSeparatedByString: @","] copy];
+        _name = JAGInternedName(property_getName(property));
+        [self parseAttributes: property_getAttributes(property)];
     }
     return self;
 }
 
+/*
+ * Decode the comma-separated attribute string once, so that
+ * every accessor afterwards is a plain field read.
+ */
+- (void)parseAttributes: (const char *)attributes
+{
+    NSMutableArray *otherAttributes = [NSMutableArray array];
+    const char *cursor = attributes ? attributes : "";
+    while (*cursor) {
+        const char *end = strchr(cursor, ',');
+        size_t length = end ? (size_t)(end - cursor) : strlen(cursor);
+        if (length == 0) {
+            cursor++;
+            continue;
+        }
+        NSString *content = [[NSString alloc] initWithBytes: cursor + 1
+                                                     length: length - 1
+                                                   encoding: NSUTF8StringEncoding];
+        switch (cursor[0]) {
+            case 'T': _typeEncoding = content; break;
+            case 'V': _ivarName = content; break;
+            case 't': _oldTypeEncoding = content; break;
+            case 'R': _flags |= JAGPropertyFlagReadOnly; break;
+            case 'C': _flags |= JAGPropertyFlagCopy; break;
+            case '&': _flags |= JAGPropertyFlagRetain; break;
+            case 'N': _flags |= JAGPropertyFlagNonAtomic; break;
+            case 'D': _flags |= JAGPropertyFlagDynamic; break;
+            case 'W': _flags |= JAGPropertyFlagWeakReference; break;
+            case 'P': _flags |= JAGPropertyFlagGarbageCollection; break;
+            case 'G': _customGetter = NSSelectorFromString(content); break;
+            case 'S': _customSetter = NSSelectorFromString(content); break;
+        }
+        if (cursor[0] != 'T' && cursor[0] != 'V') {
+            [otherAttributes addObject: [[NSString alloc] initWithBytes: cursor
+                                                                  length: length
+                                                                encoding: NSUTF8StringEncoding]];
+        }
+        cursor += length;
+        if (*cursor == ',') cursor++;
+    }
+    _attributeEncodings = [otherAttributes componentsJoinedByString: @","];
+
+    _scalarKind = JAGScalarKindForEncoding([_typeEncoding UTF8String]);
+    if ([_typeEncoding isEqualToString: @"@"]) {
+        _flags |= JAGPropertyFlagId;
+    }
+    if (_scalarKind == JAGPropertyScalarKindObject) {
+        //typeEncoding looks like '@"AModel"'.  This is with the @ and "s.
+        NSArray *encodingComponents = [_typeEncoding componentsSeparatedByString:@"\""];
+        //'@"<AProtocol>"' names no class.
+        if ([encodingComponents count] >= 2 && [[encodingComponents objectAtIndex:1] length]
+            && ![[encodingComponents objectAtIndex:1] hasPrefix:@"<"]) {
+            _propertyClassName = [encodingComponents objectAtIndex:1];
+        }
+    }
+    if ((_flags & JAGPropertyFlagWeakReference) ||
+        ([self isObject] && [self setterSemantics] == JAGPropertySetterSemanticsAssign)) {
+        _flags |= JAGPropertyFlagWeak;
+    }
+
+    _getter = _customGetter ? _customGetter : NSSelectorFromString(_name);
+    if (_customSetter) {
+        _setter = _customSetter;
+    } else if ([_name length] > 0) {
+        NSString *setterName = [NSString stringWithFormat:
+                               @"set%@%@:", 
+                                [[_name substringToIndex:1] uppercaseString],
+                                [_name substringFromIndex:1]
+                                ];
+        _setter = NSSelectorFromString(setterName);
+    }
+}
+
 
 - (NSString *)description
 {
@@ -71,170 +218,129 @@
 
 - (NSString *)name
 {
-    return [NSString stringWithUTF8String: property_getName(_property)];
+    return _name;
 }
 
 - (NSString *)attributeEncodings
 {
-    NSPredicate *filter = [NSPredicate predicateWithFormat: @"NOT (self BEGINSWITH 'T') AND NOT (self BEGINSWITH 'V')"];
-    return [[_attributes filteredArrayUsingPredicate: filter] componentsJoinedByString: @","];
-}
-
-- (BOOL)hasAttribute: (NSString *)code
-{
-    for(NSString *encoded in _attributes)
-        if([encoded hasPrefix: code]) return YES;
-    return NO;
+    return _attributeEncodings;
 }
 
 - (BOOL)isReadOnly
 {
-    return [self hasAttribute: @"R"];
+    return (_flags & JAGPropertyFlagReadOnly) != 0;
 }
 
 - (JAGPropertySetterSemantics)setterSemantics
 {
-    if([self hasAttribute: @"C"]) return JAGPropertySetterSemanticsCopy;
-    if([self hasAttribute: @"&"]) return JAGPropertySetterSemanticsRetain;
+    if(_flags & JAGPropertyFlagCopy) return JAGPropertySetterSemanticsCopy;
+    if(_flags & JAGPropertyFlagRetain) return JAGPropertySetterSemanticsRetain;
     return JAGPropertySetterSemanticsAssign;
 }
 
 - (BOOL)isNonAtomic
 {
-    return [self hasAttribute: @"N"];
+    return (_flags & JAGPropertyFlagNonAtomic) != 0;
 }
 
 - (BOOL)isDynamic
 {
-    return [self hasAttribute: @"D"];
+    return (_flags & JAGPropertyFlagDynamic) != 0;
 }
 
 - (BOOL)isWeakReference
 {
-    return [self hasAttribute: @"W"];
+    return (_flags & JAGPropertyFlagWeakReference) != 0;
 }
 
 - (BOOL)isWeak {
-    return [self isWeakReference] || ([self isObject] && [self setterSemantics] == JAGPropertySetterSemanticsAssign);
+    return (_flags & JAGPropertyFlagWeak) != 0;
 }
 
 - (BOOL)isEligibleForGarbageCollection
 {
-    return [self hasAttribute: @"P"];
-}
-
-- (NSString *)contentOfAttribute: (NSString *)code
-{
-    for(NSString *encoded in _attributes)
-        if([encoded hasPrefix: code]) return [encoded substringFromIndex: 1];
-    return nil;
+    return (_flags & JAGPropertyFlagGarbageCollection) != 0;
 }
 
 - (SEL)customGetter
 {
-    return NSSelectorFromString([self contentOfAttribute: @"G"]);
+    return _customGetter;
 }
 
 - (SEL)getter
 {
-    SEL getter = [self customGetter];
-    if (!getter) {
-        getter = NSSelectorFromString([self name]);
-    }
-    return getter;
+    return _getter;
 }
 
 - (SEL)customSetter
 {
-    return NSSelectorFromString([self contentOfAttribute: @"S"]);
+    return _customSetter;
 }
 
 - (SEL)setter
 {
-    SEL setter = [self customSetter];
-    if (!setter) {
-        NSString *propName = [self name];
-        NSString *setterName = [NSString stringWithFormat:
-                               @"set%@%@:", 
-                                [[propName substringToIndex:1] uppercaseString],
-                                [propName substringFromIndex:1]
-                                ];
-        setter = NSSelectorFromString(setterName);
-    }
-    return setter;
+    return _setter;
 }
 
 - (NSString *)typeEncoding
 {
-    return [self contentOfAttribute: @"T"];
+    return _typeEncoding;
 }
 
 - (NSString *)oldTypeEncoding
 {
-    return [self contentOfAttribute: @"t"];
+    return _oldTypeEncoding;
 }
 
 - (NSString *)ivarName
 {
-    return [self contentOfAttribute: @"V"];
+    return _ivarName;
 }
 
-
+- (JAGPropertyScalarKind) scalarKind
+{
+    return _scalarKind;
+}
 
 - (Class) propertyClass {
-    if (! [self isObject]) return nil;
-    NSArray *encodingComponents = [[self typeEncoding] componentsSeparatedByString:@"\""];
-    if ([encodingComponents count] < 2) {
-        //id looks like '@', blocks like '@?'
-        return nil;
+    Class propertyClass = _propertyClass;
+    if (!propertyClass && _propertyClassName) {
+        //Only a class that was found is kept, so one loaded later is found then.
+        propertyClass = NSClassFromString(_propertyClassName);
+        if (propertyClass) {
+            if ([propertyClass isSubclassOfClass:[NSArray class]]
+                || [propertyClass isSubclassOfClass:[NSSet class]]) {
+                __sync_fetch_and_or(&_flags, JAGPropertyFlagCollection);
+            }
+            //Publish the flag before the class, which readers check first.
+            __sync_synchronize();
+            _propertyClass = propertyClass;
+        }
     }
-    //typeEncoding looks like '@"AModel"'.  This is with the @ and "s.
-    NSString *className = [encodingComponents objectAtIndex:1];
-    Class class = NSClassFromString(className);
-    return class;
+    return propertyClass;
 }
 
 - (BOOL) isNumber
 {
-    NSString *typeEncoding = [self typeEncoding];
-    return ([typeEncoding isEqualToString: @"i"]
-            || [typeEncoding isEqualToString: @"I"]
-            || [typeEncoding isEqualToString: @"s"]
-            || [typeEncoding isEqualToString: @"S"]
-            || [typeEncoding isEqualToString: @"l"]
-            || [typeEncoding isEqualToString: @"L"]
-            || [typeEncoding isEqualToString: @"q"]
-            || [typeEncoding isEqualToString: @"Q"]
-            || [typeEncoding isEqualToString: @"f"]
-            || [typeEncoding isEqualToString: @"d"]
-            || [typeEncoding isEqualToString: @"B"]
-            || [typeEncoding isEqualToString: @"c"]
-            || [typeEncoding isEqualToString: @"C"]
-            );
+    return _scalarKind >= JAGPropertyScalarKindChar && _scalarKind <= JAGPropertyScalarKindBool;
 }
 
 - (BOOL) isObject
 {
-    return [[self typeEncoding] hasPrefix: @"@"] && ![self isBlock];
+    return _scalarKind == JAGPropertyScalarKindObject;
 }
 
 - (BOOL) isBlock {
-    return [[self typeEncoding] isEqualToString:@"@?"];
+    return _scalarKind == JAGPropertyScalarKindBlock;
 }
 
 - (BOOL) isId {
-    return [[self typeEncoding] isEqualToString:@"@"];
+    return (_flags & JAGPropertyFlagId) != 0;
 }
 
 - (BOOL) isCollection {
-    Class propClass = [self propertyClass];
-    return (propClass && 
-        (
-         [propClass isSubclassOfClass:[NSArray class]]
-         || [propClass isSubclassOfClass:[NSSet class]]
-        )
-    );
-        
+    if (!_propertyClass && ![self propertyClass]) return NO;
+    return (_flags & JAGPropertyFlagCollection) != 0;
 }
 
 - (BOOL) canAcceptValue: (id) value {
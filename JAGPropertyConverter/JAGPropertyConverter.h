@@ -26,6 +26,13 @@
 
 #import <Foundation/Foundation.h>
 
+@class JAGJSONWriter;
+@class JAGJSONReader;
+@class JAGMessagePackWriter;
+@class JAGModelPool;
+@class JAGDateCodec;
+@class JAGProjection;
+
 /**
  * The type of output the objects will be converted to.
  * @see outputType for more detailed description.
@@ -33,7 +40,8 @@
 typedef enum {
     kJAGFullOutput,
     kJAGPropertyListOutput,
-    kJAGJSONOutput
+    kJAGJSONOutput,
+    kJAGMessagePackOutput
 } JAGOutputType;
 
 ///A Block to identify what class a dictionary represents.
@@ -42,6 +50,46 @@ typedef Class (^IdentifyBlock)(NSDictionary *dictionary);
 ///A Block to convert one object to another, for converting to/from JSON
 typedef id (^ConvertBlock)(id obj);
 
+/**
+ * The kinds of problem the converter reports to its diagnosticHandler.
+ */
+typedef enum {
+    ///A value couldn't be converted, and was left out.  The context is its key or target class, if any.
+    kJAGDiagnosticDroppedValue,
+    ///A dictionary key that isn't an NSString was skipped for JSON output.
+    kJAGDiagnosticBadKeyType,
+    ///A value couldn't be set into a property.  The context is the JAGProperty.
+    kJAGDiagnosticUnsettableProperty,
+    ///An object's class isn't safe for the outputType, or can't be composed.  The context is the target class, if any.
+    kJAGDiagnosticUnknownClass,
+    ///A collection couldn't be converted to the target collection class, which is the context.
+    kJAGDiagnosticTypeMismatch,
+    ///A JAGReferenceKey named a model that hasn't been composed.  The value is the identifier.
+    kJAGDiagnosticUnresolvedReference,
+    ///A class's generated codec doesn't match its properties, so reflection was used instead.  The value is the class.
+    kJAGDiagnosticStaleGeneratedCodec
+} JAGDiagnosticCode;
+
+/**
+ * A Block that receives the converter's diagnostics.
+ *
+ * value is the object concerned, which may be nil, and context depends
+ * on code.  Pass them to JAGDiagnosticDescription for a message.
+ */
+typedef void (^DiagnosticBlock)(JAGDiagnosticCode code, id value, id context);
+
+///A readable description of a diagnostic.  Formatting it is the expensive part, so only call this when needed.
+extern NSString *JAGDiagnosticDescription(JAGDiagnosticCode code, id value, id context);
+
+///The key that identifies a model referred to elsewhere, when shouldPreserveIdentity is set.
+extern NSString * const JAGIdentityKey;
+
+///The key of a reference to a model with a JAGIdentityKey, when shouldPreserveIdentity is set.
+extern NSString * const JAGReferenceKey;
+
+///The key of a patch to the elements of an array, in a patch from patchForModel:.
+extern NSString * const JAGPatchElementsKey;
+
 /**
    JAGPropertyConverter handles the decomposition of a Model object into an NSDictionary of basic types, and
    the (re)composition of NSDictionaries into model objects.
@@ -101,6 +149,11 @@ typedef id (^ConvertBlock)(id obj);
  * kJAGJSONOutput means that any object that can't be converted
  * and isn't a valid JSON value will be dropped.  It also means
  * that non-NSString dictionary keys will be dropped.
+ *
+ * kJAGMessagePackOutput means that any object that can't be converted
+ * and isn't a valid MessagePack value will be dropped, and that
+ * non-NSString dictionary keys will be dropped.  Unlike JSON, NSDates,
+ * NSData and non-finite numbers are kept.
  */
 @property (nonatomic, assign) JAGOutputType outputType;
 
@@ -137,8 +190,12 @@ typedef id (^ConvertBlock)(id obj);
  * Also when setting a Model's properties, if the property class is a subclass
  * of these classes, the converter will coerce an unidentified NSDictionary
  * into the property.
+ *
+ * The set is copied.  The converter caches how it handles each class it sees,
+ * and that cache is reset whenever classesToConvert or outputType is assigned,
+ * so to change the classes, assign a new set rather than mutating the old one.
  */
-@property (nonatomic, strong) NSSet *classesToConvert;
+@property (nonatomic, copy) NSSet *classesToConvert;
 
 /**
  * A Block to convert a (JSON) property to an NSDate.
@@ -172,6 +229,19 @@ typedef id (^ConvertBlock)(id obj);
  */
 @property (nonatomic, copy) ConvertBlock convertFromDate;
 
+/**
+ * A built-in converter for NSDate properties, used instead of convertToDate and convertFromDate.
+ *
+ * Default is nil.  If set, NSDates are converted to JSON values, and values
+ * are composed into NSDate properties, by the codec's ISO 8601 or epoch
+ * format, which is much faster than an NSDateFormatter in a Block.
+ *
+ *     converter.dateCodec = [JAGDateCodec codecWithFormat:kJAGDateFormatISO8601];
+ *
+ * @see JAGDateCodec
+ */
+@property (nonatomic, strong) JAGDateCodec *dateCodec;
+
 /**
  * A NumberFormatter to convert NSStrings to number of NSNumber properties.
  *
@@ -184,21 +254,206 @@ typedef id (^ConvertBlock)(id obj);
  */
 @property (nonatomic, strong) NSNumberFormatter *numberFormatter;
 
+/**
+ * Whether to parse NSStrings for numeric properties with the converter's own parser.
+ *
+ * Default is NO.  If YES, NSStrings for properties of a primitive numeric type
+ * or NSNumber are parsed as numbers, without regard to locale, much more
+ * quickly than with numberFormatter.  Integers are exact, other numbers are
+ * the nearest double, and primitive properties are set without boxing the
+ * value.  A value that isn't a number, or doesn't fit in the property (such
+ * as "300" for a char, or "1.5" for an int) leaves the property unset, with
+ * a kJAGDiagnosticUnsettableProperty diagnostic.
+ *
+ * The accepted format is an optional sign, digits, and optional fraction and
+ * exponent, as in "-12", "3.25" or "1e-3".  If numberFormatter is set too,
+ * it is given the strings this rejects.
+ */
+@property (nonatomic, assign) BOOL shouldParseNumericStrings;
+
 /**
  * Whether an object's weak properties should be converted to dictionary values.
  *
  * Default is NO, since weak properties often denote
  * retain cycles and thus cyclical object graphs, which the converter
- * does not handle.
+ * does not handle unless shouldPreserveIdentity is set.
  */
 @property (nonatomic, assign) BOOL shouldConvertWeakProperties;
 
+/**
+ * The smallest array that convertToDictionaries: and
+ * composeModelsFromArray:ofClass: split across cores.
+ *
+ * Smaller arrays are converted serially on the calling thread, as are all
+ * arrays while shouldPreserveIdentity is set.
+ * Default is 1024.  If 0, batches are always converted serially.
+ */
+@property (nonatomic, assign) NSUInteger batchThreshold;
+
+/**
+ * How many elements of a collection are converted between autorelease pool drains.
+ *
+ * Converting an element can leave autoreleased temporaries behind.  Without
+ * a drain, those of every element of a large collection stay alive until the
+ * caller's pool is drained.  So collections larger than this are converted
+ * in stretches of this many elements, each inside its own @autoreleasepool,
+ * bounding the converter's peak memory whatever the collection size.
+ *
+ * Default is 256.  If 0, the converter never drains autoreleased objects itself.
+ */
+@property (nonatomic, assign) NSUInteger autoreleaseInterval;
+
+/**
+ * Whether each model is converted only once per call, however often it is referenced.
+ *
+ * Default is NO, in which case a model referenced twice is decomposed twice,
+ * and a cycle of strong properties never terminates.
+ *
+ * If YES, each call to decomposeObject:, convertToDictionary: and the
+ * other conversion methods keeps a map of the models it has seen.
+ * When decomposing, a later reference to a model reuses its NSDictionary.
+ * A reference back to a model whose dictionary is still being built
+ * (a cycle) is decomposed to `{JAGReferenceKey: n}` instead, and the model's
+ * dictionary gets `JAGIdentityKey: n`.  JSON written directly by
+ * JSONDataFromObject: and its relatives can't reuse output, so there every
+ * model gets a JAGIdentityKey, and every later reference is written as a
+ * JAGReferenceKey.
+ *
+ * When composing, the same NSDictionary is composed into the same model
+ * each time, and a dictionary with a JAGReferenceKey is replaced by the
+ * model composed from the dictionary with the matching JAGIdentityKey.
+ * The batch methods keep one map for the whole array, and so convert it
+ * serially, whatever batchThreshold is.
+ */
+@property (nonatomic, assign) BOOL shouldPreserveIdentity;
+
+/**
+ * Whether nested models and collections are composed only when first read.
+ *
+ * Default is NO.  If YES, setPropertiesOf:fromDictionary: (and the methods
+ * that use it) doesn't compose an NSDictionary or collection value for a
+ * property whose propertyClass is in classesToConvert, an NSArray or an NSSet.
+ * Instead, the value is kept and composed by the first call to the property's
+ * getter.  That uses a frozenCopy of the converter as it was when the value
+ * was decoded, made once per configuration, so reconfiguring the converter
+ * afterwards doesn't change how the value is composed, and the model doesn't
+ * keep the converter alive.  Diagnostics from it are counted by that copy,
+ * though still passed to the same diagnosticHandler.  See JAGLazyHydrator
+ * for how, and [JAGLazyHydrator hydrateModel:] to compose everything at once.
+ *
+ * The kept dictionaries and arrays must not be changed until then.  Lazy
+ * composition is not used when shouldPreserveIdentity is set, since references
+ * can only be resolved during the call.
+ */
+@property (nonatomic, assign) BOOL shouldComposeLazily;
+
+/**
+ * Whether setPropertiesOf:fromDictionary: updates the values a model already has in place.
+ *
+ * Default is NO, in which case every nested model and collection is composed
+ * anew and every property is set.  If YES:
+ *
+ * - A property whose value is equal to the new one isn't set at all, so
+ *   no Key-Value Observing notification is sent for it.
+ * - An NSDictionary for a property that already holds a model (one in
+ *   classesToConvert) updates that model, unless identifyDict identifies
+ *   the dictionary as a different class.
+ * - If mergeKey is set, the elements of an NSArray or NSSet property are
+ *   matched to the new NSDictionaries by their mergeKey values, and matched
+ *   models are updated and reused.  If the result holds the same elements
+ *   as before, the property isn't set.
+ *
+ * Use this to refresh cached models without reallocating their graphs.
+ */
+@property (nonatomic, assign) BOOL shouldMergeInPlace;
+
+/**
+ * The name of the property that identifies the models in a collection, when merging.
+ *
+ * Default is nil, in which case collections are composed anew even when
+ * shouldMergeInPlace is set.  @see shouldMergeInPlace
+ */
+@property (nonatomic, copy) NSString *mergeKey;
+
+/**
+ * Where composed models come from.
+ *
+ * Default is nil, in which case every model is created with `alloc`/`init`.
+ * If set, models are taken from the pool when it has any of the right class;
+ * return them with recycleModel:.  @see JAGModelPool
+ */
+@property (nonatomic, strong) JAGModelPool *modelPool;
+
+/**
+ * Whether to use the codecs generated by Tools/jagcodegen.py, for classes that have one.
+ *
+ * Default is YES.  A generated codec calls the accessors of its class
+ * directly, in convertToDictionary: and setPropertiesOf:fromDictionary:,
+ * with the same results as the reflective path; it is not used while
+ * shouldMergeInPlace or shouldComposeLazily is set.  @see JAGGeneratedCodec.h
+ */
+@property (nonatomic, assign) BOOL shouldUseGeneratedCodecs;
+
+/**
+ * A Block called whenever the converter drops a value or can't set a property.
+ *
+ * Every diagnostic is counted (see diagnosticCountForCode:) whether or not
+ * this is set.  If it is nil, the default, the 1st, 2nd, 4th, 8th, ...
+ * occurrence of each code is logged with NSLog, so that a payload with
+ * many unconvertible values doesn't flood the log.
+ *
+ * The Block is called synchronously, possibly from several threads
+ * during batch conversion, and should be quick.
+ */
+@property (nonatomic, copy) DiagnosticBlock diagnosticHandler;
+
 #pragma mark - Lifecycle
 
 + (JAGPropertyConverter *) converterWithOutputType: (JAGOutputType) outputType;
 
 - (id) initWithOutputType: (JAGOutputType) outputType;
 
+#pragma mark - Sharing
+
+/**
+ * An immutable copy of the converter, which any number of threads can share.
+ *
+ * The copy is an instance of the receiver's class, with the same value for
+ * every writable property, including those a subclass declares.  It gets
+ * its own copies of numberFormatter and dateCodec, and a new, empty
+ * modelPool of the same capacity, so reconfiguring those through the
+ * receiver doesn't affect it.  Blocks, such as identifyDict and
+ * diagnosticHandler, are shared, and will be called from all of those
+ * threads.  (NSNumberFormatter isn't thread-safe before iOS 7; prefer
+ * shouldParseNumericStrings.)  Its caches are warmed for classesToConvert.
+ * Calling a setter on the copy raises an NSInternalInconsistencyException;
+ * a subclass's own setters should check isFrozen to do the same.
+ *
+ * Every converter reads its caches without locking, so an unfrozen one
+ * can also convert on several threads at once, but it mustn't be
+ * reconfigured while it is converting.  A frozen one can't be.
+ *
+ * @return A frozen converter, or the receiver if it is already frozen.
+ */
+- (JAGPropertyConverter *) frozenCopy;
+
+///Whether this converter came from frozenCopy, and can't be reconfigured.
+@property (nonatomic, readonly, getter = isFrozen) BOOL frozen;
+
+#pragma mark - Diagnostics
+
+/**
+ * How many times a diagnostic has been reported since the converter was
+ * created or resetDiagnosticCounts was called.
+ *
+ * @param code The kind of diagnostic.
+ * @return The number of times it was reported.
+ */
+- (NSUInteger) diagnosticCountForCode: (JAGDiagnosticCode) code;
+
+///Set all diagnostic counts to zero.
+- (void) resetDiagnosticCounts;
+
 #pragma mark - Decompose Model
 
 /**
@@ -243,6 +498,97 @@ typedef id (^ConvertBlock)(id obj);
  */
 - (NSDictionary*) convertToDictionary: (id) model;
 
+/**
+ * Convert only part of an object (or collection of objects), as decomposeObject: does.
+ *
+ * Unselected properties of models are skipped without calling their
+ * getters, and unselected keys of NSDictionaries are left out.
+ *
+ * @param object The model object (or collection of model objects) to convert.
+ * @param projection What to convert, or nil for everything.
+ * @return The selected part of decomposeObject:'s result.
+ */
+- (id) decomposeObject: (id) object projection: (JAGProjection *) projection;
+
+/**
+ * Convert only the selected properties of a model, as convertToDictionary: does.
+ *
+ * @see decomposeObject:projection:
+ *
+ * @param model The model object to convert.
+ * @param projection Which properties to convert, and what within them, or nil for everything.
+ * @return An NSDictionary of the selected properties.
+ */
+- (NSDictionary*) convertToDictionary: (id) model projection: (JAGProjection *) projection;
+
+#pragma mark - Encode JSON
+
+/**
+ * Encode an object (or collection of objects) directly into JSON data.
+ *
+ * The result is the same as serializing the output of decomposeObject:
+ * with an outputType of kJAGJSONOutput (regardless of this converter's
+ * outputType): NaN and infinite numbers are dropped, NSDates are passed through
+ * convertFromDate, NSURLs become strings, NSSets become arrays, and weak
+ * properties are skipped unless shouldConvertWeakProperties is set.
+ * Models are written straight into the output buffer, without building
+ * an intermediate tree of NSDictionaries and NSArrays.
+ *
+ * @param object The model object (or collection of model objects) to encode.
+ * @return UTF-8 JSON data, or nil if object can't be represented in JSON.
+ */
+- (NSData *) JSONDataFromObject: (id) object;
+
+/**
+ * Encode an object (or collection of objects) as JSON into an NSOutputStream.
+ *
+ * The JSON is buffered and written to the stream in 64KB chunks.
+ * Use writeJSONFromObject:toWriter: to choose a different chunk size.
+ *
+ * @param object The model object (or collection of model objects) to encode.
+ * @param stream An open NSOutputStream.
+ * @param error Set to the stream's error if writing fails, or to a JAGJSONWriterErrorDomain
+ * error if object is nil or can't be represented in JSON.
+ * @return YES if the object was written.
+ */
+- (BOOL) writeJSONFromObject: (id) object toStream: (NSOutputStream *) stream error: (NSError **) error;
+
+/**
+ * Encode an object (or collection of objects) as JSON into a JAGJSONWriter.
+ *
+ * The writer is not flushed.
+ *
+ * @param object The model object (or collection of model objects) to encode.
+ * @param writer The JAGJSONWriter to write to.
+ * @return NO if nothing was written, because object can't be represented in JSON.
+ */
+- (BOOL) writeJSONFromObject: (id) object toWriter: (JAGJSONWriter *) writer;
+
+#pragma mark - Encode MessagePack
+
+/**
+ * Encode an object (or collection of objects) directly into MessagePack data.
+ *
+ * The result is the same as encoding the output of decomposeObject:
+ * with an outputType of kJAGMessagePackOutput: NSDates become MessagePack
+ * timestamps, NSData becomes binary, NaN and infinite numbers are kept,
+ * NSURLs become strings, and NSSets become arrays.  Like JSONDataFromObject:,
+ * models are written straight into the output buffer.
+ *
+ * @param object The model object (or collection of model objects) to encode.
+ * @return MessagePack data, or nil if object can't be represented in MessagePack.
+ */
+- (NSData *) messagePackDataFromObject: (id) object;
+
+/**
+ * Encode an object (or collection of objects) as MessagePack into a JAGMessagePackWriter.
+ *
+ * @param object The model object (or collection of model objects) to encode.
+ * @param writer The JAGMessagePackWriter to write to.
+ * @return NO if nothing was written, because object can't be represented in MessagePack.
+ */
+- (BOOL) writeMessagePackFromObject: (id) object toWriter: (JAGMessagePackWriter *) writer;
+
 #pragma mark - Compose Model
 
 /**
@@ -272,4 +618,266 @@ typedef id (^ConvertBlock)(id obj);
  */
 - (void) setPropertiesOf: (id) model fromDictionary: (NSDictionary*) dictionary;
 
+/**
+ * Set only the selected properties of model from the entries of dictionary.
+ *
+ * Unselected keys are ignored without composing their values, and within
+ * a selected value, unselected keys of its dictionaries are ignored in turn.
+ *
+ * @param model Model to set the properties of.
+ * @param dictionary Dictionary of values for the model's properties.
+ * @param projection Which properties to set, and what within them, or nil for everything.
+ */
+- (void) setPropertiesOf: (id) model fromDictionary: (NSDictionary*) dictionary projection: (JAGProjection *) projection;
+
+/**
+ * Return model, and the models it holds, to modelPool.
+ *
+ * Models in model's properties, and in the NSArrays, NSSets and NSDictionaries
+ * of its properties, are recycled too, if their classes are in classesToConvert.
+ * Call this once nothing else refers to any of them.  Does nothing if modelPool is nil.
+ *
+ * @param model Model to recycle.
+ */
+- (void) recycleModel: (id) model;
+
+#pragma mark - Changes
+
+/**
+ * Record model's current state, for patchForModel: to compare against.
+ *
+ * The baseline is the model's convertToDictionary: output, kept with the model
+ * until the next call.  Call this again once a patch has been sent.
+ *
+ * @param model The model object to track.
+ */
+- (void) recordBaselineForModel: (id) model;
+
+/**
+ * The changes to model since recordBaselineForModel: was last called.
+ *
+ * Only properties whose decomposed values differ from the baseline are
+ * included.  A property that has become nil is included as NSNull.  For a
+ * nested model (one in classesToConvert) that was in the baseline, the patch
+ * holds a nested patch of the changes to it, whether or not it's the same
+ * instance.  For an NSArray the same length as in the baseline, the patch
+ * holds `{JAGPatchElementsKey: {index: change}}`, with each changed element's
+ * index as a decimal string, and its nested patch or new value.  Other
+ * values, including sets, dictionaries and arrays whose length changed, are
+ * included whole.  Unchanged nested values are compared without being
+ * decomposed again where possible, so a patch is cheaper to make than a full
+ * convertToDictionary:.
+ *
+ * If shouldPreserveIdentity is set, references in the baseline are followed,
+ * and a model reached more than once is compared only the first time; a
+ * property that now holds a model the baseline held elsewhere is included whole.
+ *
+ * @param model The model object to compare to its baseline.
+ * @return A dictionary of the changed properties, empty if nothing changed,
+ * or nil if no baseline was recorded.
+ */
+- (NSDictionary *) patchForModel: (id) model;
+
+/**
+ * Apply a patch from patchForModel: to a model.
+ *
+ * Values are set with the semantics of setPropertiesOf:fromDictionary:,
+ * except that an NSNull sets an object property to nil, and a nested patch
+ * is applied to the model or array the property already holds, if any.
+ *
+ * @param patch A patch from patchForModel:.
+ * @param model The model object to change.
+ */
+- (void) applyPatch: (NSDictionary *) patch toModel: (id) model;
+
+#pragma mark - Batch Conversion
+
+/**
+ * Convert each model in an array into an NSDictionary, as by convertToDictionary:.
+ *
+ * Arrays with at least batchThreshold models are split into chunks which are
+ * converted concurrently.  The converter's caches are safe to use from
+ * several threads, but identifyDict, convertToDate, convertFromDate and
+ * numberFormatter may be called concurrently, so they must be too.  Neither
+ * the converter's configuration nor the models may be changed during the call.
+ *
+ * @param models An array of model objects.
+ * @return An array of NSDictionaries, in the same order as models.
+ */
+- (NSArray *) convertToDictionaries: (NSArray *) models;
+
+/**
+ * Compose each object in an array into a model.
+ *
+ * NSDictionaries become new instances of modelClass (or of the class
+ * identifyDict gives them, if any), populated via
+ * setPropertiesOf:fromDictionary:.  Other objects are composed as by
+ * composeModelFromObject:, with modelClass as the target class.
+ * Objects that can't be composed are dropped.
+ *
+ * Large arrays are composed concurrently, as for convertToDictionaries:.
+ *
+ * @param array An array of NSDictionaries (or other objects).
+ * @param modelClass The class of the models, or nil to use identifyDict.
+ * @return An array of models, in the same order as array.
+ */
+- (NSArray *) composeModelsFromArray: (NSArray *) array ofClass: (Class) modelClass;
+
+/**
+ * Convert an array of numeric NSStrings into NSNumbers, in one pass.
+ *
+ * Strings are parsed as with shouldParseNumericStrings, falling back to
+ * numberFormatter if it is set.  Elements that can't be converted become
+ * NSNull, so that the result lines up with strings.
+ *
+ * @param strings An array of NSStrings.
+ * @return An array of NSNumbers and NSNulls, the same length as strings.
+ */
+- (NSArray *) numbersFromStrings: (NSArray *) strings;
+
+#pragma mark - Decode JSON
+
+/**
+ * Compose a model (or array of models) directly from JSON data.
+ *
+ * The result is the same as parsing data with NSJSONSerialization and
+ * passing the dictionary to setPropertiesOf:fromDictionary: on a new
+ * instance of modelClass, but properties are set while the JSON is read,
+ * without building an intermediate tree of NSDictionaries and NSArrays.
+ * Numeric properties are set without boxing.
+ *
+ * If the JSON is an object, it is composed into an instance of modelClass.
+ * If it is an array, each object in it is composed into an instance of
+ * modelClass.  If modelClass is nil, the JSON is composed as by
+ * composeModelFromObject:.
+ *
+ * Nested objects are handled as by composeModelFromObject:withTargetClass:,
+ * using each JAGProperty's propertyClass as the target class.  Since
+ * identifyDict needs to see a whole dictionary, when it is set each nested
+ * JSON object is read into an NSDictionary before being composed.
+ *
+ * @param data UTF-8 JSON data.
+ * @param modelClass The class of the top-level model(s).
+ * @param error Set if data is not valid JSON.
+ * @return The composed model (or array of models), or nil on error.
+ */
+- (id) composeModelFromJSONData: (NSData *) data ofClass: (Class) modelClass error: (NSError **) error;
+
+/**
+ * Compose a model (or array of models) from JSON read from an NSInputStream.
+ *
+ * Only a 64KB buffer of the stream is held at a time.
+ * @see composeModelFromJSONData:ofClass:error:
+ *
+ * @param stream An open NSInputStream of UTF-8 JSON.
+ * @param modelClass The class of the top-level model(s).
+ * @param error Set if the JSON is invalid, or reading the stream fails.
+ * @return The composed model (or array of models), or nil on error.
+ */
+- (id) composeModelFromJSONStream: (NSInputStream *) stream ofClass: (Class) modelClass error: (NSError **) error;
+
+/**
+ * Compose the next JSON value from a JAGJSONReader.
+ *
+ * Unlike composeModelFromJSONData:ofClass:error:, this does not check
+ * that the value is the end of the input.
+ * @see composeModelFromJSONData:ofClass:error:
+ *
+ * @param reader The JAGJSONReader to read from.
+ * @param modelClass The class of the model(s).
+ * @return The composed model (or array of models), or nil if the reader reports an error.
+ */
+- (id) composeModelFromJSONReader: (JAGJSONReader *) reader ofClass: (Class) modelClass;
+
+/**
+ * Compose the elements of a file holding a JSON array, one at a time.
+ *
+ * The file is memory-mapped and read lazily, and each element is composed
+ * as by composeModelFromJSONData:ofClass:error: and passed to block before
+ * the next is read.  Pages already read are given back to the system, so
+ * memory use follows the largest element rather than the file.  Elements
+ * that compose to nil are skipped with a kJAGDiagnosticDroppedValue diagnostic.
+ *
+ * If shouldPreserveIdentity is set, the identity map holds every
+ * identified model until the whole file has been read.
+ *
+ *     [converter enumerateModelsInJSONFile:path ofClass:[User class] withBlock:^(id user, BOOL *stop) {
+ *         [store addUser:user];
+ *     } error:&error];
+ *
+ * @param path The path of a UTF-8 JSON file whose top-level value is an array.
+ * @param modelClass The class of the elements' models, or nil.
+ * @param block Called with each model.  Set *stop to YES to read no further.
+ * @param error Set if the file can't be mapped, isn't an array, or is malformed.
+ * @return NO on error.  Models already passed to block stay valid.
+ */
+- (BOOL) enumerateModelsInJSONFile: (NSString *) path
+                           ofClass: (Class) modelClass
+                         withBlock: (void (^)(id model, BOOL *stop)) block
+                             error: (NSError **) error;
+
+#pragma mark - Decode MessagePack
+
+/**
+ * Compose a model (or array of models) from MessagePack data.
+ *
+ * If the MessagePack is a map, it is composed into an instance of modelClass
+ * via setPropertiesOf:fromDictionary:.  If it is an array, each map in it is
+ * composed into an instance of modelClass.  If modelClass is nil, the
+ * MessagePack is composed as by composeModelFromObject:.  Timestamps and binary
+ * values are set on NSDate and NSData properties as they are.
+ *
+ * @param data MessagePack data, such as that from messagePackDataFromObject:.
+ * @param modelClass The class of the top-level model(s).
+ * @param error Set if data is not valid MessagePack.
+ * @return The composed model (or array of models), or nil on error.
+ */
+- (id) composeModelFromMessagePackData: (NSData *) data ofClass: (Class) modelClass error: (NSError **) error;
+
+@end
+
+/**
+ * The compact model format, implemented in JAGCompactFormat.m.
+ */
+@interface JAGPropertyConverter (JAGCompactFormat)
+
+/**
+ * Encode an array of models of one class into a compact, schema-indexed format.
+ *
+ * The names and types of modelClass's properties are written once, and each
+ * model is then written as a record of values in schema order, with no keys:
+ * integer and BOOL properties as varints, floating-point properties as raw
+ * doubles, and object properties as MessagePack values (as by
+ * messagePackDataFromObject:), preceded by a bitmap of which object
+ * properties are non-nil.  For large arrays of one class, this is several
+ * times smaller than JSON or MessagePack, and faster to decode.
+ *
+ * Models that aren't instances of modelClass are dropped.  Subclass
+ * instances are written with modelClass's properties only.  Weak properties
+ * are skipped unless shouldConvertWeakProperties is set, and struct
+ * properties are always skipped.
+ *
+ * @param models An array of instances of modelClass.
+ * @param modelClass The class whose properties make up the schema.
+ * @return The encoded models.
+ */
+- (NSData *) compactDataFromModels: (NSArray *) models ofClass: (Class) modelClass;
+
+/**
+ * Decode models written by compactDataFromModels:ofClass:.
+ *
+ * The data's schema is matched to modelClass's properties by name, so data
+ * written by an older or newer version of modelClass still loads: properties
+ * modelClass no longer has are skipped, and properties it has gained are
+ * left unset.  A value whose type no longer matches its property is set as
+ * by setPropertiesOf:fromDictionary:, dropping any fraction; a number out of
+ * the property's range is reported as kJAGDiagnosticUnsettableProperty.
+ *
+ * @param data Data from compactDataFromModels:ofClass:.
+ * @param modelClass The class of the models to create.
+ * @param error Set if data is malformed.
+ * @return An array of new instances of modelClass, or nil on error.
+ */
+- (NSArray *) composeModelsFromCompactData: (NSData *) data ofClass: (Class) modelClass error: (NSError **) error;
+
 @end
@@ -27,10 +27,93 @@
 #import "JAGPropertyConverter.h"
 #import "JAGPropertyFinder.h"
 #import "JAGProperty.h"
+#import "JAGClassCodec.h"
+#import "JAGJSONWriter.h"
+#import "JAGJSONReader.h"
+#import "JAGMessagePackWriter.h"
+#import "JAGMessagePackReader.h"
+#import "JAGLazyHydrator.h"
+#import "JAGModelPool.h"
+#import "JAGNumberParser.h"
+#import "JAGDateCodec.h"
+#import "JAGGeneratedCodec.h"
+#import "JAGClassTable.h"
+#import "JAGProjection.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+#import <dispatch/dispatch.h>
+
+/*
+ * How decomposeObject: handles an instance of a class, given the
+ * converter's outputType and classesToConvert.
+ */
+typedef enum {
+    JAGDecomposePassThrough = 1,
+    JAGDecomposeFiniteNumber,
+    JAGDecomposeDate,
+    JAGDecomposeURL,
+    JAGDecomposeArray,
+    JAGDecomposeSet,
+    JAGDecomposeSetAsArray,
+    JAGDecomposeDictionary,
+    JAGDecomposeModel,
+    JAGDecomposeDrop,
+    JAGDecomposeUnsafe
+} JAGDecomposeHandler;
+
+/*
+ * What composeModelFromObject:withTargetClass: sees an instance of a class as.
+ */
+typedef enum {
+    JAGComposeOther = 1,
+    JAGComposeCollection,
+    JAGComposeDictionary,
+    JAGComposeString,
+    JAGComposeBasic
+} JAGComposeKind;
+
+/*
+ * What composeModelFromObject:withTargetClass: needs to know about a targetClass.
+ */
+enum {
+    JAGTargetIsDate         = 1 << 0,
+    JAGTargetIsURL          = 1 << 1,
+    JAGTargetIsNumber       = 1 << 2,
+    JAGTargetIsArray        = 1 << 3,
+    JAGTargetIsSet          = 1 << 4,
+    JAGTargetIsConvertible  = 1 << 5
+};
+
+//One more than the largest JAGDiagnosticCode.
+#define JAGDiagnosticCodeCount (kJAGDiagnosticStaleGeneratedCodec + 1)
+
+/*
+ * A class's dispatch information is packed into one word:
+ * bits 0-7 are the JAGDecomposeHandler for the outputType, 8-15 the
+ * JAGComposeKind, 16-23 the target flags, 24-27 the JAGDecomposeHandler
+ * for kJAGJSONOutput, used when writing JSON directly, and 28-31 the
+ * JAGDecomposeHandler for kJAGMessagePackOutput, used when writing MessagePack.
+ */
+#define JAGDecomposeHandlerOf(dispatch)     ((JAGDecomposeHandler)((dispatch) & 0xff))
+#define JAGComposeKindOf(dispatch)          ((JAGComposeKind)(((dispatch) >> 8) & 0xff))
+#define JAGTargetFlagsOf(dispatch)          (((dispatch) >> 16) & 0xff)
+#define JAGJSONHandlerOf(dispatch)          ((JAGDecomposeHandler)(((dispatch) >> 24) & 0xf))
+#define JAGMessagePackHandlerOf(dispatch)   ((JAGDecomposeHandler)(((dispatch) >> 28) & 0xf))
+
+//isKindOfClass: on a proxy answers for its target, so proxies can't be classified by class.
+static BOOL JAGClassIsProxy(Class cls) {
+    static Class proxyClass = Nil;
+    if (!proxyClass) proxyClass = objc_getClass("NSProxy");
+    for (Class c = cls; c; c = class_getSuperclass(c)) {
+        if (c == proxyClass) return YES;
+    }
+    return NO;
+}
 
 @interface JAGPropertyConverter () 
 
 - (id) composeCollection: (id) collection withTargetClass: (Class) targetClass;
+- (id) composeCollection: (id) collection withTargetClass: (Class) targetClass projection: (JAGProjection *) projection;
 
 /*
  * This converts a property to a PropertyModel-friendly form.
@@ -46,11 +129,229 @@
  */
 - (id) composeModelFromObject: (id) object withTargetClass: (Class) targetClass;
 
+/*
+ * As composeModelFromObject:withTargetClass:, composing only what projection
+ * selects.  A nil projection selects everything.
+ */
+- (id) composeModelFromObject: (id) object withTargetClass: (Class) targetClass projection: (JAGProjection *) projection;
+
 - (BOOL) shouldConvertClass: (Class) aClass;
 
+/*
+ * The packed dispatch information for a class, from the cache if possible.
+ */
+- (unsigned int) dispatchForClass: (Class) aClass;
+
+/*
+ * The packed dispatch information for an object's class.
+ */
+- (unsigned int) dispatchForObject: (id) object;
+
+/*
+ * Forget the dispatch information, after the configuration it was classified
+ * with changes.  An unfrozen converter mustn't be reconfigured while it is
+ * converting, so no lookup can be reading the old table.
+ */
+- (void) clearDispatchTable;
+
+/*
+ * Run block with a new identity map installed for this thread.
+ */
+- (id) withIdentityMap: (id (^)(void)) block;
+
+/*
+ * Count a diagnostic, and pass it to diagnosticHandler or the default log.
+ */
+- (void) reportDiagnostic: (JAGDiagnosticCode) code value: (id) value context: (id) context;
+
+@end
+
+NSString * const JAGIdentityKey = @"$id";
+//JAGIdentityKey as UTF-8, for matching keys read from JSON.
+static const char JAGIdentityKeyBytes[] = "$id";
+NSString * const JAGReferenceKey = @"$ref";
+NSString * const JAGPatchElementsKey = @"$elements";
+
+/*
+ * The models seen so far by one conversion call, when shouldPreserveIdentity
+ * is set.  The outermost call on a thread installs one in a thread-local;
+ * nested calls on the same thread find it with JAGCurrentIdentityMap.
+ */
+@interface JAGIdentityMap : NSObject
+{
+@public
+    __unsafe_unretained JAGPropertyConverter *_converter;
+    //The map of an enclosing call by another converter on this thread.
+    JAGIdentityMap *_previous;
+    //Model (when decomposing) or dictionary (when composing) to its conversion, by pointer.
+    CFMutableDictionaryRef _results;
+    //Models whose dictionaries are still being built.
+    CFMutableSetRef _pending;
+    //Model to the identifier written for it, by pointer.
+    CFMutableDictionaryRef _identifiersByModel;
+    //Identifier read from JAGIdentityKey to the model composed for it.
+    NSMutableDictionary *_modelsByIdentifier;
+    NSUInteger _nextIdentifier;
+    //The baseline patchForModel: is comparing against, and what it has compared.
+    NSDictionary *_baseline;
+    //Model to the part of _baseline it was compared with, by pointer.
+    CFMutableDictionaryRef _comparedBaselines;
+    //JAGIdentityKey to the dictionary of _baseline holding it, made when first needed.
+    NSMutableDictionary *_baselinesByIdentifier;
+}
+@end
+
+static CFMutableDictionaryRef JAGCreatePointerKeyedDictionary(void) {
+    CFDictionaryKeyCallBacks keyCallBacks = kCFTypeDictionaryKeyCallBacks;
+    keyCallBacks.equal = NULL;
+    keyCallBacks.hash = NULL;
+    return CFDictionaryCreateMutable(NULL, 0, &keyCallBacks, &kCFTypeDictionaryValueCallBacks);
+}
+
+@implementation JAGIdentityMap
+
+- (id) initWithConverter: (JAGPropertyConverter *) converter previous: (JAGIdentityMap *) previous {
+    self = [super init];
+    if (self) {
+        _converter = converter;
+        _previous = previous;
+        _results = JAGCreatePointerKeyedDictionary();
+        _pending = CFSetCreateMutable(NULL, 0, NULL);
+        _identifiersByModel = JAGCreatePointerKeyedDictionary();
+        _modelsByIdentifier = [[NSMutableDictionary alloc] init];
+    }
+    return self;
+}
+
+- (void) dealloc {
+    CFRelease(_results);
+    CFRelease(_pending);
+    CFRelease(_identifiersByModel);
+    if (_comparedBaselines) CFRelease(_comparedBaselines);
+}
+
+- (id) resultForObject: (id) object {
+    return (__bridge id)CFDictionaryGetValue(_results, (__bridge void *)object);
+}
+
+- (void) setResult: (id) result forObject: (id) object {
+    CFDictionarySetValue(_results, (__bridge void *)object, (__bridge void *)result);
+}
+
+- (NSNumber *) existingIdentifierForModel: (id) model {
+    return (__bridge NSNumber *)CFDictionaryGetValue(_identifiersByModel, (__bridge void *)model);
+}
+
+- (NSNumber *) identifierForModel: (id) model {
+    NSNumber *identifier = [self existingIdentifierForModel:model];
+    if (!identifier) {
+        identifier = [NSNumber numberWithUnsignedInteger:++_nextIdentifier];
+        CFDictionarySetValue(_identifiersByModel, (__bridge void *)model, (__bridge void *)identifier);
+    }
+    return identifier;
+}
+
+/*
+ * What to decompose a model into if it has been seen before: its dictionary,
+ * or if that dictionary is still being built, a reference to it.
+ * Returns nil for a model that hasn't been seen.
+ */
+- (id) dictionaryOrReferenceForModel: (id) model {
+    NSMutableDictionary *dictionary = [self resultForObject:model];
+    if (!dictionary || !CFSetContainsValue(_pending, (__bridge void *)model)) {
+        return dictionary;
+    }
+    NSNumber *identifier = [self identifierForModel:model];
+    [dictionary setObject:identifier forKey:JAGIdentityKey];
+    return [NSDictionary dictionaryWithObject:identifier forKey:JAGReferenceKey];
+}
+
+- (void) beginModel: (id) model dictionary: (NSMutableDictionary *) dictionary {
+    [self setResult:dictionary forObject:model];
+    CFSetAddValue(_pending, (__bridge void *)model);
+}
+
+- (void) endModel: (id) model {
+    CFSetRemoveValue(_pending, (__bridge void *)model);
+}
+
+- (id) modelForIdentifier: (id) identifier {
+    id model = [_modelsByIdentifier objectForKey:identifier];
+    if (!model) {
+        [_converter reportDiagnostic:kJAGDiagnosticUnresolvedReference value:identifier context:nil];
+    }
+    return model;
+}
+
+- (void) setModel: (id) model forIdentifier: (id) identifier {
+    [_modelsByIdentifier setObject:model forKey:identifier];
+}
+
+//Add the dictionaries under value that have a JAGIdentityKey to index.
+static void JAGIndexIdentifiedDictionaries(id value, NSMutableDictionary *index, CFMutableSetRef visited) {
+    BOOL isDictionary = [value isKindOfClass:[NSDictionary class]];
+    if (!isDictionary && ![value isKindOfClass:[NSArray class]] && ![value isKindOfClass:[NSSet class]]) return;
+    //A model referred to more than once is the same dictionary each time.
+    if (CFSetContainsValue(visited, (__bridge void *)value)) return;
+    CFSetAddValue(visited, (__bridge void *)value);
+    if (isDictionary) {
+        id identifier = [value objectForKey:JAGIdentityKey];
+        if (identifier) [index setObject:value forKey:identifier];
+        value = [value allValues];
+    }
+    for (id element in value) {
+        JAGIndexIdentifiedDictionaries(element, index, visited);
+    }
+}
+
+/*
+ * The part of _baseline that old, a dictionary within it, stands for: old
+ * itself, or if it is a reference, the dictionary it refers to.
+ */
+- (NSDictionary *) baselineForDictionary: (NSDictionary *) old {
+    id identifier = [old objectForKey:JAGReferenceKey];
+    if (!identifier) return old;
+    if (!_baselinesByIdentifier) {
+        _baselinesByIdentifier = [[NSMutableDictionary alloc] init];
+        CFMutableSetRef visited = CFSetCreateMutable(NULL, 0, NULL);
+        JAGIndexIdentifiedDictionaries(_baseline, _baselinesByIdentifier, visited);
+        CFRelease(visited);
+    }
+    return [_baselinesByIdentifier objectForKey:identifier];
+}
+
+- (NSDictionary *) comparedBaselineForModel: (id) model {
+    return _comparedBaselines ? (__bridge NSDictionary *)CFDictionaryGetValue(_comparedBaselines, (__bridge void *)model) : nil;
+}
+
+- (void) setComparedBaseline: (NSDictionary *) baseline forModel: (id) model {
+    if (!_comparedBaselines) _comparedBaselines = JAGCreatePointerKeyedDictionary();
+    CFDictionarySetValue(_comparedBaselines, (__bridge void *)model, (__bridge void *)baseline);
+}
+
 @end
 
+static pthread_key_t gIdentityMapKey;
+
+static JAGIdentityMap *JAGCurrentIdentityMap(JAGPropertyConverter *converter) {
+    JAGIdentityMap *map = (__bridge JAGIdentityMap *)pthread_getspecific(gIdentityMapKey);
+    while (map && map->_converter != converter) {
+        map = map->_previous;
+    }
+    return map;
+}
+
 @implementation JAGPropertyConverter
+{
+@private
+    //Class to packed dispatch information.  Batch conversion, and threads
+    //sharing a frozen converter, read it at once without locking.
+    JAGClassTable _dispatchTable;
+    volatile int64_t _diagnosticCounts[JAGDiagnosticCodeCount];
+    //A retained frozenCopy, for composing deferred properties with the
+    //configuration they were decoded with; see lazySnapshot.
+    void *_lazySnapshot;
+}
 
 
 @synthesize outputType = _outputType;
@@ -58,11 +359,29 @@
 @synthesize classesToConvert = _classesToConvert;
 @synthesize convertToDate = _convertToDate;
 @synthesize convertFromDate = _convertFromDate;
+@synthesize dateCodec = _dateCodec;
+@synthesize shouldUseGeneratedCodecs = _shouldUseGeneratedCodecs;
 @synthesize numberFormatter = _numberFormatter;
+@synthesize shouldParseNumericStrings = _shouldParseNumericStrings;
 @synthesize shouldConvertWeakProperties = _shouldConvertWeakProperties;
+@synthesize batchThreshold = _batchThreshold;
+@synthesize autoreleaseInterval = _autoreleaseInterval;
+@synthesize shouldPreserveIdentity = _shouldPreserveIdentity;
+@synthesize shouldComposeLazily = _shouldComposeLazily;
+@synthesize shouldMergeInPlace = _shouldMergeInPlace;
+@synthesize mergeKey = _mergeKey;
+@synthesize modelPool = _modelPool;
+@synthesize diagnosticHandler = _diagnosticHandler;
+@synthesize frozen = _frozen;
 
 #pragma mark - Lifecycle
 
++ (void) initialize {
+    if (self == [JAGPropertyConverter class]) {
+        pthread_key_create(&gIdentityMapKey, NULL);
+    }
+}
+
 + (JAGPropertyConverter *) converterWithOutputType: (JAGOutputType) outputType {
     return [[JAGPropertyConverter alloc] initWithOutputType:outputType];
 }
@@ -70,12 +389,17 @@
 - (id) initWithOutputType: (JAGOutputType) outputType {
     self = [super init];
     if (self) {
+        JAGClassTableInit(&_dispatchTable);
         self.outputType = outputType;
         self.identifyDict = nil;
         self.convertToDate = nil;
         self.convertFromDate = nil;
-        self.classesToConvert = [NSMutableSet set];
+        self.classesToConvert = [NSSet set];
         self.shouldConvertWeakProperties = NO;
+        self.batchThreshold = 1024;
+        self.autoreleaseInterval = 256;
+        self.shouldPreserveIdentity = NO;
+        self.shouldUseGeneratedCodecs = YES;
     }
     return self;
 }
@@ -84,272 +408,1819 @@
     return [self initWithOutputType:kJAGFullOutput];
 }
 
-#pragma mark - Convert To Dictionary
+- (void) dealloc {
+    JAGClassTableDestroy(&_dispatchTable);
+    if (_lazySnapshot) CFRelease(_lazySnapshot);
+}
 
-- (BOOL) shouldConvertClass: (Class) aClass {
+#pragma mark - Sharing
+
+- (JAGPropertyConverter *) frozenCopy {
+    if (_frozen) return self;
+    JAGPropertyConverter *frozen = [[[self class] alloc] initWithOutputType:self.outputType];
+    //Found by reflection, so that a subclass's configuration is copied too.
+    for (JAGProperty *property in [JAGPropertyFinder propertiesForClass:[self class]]) {
+        if ([property isReadOnly]) continue;
+        [frozen setValue:[self valueForKey:[property name]] forKey:[property name]];
+    }
+    //Snapshot the configuration objects that can still be changed through the receiver.
+    frozen.numberFormatter = [self.numberFormatter copy];
+    if (self.dateCodec) {
+        JAGDateCodec *dateCodec = [[JAGDateCodec alloc] initWithFormat:self.dateCodec.format];
+        dateCodec.cacheCapacity = self.dateCodec.cacheCapacity;
+        frozen.dateCodec = dateCodec;
+    }
+    if (self.modelPool) {
+        JAGModelPool *modelPool = [[JAGModelPool alloc] init];
+        modelPool.capacity = self.modelPool.capacity;
+        frozen.modelPool = modelPool;
+    }
+    for (Class modelClass in frozen.classesToConvert) {
+        [frozen dispatchForClass:modelClass];
+        [JAGClassCodec codecForClass:modelClass];
+        if (frozen.shouldUseGeneratedCodecs) JAGGeneratedCodecForClass(modelClass, nil);
+    }
+    frozen->_frozen = YES;
+    return frozen;
+}
+
+#pragma mark - Configuration
+
+/*
+ * Called by each setter before it changes the configuration.  A frozen
+ * converter raises, as Foundation's immutable types do; otherwise the
+ * snapshot for lazy composition is discarded, since it no longer matches.
+ */
+- (void) willChangeConfiguration: (SEL) setter {
+    if (_frozen) {
+        [NSException raise:NSInternalInconsistencyException
+                    format:@"-[%@ %@] called on a frozen converter; configure it before frozenCopy.",
+                           NSStringFromClass([self class]), NSStringFromSelector(setter)];
+    }
+    if (_lazySnapshot) {
+        CFRelease(_lazySnapshot);
+        _lazySnapshot = NULL;
+    }
+}
+
+- (void) setOutputType: (JAGOutputType) outputType {
+    [self willChangeConfiguration:_cmd];
+    _outputType = outputType;
+    [self clearDispatchTable];
+}
+
+- (void) setClassesToConvert: (NSSet *) classesToConvert {
+    [self willChangeConfiguration:_cmd];
+    _classesToConvert = [classesToConvert copy];
+    [self clearDispatchTable];
+}
+
+- (void) setIdentifyDict: (IdentifyBlock) identifyDict {
+    [self willChangeConfiguration:_cmd];
+    _identifyDict = [identifyDict copy];
+}
+
+- (void) setConvertToDate: (ConvertBlock) convertToDate {
+    [self willChangeConfiguration:_cmd];
+    _convertToDate = [convertToDate copy];
+}
+
+- (void) setConvertFromDate: (ConvertBlock) convertFromDate {
+    [self willChangeConfiguration:_cmd];
+    _convertFromDate = [convertFromDate copy];
+}
+
+- (void) setDateCodec: (JAGDateCodec *) dateCodec {
+    [self willChangeConfiguration:_cmd];
+    _dateCodec = dateCodec;
+}
+
+- (void) setShouldUseGeneratedCodecs: (BOOL) shouldUseGeneratedCodecs {
+    [self willChangeConfiguration:_cmd];
+    _shouldUseGeneratedCodecs = shouldUseGeneratedCodecs;
+}
+
+- (void) setNumberFormatter: (NSNumberFormatter *) numberFormatter {
+    [self willChangeConfiguration:_cmd];
+    _numberFormatter = numberFormatter;
+}
+
+- (void) setShouldParseNumericStrings: (BOOL) shouldParseNumericStrings {
+    [self willChangeConfiguration:_cmd];
+    _shouldParseNumericStrings = shouldParseNumericStrings;
+}
+
+- (void) setShouldConvertWeakProperties: (BOOL) shouldConvertWeakProperties {
+    [self willChangeConfiguration:_cmd];
+    _shouldConvertWeakProperties = shouldConvertWeakProperties;
+}
+
+- (void) setBatchThreshold: (NSUInteger) batchThreshold {
+    [self willChangeConfiguration:_cmd];
+    _batchThreshold = batchThreshold;
+}
+
+- (void) setAutoreleaseInterval: (NSUInteger) autoreleaseInterval {
+    [self willChangeConfiguration:_cmd];
+    _autoreleaseInterval = autoreleaseInterval;
+}
+
+- (void) setShouldPreserveIdentity: (BOOL) shouldPreserveIdentity {
+    [self willChangeConfiguration:_cmd];
+    _shouldPreserveIdentity = shouldPreserveIdentity;
+}
+
+- (void) setShouldComposeLazily: (BOOL) shouldComposeLazily {
+    [self willChangeConfiguration:_cmd];
+    _shouldComposeLazily = shouldComposeLazily;
+}
+
+- (void) setShouldMergeInPlace: (BOOL) shouldMergeInPlace {
+    [self willChangeConfiguration:_cmd];
+    _shouldMergeInPlace = shouldMergeInPlace;
+}
+
+- (void) setMergeKey: (NSString *) mergeKey {
+    [self willChangeConfiguration:_cmd];
+    _mergeKey = [mergeKey copy];
+}
+
+- (void) setModelPool: (JAGModelPool *) modelPool {
+    [self willChangeConfiguration:_cmd];
+    _modelPool = modelPool;
+}
+
+- (void) setDiagnosticHandler: (DiagnosticBlock) diagnosticHandler {
+    [self willChangeConfiguration:_cmd];
+    _diagnosticHandler = [diagnosticHandler copy];
+}
+
+- (void) clearDispatchTable {
+    JAGClassTableRemoveAll(&_dispatchTable);
+    JAGClassTableReclaim(&_dispatchTable);
+}
+
+#pragma mark - Class Dispatch
+
+static JAGDecomposeHandler JAGDecomposeHandlerForClass(Class aClass, JAGOutputType outputType, BOOL isConvertible) {
+    if ([aClass isSubclassOfClass: [NSString class]]
+        || [aClass isSubclassOfClass: [NSNull class]]) {
+        //These objects are fine for all output types
+        return JAGDecomposePassThrough;
+    } else if ([aClass isSubclassOfClass: [NSNumber class]]) {
+        //JSON cannot handle +-infinity or NaN
+        return outputType == kJAGJSONOutput ? JAGDecomposeFiniteNumber : JAGDecomposePassThrough;
+    } else if ([aClass isSubclassOfClass: [NSDate class]]) {
+        return outputType == kJAGJSONOutput ? JAGDecomposeDate : JAGDecomposePassThrough;
+    } else if ([aClass isSubclassOfClass: [NSData class]]) {
+        //These objects are fine for PropertyLists and MessagePack, but not JSON
+        return outputType == kJAGJSONOutput ? JAGDecomposeDrop : JAGDecomposePassThrough;
+    } else if ([aClass isSubclassOfClass: [NSValue class]]) {
+        //These objects are only ok for FullOutput
+        return outputType == kJAGFullOutput ? JAGDecomposePassThrough : JAGDecomposeDrop;
+    } else if ([aClass isSubclassOfClass: [NSURL class]]) {
+        //These objects are only ok for FullOutput; otherwise convert them to strings.
+        return outputType == kJAGFullOutput ? JAGDecomposePassThrough : JAGDecomposeURL;
+    } else if ([aClass isSubclassOfClass: [NSArray class]]) {
+        return JAGDecomposeArray;
+    } else if ([aClass isSubclassOfClass: [NSSet class]]) {
+        //JSON, PropertyLists and MessagePack only support arrays.
+        return outputType == kJAGFullOutput ? JAGDecomposeSet : JAGDecomposeSetAsArray;
+    } else if ([aClass isSubclassOfClass: [NSDictionary class]]) {
+        return JAGDecomposeDictionary;
+    } else if (isConvertible) {
+        return JAGDecomposeModel;
+    } else {
+        return outputType == kJAGFullOutput ? JAGDecomposePassThrough : JAGDecomposeUnsafe;
+    }
+}
+
+- (unsigned int) classifyClass: (Class) aClass {
+    BOOL isConvertible = NO;
     for (Class class in self.classesToConvert) {
         if ([aClass isSubclassOfClass:class]) {
-            return YES;
+            isConvertible = YES;
+            break;
         }
     }
-    return NO;
+
+    JAGComposeKind kind;
+    if ([aClass isSubclassOfClass: [NSString class]]) {
+        kind = JAGComposeString;
+    } else if ([aClass isSubclassOfClass: [NSNull class]]
+               || [aClass isSubclassOfClass: [NSNumber class]]
+               || [aClass isSubclassOfClass: [NSDate class]]
+               || [aClass isSubclassOfClass: [NSData class]]
+               || [aClass isSubclassOfClass: [NSValue class]]) {
+        kind = JAGComposeBasic;
+    } else if ([aClass isSubclassOfClass: [NSArray class]]
+               || [aClass isSubclassOfClass: [NSSet class]]) {
+        kind = JAGComposeCollection;
+    } else if ([aClass isSubclassOfClass: [NSDictionary class]]) {
+        kind = JAGComposeDictionary;
+    } else {
+        kind = JAGComposeOther;
+    }
+
+    unsigned int targetFlags = 0;
+    if ([aClass isSubclassOfClass: [NSDate class]]) targetFlags |= JAGTargetIsDate;
+    if ([aClass isSubclassOfClass: [NSURL class]]) targetFlags |= JAGTargetIsURL;
+    if ([aClass isSubclassOfClass: [NSNumber class]]) targetFlags |= JAGTargetIsNumber;
+    if ([aClass isSubclassOfClass: [NSArray class]]) targetFlags |= JAGTargetIsArray;
+    if ([aClass isSubclassOfClass: [NSSet class]]) targetFlags |= JAGTargetIsSet;
+    if (isConvertible) targetFlags |= JAGTargetIsConvertible;
+
+    JAGDecomposeHandler handler = JAGDecomposeHandlerForClass(aClass, self.outputType, isConvertible);
+    JAGDecomposeHandler jsonHandler = JAGDecomposeHandlerForClass(aClass, kJAGJSONOutput, isConvertible);
+    JAGDecomposeHandler messagePackHandler = JAGDecomposeHandlerForClass(aClass, kJAGMessagePackOutput, isConvertible);
+    return handler | (kind << 8) | (targetFlags << 16) | (jsonHandler << 24) | ((unsigned int)messagePackHandler << 28);
+}
+
+- (unsigned int) dispatchForClass: (Class) aClass {
+    uintptr_t found;
+    if (JAGClassTableLookup(&_dispatchTable, aClass, &found)) {
+        return (unsigned int)found;
+    }
+    //Classify outside the lock; two threads may both do it, but they agree.
+    unsigned int dispatch = [self classifyClass:aClass];
+    if (!JAGClassIsProxy(aClass)) {
+        JAGClassTableInsert(&_dispatchTable, aClass, dispatch);
+    }
+    return dispatch;
+}
+
+- (unsigned int) dispatchForObject: (id) object {
+    Class objectClass = object_getClass(object);
+    uintptr_t found;
+    if (JAGClassTableLookup(&_dispatchTable, objectClass, &found)) {
+        return (unsigned int)found;
+    }
+    if (JAGClassIsProxy(objectClass)) {
+        //Classify what the proxy stands in for, without caching it.
+        return [self classifyClass:[object class]];
+    }
+    return [self dispatchForClass:objectClass];
+}
+
+- (BOOL) shouldConvertClass: (Class) aClass {
+    return (JAGTargetFlagsOf([self dispatchForClass:aClass]) & JAGTargetIsConvertible) != 0;
+}
+
+#pragma mark - Diagnostics
+
+NSString *JAGDiagnosticDescription(JAGDiagnosticCode code, id value, id context) {
+    switch (code) {
+        case kJAGDiagnosticDroppedValue:
+            if (context) {
+                return [NSString stringWithFormat:@"Unable to convert value of class %@ for %@, dropping it.",
+                        [value class], context];
+            }
+            return [NSString stringWithFormat:@"Unable to convert value of class %@, dropping it.", [value class]];
+        case kJAGDiagnosticBadKeyType:
+            return [NSString stringWithFormat:@"JSON dictionaries must have string keys, skipping key %@", value];
+        case kJAGDiagnosticUnsettableProperty:
+            return [NSString stringWithFormat:@"Unable to set value of class %@ into property %@ of typeEncoding %@",
+                    [value class], [context name], [context typeEncoding]];
+        case kJAGDiagnosticUnknownClass:
+            return [NSString stringWithFormat:@"Object of class %@ is not safe for this output type or property.  Removing.",
+                    [value class]];
+        case kJAGDiagnosticTypeMismatch:
+            return [NSString stringWithFormat:@"Unable to convert %@ to collection type %@",
+                    value ? [value class] : [NSArray class], context];
+        case kJAGDiagnosticUnresolvedReference:
+            return [NSString stringWithFormat:@"No model with %@ %@ has been composed, dropping the reference.",
+                    JAGIdentityKey, value];
+        case kJAGDiagnosticStaleGeneratedCodec:
+            return [NSString stringWithFormat:@"The generated codec for %@ doesn't match its properties; regenerate it.",
+                    value];
+        default:
+            return [NSString stringWithFormat:@"Unknown diagnostic %d", (int)code];
+    }
+}
+
+- (void) reportDiagnostic: (JAGDiagnosticCode) code value: (id) value context: (id) context {
+    int64_t count = __sync_add_and_fetch(&_diagnosticCounts[code], 1);
+    DiagnosticBlock handler = self.diagnosticHandler;
+    if (handler) {
+        handler(code, value, context);
+    } else if ((count & (count - 1)) == 0) {
+        //Log the 1st, 2nd, 4th, 8th... occurrence of each code, so a flood costs O(log n) lines.
+        NSLog(@"JAGPropertyConverter: %@ (%lld so far)", JAGDiagnosticDescription(code, value, context), (long long)count);
+    }
+}
+
+- (NSUInteger) diagnosticCountForCode: (JAGDiagnosticCode) code {
+    if ((unsigned)code >= JAGDiagnosticCodeCount) return 0;
+    return (NSUInteger)_diagnosticCounts[code];
+}
+
+- (void) resetDiagnosticCounts {
+    for (int i = 0; i < JAGDiagnosticCodeCount; i++) {
+        __sync_lock_test_and_set(&_diagnosticCounts[i], 0);
+    }
+}
+
+#pragma mark - Identity Map
+
+- (id) withIdentityMap: (id (^)(void)) block {
+    JAGIdentityMap *previous = (__bridge JAGIdentityMap *)pthread_getspecific(gIdentityMapKey);
+    JAGIdentityMap *map = [[JAGIdentityMap alloc] initWithConverter:self previous:previous];
+    pthread_setspecific(gIdentityMapKey, (__bridge void *)map);
+    @try {
+        return block();
+    }
+    @finally {
+        pthread_setspecific(gIdentityMapKey, (__bridge void *)previous);
+    }
 }
 
+#pragma mark - Convert To Dictionary
+
 - (id) decomposeObject: (id) object {
+    return [self decomposeObject:object projection:nil];
+}
+
+- (id) decomposeObject: (id) object projection: (JAGProjection *) projection {
     if (!object) {
         return nil;
-    } else if ([object isKindOfClass: [NSNull class]]
-               || [object isKindOfClass: [NSString class]]) {
-        //These objects are fine for all output types
-        return object;    
-    } else if ([object isKindOfClass: [NSNumber class]]) {
-        if ( self.outputType == kJAGJSONOutput ) {
-            if ( isfinite([object doubleValue]) ) {
-                return object;
-            } else {
-                //JSON cannot handle +-infinity or NaN
-                return nil;
-            }
-        } else {
-            return object;
-        }
-    } else if ([object isKindOfClass: [NSDate class]]) {
-        if ( self.outputType == kJAGFullOutput
-            || self.outputType == kJAGPropertyListOutput ) {
-            return object;
-        } else if (self.convertFromDate) {
-            return self.convertFromDate(object);
-        } else {
-            //Object is not safe for JSON.  Removing.
-            return nil;
-        }
-        
-    } else if ([object isKindOfClass: [NSData class]]) {
-        //These objects are fine for PropertyLists, but not JSON
-        if ( self.outputType == kJAGFullOutput
-            || self.outputType == kJAGPropertyListOutput ) {
-            return object;
-        } else {
-            //Object is not safe for JSON.  Removing.
-            return nil;
-        }
-    } else if ( [object isKindOfClass: [NSValue class]] ) {
-        //These objects are only ok for FullOutput
-        if ( self.outputType == kJAGFullOutput ) {
-            return object;
-        } else {
-            //Object is not safe for JSON or PropertyLists.  Removing.
-            return nil;
-        }
-    } else if ( [object isKindOfClass: [NSURL class]] ) {
-        //These objects are only ok for FullOutput
-        if ( self.outputType == kJAGFullOutput ) {
+    }
+    if ([projection isFull]) {
+        projection = nil;
+    }
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [self withIdentityMap:^ id { return [self decomposeObject:object projection:projection]; }];
+    }
+    JAGDecomposeHandler handler = JAGDecomposeHandlerOf([self dispatchForObject:object]);
+    switch (handler) {
+        case JAGDecomposePassThrough:
             return object;
-        } else {
-            //Convert them to strings.
+        case JAGDecomposeFiniteNumber:
+            //JSON cannot handle +-infinity or NaN
+            return isfinite([object doubleValue]) ? object : nil;
+        case JAGDecomposeDate:
+            //Object is not safe for JSON unless we know how to convert it.
+            if (_dateCodec) return [_dateCodec valueFromDate:object];
+            return self.convertFromDate ? self.convertFromDate(object) : nil;
+        case JAGDecomposeURL:
             return [object absoluteString];
-        }
-        
-    } else if ([object isKindOfClass: [NSArray class]]) {
-        NSMutableArray *array = [NSMutableArray array];
-        for (id obj in object) {
-            id value = [self decomposeObject:obj];
-            if (value) {
-                [array addObject: value];
-            } else {
-                NSLog(@"Object %@ can't be converted to properties.", obj);
-            }
-        }
-        return array;
-    } else if ([object isKindOfClass: [NSSet class]]) {
-        id collection;
-        if (self.outputType == kJAGJSONOutput || self.outputType == kJAGPropertyListOutput) {
-            //JSON and PropertyLists only support arrays.
-            collection = [NSMutableArray array];
-        } else {
-            collection = [NSMutableSet set];
-        }
-        for (id obj in object) {
-            id value = [self decomposeObject:obj];
-            if (value) {
-                [collection addObject: value];
+        case JAGDecomposeDrop:
+            //Object is not safe for this outputType.  Removing.
+            return nil;
+        case JAGDecomposeArray:
+        case JAGDecomposeSetAsArray:
+        case JAGDecomposeSet: {
+            id collection;
+            if (handler == JAGDecomposeSet) {
+                collection = [[NSMutableSet alloc] initWithCapacity:[object count]];
             } else {
-                NSLog(@"Object %@ can't be converted to properties.", obj);
+                collection = [[NSMutableArray alloc] initWithCapacity:[object count]];
             }
+            JAGProjection *elementProjection = [projection elementProjection];
+            [self forEachElementOf:object usingBlock:^(id obj) {
+                id value = [self decomposeObject:obj projection:elementProjection];
+                if (value) {
+                    [collection addObject: value];
+                } else {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:obj context:nil];
+                }
+            }];
+            return collection;
         }
-        return collection;
-    } else if ([object isKindOfClass: [NSDictionary class]]) {
-        NSMutableDictionary *dict = [NSMutableDictionary dictionary];
-        for (id key in object) {
-            if ( self.outputType == kJAGJSONOutput && ![key isKindOfClass:[NSString class]] ) {
-                NSLog(@"JSON dictionaries must have string keys, skipping key %@", key);
-                continue;
-            }
-            id value = [self decomposeObject:[object objectForKey: key]];
-            if (value) {
-                [dict setObject: [self decomposeObject: value] forKey: key];
-            } else {
-                NSLog(@"Unable to convert %@ to properties.", [object objectForKey: key]);
-            }
+        case JAGDecomposeDictionary: {
+            NSMutableDictionary *dict = [[NSMutableDictionary alloc] initWithCapacity:[object count]];
+            BOOL needsStringKeys = self.outputType == kJAGJSONOutput || self.outputType == kJAGMessagePackOutput;
+            [self forEachElementOf:object usingBlock:^(id key) {
+                if ( needsStringKeys && ![key isKindOfClass:[NSString class]] ) {
+                    [self reportDiagnostic:kJAGDiagnosticBadKeyType value:key context:nil];
+                    return;
+                }
+                JAGProjection *child = nil;
+                if (projection && !(child = [projection projectionForKey:key])) {
+                    return;
+                }
+                id value = [self decomposeObject:[object objectForKey: key] projection:child];
+                if (value) {
+                    [dict setObject: value forKey: key];
+                } else {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:[object objectForKey: key] context:key];
+                }
+            }];
+            return dict;
         }
-        return dict;
-    } else if ([self shouldConvertClass:[object class]]) {
-        return [self convertToDictionary:object];
-    } else {
-        if ( self.outputType == kJAGFullOutput ) {
-            return object;
-        } else {
-            NSLog(@"Object %@ is not safe for JSON or PropertyLists.  Removing.", [object class]);
+        case JAGDecomposeModel:
+            return [self convertToDictionary:object projection:projection];
+        case JAGDecomposeUnsafe:
+        default:
+            [self reportDiagnostic:kJAGDiagnosticUnknownClass value:object context:nil];
             return nil;
-        }
     }
-    
 }
 
 - (NSDictionary*) convertToDictionary: (id) model {
+    return [self convertToDictionary:model projection:nil];
+}
+
+- (NSDictionary*) convertToDictionary: (id) model projection: (JAGProjection *) projection {
     if (!model) return nil;
-    NSMutableDictionary *values = [NSMutableDictionary dictionary];
-    NSArray* properties = [JAGPropertyFinder propertiesForClass:[model class]];
-    NSString* propertyName;
-    for (JAGProperty *property in properties) {
-        propertyName = [property name];
+    if ([projection isFull]) {
+        projection = nil;
+    }
+    JAGIdentityMap *map = nil;
+    if (_shouldPreserveIdentity) {
+        map = JAGCurrentIdentityMap(self);
+        if (!map) {
+            return [self withIdentityMap:^ id { return [self convertToDictionary:model projection:projection]; }];
+        }
+        id seen = [map dictionaryOrReferenceForModel:model];
+        if (seen) return seen;
+    }
+    //Generated codecs encode every property.
+    const JAGGeneratedCodec *generated = (_shouldUseGeneratedCodecs && !projection) ? JAGGeneratedCodecForClass([model class], self) : NULL;
+    if (generated) {
+        NSMutableDictionary *values = [[NSMutableDictionary alloc] initWithCapacity:generated->propertyCount];
+        [map beginModel:model dictionary:values];
+        generated->encode(self, model, values);
+        [map endModel:model];
+        return values;
+    }
+    //Use the real isa, so KVO-generated accessors are honored.
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    //Only visit the selected properties, so the others' getters are never called.
+    const JAGProjectedProperties *selected = projection ? [projection propertiesForCodec:codec] : NULL;
+    NSUInteger count = selected ? selected->count : [codec count];
+    NSMutableDictionary *values = [[NSMutableDictionary alloc] initWithCapacity:count];
+    [map beginModel:model dictionary:values];
+    for (NSUInteger n = 0; n < count; n++) {
+        NSUInteger i = selected ? selected->properties[n].index : n;
+        JAGProperty *property = [codec propertyAtIndex:i];
         if (!self.shouldConvertWeakProperties && [property isWeak]) {
             continue;
         }
-        SEL getter = [property getter];
-        if (![model respondsToSelector:getter]) {
+        if (![codec canGetValueAtIndex:i ofModel:model]) {
             //Found property without a valid getter. Skipping.
             continue;
         }
-        //TODO: Should use the getter for this?  Harder to handle non-objects.
-        id object = [model valueForKey:propertyName];
-        [values setValue:[self decomposeObject: object] forKey:propertyName];
+        id object = [codec valueAtIndex:i ofModel:model];
+        id value = [self decomposeObject:object projection:selected ? selected->properties[n].projection : nil];
+        if (value) {
+            [values setObject:value forKey:[property name]];
+        }
     }
+    [map endModel:model];
     return values;
 }
 
 
-#pragma mark - Convert From Dictionary
+#pragma mark - Encode JSON
 
-- (id) composeCollection: (id) collection withTargetClass: (Class) targetClass {
+- (NSData *) JSONDataFromObject: (id) object {
+    JAGJSONWriter *writer = [[JAGJSONWriter alloc] init];
+    if (![self writeJSONFromObject:object toWriter:writer]) {
+        return nil;
+    }
+    return [writer takeData];
+}
+
+- (BOOL) writeJSONFromObject: (id) object toStream: (NSOutputStream *) stream error: (NSError **) error {
+    JAGJSONWriter *writer = [[JAGJSONWriter alloc] initWithOutputStream:stream chunkSize:0];
+    BOOL wrote = [self writeJSONFromObject:object toWriter:writer];
+    if (wrote) {
+        [writer flush];
+    }
+    if (writer.error) {
+        if (error) *error = writer.error;
+        return NO;
+    }
+    if (!wrote && error) {
+        NSString *description = object
+            ? [NSString stringWithFormat:@"An object of class %@ can't be represented in JSON.", [object class]]
+            : @"There is no object to write.";
+        *error = [NSError errorWithDomain:JAGJSONWriterErrorDomain
+                                     code:JAGJSONWriterErrorInvalidObject
+                                 userInfo:[NSDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey]];
+    }
+    return wrote;
+}
+
+- (BOOL) writeJSONFromObject: (id) object toWriter: (JAGJSONWriter *) writer {
+    if (!object) {
+        return NO;
+    }
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [[self withIdentityMap:^ id {
+            return [NSNumber numberWithBool:[self writeJSONFromObject:object toWriter:writer]];
+        }] boolValue];
+    }
+    unsigned int dispatch = [self dispatchForObject:object];
+    switch (JAGJSONHandlerOf(dispatch)) {
+        case JAGDecomposePassThrough:
+            //Only NSStrings and NSNulls pass through unchanged to JSON.
+            if (JAGComposeKindOf(dispatch) == JAGComposeString) {
+                [writer writeString:object];
+            } else {
+                [writer writeNull];
+            }
+            return YES;
+        case JAGDecomposeFiniteNumber:
+            //JSON cannot handle +-infinity or NaN
+            return [writer writeNumber:object];
+        case JAGDecomposeDate:
+            //Object is not safe for JSON unless we know how to convert it.
+            if (_dateCodec) return [self writeJSONFromObject:[_dateCodec valueFromDate:object] toWriter:writer];
+            return self.convertFromDate && [self writeJSONFromObject:self.convertFromDate(object) toWriter:writer];
+        case JAGDecomposeURL: {
+            NSString *string = [object absoluteString];
+            if (!string) return NO;
+            [writer writeString:string];
+            return YES;
+        }
+        case JAGDecomposeDrop:
+            return NO;
+        case JAGDecomposeArray:
+        case JAGDecomposeSetAsArray:
+        case JAGDecomposeSet:
+            [writer beginArray];
+            [self forEachElementOf:object usingBlock:^(id obj) {
+                if (![self writeJSONFromObject:obj toWriter:writer]) {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:obj context:nil];
+                }
+            }];
+            [writer endArray];
+            return YES;
+        case JAGDecomposeDictionary:
+            [writer beginObject];
+            [self forEachElementOf:object usingBlock:^(id key) {
+                if (![key isKindOfClass:[NSString class]]) {
+                    [self reportDiagnostic:kJAGDiagnosticBadKeyType value:key context:nil];
+                    return;
+                }
+                [writer writeKey:key];
+                id value = [object objectForKey:key];
+                if (![self writeJSONFromObject:value toWriter:writer]) {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:value context:key];
+                }
+            }];
+            [writer endObject];
+            return YES;
+        case JAGDecomposeModel:
+            [self writeModel:object toWriter:writer usingBlock:^(id value) {
+                [self writeJSONFromObject:value toWriter:writer];
+            }];
+            return YES;
+        case JAGDecomposeUnsafe:
+        default:
+            [self reportDiagnostic:kJAGDiagnosticUnknownClass value:object context:nil];
+            return NO;
+    }
+}
+
+/*
+ * The JSON and MessagePack counterpart of convertToDictionary:.  Numeric
+ * properties are read unboxed and written straight into the writer; other
+ * values are passed to writeObject.  Floating point properties that the
+ * format can't represent (NaN or infinite, in JSON) are left out.
+ *
+ * When preserving identity, the writer can't go back and mark a model once
+ * it turns out to be shared, so every model gets a JAGIdentityKey up front,
+ * and every later occurrence is written as a reference.
+ */
+- (void) writeModel: (id) model toWriter: (id<JAGStructuredWriter>) writer
+         usingBlock: (void (^)(id object)) writeObject {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    NSUInteger count = [codec count];
+    [writer beginMap];
+    if (_shouldPreserveIdentity) {
+        JAGIdentityMap *map = JAGCurrentIdentityMap(self);
+        NSNumber *identifier = [map existingIdentifierForModel:model];
+        if (identifier) {
+            [writer writeKey:JAGReferenceKey];
+            [writer writeLongLong:[identifier longLongValue]];
+            [writer endMap];
+            return;
+        }
+        [writer writeKey:JAGIdentityKey];
+        [writer writeLongLong:[[map identifierForModel:model] longLongValue]];
+    }
+    for (NSUInteger i = 0; i < count; i++) {
+        JAGProperty *property = [codec propertyAtIndex:i];
+        if (!self.shouldConvertWeakProperties && [property isWeak]) {
+            continue;
+        }
+        if (![codec canGetValueAtIndex:i ofModel:model]) {
+            //Found property without a valid getter. Skipping.
+            continue;
+        }
+        [writer writeKey:[property name]];
+        switch ([property scalarKind]) {
+            case JAGPropertyScalarKindFloat:
+                //Narrowing back is exact, and keeps 1.1f from being written as 1.10000002384186.
+                [writer writeFloat:(float)[codec doubleValueAtIndex:i ofModel:model]];
+                break;
+            case JAGPropertyScalarKindDouble:
+                [writer writeDouble:[codec doubleValueAtIndex:i ofModel:model]];
+                break;
+            case JAGPropertyScalarKindBool:
+                [writer writeBool:[codec longLongValueAtIndex:i ofModel:model] != 0];
+                break;
+            case JAGPropertyScalarKindUnsignedLong:
+            case JAGPropertyScalarKindUnsignedLongLong:
+                [writer writeUnsignedLongLong:(unsigned long long)[codec longLongValueAtIndex:i ofModel:model]];
+                break;
+            case JAGPropertyScalarKindChar:
+            case JAGPropertyScalarKindInt:
+            case JAGPropertyScalarKindShort:
+            case JAGPropertyScalarKindLong:
+            case JAGPropertyScalarKindLongLong:
+            case JAGPropertyScalarKindUnsignedChar:
+            case JAGPropertyScalarKindUnsignedInt:
+            case JAGPropertyScalarKindUnsignedShort:
+                [writer writeLongLong:[codec longLongValueAtIndex:i ofModel:model]];
+                break;
+            default:
+                writeObject([codec valueAtIndex:i ofModel:model]);
+                break;
+        }
+    }
+    [writer endMap];
+}
+
+#pragma mark - Encode MessagePack
+
+- (NSData *) messagePackDataFromObject: (id) object {
+    JAGMessagePackWriter *writer = [[JAGMessagePackWriter alloc] init];
+    if (![self writeMessagePackFromObject:object toWriter:writer]) {
+        return nil;
+    }
+    return [writer takeData];
+}
+
+- (BOOL) writeMessagePackFromObject: (id) object toWriter: (JAGMessagePackWriter *) writer {
+    if (!object) {
+        return NO;
+    }
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [[self withIdentityMap:^ id {
+            return [NSNumber numberWithBool:[self writeMessagePackFromObject:object toWriter:writer]];
+        }] boolValue];
+    }
+    unsigned int dispatch = [self dispatchForObject:object];
+    switch (JAGMessagePackHandlerOf(dispatch)) {
+        case JAGDecomposePassThrough: {
+            unsigned int targetFlags = JAGTargetFlagsOf(dispatch);
+            if (JAGComposeKindOf(dispatch) == JAGComposeString) {
+                [writer writeString:object];
+            } else if (targetFlags & JAGTargetIsNumber) {
+                [writer writeNumber:object];
+            } else if (targetFlags & JAGTargetIsDate) {
+                [writer writeDate:object];
+            } else if ([object isKindOfClass:[NSData class]]) {
+                [writer writeData:object];
+            } else {
+                [writer writeNil];
+            }
+            return YES;
+        }
+        case JAGDecomposeURL: {
+            NSString *string = [object absoluteString];
+            if (!string) return NO;
+            [writer writeString:string];
+            return YES;
+        }
+        case JAGDecomposeDrop:
+            return NO;
+        case JAGDecomposeArray:
+        case JAGDecomposeSetAsArray:
+        case JAGDecomposeSet:
+            [writer beginArray];
+            [self forEachElementOf:object usingBlock:^(id obj) {
+                if (![self writeMessagePackFromObject:obj toWriter:writer]) {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:obj context:nil];
+                }
+            }];
+            [writer endArray];
+            return YES;
+        case JAGDecomposeDictionary:
+            [writer beginMap];
+            [self forEachElementOf:object usingBlock:^(id key) {
+                if (![key isKindOfClass:[NSString class]]) {
+                    [self reportDiagnostic:kJAGDiagnosticBadKeyType value:key context:nil];
+                    return;
+                }
+                [writer writeKey:key];
+                id value = [object objectForKey:key];
+                if (![self writeMessagePackFromObject:value toWriter:writer]) {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:value context:key];
+                }
+            }];
+            [writer endMap];
+            return YES;
+        case JAGDecomposeModel:
+            [self writeModel:object toWriter:writer usingBlock:^(id value) {
+                [self writeMessagePackFromObject:value toWriter:writer];
+            }];
+            return YES;
+        case JAGDecomposeUnsafe:
+        default:
+            [self reportDiagnostic:kJAGDiagnosticUnknownClass value:object context:nil];
+            return NO;
+    }
+}
+
+#pragma mark - Changes
+
+//The key of the baseline dictionary associated with a model.
+static char JAGBaselineKey;
+
+- (void) recordBaselineForModel: (id) model {
+    if (!model) return;
+    objc_setAssociatedObject(model, &JAGBaselineKey, [self convertToDictionary:model], OBJC_ASSOCIATION_RETAIN);
+}
+
+- (NSDictionary *) patchForModel: (id) model {
+    NSDictionary *baseline = model ? objc_getAssociatedObject(model, &JAGBaselineKey) : nil;
+    if (!baseline) return nil;
+    if (_shouldPreserveIdentity) {
+        //The map resolves the baseline's references, and decomposes changed values as the baseline was.
+        return [self withIdentityMap:^ id {
+            JAGIdentityMap *map = JAGCurrentIdentityMap(self);
+            map->_baseline = baseline;
+            [map setComparedBaseline:baseline forModel:model];
+            return [self patchFromDictionary:baseline toModel:model];
+        }];
+    }
+    return [self patchFromDictionary:baseline toModel:model];
+}
+
+/*
+ * The changes from baseline, a dictionary from convertToDictionary:, to
+ * model.  Nested models are compared with their part of baseline directly.
+ */
+- (NSMutableDictionary *) patchFromDictionary: (NSDictionary *) baseline toModel: (id) model {
+    NSMutableDictionary *patch = [NSMutableDictionary dictionary];
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    NSUInteger count = [codec count];
+    for (NSUInteger i = 0; i < count; i++) {
+        JAGProperty *property = [codec propertyAtIndex:i];
+        if (!self.shouldConvertWeakProperties && [property isWeak]) {
+            continue;
+        }
+        if (![codec canGetValueAtIndex:i ofModel:model]) {
+            continue;
+        }
+        NSString *name = [property name];
+        id change = [self patchFromValue:[baseline objectForKey:name] toObject:[codec valueAtIndex:i ofModel:model]];
+        if (change) {
+            [patch setObject:change forKey:name];
+        }
+    }
+    return patch;
+}
+
+/*
+ * The change from old, a value in a baseline, to object: nil if there is
+ * none, a nested patch for a model or an array of the same length, or
+ * otherwise object decomposed, or NSNull if object is nil.
+ */
+- (id) patchFromValue: (id) old toObject: (id) object {
+    JAGDecomposeHandler handler = object ? JAGDecomposeHandlerOf([self dispatchForObject:object]) : JAGDecomposeDrop;
+    if (handler == JAGDecomposeModel && [old isKindOfClass:[NSDictionary class]]) {
+        JAGIdentityMap *map = _shouldPreserveIdentity ? JAGCurrentIdentityMap(self) : nil;
+        if (map) {
+            old = [map baselineForDictionary:old];
+            //A model reached again, perhaps through a cycle, was compared the first time.
+            NSDictionary *compared = [map comparedBaselineForModel:object];
+            if (compared) {
+                return compared == old ? nil : [self decomposeObject:object];
+            }
+            if (old) [map setComparedBaseline:old forModel:object];
+        }
+        if (old) {
+            NSDictionary *nested = [self patchFromDictionary:old toModel:object];
+            return [nested count] ? nested : nil;
+        }
+    } else if (handler == JAGDecomposeArray && [old isKindOfClass:[NSArray class]] && [old count] == [object count]) {
+        NSMutableDictionary *elements = [NSMutableDictionary dictionary];
+        NSUInteger i = 0;
+        for (id element in object) {
+            id change = [self patchFromValue:[old objectAtIndex:i] toObject:element];
+            if (change) {
+                [elements setObject:change forKey:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+            }
+            i++;
+        }
+        return [elements count] ? [NSDictionary dictionaryWithObject:elements forKey:JAGPatchElementsKey] : nil;
+    }
+    id value = object ? [self decomposeObject:object] : nil;
+    if (value == old || [value isEqual:old]) {
+        return nil;
+    }
+    return value ? value : [NSNull null];
+}
+
+- (void) applyPatch: (NSDictionary *) patch toModel: (id) model {
+    if (!model) return;
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(model)];
+    //Whatever isn't a removal or a nested patch is set as setPropertiesOf:fromDictionary: would.
+    NSMutableDictionary *values = [NSMutableDictionary dictionaryWithCapacity:[patch count]];
+    for (NSString *key in patch) {
+        id value = [patch objectForKey:key];
+        NSUInteger index = [codec indexOfPropertyNamed:key];
+        JAGProperty *property = index != NSNotFound ? [codec propertyAtIndex:index] : nil;
+        if (property && [property isObject] && ![property isReadOnly]) {
+            if (value == [NSNull null]) {
+                [codec setValue:nil atIndex:index ofModel:model];
+                continue;
+            }
+            if (JAGComposeKindOf([self dispatchForObject:value]) == JAGComposeDictionary) {
+                id current = [codec valueAtIndex:index ofModel:model];
+                id patched = [self applyNestedPatch:value toObject:current];
+                if (patched) {
+                    if (patched != current) [codec setValue:patched atIndex:index ofModel:model];
+                    continue;
+                }
+            }
+        }
+        [values setObject:value forKey:key];
+    }
+    [self setPropertiesOf:model fromDictionary:values];
+}
+
+/*
+ * Apply a nested patch from patchFromValue:toObject: to current: to a model
+ * in place, or to a copy of an array.  Returns the patched object, or nil if
+ * patch can't apply to current, and so should replace it.
+ */
+- (id) applyNestedPatch: (NSDictionary *) patch toObject: (id) current {
+    if (!current) return nil;
+    JAGDecomposeHandler handler = JAGDecomposeHandlerOf([self dispatchForObject:current]);
+    if (handler == JAGDecomposeModel) {
+        [self applyPatch:patch toModel:current];
+        return current;
+    }
+    NSDictionary *elements = [patch objectForKey:JAGPatchElementsKey];
+    if (handler != JAGDecomposeArray || ![elements isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    NSMutableArray *array = [current mutableCopy];
+    for (id key in elements) {
+        id change = [elements objectForKey:key];
+        NSInteger i = [key isKindOfClass:[NSString class]] ? [key integerValue] : -1;
+        if (i < 0 || (NSUInteger)i >= [array count]
+            || ![key isEqualToString:[NSString stringWithFormat:@"%ld", (long)i]])
+        {
+            [self reportDiagnostic:kJAGDiagnosticDroppedValue value:change context:key];
+            continue;
+        }
+        id element = nil;
+        if (JAGComposeKindOf([self dispatchForObject:change]) == JAGComposeDictionary) {
+            element = [self applyNestedPatch:change toObject:[array objectAtIndex:(NSUInteger)i]];
+        }
+        if (!element) {
+            element = [self composeModelFromObject:change withTargetClass:nil];
+        }
+        if (element) {
+            [array replaceObjectAtIndex:(NSUInteger)i withObject:element];
+        } else {
+            [self reportDiagnostic:kJAGDiagnosticDroppedValue value:change context:key];
+        }
+    }
+    return array;
+}
+
+#pragma mark - Batch Conversion
+
+- (NSArray *) convertToDictionaries: (NSArray *) models {
+    return [self mapArray:models withBlock:^ id (id model) {
+        return [self convertToDictionary:model];
+    }];
+}
+
+- (NSArray *) composeModelsFromArray: (NSArray *) array ofClass: (Class) modelClass {
+    return [self mapArray:array withBlock:^ id (id object) {
+        if (modelClass && JAGComposeKindOf([self dispatchForObject:object]) == JAGComposeDictionary) {
+            //modelClass needn't be in classesToConvert.
+            return [self composeModelFromDictionary:object coercedClass:modelClass projection:nil];
+        }
+        return [self composeModelFromObject:object withTargetClass:modelClass];
+    }];
+}
+
+/*
+ * Apply block to each element of array, in chunks spread across cores if
+ * array has at least batchThreshold elements.  Each result goes in its own
+ * slot, so no lock is needed to collect them.  Elements the block returns
+ * nil for are dropped; the rest keep their order.
+ *
+ * When preserving identity, the whole array shares one identity map, so that
+ * models shared between elements stay shared and references between them
+ * resolve.  The map is per-thread and in order, so then the array is mapped serially.
+ */
+- (NSArray *) mapArray: (NSArray *) array withBlock: (id (^)(id obj)) block {
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [self withIdentityMap:^ id { return [self mapArray:array withBlock:block]; }];
+    }
+    NSUInteger count = [array count];
+    if (!count) return [NSArray array];
+    __strong id *results = (__strong id *)calloc(count, sizeof(id));
+
+    if (count < self.batchThreshold || self.batchThreshold == 0 || _shouldPreserveIdentity) {
+        NSUInteger interval = self.autoreleaseInterval ? self.autoreleaseInterval : count;
+        for (NSUInteger start = 0; start < count; start += interval) {
+            @autoreleasepool {
+                NSUInteger end = MIN(start + interval, count);
+                for (NSUInteger i = start; i < end; i++) {
+                    results[i] = block([array objectAtIndex:i]);
+                }
+            }
+        }
+    } else {
+        //Several chunks per core, so that a slow chunk doesn't hold up the rest.
+        NSUInteger chunkCount = MIN(count, [[NSProcessInfo processInfo] activeProcessorCount] * 4);
+        NSUInteger chunkSize = (count + chunkCount - 1) / chunkCount;
+        dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+            NSUInteger start = chunk * chunkSize;
+            NSUInteger end = MIN(start + chunkSize, count);
+            @autoreleasepool {
+                for (NSUInteger i = start; i < end; i++) {
+                    results[i] = block([array objectAtIndex:i]);
+                }
+            }
+        });
+    }
+
+    NSMutableArray *mapped = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        if (results[i]) {
+            [mapped addObject:results[i]];
+            results[i] = nil;
+        } else {
+            [self reportDiagnostic:kJAGDiagnosticDroppedValue value:[array objectAtIndex:i] context:nil];
+        }
+    }
+    free(results);
+    return mapped;
+}
+
+#pragma mark - Convert From Dictionary
+
+- (id) composeCollection: (id) collection withTargetClass: (Class) targetClass {
+    return [self composeCollection:collection withTargetClass:targetClass projection:nil];
+}
+
+- (id) composeCollection: (id) collection withTargetClass: (Class) targetClass projection: (JAGProjection *) projection {
     if (!targetClass) {
         targetClass = [collection class];
     }
     id mutableCollection;
+    unsigned int targetFlags = JAGTargetFlagsOf([self dispatchForClass:targetClass]);
     //FIXME: If targetClass is a proper subclass, the property may not be settable to mutableCollection.
-    if ([targetClass isSubclassOfClass:[NSArray class]]) {
+    if (targetFlags & JAGTargetIsArray) {
         mutableCollection = [[NSMutableArray alloc] init];
-    } else if ([targetClass isSubclassOfClass:[NSSet class]]) {
+    } else if (targetFlags & JAGTargetIsSet) {
         mutableCollection = [[NSMutableSet alloc] init];
     } else {
         //TODO: Catch mutisets and the like.
-        NSLog(@"Unable to convert %@ to collection type %@", [collection class], targetClass);
+        [self reportDiagnostic:kJAGDiagnosticTypeMismatch value:collection context:targetClass];
         return nil;
     }
-    for (id elt in collection) {
-        id value = [self composeModelFromObject:elt];
+    JAGProjection *elementProjection = [projection elementProjection];
+    [self forEachElementOf:collection usingBlock:^(id elt) {
+        id value = [self composeModelFromObject:elt withTargetClass:nil projection:elementProjection];
         if (value) {
             [mutableCollection addObject: value];
         } else {
-            NSLog(@"Object %@ can't be converted to properties.", [elt class]);
+            [self reportDiagnostic:kJAGDiagnosticDroppedValue value:elt context:nil];
         }
-    }
+    }];
     return mutableCollection;
 }
+
+/*
+ * Call block with each element of collection (each key, for a dictionary).
+ * Collections larger than autoreleaseInterval are walked in stretches of that
+ * many elements, each in its own autorelease pool, so that the temporaries
+ * made for each element are freed as the walk goes instead of at the end.
+ */
+- (void) forEachElementOf: (id) collection usingBlock: (void (^)(id element)) block {
+    NSUInteger interval = self.autoreleaseInterval;
+    if (!interval || [collection count] <= interval) {
+        for (id element in collection) {
+            block(element);
+        }
+        return;
+    }
+    NSArray *elements;
+    if ([collection isKindOfClass:[NSArray class]]) {
+        elements = collection;
+    } else if ([collection isKindOfClass:[NSDictionary class]]) {
+        elements = [collection allKeys];
+    } else {
+        NSMutableArray *copied = [[NSMutableArray alloc] initWithCapacity:[collection count]];
+        for (id element in collection) {
+            [copied addObject:element];
+        }
+        elements = copied;
+    }
+    NSUInteger count = [elements count];
+    for (NSUInteger start = 0; start < count; start += interval) {
+        @autoreleasepool {
+            NSUInteger end = MIN(start + interval, count);
+            for (NSUInteger i = start; i < end; i++) {
+                block([elements objectAtIndex:i]);
+            }
+        }
+    }
+}
+
 - (id) composeModelFromObject: (id) object {
     return [self composeModelFromObject:object withTargetClass: nil];
 }
 
 - (id) composeModelFromObject: (id) object withTargetClass: (Class) targetClass {
+    return [self composeModelFromObject:object withTargetClass:targetClass projection:nil];
+}
+
+- (id) composeModelFromObject: (id) object withTargetClass: (Class) targetClass projection: (JAGProjection *) projection {
     if (!object) {
         return nil;
-    } else if ([object isKindOfClass: [NSArray class]]
-               || [object isKindOfClass: [NSSet class]]) {
-        return [self composeCollection:object withTargetClass:targetClass];
-    } else if ([object isKindOfClass: [NSDictionary class]]) {
-        //Is this a PropertyModel in disguise?
-        Class modelClass = nil;
-        if (self.identifyDict) {
-            modelClass = self.identifyDict(object);
-        }
-        if (modelClass) {
-            id model = [[modelClass alloc] init];
-            [self setPropertiesOf:model fromDictionary:object];
-            return model;
-        } else if (targetClass && [self shouldConvertClass:targetClass]) {
-            //Try to coerce it into targetClass.
-            id model = [[targetClass alloc] init];
-            [self setPropertiesOf:model fromDictionary:object];
-            return model;
-        } else {
-            NSMutableDictionary *dict = [NSMutableDictionary dictionary];
-            for (id key in object) {
-                [dict setValue: [self composeModelFromObject: [object valueForKey: key]]
-                        forKey: key];
-            }
-            return dict;
-        }
+    }
+    if ([projection isFull]) {
+        projection = nil;
+    }
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [self withIdentityMap:^ id {
+            return [self composeModelFromObject:object withTargetClass:targetClass projection:projection];
+        }];
+    }
+    JAGComposeKind kind = JAGComposeKindOf([self dispatchForObject:object]);
+    unsigned int targetFlags = targetClass ? JAGTargetFlagsOf([self dispatchForClass:targetClass]) : 0;
+    if (kind == JAGComposeCollection) {
+        return [self composeCollection:object withTargetClass:targetClass projection:projection];
+    } else if (kind == JAGComposeDictionary) {
+        //Try to coerce it into targetClass, if identifyDict doesn't know better.
+        Class coercedClass = (targetFlags & JAGTargetIsConvertible) ? targetClass : Nil;
+        return [self composeModelFromDictionary:object coercedClass:coercedClass projection:projection];
     } else if (targetClass && [object isKindOfClass: targetClass]) {
         //TODO: If there are other collections that aren't subclasses of NSSet, NSArray, or NSDictionary,
         //this won't convert their elements/values.
         return object;
-    } else if (targetClass 
-               && [targetClass isSubclassOfClass:[NSDate class]] 
-               && self.convertToDate) {
-        //        NSLog(@"Found prop %@ for NSDate targetClass.  Converting.", prop);
+    } else if ((targetFlags & JAGTargetIsDate) && _dateCodec) {
+        return [_dateCodec dateFromValue:object];
+    } else if ((targetFlags & JAGTargetIsDate) && self.convertToDate) {
         return self.convertToDate(object);
-    } else if ( targetClass 
-               && [targetClass isSubclassOfClass:[NSURL class]]
-               && [object isKindOfClass:[NSString class]]
-               )
-    {        
+    } else if ((targetFlags & JAGTargetIsURL) && kind == JAGComposeString) {
         return [NSURL URLWithString:object];
-    } else if ( self.numberFormatter
-               && targetClass
-               && [targetClass isSubclassOfClass:[NSNumber class]]
-               && [object isKindOfClass:[NSString class]])
+    } else if ( (_shouldParseNumericStrings || self.numberFormatter)
+               && (targetFlags & JAGTargetIsNumber)
+               && kind == JAGComposeString)
     {
-        return [self.numberFormatter numberFromString:object];
-    } else if ([object  isKindOfClass: [NSNull class]]
-               || [object isKindOfClass: [NSString class]]
-               || [object isKindOfClass: [NSNumber class]]
-               || [object isKindOfClass: [NSDate class]]
-               || [object isKindOfClass: [NSData class]]
-               || [object isKindOfClass: [NSValue class]]
-               ) {
+        return [self numberFromString:object];
+    } else if (kind == JAGComposeString || kind == JAGComposeBasic) {
         return object;
     }
     
     //TODO: Don't know what to do with this!  If we are using fullOutputType, we might be
     //getting other NSObject types, which we should be able to handle.
-    NSLog(@"Unable to convert value %@ to an object property, returning nil.", [object class]);
+    [self reportDiagnostic:kJAGDiagnosticUnknownClass value:object context:targetClass];
     return nil;
     
 }
 
+/*
+ * Compose a dictionary into a model of the class identifyDict gives, or else
+ * of coercedClass, or if neither gives one, into a dictionary of composed
+ * values.  With an identity map installed, a dictionary seen before or a
+ * reference resolves to the model already composed for it.
+ */
+- (id) composeModelFromDictionary: (NSDictionary *) object
+                     coercedClass: (Class) coercedClass
+                       projection: (JAGProjection *) projection
+{
+    JAGIdentityMap *map = _shouldPreserveIdentity ? JAGCurrentIdentityMap(self) : nil;
+    if (map) {
+        //A dictionary that appears more than once becomes a single model.
+        id seen = [map resultForObject:object];
+        if (seen) return seen;
+        id identifier = [object objectForKey:JAGReferenceKey];
+        if (identifier) return [map modelForIdentifier:identifier];
+    }
+    //Is this a PropertyModel in disguise?
+    Class modelClass = nil;
+    if (self.identifyDict) {
+        modelClass = self.identifyDict(object);
+    }
+    if (!modelClass) {
+        modelClass = coercedClass;
+    }
+    if (modelClass) {
+        id model = [self newModelOfClass:modelClass];
+        [map setResult:model forObject:object];
+        [self setPropertiesOf:model fromDictionary:object projection:projection];
+        return model;
+    }
+    NSMutableDictionary *dict = [[NSMutableDictionary alloc] initWithCapacity:[object count]];
+    [self forEachElementOf:object usingBlock:^(id key) {
+        JAGProjection *child = nil;
+        if (projection && !(child = [projection projectionForKey:key])) {
+            return;
+        }
+        [dict setValue: [self composeModelFromObject: [object valueForKey: key] withTargetClass:nil projection:child]
+                forKey: key];
+    }];
+    return dict;
+}
+
 - (void) setPropertiesOf: (id) object fromDictionary: (NSDictionary*) dictionary {
-    JAGProperty *property;
+    [self setPropertiesOf:object fromDictionary:dictionary projection:nil];
+}
+
+- (void) setPropertiesOf: (id) object fromDictionary: (NSDictionary*) dictionary projection: (JAGProjection *) projection {
+    if ([projection isFull]) {
+        projection = nil;
+    }
+    if (_shouldPreserveIdentity) {
+        JAGIdentityMap *map = JAGCurrentIdentityMap(self);
+        if (!map) {
+            [self withIdentityMap:^ id { [self setPropertiesOf:object fromDictionary:dictionary projection:projection]; return nil; }];
+            return;
+        }
+        //Register before setting properties, so that cycles back to object resolve.
+        id identifier = [dictionary objectForKey:JAGIdentityKey];
+        if (identifier) [map setModel:object forIdentifier:identifier];
+    }
+    if (_shouldUseGeneratedCodecs && !_shouldMergeInPlace && !_shouldComposeLazily && !projection) {
+        const JAGGeneratedCodec *generated = JAGGeneratedCodecForClass([object class], self);
+        if (generated) {
+            generated->decode(self, object, dictionary);
+            return;
+        }
+    }
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(object)];
     for (NSString *key in dictionary) {
-        property = [JAGPropertyFinder propertyForName: key inClass:[object class] ];
-        if (!property || [property isReadOnly]) continue;
-        id value = [dictionary valueForKey:key];
-        //See if we should convert an NSString to an NSNumber
-        if (self.numberFormatter && property.isNumber && [value isKindOfClass:[NSString class]])
-        {
-            //Handle NSNumber propertyClasses in the compose function
-            value = [self.numberFormatter numberFromString:value];
+        JAGProjection *child = nil;
+        if (projection && !(child = [projection projectionForKey:key])) {
+            continue;
         }
-        if ([property isObject]) {
-            Class propertyClass = [property propertyClass];
-            value = [self composeModelFromObject: value withTargetClass:propertyClass];
+        [self setPropertyNamed:key ofModel:object toValue:[dictionary objectForKey:key] codec:codec projection:child];
+    }
+}
+
+- (void) setPropertyNamed: (NSString *) key ofModel: (id) object toValue: (id) value codec: (JAGClassCodec *) codec {
+    [self setPropertyNamed:key ofModel:object toValue:value codec:codec projection:nil];
+}
+
+/*
+ * Set one property of object from a dictionary value, as setPropertiesOf:fromDictionary: does.
+ * Merging in place merges the whole value; projection only limits what is composed.
+ *
+ * @param codec The codec for object_getClass(object).
+ * @param projection What to compose within value, or nil for everything.
+ */
+- (void) setPropertyNamed: (NSString *) key
+                  ofModel: (id) object
+                  toValue: (id) value
+                    codec: (JAGClassCodec *) codec
+               projection: (JAGProjection *) projection {
+    if ([projection isFull]) {
+        projection = nil;
+    }
+    //Properties declared on NSObject itself are found too, with no index.
+    NSUInteger index;
+    JAGProperty *property = [codec propertyNamed:key index:&index];
+    if (!property || [property isReadOnly]) return;
+    //See if we should convert an NSString to an NSNumber
+    if ((_shouldParseNumericStrings || self.numberFormatter) && property.isNumber && [value isKindOfClass:[NSString class]])
+    {
+        if (_shouldParseNumericStrings && !_shouldMergeInPlace && ![property isObject] && index != NSNotFound) {
+            [self setNumericString:value toProperty:property atIndex:index ofModel:object codec:codec];
+            return;
+        }
+        //Handle NSNumber propertyClasses in the compose function
+        value = [self numberFromString:value];
+    }
+    id current = nil;
+    if (_shouldMergeInPlace && index != NSNotFound && [codec canGetValueAtIndex:index ofModel:object]) {
+        current = [codec valueAtIndex:index ofModel:object];
+        if (current && [self mergeValue:value into:current ofProperty:property atIndex:index ofModel:object codec:codec]) {
+            return;
+        }
+    }
+    if ([property isObject]) {
+        //A deferred value would be composed whole, so only defer without a projection.
+        if (_shouldComposeLazily && !projection && [self deferComposing:value ofProperty:property toModel:object]) {
+            return;
+        }
+        Class propertyClass = [property propertyClass];
+        value = [self composeModelFromObject: value withTargetClass:propertyClass projection:projection];
+    }
+    if (current && [current isEqual:value]) {
+        //Unchanged; don't set it, so observers aren't notified.
+        return;
+    }
+    [self assignValue:value toProperty:property atIndex:index ofModel:object codec:codec];
+}
+
+#pragma mark - Merge
+
+/*
+ * Merge value into current, the value property already has: a dictionary
+ * into a model, or the elements of a collection into current's elements.
+ *
+ * @return YES if value was merged, NO if it should be composed and set as usual.
+ */
+- (BOOL) mergeValue: (id) value
+               into: (id) current
+         ofProperty: (JAGProperty *) property
+            atIndex: (NSUInteger) index
+            ofModel: (id) model
+              codec: (JAGClassCodec *) codec
+{
+    JAGComposeKind kind = JAGComposeKindOf([self dispatchForObject:value]);
+    if (kind == JAGComposeDictionary) {
+        if (JAGDecomposeHandlerOf([self dispatchForObject:current]) != JAGDecomposeModel) return NO;
+        Class modelClass = self.identifyDict ? self.identifyDict(value) : nil;
+        if (modelClass && [current class] != modelClass) return NO;
+        [self setPropertiesOf:current fromDictionary:value];
+        return YES;
+    } else if (kind == JAGComposeCollection && self.mergeKey) {
+        id merged = [self mergeCollection:value into:current withTargetClass:[property propertyClass]];
+        if (!merged) return NO;
+        if (merged != current) {
+            [self assignValue:merged toProperty:property atIndex:index ofModel:model codec:codec];
+        }
+        return YES;
+    }
+    return NO;
+}
+
+/*
+ * Compose collection, reusing (and updating) the models of current whose
+ * mergeKey values match those of collection's dictionaries.
+ *
+ * @return current if the result has the same elements, the new collection,
+ * or nil if targetClass isn't an array or set.
+ */
+- (id) mergeCollection: (id) collection into: (id) current withTargetClass: (Class) targetClass {
+    unsigned int targetFlags = JAGTargetFlagsOf([self dispatchForClass:targetClass ? targetClass : [current class]]);
+    if (!(targetFlags & (JAGTargetIsArray | JAGTargetIsSet))) return nil;
+    NSString *mergeKey = self.mergeKey;
+
+    NSMutableDictionary *existing = [[NSMutableDictionary alloc] initWithCapacity:[current count]];
+    for (id element in current) {
+        if (JAGDecomposeHandlerOf([self dispatchForObject:element]) != JAGDecomposeModel) continue;
+        JAGClassCodec *elementCodec = [JAGClassCodec codecForClass:object_getClass(element)];
+        NSUInteger keyIndex = [elementCodec indexOfPropertyNamed:mergeKey];
+        if (keyIndex == NSNotFound) continue;
+        id key = [elementCodec valueAtIndex:keyIndex ofModel:element];
+        if (key) [existing setObject:element forKey:key];
+    }
+
+    id merged;
+    if (targetFlags & JAGTargetIsArray) {
+        merged = [[NSMutableArray alloc] initWithCapacity:[collection count]];
+    } else {
+        merged = [[NSMutableSet alloc] initWithCapacity:[collection count]];
+    }
+    [self forEachElementOf:collection usingBlock:^(id elt) {
+        id value = nil;
+        if (JAGComposeKindOf([self dispatchForObject:elt]) == JAGComposeDictionary) {
+            id key = [elt objectForKey:mergeKey];
+            value = key ? [existing objectForKey:key] : nil;
+            if (value) {
+                [self setPropertiesOf:value fromDictionary:elt];
+            }
+        }
+        if (!value) {
+            value = [self composeModelFromObject:elt withTargetClass:nil];
+        }
+        if (value) {
+            [merged addObject:value];
+        } else {
+            [self reportDiagnostic:kJAGDiagnosticDroppedValue value:elt context:nil];
+        }
+    }];
+    return [merged isEqual:current] ? current : merged;
+}
+
+/*
+ * A frozen copy of the current configuration, made once and kept until the
+ * configuration changes.  Threads composing at once may each make one, but
+ * only one is kept.
+ */
+- (JAGPropertyConverter *) lazySnapshot {
+    if (_frozen) return self;
+    void *snapshot = _lazySnapshot;
+    if (!snapshot) {
+        void *made = (__bridge_retained void *)[self frozenCopy];
+        if (__sync_bool_compare_and_swap(&_lazySnapshot, NULL, made)) {
+            snapshot = made;
+        } else {
+            CFRelease(made);
+            snapshot = _lazySnapshot;
+        }
+    }
+    return (__bridge JAGPropertyConverter *)snapshot;
+}
+
+/*
+ * Leave a nested model or collection uncomposed until property's getter is
+ * first called, if it's the kind of value shouldComposeLazily covers.
+ */
+- (BOOL) deferComposing: (id) value ofProperty: (JAGProperty *) property toModel: (id) model {
+    Class propertyClass = [property propertyClass];
+    if (_shouldPreserveIdentity || !propertyClass || !value) return NO;
+    unsigned int targetFlags = JAGTargetFlagsOf([self dispatchForClass:propertyClass]);
+    if (!(targetFlags & (JAGTargetIsConvertible | JAGTargetIsArray | JAGTargetIsSet))) return NO;
+    JAGComposeKind kind = JAGComposeKindOf([self dispatchForObject:value]);
+    if (kind != JAGComposeDictionary && kind != JAGComposeCollection) return NO;
+    //Compose with the configuration of now, not of the first read, and without keeping self alive.
+    JAGPropertyConverter *snapshot = [self lazySnapshot];
+    return [JAGLazyHydrator deferProperty:property ofModel:model withBlock:^(id lazyModel) {
+        id composed = [snapshot composeModelFromObject:value withTargetClass:propertyClass];
+        JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(lazyModel)];
+        NSUInteger index = [codec indexOfPropertyNamed:[property name]];
+        [snapshot assignValue:composed toProperty:property atIndex:index ofModel:lazyModel codec:codec];
+    }];
+}
+
+/*
+ * Set a composed value, if the property can accept it.  An index of NSNotFound
+ * means the property isn't in the codec, and is set through KVC.
+ */
+- (void) assignValue: (id) value
+          toProperty: (JAGProperty *) property
+             atIndex: (NSUInteger) index
+             ofModel: (id) object
+               codec: (JAGClassCodec *) codec
+{
+    if ([property canAcceptValue:value]) {
+        if (index != NSNotFound) {
+            [codec setValue:value atIndex:index ofModel:object];
+        } else {
+            [object setValue:value forKey:[property name]];
+        }
+    } else {
+        [self reportDiagnostic:kJAGDiagnosticUnsettableProperty value:value context:property];
+    }
+}
+
+#pragma mark - Numeric Strings
+
+/*
+ * Parse string with the converter's parser, if shouldParseNumericStrings
+ * is set, falling back to numberFormatter.
+ */
+- (NSNumber *) numberFromString: (NSString *) string {
+    if (_shouldParseNumericStrings) {
+        JAGParsedNumber number;
+        if (JAGParseNumericString(string, &number)) {
+            return JAGNumberFromParsedNumber(&number);
+        }
+    }
+    return [self.numberFormatter numberFromString:string];
+}
+
+/*
+ * Set a primitive numeric property from string without boxing it, if it
+ * parses and fits the property's type.
+ */
+- (void) setNumericString: (NSString *) string
+               toProperty: (JAGProperty *) property
+                  atIndex: (NSUInteger) index
+                  ofModel: (id) object
+                    codec: (JAGClassCodec *) codec
+{
+    JAGParsedNumber number;
+    if (!JAGParseNumericString(string, &number)) {
+        if (self.numberFormatter) {
+            NSNumber *value = [self.numberFormatter numberFromString:string];
+            [self assignValue:value toProperty:property atIndex:index ofModel:object codec:codec];
+        } else {
+            [self reportDiagnostic:kJAGDiagnosticUnsettableProperty value:string context:property];
+        }
+    } else if (![self setNumber:number truncating:NO toProperty:property atIndex:index ofModel:object codec:codec]) {
+        [self reportDiagnostic:kJAGDiagnosticUnsettableProperty value:string context:property];
+    }
+}
+
+/*
+ * Set a primitive numeric property from number without boxing it, if it
+ * fits the property's type.  If truncating, as setValue:forKey: does with
+ * an NSNumber, a fraction is dropped for an integer property and any nonzero
+ * number sets a BOOL; otherwise those don't fit.  Either way a number out of
+ * the property's range doesn't, since casting it would be undefined.
+ *
+ * @return NO, having set nothing, if number doesn't fit.
+ */
+- (BOOL) setNumber: (JAGParsedNumber) number
+        truncating: (BOOL) truncating
+        toProperty: (JAGProperty *) property
+           atIndex: (NSUInteger) index
+           ofModel: (id) object
+             codec: (JAGClassCodec *) codec
+{
+    JAGPropertyScalarKind scalarKind = [property scalarKind];
+    BOOL isFloatingPoint = scalarKind == JAGPropertyScalarKindFloat || scalarKind == JAGPropertyScalarKindDouble;
+    if (truncating && scalarKind == JAGPropertyScalarKindBool) {
+        BOOL isTrue = number.kind == JAGParsedNumberDouble ? number.doubleValue != 0 : number.unsignedLongLongValue != 0;
+        [codec setLongLongValue:isTrue atIndex:index ofModel:object];
+        return YES;
+    }
+    if (truncating && !isFloatingPoint && number.kind == JAGParsedNumberDouble) {
+        //longLongValue is already truncated toward zero, where it is in range.
+        number.doubleValue = trunc(number.doubleValue);
+    }
+    if (!JAGParsedNumberFitsScalarKind(&number, scalarKind)) {
+        return NO;
+    }
+    if (isFloatingPoint) {
+        [codec setDoubleValue:number.doubleValue atIndex:index ofModel:object];
+    } else if (number.kind == JAGParsedNumberUnsignedLongLong) {
+        //setLongLongValue: casts back to the unsigned type, so this is exact.
+        [codec setLongLongValue:(long long)number.unsignedLongLongValue atIndex:index ofModel:object];
+    } else {
+        [codec setLongLongValue:number.longLongValue atIndex:index ofModel:object];
+    }
+    return YES;
+}
+
+- (NSArray *) numbersFromStrings: (NSArray *) strings {
+    NSUInteger count = [strings count];
+    JAGParsedNumber *numbers = malloc(MAX(count, (NSUInteger)1) * sizeof(JAGParsedNumber));
+    JAGParseNumericStrings(strings, numbers);
+    NSMutableArray *result = [[NSMutableArray alloc] initWithCapacity:count];
+    NSNull *null = [NSNull null];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSNumber *number = JAGNumberFromParsedNumber(&numbers[i]);
+        if (!number && self.numberFormatter) {
+            id string = [strings objectAtIndex:i];
+            if ([string isKindOfClass:[NSString class]]) {
+                number = [self.numberFormatter numberFromString:string];
+            }
+        }
+        [result addObject:number ? number : null];
+    }
+    free(numbers);
+    return result;
+}
+
+#pragma mark - Model Pool
+
+- (id) newModelOfClass: (Class) modelClass {
+    id model = [_modelPool dequeueModelOfClass:modelClass];
+    return model ? model : [[modelClass alloc] init];
+}
+
+- (void) recycleModel: (id) model {
+    if (!_modelPool || !model) return;
+    CFMutableSetRef visited = CFSetCreateMutable(NULL, 0, NULL);
+    [self recycleObject:model visited:visited];
+    CFRelease(visited);
+}
+
+/*
+ * Recycle the models object holds, then object itself if it is a model.
+ * visited holds the objects already seen, so that models that are shared
+ * or in cycles are recycled once.
+ */
+- (void) recycleObject: (id) object visited: (CFMutableSetRef) visited {
+    if (!object || CFSetContainsValue(visited, (__bridge void *) object)) return;
+    CFSetAddValue(visited, (__bridge void *) object);
+    unsigned int dispatch = [self dispatchForObject:object];
+    JAGComposeKind kind = JAGComposeKindOf(dispatch);
+    if (kind == JAGComposeCollection) {
+        for (id element in object) {
+            [self recycleObject:element visited:visited];
+        }
+    } else if (kind == JAGComposeDictionary) {
+        for (id key in object) {
+            [self recycleObject:[object objectForKey:key] visited:visited];
+        }
+    } else if (JAGTargetFlagsOf(dispatch) & JAGTargetIsConvertible) {
+        JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(object)];
+        NSUInteger count = [codec count];
+        for (NSUInteger i = 0; i < count; i++) {
+            JAGProperty *property = [codec propertyAtIndex:i];
+            //Weak properties don't own their models.
+            if (![property isObject] || [property isWeak] || ![codec canGetValueAtIndex:i ofModel:object]) continue;
+            [self recycleObject:[codec valueAtIndex:i ofModel:object] visited:visited];
         }
-        if ([property canAcceptValue:value]) {
-            [object setValue:value forKey:key];
+        [_modelPool recycleModel:object];
+    }
+}
+
+#pragma mark - Decode JSON
+
+- (id) composeModelFromJSONData: (NSData *) data ofClass: (Class) modelClass error: (NSError **) error {
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithData:data];
+    return [self composeModelFromEntireReader:reader ofClass:modelClass error:error];
+}
+
+- (id) composeModelFromJSONStream: (NSInputStream *) stream ofClass: (Class) modelClass error: (NSError **) error {
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithInputStream:stream bufferSize:0];
+    return [self composeModelFromEntireReader:reader ofClass:modelClass error:error];
+}
+
+- (id) composeModelFromEntireReader: (JAGJSONReader *) reader ofClass: (Class) modelClass error: (NSError **) error {
+    id result = [self composeModelFromJSONReader:reader ofClass:modelClass];
+    if (result && [reader nextToken] != JAGJSONTokenEnd) {
+        result = nil;
+    }
+    if (!result && error) {
+        *error = reader.error;
+    }
+    return result;
+}
+
+- (id) composeModelFromJSONReader: (JAGJSONReader *) reader ofClass: (Class) modelClass {
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [self withIdentityMap:^ id { return [self composeModelFromJSONReader:reader ofClass:modelClass]; }];
+    }
+    JAGJSONToken token = [reader nextToken];
+    id result;
+    if (!modelClass) {
+        result = [self composeModelFromReader:reader token:token withTargetClass:nil];
+    } else if (token == JAGJSONTokenBeginObject) {
+        result = [self modelOfClass:modelClass fromReader:reader];
+    } else if (token == JAGJSONTokenBeginArray) {
+        NSMutableArray *models = [NSMutableArray array];
+        while ((token = [reader nextToken]) != JAGJSONTokenEndArray) {
+            id value;
+            if (token == JAGJSONTokenBeginObject) {
+                value = [self modelOfClass:modelClass fromReader:reader];
+            } else {
+                value = [self composeModelFromReader:reader token:token withTargetClass:nil];
+            }
+            if (reader.error) {
+                return nil;
+            }
+            if (value) {
+                [models addObject:value];
+            } else {
+                [self reportDiagnostic:kJAGDiagnosticDroppedValue value:nil context:modelClass];
+            }
+        }
+        result = models;
+    } else {
+        result = [self composeModelFromReader:reader token:token withTargetClass:modelClass];
+    }
+    return reader.error ? nil : result;
+}
+
+- (BOOL) enumerateModelsInJSONFile: (NSString *) path
+                           ofClass: (Class) modelClass
+                         withBlock: (void (^)(id model, BOOL *stop)) block
+                             error: (NSError **) error {
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithContentsOfMappedFile:path error:error];
+    if (!reader) return NO;
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        __block BOOL succeeded = NO;
+        __block NSError *failure = nil;
+        [self withIdentityMap:^ id {
+            NSError *readError = nil;
+            succeeded = [self enumerateModelsFromJSONReader:reader ofClass:modelClass withBlock:block error:&readError];
+            failure = readError;
+            return nil;
+        }];
+        if (!succeeded && error) *error = failure;
+        return succeeded;
+    }
+    return [self enumerateModelsFromJSONReader:reader ofClass:modelClass withBlock:block error:error];
+}
+
+- (BOOL) enumerateModelsFromJSONReader: (JAGJSONReader *) reader
+                               ofClass: (Class) modelClass
+                             withBlock: (void (^)(id model, BOOL *stop)) block
+                                 error: (NSError **) error {
+    JAGJSONToken token = [reader nextToken];
+    if (token != JAGJSONTokenBeginArray) {
+        if (error) {
+            *error = reader.error ? reader.error : [NSError errorWithDomain:JAGJSONReaderErrorDomain
+                                                                       code:JAGJSONReaderErrorSyntax
+                                                                   userInfo:[NSDictionary dictionaryWithObject:@"Expected a top-level array."
+                                                                                                        forKey:NSLocalizedDescriptionKey]];
+        }
+        return NO;
+    }
+    BOOL stop = NO;
+    while (!stop) {
+        //Each model is the caller's once block returns, so don't let temporaries pile up across elements.
+        @autoreleasepool {
+            token = [reader nextToken];
+            if (token == JAGJSONTokenEndArray) break;
+            id value;
+            if (modelClass && token == JAGJSONTokenBeginObject) {
+                value = [self modelOfClass:modelClass fromReader:reader];
+            } else {
+                value = [self composeModelFromReader:reader token:token withTargetClass:nil];
+            }
+            if (reader.error) break;
+            if (value) {
+                block(value, &stop);
+            } else {
+                [self reportDiagnostic:kJAGDiagnosticDroppedValue value:nil context:modelClass];
+            }
+            [reader discardConsumedInput];
+        }
+    }
+    //After stopping early the rest of the file is left unchecked.
+    if (!reader.error && !stop) {
+        [reader nextToken];
+    }
+    if (reader.error) {
+        if (error) *error = reader.error;
+        return NO;
+    }
+    return YES;
+}
+
+- (id) modelOfClass: (Class) modelClass fromReader: (JAGJSONReader *) reader {
+    JAGJSONToken token = [reader nextToken];
+    if (_shouldPreserveIdentity && token == JAGJSONTokenKey && [[reader stringValue] isEqualToString:JAGReferenceKey]) {
+        id identifier = [reader objectValueForToken:[reader nextToken]];
+        //Ignore anything else in the reference.
+        while ((token = [reader nextToken]) == JAGJSONTokenKey) {
+            [reader skipValueForToken:[reader nextToken]];
+        }
+        if (!identifier || token != JAGJSONTokenEndObject) return nil;
+        return [JAGCurrentIdentityMap(self) modelForIdentifier:identifier];
+    }
+    id model = [self newModelOfClass:modelClass];
+    return [self setPropertiesOf:model fromReader:reader token:token] ? model : nil;
+}
+
+/*
+ * The streaming counterpart of composeModelFromObject:withTargetClass:,
+ * for the JSON value that starts with token.
+ */
+- (id) composeModelFromReader: (JAGJSONReader *) reader token: (JAGJSONToken) token withTargetClass: (Class) targetClass {
+    unsigned int targetFlags = targetClass ? JAGTargetFlagsOf([self dispatchForClass:targetClass]) : 0;
+    switch (token) {
+        case JAGJSONTokenBeginObject: {
+            if (self.identifyDict) {
+                //identifyDict needs the whole dictionary.
+                NSDictionary *dictionary = [reader objectValueForToken:token];
+                return dictionary ? [self composeModelFromObject:dictionary withTargetClass:targetClass] : nil;
+            } else if (targetFlags & JAGTargetIsConvertible) {
+                //Coerce it into targetClass.
+                return [self modelOfClass:targetClass fromReader:reader];
+            }
+            NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+            while ((token = [reader nextToken]) != JAGJSONTokenEndObject) {
+                if (token != JAGJSONTokenKey) return nil;
+                NSString *key = [reader stringValue];
+                id value = [self composeModelFromReader:reader token:[reader nextToken] withTargetClass:nil];
+                if (reader.error) return nil;
+                if (key) {
+                    [dict setValue:value forKey:key];
+                }
+            }
+            id identifier = _shouldPreserveIdentity ? [dict objectForKey:JAGReferenceKey] : nil;
+            if (identifier) {
+                return [JAGCurrentIdentityMap(self) modelForIdentifier:identifier];
+            }
+            return dict;
+        }
+        case JAGJSONTokenBeginArray: {
+            id collection;
+            //A JSON array is an NSArray, which is what we make without a targetClass.
+            if (!targetClass || (targetFlags & JAGTargetIsArray)) {
+                collection = [[NSMutableArray alloc] init];
+            } else if (targetFlags & JAGTargetIsSet) {
+                collection = [[NSMutableSet alloc] init];
+            } else {
+                [self reportDiagnostic:kJAGDiagnosticTypeMismatch value:nil context:targetClass];
+                [reader skipValueForToken:token];
+                return nil;
+            }
+            while ((token = [reader nextToken]) != JAGJSONTokenEndArray) {
+                id value = [self composeModelFromReader:reader token:token withTargetClass:nil];
+                if (reader.error) return nil;
+                if (value) {
+                    [collection addObject:value];
+                } else {
+                    [self reportDiagnostic:kJAGDiagnosticDroppedValue value:nil context:nil];
+                }
+            }
+            return collection;
+        }
+        default: {
+            //Scalars are small, so box them and reuse the usual rules.
+            id value = [reader objectValueForToken:token];
+            return value ? [self composeModelFromObject:value withTargetClass:targetClass] : nil;
+        }
+    }
+}
+
+/*
+ * The streaming counterpart of setPropertiesOf:fromDictionary:.  token is
+ * the first token after the JAGJSONTokenBeginObject; this reads up to and
+ * including the matching JAGJSONTokenEndObject.
+ *
+ * @return NO if the reader reports an error.
+ */
+- (BOOL) setPropertiesOf: (id) object fromReader: (JAGJSONReader *) reader token: (JAGJSONToken) token {
+    JAGClassCodec *codec = [JAGClassCodec codecForClass:object_getClass(object)];
+    JAGIdentityMap *map = _shouldPreserveIdentity ? JAGCurrentIdentityMap(self) : nil;
+    for (; token != JAGJSONTokenEndObject; token = [reader nextToken]) {
+        if (token != JAGJSONTokenKey) return NO;
+        //Look the key up by its bytes, without making an NSString of it.
+        const char *keyBytes = [reader stringBytes];
+        NSUInteger keyLength = [reader stringLength];
+        NSUInteger index;
+        JAGProperty *property = [codec propertyNamedBytes:keyBytes length:keyLength index:&index];
+        BOOL isIdentityKey = map && !property && keyLength == sizeof(JAGIdentityKeyBytes) - 1
+            && memcmp(keyBytes, JAGIdentityKeyBytes, keyLength) == 0;
+        token = [reader nextToken];
+        if (!property || [property isReadOnly]) {
+            if (isIdentityKey) {
+                //Written first by writeModel:toWriter:usingBlock:, so cycles back to object resolve.
+                id identifier = [reader objectValueForToken:token];
+                if (!identifier) return NO;
+                [map setModel:object forIdentifier:identifier];
+                continue;
+            }
+            if (![reader skipValueForToken:token]) return NO;
+            continue;
+        }
+        if (index != NSNotFound && [property isNumber]) {
+            //Set numeric properties straight from the token, without boxing.
+            if (token == JAGJSONTokenNumber) {
+                if (![self setNumber:*[reader parsedNumber] truncating:YES toProperty:property atIndex:index ofModel:object codec:codec]) {
+                    [self reportDiagnostic:kJAGDiagnosticUnsettableProperty value:[reader numberValue] context:property];
+                }
+                continue;
+            } else if (token == JAGJSONTokenTrue || token == JAGJSONTokenFalse) {
+                [codec setLongLongValue:(token == JAGJSONTokenTrue) atIndex:index ofModel:object];
+                continue;
+            }
+        }
+        id value;
+        if ([property isObject]) {
+            value = [self composeModelFromReader:reader token:token withTargetClass:[property propertyClass]];
         } else {
-            NSLog(@"Unable to set value of class %@ into property %@ of typeEncoding %@", 
-                  [value class], [property name], [property typeEncoding]);
+            value = [reader objectValueForToken:token];
+            //See if we should convert an NSString to an NSNumber
+            if ((_shouldParseNumericStrings || self.numberFormatter) && property.isNumber && [value isKindOfClass:[NSString class]]) {
+                if (_shouldParseNumericStrings && index != NSNotFound) {
+                    [self setNumericString:value toProperty:property atIndex:index ofModel:object codec:codec];
+                    continue;
+                }
+                value = [self numberFromString:value];
+            }
+        }
+        if (reader.error) return NO;
+        [self assignValue:value toProperty:property atIndex:index ofModel:object codec:codec];
+    }
+    return YES;
+}
+
+#pragma mark - Decode MessagePack
+
+- (id) composeModelFromMessagePackData: (NSData *) data ofClass: (Class) modelClass error: (NSError **) error {
+    JAGMessagePackReader *reader = [[JAGMessagePackReader alloc] initWithData:data];
+    id object = [reader readEntireObject];
+    if (!object) {
+        if (error) *error = reader.error;
+        return nil;
+    }
+    if (_shouldPreserveIdentity && !JAGCurrentIdentityMap(self)) {
+        return [self withIdentityMap:^ id { return [self composeModelFromMessagePackObject:object ofClass:modelClass]; }];
+    }
+    return [self composeModelFromMessagePackObject:object ofClass:modelClass];
+}
+
+/*
+ * Compose a decoded MessagePack map into a modelClass, or each map in an
+ * array.  Unlike composeModelsFromArray:ofClass:, the array is composed
+ * serially, so that references between its elements resolve.
+ */
+- (id) composeModelFromMessagePackObject: (id) object ofClass: (Class) modelClass {
+    if (!modelClass) {
+        return [self composeModelFromObject:object withTargetClass:nil];
+    }
+    JAGComposeKind kind = JAGComposeKindOf([self dispatchForObject:object]);
+    if (kind == JAGComposeDictionary) {
+        JAGIdentityMap *map = _shouldPreserveIdentity ? JAGCurrentIdentityMap(self) : nil;
+        id identifier = map ? [object objectForKey:JAGReferenceKey] : nil;
+        if (identifier) return [map modelForIdentifier:identifier];
+        id model = [self newModelOfClass:modelClass];
+        [map setResult:model forObject:object];
+        [self setPropertiesOf:model fromDictionary:object];
+        return model;
+    } else if (kind == JAGComposeCollection) {
+        NSMutableArray *models = [NSMutableArray array];
+        for (id elt in object) {
+            id value = [self composeModelFromMessagePackObject:elt ofClass:modelClass];
+            if (value) {
+                [models addObject:value];
+            } else {
+                [self reportDiagnostic:kJAGDiagnosticDroppedValue value:elt context:nil];
+            }
         }
+        return models;
     }
+    return [self composeModelFromObject:object withTargetClass:modelClass];
 }
 
 @end
@@ -75,6 +75,15 @@
      NSArray *propertyNames = [JAGPropertyFinder propertyNamesForClass:[MySubclass class]];
      // [ @"subtitle", @"fun", @"things", @"anotherOne", @"count", @"title" ]
 
+   The property metadata for each class is computed once and cached for the
+   life of the process, so repeated calls return the same (immutable) arrays
+   and the same JAGProperty instances.  The cache is thread-safe.  On Apple
+   platforms it is flushed automatically when new images are loaded.  A
+   class is only read when first looked up, so registering a new class needs
+   nothing.  The runtime gives no notice of properties added with
+   `class_addProperty` to a class already looked up, and on other platforms
+   (GNUstep's libobjc2) none of image loading either, so after changing
+   such classes at runtime, call invalidatePropertyCache.
   
  */
 @interface JAGPropertyFinder : NSObject
@@ -124,4 +133,14 @@
  */
 + (NSArray*) propertyNamesForClass: (Class) aClass;
 
+/**
+ * Discard all cached property metadata.
+ *
+ * The next lookup for each class will re-read its properties from the runtime.
+ * This is only needed if classes already looked up change without an image being
+ * loaded on an Apple platform: properties added with `class_addProperty`, or,
+ * elsewhere, categories loaded from a bundle.
+ */
++ (void) invalidatePropertyCache;
+
 @end
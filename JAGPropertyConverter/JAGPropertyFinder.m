@@ -25,50 +25,213 @@
 
 #import "JAGPropertyFinder.h"
 #import "JAGProperty.h"
+#import "JAGClassTable.h"
 #import <objc/runtime.h>
+#import <pthread.h>
+#if defined(__APPLE__)
+#import <mach-o/dyld.h>
+#endif
 
+/*
+ * The flattened property metadata for a single class.  Entries are built
+ * once and never mutated, so they can be handed out to any thread.
+ */
+@interface JAGPropertyCacheEntry : NSObject
+
+///JAGProperty objects declared directly on the class.
+@property (nonatomic, readonly) NSArray *declaredProperties;
+///JAGProperty objects for the class and its superclasses, excluding NSObject.
+@property (nonatomic, readonly) NSArray *properties;
+///Names of the JAGProperty objects in properties, in the same order.
+@property (nonatomic, readonly) NSArray *propertyNames;
+///Name -> JAGProperty for the whole class hierarchy, NSObject included.
+@property (nonatomic, readonly) NSDictionary *propertiesByName;
+
+- (id) initWithClass: (Class) aClass;
+
+@end
+
+@implementation JAGPropertyCacheEntry
+
+@synthesize declaredProperties = _declaredProperties;
+@synthesize properties = _properties;
+@synthesize propertyNames = _propertyNames;
+@synthesize propertiesByName = _propertiesByName;
+
+- (id) initWithClass: (Class) aClass {
+    self = [super init];
+    if (self) {
+        NSMutableArray *properties = [NSMutableArray array];
+        NSMutableArray *propertyNames = [NSMutableArray array];
+        NSMutableDictionary *propertiesByName = [NSMutableDictionary dictionary];
+        BOOL isBelowNSObject = YES;
+        for (Class cls = aClass; cls; cls = class_getSuperclass(cls)) {
+            if (cls == [NSObject class]) {
+                isBelowNSObject = NO;
+            }
+            unsigned int count;
+            objc_property_t *list = class_copyPropertyList(cls, &count);
+            NSMutableArray *declared = [NSMutableArray arrayWithCapacity:count];
+            for (unsigned int i = 0; i < count; i++) {
+                JAGProperty *property = [JAGProperty propertyWithObjCProperty: list[i]];
+                [declared addObject:property];
+                //Like class_getProperty, the most-derived declaration wins.
+                if (![propertiesByName objectForKey:property.name]) {
+                    [propertiesByName setObject:property forKey:property.name];
+                }
+            }
+            free(list);
+            if (cls == aClass) {
+                _declaredProperties = [declared copy];
+            }
+            if (isBelowNSObject) {
+                [properties addObjectsFromArray:declared];
+                for (JAGProperty *property in declared) {
+                    [propertyNames addObject:property.name];
+                }
+            }
+        }
+        _properties = [properties copy];
+        _propertyNames = [propertyNames copy];
+        _propertiesByName = [propertiesByName copy];
+    }
+    return self;
+}
+
+@end
+
+#pragma mark - Cache
+
+//Class to its JAGPropertyCacheEntry, read without locking.
+static JAGClassTable gPropertyTable = JAG_CLASS_TABLE_INITIALIZER;
+//The entries in gPropertyTable, which keeps no references of its own.
+//Guarded by gPropertyCacheLock.
+static NSMutableArray *gPropertyEntries = nil;
+//Entries from before the last rebuild, kept alive until no lookup can
+//still be retaining one.  Guarded by gPropertyCacheLock.
+static NSMutableArray *gRetiredPropertyEntries = nil;
+static volatile BOOL gHasRetiredPropertyEntries = NO;
+static pthread_mutex_t gPropertyCacheLock = PTHREAD_MUTEX_INITIALIZER;
+//Bumped whenever the set of loaded classes may have changed.
+static volatile int32_t gPropertyCacheGeneration = 0;
+//The generation gPropertyTable was built against.  Written under gPropertyCacheLock.
+static volatile int32_t gPropertyCacheBuiltGeneration = 0;
+
+static void JAGInvalidatePropertyCache(void) {
+    __sync_fetch_and_add(&gPropertyCacheGeneration, 1);
+}
+
+#if defined(__APPLE__)
+//Loading an image can register new classes or add category properties
+//to existing ones.  This is called from inside dyld, so just bump the
+//generation and let the next lookup throw the stale entries away.
+static void JAGPropertyCacheImageAdded(const struct mach_header *header, intptr_t slide) {
+    JAGInvalidatePropertyCache();
+}
+#endif
+
+//Release the retired entries and table storage, if no lookup is running.  Must hold gPropertyCacheLock.
+static void JAGReclaimRetiredPropertyEntries(void) {
+    if (JAGClassTableReclaimIfQuiescent(&gPropertyTable)) {
+        [gRetiredPropertyEntries removeAllObjects];
+        gHasRetiredPropertyEntries = NO;
+    }
+}
+
+static JAGPropertyCacheEntry *JAGPropertyCacheEntryForClass(Class aClass) {
+    if (!aClass) return nil;
+
+    uintptr_t found;
+    //The entry is retained before the read ends, so it can't be released under us.
+    JAGClassTableBeginRead(&gPropertyTable);
+    JAGPropertyCacheEntry *cached = gPropertyCacheBuiltGeneration == gPropertyCacheGeneration
+        && JAGClassTableLookup(&gPropertyTable, aClass, &found)
+        ? (__bridge JAGPropertyCacheEntry *)(void *)found
+        : nil;
+    if (JAGClassTableEndRead(&gPropertyTable) && gHasRetiredPropertyEntries
+        && pthread_mutex_trylock(&gPropertyCacheLock) == 0)
+    {
+        JAGReclaimRetiredPropertyEntries();
+        pthread_mutex_unlock(&gPropertyCacheLock);
+    }
+    if (cached) return cached;
+
+    pthread_mutex_lock(&gPropertyCacheLock);
+    if (gPropertyCacheBuiltGeneration != gPropertyCacheGeneration) {
+        //Other threads may still be reading the stale entries, so they are retired, not released.
+        JAGClassTableRemoveAll(&gPropertyTable);
+        [gRetiredPropertyEntries addObjectsFromArray:gPropertyEntries];
+        [gPropertyEntries removeAllObjects];
+        gHasRetiredPropertyEntries = YES;
+        gPropertyCacheBuiltGeneration = gPropertyCacheGeneration;
+        JAGReclaimRetiredPropertyEntries();
+    }
+    //Retained under the lock, which reclaiming takes.
+    cached = JAGClassTableLookup(&gPropertyTable, aClass, &found) ? (__bridge JAGPropertyCacheEntry *)(void *)found : nil;
+    int32_t generation = gPropertyCacheBuiltGeneration;
+    pthread_mutex_unlock(&gPropertyCacheLock);
+    if (cached) return cached;
+
+    //Build outside the lock; reflection is the slow part.
+    JAGPropertyCacheEntry *entry = [[JAGPropertyCacheEntry alloc] initWithClass:aClass];
+
+    pthread_mutex_lock(&gPropertyCacheLock);
+    if (gPropertyCacheGeneration != generation) {
+        //Invalidated while building, so entry may be stale; caching it would outlive the rebuild.
+        pthread_mutex_unlock(&gPropertyCacheLock);
+        return JAGPropertyCacheEntryForClass(aClass);
+    }
+    if (JAGClassTableLookup(&gPropertyTable, aClass, &found)) {
+        //Another thread got here first; keep a single canonical entry.
+        entry = (__bridge JAGPropertyCacheEntry *)(void *)found;
+    } else {
+        [gPropertyEntries addObject:entry];
+        JAGClassTableInsert(&gPropertyTable, aClass, (uintptr_t)(__bridge void *)entry);
+        //Growing the table may have retired its storage.
+        gHasRetiredPropertyEntries = YES;
+        JAGReclaimRetiredPropertyEntries();
+    }
+    pthread_mutex_unlock(&gPropertyCacheLock);
+    return entry;
+}
 
 @implementation JAGPropertyFinder
 
++ (void) initialize {
+    if (self == [JAGPropertyFinder class]) {
+        gPropertyEntries = [[NSMutableArray alloc] init];
+        gRetiredPropertyEntries = [[NSMutableArray alloc] init];
+#if defined(__APPLE__)
+        _dyld_register_func_for_add_image(JAGPropertyCacheImageAdded);
+#endif
+    }
+}
+
++ (void) invalidatePropertyCache {
+    JAGInvalidatePropertyCache();
+}
 
 + (NSArray *)propertiesForSubclass: (Class) subclass;
 {
-    unsigned int count;
-    objc_property_t *list = class_copyPropertyList(subclass, &count);
-    
-    NSMutableArray* propertyArray = [NSMutableArray arrayWithCapacity:count];
-    for (int i = 0; i < count ; i++)
-    {
-        [propertyArray addObject: [JAGProperty propertyWithObjCProperty: list[i]]];
-    }
-    free(list);
-    return propertyArray;
+    NSArray *properties = [JAGPropertyCacheEntryForClass(subclass) declaredProperties];
+    return properties ? properties : [NSArray array];
 }
 
 + (NSArray *)propertiesForClass:(Class)aClass
 {
-    NSMutableArray *propertyArray = [NSMutableArray array];
-    while (aClass && (aClass != [NSObject class]) ) {
-        [propertyArray addObjectsFromArray: [self propertiesForSubclass: aClass]];
-        aClass = [aClass superclass];
-    }
-    return propertyArray; 
+    NSArray *properties = [JAGPropertyCacheEntryForClass(aClass) properties];
+    return properties ? properties : [NSArray array];
 }
 
 + (JAGProperty *)propertyForName: (NSString *)name inClass:(__unsafe_unretained Class)aClass
 {
-    objc_property_t property = class_getProperty(aClass, [name UTF8String]);
-    if(!property) return nil;
-    return [JAGProperty propertyWithObjCProperty: property];
+    if (!name) return nil;
+    return [[JAGPropertyCacheEntryForClass(aClass) propertiesByName] objectForKey:name];
 }
 
 + (NSArray*) propertyNamesForClass: (Class) aClass {
-    NSArray *propertyArray = [self propertiesForClass: aClass];
-    NSMutableArray *propertyNames = [NSMutableArray arrayWithCapacity:[propertyArray count]];
-    for (JAGProperty *property in propertyArray) {
-        [propertyNames addObject:property.name];
-    }
-    return propertyNames;
+    NSArray *propertyNames = [JAGPropertyCacheEntryForClass(aClass) propertyNames];
+    return propertyNames ? propertyNames : [NSArray array];
 }
 
 @end
@@ -0,0 +1,156 @@
+//
+//  JAGRecordPipeline.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+@class JAGPropertyConverter;
+
+/**
+ * What a JAGRecordPipeline did, stage by stage.
+ *
+ * Divide a stage's count by its time for its throughput: recordCount by
+ * readTime for splitting, recordCount by decodeTime for one decoding
+ * worker, and modelCount by consumeTime for the consumer.  A large
+ * stallTime means the reader was held back by slower stages.
+ */
+typedef struct {
+    ///Bytes read from the input.
+    unsigned long long byteCount;
+    ///Non-blank lines read.
+    NSUInteger recordCount;
+    ///Records composed and delivered.
+    NSUInteger modelCount;
+    ///Records that weren't valid JSON, and were dropped.
+    NSUInteger failedRecordCount;
+    ///Batches delivered to the consumer.
+    NSUInteger batchCount;
+    ///Seconds spent reading and splitting the input.
+    NSTimeInterval readTime;
+    ///Seconds the reader spent waiting for a free worker or batch slot.
+    NSTimeInterval stallTime;
+    ///Seconds spent decoding, summed over the workers.
+    NSTimeInterval decodeTime;
+    ///Seconds spent in the consumer Block.
+    NSTimeInterval consumeTime;
+    ///Seconds from the start of the input to the last delivery.
+    NSTimeInterval elapsedTime;
+} JAGRecordPipelineStatistics;
+
+///Receives each batch of models, in a JAGRecordPipeline.
+typedef void (^JAGRecordConsumer)(NSArray *models);
+
+///Called once a JAGRecordPipeline has delivered everything it read.  error is nil if the input ended normally.
+typedef void (^JAGRecordCompletion)(JAGRecordPipelineStatistics statistics, NSError *error);
+
+/**
+   JAGRecordPipeline composes models from newline-delimited JSON (one JSON
+   value per line) in the background.
+
+     JAGRecordPipeline *pipeline = [[JAGRecordPipeline alloc] initWithConverter:converter
+                                                                     modelClass:[User class]];
+     [pipeline processStream:stream consumer:^(NSArray *users) {
+         [store addUsers:users];
+     } completion:^(JAGRecordPipelineStatistics statistics, NSError *error) {
+         NSLog(@"%lu users", (unsigned long)statistics.modelCount);
+     }];
+
+   One thread reads the input and splits it into batches of lines.  Up to
+   workerCount batches are decoded at once, each record with
+   [JAGPropertyConverter composeModelFromJSONData:ofClass:error:], and the
+   models of each batch are passed to the consumer.  Records that aren't
+   valid JSON are dropped, with a kJAGDiagnosticDroppedValue diagnostic.
+   Blank lines, and a `\r` before a newline, are ignored.
+
+   At most queueCapacity batches are in the pipeline at once, between being
+   read and the consumer returning, so a slow consumer slows the reader
+   rather than letting batches pile up in memory.
+
+   The consumer is called for one batch at a time, on a private serial
+   queue, and in the order of the input unless shouldPreserveOrder is NO.
+   Configure the pipeline before processing, and process one input at a
+   time.
+ */
+@interface JAGRecordPipeline : NSObject
+
+/**
+ * A pipeline that composes records into models of modelClass.
+ *
+ * @param converter Its rules are used for every record.  The workers
+ * share its frozenCopy, so reconfiguring it afterwards has no effect.
+ * @param modelClass The class of the models, or nil to compose each
+ * record with the converter's identifyDict.
+ */
+- (id) initWithConverter: (JAGPropertyConverter *) converter modelClass: (Class) modelClass;
+
+/// The frozen converter the workers use.
+@property (nonatomic, readonly, strong) JAGPropertyConverter *converter;
+
+/// The class of the models, or nil.
+@property (nonatomic, readonly, unsafe_unretained) Class modelClass;
+
+/// The most batches decoded at once.  Default is the number of active processors.
+@property (nonatomic, assign) NSUInteger workerCount;
+
+/// The most records in a batch.  Default is 256.
+@property (nonatomic, assign) NSUInteger batchSize;
+
+/// The most batches between being read and consumed.  Default is twice workerCount.
+@property (nonatomic, assign) NSUInteger queueCapacity;
+
+/// Whether batches are delivered in the order of the input.  Default is YES.
+@property (nonatomic, assign) BOOL shouldPreserveOrder;
+
+/**
+ * Compose the records of an open stream, in the background.
+ *
+ * The stream is read until it ends or fails, from another thread, and is
+ * left open.
+ *
+ * @param consumer Called with the models of each batch that has any.
+ * @param completion Called after the last batch, on the consumer's queue.
+ */
+- (void) processStream: (NSInputStream *) stream
+              consumer: (JAGRecordConsumer) consumer
+            completion: (JAGRecordCompletion) completion;
+
+/**
+ * Compose the records of a file descriptor, such as a file or a pipe, in the background.
+ *
+ * The descriptor is read until end of file or an error, and is left open.
+ *
+ * @param consumer Called with the models of each batch that has any.
+ * @param completion Called after the last batch, on the consumer's queue.
+ */
+- (void) processFileDescriptor: (int) fileDescriptor
+                      consumer: (JAGRecordConsumer) consumer
+                    completion: (JAGRecordCompletion) completion;
+
+/**
+ * Stop reading, and drop the batches not yet delivered.
+ *
+ * The completion Block is still called, with an NSUserCancelledError.
+ */
+- (void) cancel;
+
+@end
@@ -0,0 +1,372 @@
+//
+//  JAGRecordPipeline.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGRecordPipeline.h"
+#import "JAGPropertyConverter.h"
+#import <dispatch/dispatch.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+//Bytes read from the input at a time.
+#define JAGRecordReadSize (64 * 1024)
+
+//Reads up to length bytes into buffer.  Returns 0 at the end of the input, or -1 and sets *error.
+typedef NSInteger (^JAGRecordReadBlock)(uint8_t *buffer, NSUInteger length, NSError **error);
+
+//The converter's private diagnostic hook.
+@interface JAGPropertyConverter (JAGRecordPipeline)
+- (void) reportDiagnostic: (JAGDiagnosticCode) code value: (id) value context: (id) context;
+@end
+
+/*
+ * The lines of one batch, and then the models composed from them.
+ * The reader fills in the lines, one worker the models.
+ */
+@interface JAGRecordBatch : NSObject
+{
+@public
+    NSUInteger _sequence;
+    NSMutableData *_bytes;
+    //An NSRange into _bytes for each record.
+    NSMutableData *_ranges;
+    NSUInteger _count;
+    NSMutableArray *_models;
+    NSUInteger _failedCount;
+    NSTimeInterval _decodeTime;
+}
+@end
+
+@implementation JAGRecordBatch
+
+- (id) init {
+    self = [super init];
+    if (self) {
+        _bytes = [[NSMutableData alloc] initWithCapacity:JAGRecordReadSize];
+        _ranges = [[NSMutableData alloc] init];
+    }
+    return self;
+}
+
+//Ends the record that starts at *start, unless it is blank.  Returns YES if it was added.
+- (BOOL) endRecordAt: (NSUInteger *) start {
+    const uint8_t *bytes = [_bytes bytes];
+    NSUInteger end = [_bytes length];
+    NSUInteger begin = *start;
+    *start = end;
+    if (end > begin && bytes[end - 1] == '\r') end--;
+    for (NSUInteger i = begin; i < end; i++) {
+        uint8_t c = bytes[i];
+        if (c != ' ' && c != '\t' && c != '\r') {
+            NSRange range = NSMakeRange(begin, end - begin);
+            [_ranges appendBytes:&range length:sizeof(range)];
+            _count++;
+            return YES;
+        }
+    }
+    return NO;
+}
+
+@end
+
+@interface JAGRecordPipeline ()
+
+- (void) processWithReadBlock: (JAGRecordReadBlock) readBytes
+                     consumer: (JAGRecordConsumer) consumer
+                   completion: (JAGRecordCompletion) completion;
+- (NSError *) readRecords: (JAGRecordReadBlock) readBytes consumer: (JAGRecordConsumer) consumer;
+- (void) submitBatch: (JAGRecordBatch *) batch consumer: (JAGRecordConsumer) consumer;
+- (void) decodeBatch: (JAGRecordBatch *) batch;
+- (void) deliverBatch: (JAGRecordBatch *) batch consumer: (JAGRecordConsumer) consumer;
+- (void) consumeBatch: (JAGRecordBatch *) batch consumer: (JAGRecordConsumer) consumer;
+- (void) releaseRunState;
+
+@end
+
+@implementation JAGRecordPipeline
+{
+@private
+    dispatch_queue_t _readQueue;
+    dispatch_queue_t _deliveryQueue;
+    //The state of the input being processed, from here down.
+    dispatch_semaphore_t _slots;
+    dispatch_semaphore_t _workers;
+    dispatch_group_t _group;
+    NSUInteger _batchLimit;
+    NSUInteger _submittedCount;
+    //Batches decoded ahead of their turn, by sequence.  Only touched on _deliveryQueue.
+    NSMutableDictionary *_waiting;
+    NSUInteger _nextSequence;
+    //The reader's fields are only written on _readQueue, the rest on _deliveryQueue.
+    JAGRecordPipelineStatistics _statistics;
+    volatile int32_t _cancelled;
+}
+
+@synthesize converter = _converter;
+@synthesize modelClass = _modelClass;
+@synthesize workerCount = _workerCount;
+@synthesize batchSize = _batchSize;
+@synthesize queueCapacity = _queueCapacity;
+@synthesize shouldPreserveOrder = _shouldPreserveOrder;
+
+- (id) initWithConverter: (JAGPropertyConverter *) converter modelClass: (Class) modelClass {
+    self = [super init];
+    if (self) {
+        _converter = [converter frozenCopy];
+        _modelClass = modelClass;
+        _workerCount = [[NSProcessInfo processInfo] activeProcessorCount];
+        _batchSize = 256;
+        _shouldPreserveOrder = YES;
+        _readQueue = dispatch_queue_create("JAGRecordPipeline.read", NULL);
+        _deliveryQueue = dispatch_queue_create("JAGRecordPipeline.deliver", NULL);
+    }
+    return self;
+}
+
+- (void) dealloc {
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(_readQueue);
+    dispatch_release(_deliveryQueue);
+#endif
+}
+
+- (NSUInteger) queueCapacity {
+    //Unset means twice the workers, so each worker has a batch waiting.
+    return _queueCapacity ? _queueCapacity : 2 * MAX(_workerCount, 1);
+}
+
+#pragma mark - Processing
+
+- (void) processStream: (NSInputStream *) stream
+              consumer: (JAGRecordConsumer) consumer
+            completion: (JAGRecordCompletion) completion {
+    [self processWithReadBlock:^NSInteger(uint8_t *buffer, NSUInteger length, NSError **error) {
+        NSInteger count = [stream read:buffer maxLength:length];
+        if (count < 0) {
+            NSError *streamError = [stream streamError];
+            *error = streamError ? streamError : [NSError errorWithDomain:NSPOSIXErrorDomain code:EIO userInfo:nil];
+        }
+        return count;
+    } consumer:consumer completion:completion];
+}
+
+- (void) processFileDescriptor: (int) fileDescriptor
+                      consumer: (JAGRecordConsumer) consumer
+                    completion: (JAGRecordCompletion) completion {
+    [self processWithReadBlock:^NSInteger(uint8_t *buffer, NSUInteger length, NSError **error) {
+        ssize_t count;
+        do {
+            count = read(fileDescriptor, buffer, length);
+        } while (count < 0 && errno == EINTR);
+        if (count < 0) {
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        }
+        return (NSInteger) count;
+    } consumer:consumer completion:completion];
+}
+
+- (void) cancel {
+    __sync_lock_test_and_set(&_cancelled, 1);
+}
+
+- (void) processWithReadBlock: (JAGRecordReadBlock) readBytes
+                     consumer: (JAGRecordConsumer) consumer
+                   completion: (JAGRecordCompletion) completion {
+    _slots = dispatch_semaphore_create(self.queueCapacity);
+    _workers = dispatch_semaphore_create(MAX(_workerCount, 1));
+    _group = dispatch_group_create();
+    _batchLimit = MAX(_batchSize, 1);
+    _waiting = [[NSMutableDictionary alloc] init];
+    _submittedCount = 0;
+    _nextSequence = 0;
+    memset(&_statistics, 0, sizeof(_statistics));
+    _cancelled = 0;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    dispatch_async(_readQueue, ^{
+        NSError *readError = [self readRecords:readBytes consumer:consumer];
+        //Every batch has been submitted; finish once the last one is consumed.
+        dispatch_group_notify(_group, _deliveryQueue, ^{
+            NSError *error = readError;
+            if (!error && _cancelled) {
+                error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSUserCancelledError userInfo:nil];
+            }
+            _statistics.elapsedTime = CFAbsoluteTimeGetCurrent() - start;
+            JAGRecordPipelineStatistics statistics = _statistics;
+            [self releaseRunState];
+            if (completion) completion(statistics, error);
+        });
+    });
+}
+
+//Runs on _readQueue.  Returns the read error, if any.
+- (NSError *) readRecords: (JAGRecordReadBlock) readBytes consumer: (JAGRecordConsumer) consumer {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    uint8_t *buffer = malloc(JAGRecordReadSize);
+    JAGRecordBatch *batch = [[JAGRecordBatch alloc] init];
+    NSUInteger recordStart = 0;
+    NSError *error = nil;
+    BOOL atEnd = NO;
+
+    while (!atEnd && !_cancelled) {
+        NSInteger count = readBytes(buffer, JAGRecordReadSize, &error);
+        if (count < 0) break;
+        if (count == 0) {
+            atEnd = YES;
+            break;
+        }
+        _statistics.byteCount += count;
+
+        const uint8_t *cursor = buffer;
+        const uint8_t *end = buffer + count;
+        while (cursor < end) {
+            const uint8_t *newline = memchr(cursor, '\n', end - cursor);
+            const uint8_t *stop = newline ? newline : end;
+            [batch->_bytes appendBytes:cursor length:stop - cursor];
+            cursor = stop;
+            if (!newline) break;
+            cursor++;
+            if ([batch endRecordAt:&recordStart]) {
+                _statistics.recordCount++;
+                if (batch->_count == _batchLimit) {
+                    //A full batch ends on a newline, so it holds no part of the next record.
+                    [self submitBatch:batch consumer:consumer];
+                    batch = [[JAGRecordBatch alloc] init];
+                    recordStart = 0;
+                }
+            }
+        }
+    }
+    free(buffer);
+
+    if (atEnd && !_cancelled) {
+        //The last line needn't end with a newline.
+        if ([batch endRecordAt:&recordStart]) _statistics.recordCount++;
+        if (batch->_count) [self submitBatch:batch consumer:consumer];
+    }
+    _statistics.readTime = CFAbsoluteTimeGetCurrent() - start - _statistics.stallTime;
+    return error;
+}
+
+//Runs on _readQueue.  Waits for room in the pipeline, then hands the batch to a worker.
+- (void) submitBatch: (JAGRecordBatch *) batch consumer: (JAGRecordConsumer) consumer {
+    batch->_sequence = _submittedCount++;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    //A slot is held until the batch is consumed, a worker only while it is decoded.
+    dispatch_semaphore_wait(_slots, DISPATCH_TIME_FOREVER);
+    dispatch_semaphore_wait(_workers, DISPATCH_TIME_FOREVER);
+    _statistics.stallTime += CFAbsoluteTimeGetCurrent() - start;
+
+    dispatch_group_enter(_group);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [self decodeBatch:batch];
+        dispatch_semaphore_signal(_workers);
+        dispatch_async(_deliveryQueue, ^{
+            [self deliverBatch:batch consumer:consumer];
+        });
+    });
+}
+
+//Runs on a global queue.
+- (void) decodeBatch: (JAGRecordBatch *) batch {
+    if (_cancelled) return;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    const uint8_t *bytes = [batch->_bytes bytes];
+    const NSRange *ranges = [batch->_ranges bytes];
+    NSMutableArray *models = [[NSMutableArray alloc] initWithCapacity:batch->_count];
+    for (NSUInteger i = 0; i < batch->_count; i++) {
+        @autoreleasepool {
+            NSData *record = [[NSData alloc] initWithBytesNoCopy:(void *) (bytes + ranges[i].location)
+                                                          length:ranges[i].length
+                                                    freeWhenDone:NO];
+            id model = [_converter composeModelFromJSONData:record ofClass:_modelClass error:NULL];
+            if (model) {
+                [models addObject:model];
+            } else {
+                batch->_failedCount++;
+                //The handler may keep the value, so don't pass it the batch's bytes.
+                [_converter reportDiagnostic:kJAGDiagnosticDroppedValue
+                                       value:[NSData dataWithData:record]
+                                     context:_modelClass];
+            }
+        }
+    }
+    batch->_models = models;
+    batch->_bytes = nil;
+    batch->_ranges = nil;
+    batch->_decodeTime = CFAbsoluteTimeGetCurrent() - start;
+}
+
+//Runs on _deliveryQueue.
+- (void) deliverBatch: (JAGRecordBatch *) batch consumer: (JAGRecordConsumer) consumer {
+    if (!_shouldPreserveOrder) {
+        [self consumeBatch:batch consumer:consumer];
+        return;
+    }
+    [_waiting setObject:batch forKey:[NSNumber numberWithUnsignedInteger:batch->_sequence]];
+    //The earliest batch always holds a slot, so waiting here can't starve the reader.
+    NSNumber *key = [NSNumber numberWithUnsignedInteger:_nextSequence];
+    JAGRecordBatch *next;
+    while ((next = [_waiting objectForKey:key])) {
+        [_waiting removeObjectForKey:key];
+        _nextSequence++;
+        [self consumeBatch:next consumer:consumer];
+        key = [NSNumber numberWithUnsignedInteger:_nextSequence];
+    }
+}
+
+//Runs on _deliveryQueue.
+- (void) consumeBatch: (JAGRecordBatch *) batch consumer: (JAGRecordConsumer) consumer {
+    if (!_cancelled && batch->_models) {
+        _statistics.modelCount += [batch->_models count];
+        _statistics.failedRecordCount += batch->_failedCount;
+        _statistics.decodeTime += batch->_decodeTime;
+        _statistics.batchCount++;
+        if ([batch->_models count] && consumer) {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            @autoreleasepool {
+                consumer(batch->_models);
+            }
+            _statistics.consumeTime += CFAbsoluteTimeGetCurrent() - start;
+        }
+    }
+    batch->_models = nil;
+    dispatch_semaphore_signal(_slots);
+    dispatch_group_leave(_group);
+}
+
+//Runs on _deliveryQueue, once every slot and worker has been returned.
+- (void) releaseRunState {
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(_slots);
+    dispatch_release(_workers);
+    dispatch_release(_group);
+#endif
+    _slots = NULL;
+    _workers = NULL;
+    _group = NULL;
+    _waiting = nil;
+}
+
+@end
@@ -0,0 +1,62 @@
+//
+//  JAGStructuredWriter.h
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <Foundation/Foundation.h>
+
+/**
+   The writing methods that JAGJSONWriter and JAGMessagePackWriter share,
+   so that JAGPropertyConverter can write a model's properties to either
+   with the same code.
+
+   A map is a JSON object or a MessagePack map.  As with each writer, a key
+   is only written along with the next value, so a value that can't be
+   written leaves its key out too.
+ */
+@protocol JAGStructuredWriter <NSObject>
+
+- (void) beginMap;
+- (void) endMap;
+
+/// Set the key for the next value in the current map.
+- (void) writeKey: (NSString *) key;
+
+- (void) writeBool: (BOOL) value;
+- (void) writeLongLong: (long long) value;
+- (void) writeUnsignedLongLong: (unsigned long long) value;
+
+/**
+ * Write a float, without the digits it would gain from widening to double.
+ *
+ * @return NO (writing nothing) if the format can't represent value.
+ */
+- (BOOL) writeFloat: (float) value;
+
+/**
+ * Write a double.
+ *
+ * @return NO (writing nothing) if the format can't represent value.
+ */
+- (BOOL) writeDouble: (double) value;
+
+@end
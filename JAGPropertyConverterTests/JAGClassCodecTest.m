@@ -0,0 +1,154 @@
+//
+//  JAGClassCodecTest.m
+//  JAGPropertyConverterTests
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGClassCodecTest.h"
+#import "TestModel.h"
+#import "JAGClassCodec.h"
+#import "JAGProperty.h"
+#import "JAGPropertyFinder.h"
+
+@interface JAGClassCodecTest () {
+@private
+    TestModel *model;
+    JAGClassCodec *codec;
+}
+@end
+
+@implementation JAGClassCodecTest
+
+- (void) setUp {
+    model = [TestModel testModel];
+    [model populate];
+    codec = [JAGClassCodec codecForClass:[TestModel class]];
+}
+
+- (void) testCodecIsCached {
+    STAssertTrue(codec == [JAGClassCodec codecForClass:[TestModel class]], @"Codecs should be cached per class.");
+    STAssertFalse(codec == [JAGClassCodec codecForClass:[TestModelSubclass class]], @"Each class should have its own codec.");
+}
+
+- (void) testPropertiesMatchFinder {
+    NSArray *properties = [JAGPropertyFinder propertiesForClass:[TestModel class]];
+    STAssertEquals([codec count], [properties count], @"Codec should have a slot for each property.");
+    STAssertEqualObjects([codec properties], properties, @"Codec should use the finder's properties.");
+}
+
+- (void) testIndexOfPropertyNamed {
+    NSUInteger index = [codec indexOfPropertyNamed:@"stringProperty"];
+    STAssertTrue(index != NSNotFound, @"stringProperty should be found.");
+    STAssertEqualObjects([[codec propertyAtIndex:index] name], @"stringProperty", @"Index should point to stringProperty.");
+    STAssertEquals([codec indexOfPropertyNamed:@"noSuchProperty"], (NSUInteger)NSNotFound, @"Unknown names should not be found.");
+}
+
+- (void) testIndexOfPropertyNamedBytes {
+    //Every property, superclass ones included, should hash to its own index.
+    JAGClassCodec *subCodec = [JAGClassCodec codecForClass:[TestModelSubclass class]];
+    for (NSUInteger i = 0; i < [subCodec count]; i++) {
+        NSString *name = [[subCodec propertyAtIndex:i] name];
+        const char *bytes = [name UTF8String];
+        STAssertEquals([subCodec indexOfPropertyNamedBytes:bytes length:strlen(bytes)], [subCodec indexOfPropertyNamed:name],
+                       @"%@ should be found by its bytes.", name);
+        STAssertEqualObjects([[subCodec propertyAtIndex:[subCodec indexOfPropertyNamed:name]] name], name,
+                             @"%@ should be found at its own index.", name);
+    }
+    STAssertEquals([codec indexOfPropertyNamedBytes:"stringPropertyX" length:14], [codec indexOfPropertyNamed:@"stringProperty"],
+                   @"Only length bytes should be compared.");
+    STAssertEquals([codec indexOfPropertyNamedBytes:"stringPropert" length:13], (NSUInteger)NSNotFound, @"Prefixes should not be found.");
+    STAssertEquals([codec indexOfPropertyNamedBytes:"" length:0], (NSUInteger)NSNotFound, @"Empty names should not be found.");
+    STAssertEquals([codec indexOfPropertyNamedBytes:"subclassStringProperty" length:22], (NSUInteger)NSNotFound,
+                   @"Subclass properties should not be found in the superclass.");
+}
+
+- (void) testPropertyNamedFindsRootProperties {
+    NSUInteger index = 0;
+    JAGProperty *property = [codec propertyNamed:@"intProperty" index:&index];
+    STAssertEqualObjects([property name], @"intProperty", @"Codec properties should be found.");
+    STAssertEquals(index, [codec indexOfPropertyNamed:@"intProperty"], @"Codec properties should have their index.");
+    STAssertNil([codec propertyNamed:@"noSuchProperty" index:&index], @"Unknown names should not be found.");
+    STAssertEquals(index, (NSUInteger)NSNotFound, @"Unknown names should have no index.");
+    for (JAGProperty *rootProperty in [JAGPropertyFinder propertiesForSubclass:[NSObject class]]) {
+        if ([rootProperty isReadOnly] || [codec indexOfPropertyNamed:[rootProperty name]] != NSNotFound) continue;
+        STAssertEqualObjects([[codec propertyNamed:[rootProperty name] index:&index] name], [rootProperty name],
+                             @"Writable NSObject properties should be found.");
+        STAssertEquals(index, (NSUInteger)NSNotFound, @"NSObject properties should have no index.");
+    }
+}
+
+- (void) testGetObjectValue {
+    NSUInteger index = [codec indexOfPropertyNamed:@"stringProperty"];
+    STAssertEqualObjects([codec valueAtIndex:index ofModel:model], model.stringProperty, @"Codec should read object properties.");
+}
+
+- (void) testGetScalarValue {
+    NSUInteger index = [codec indexOfPropertyNamed:@"intProperty"];
+    STAssertEqualObjects([codec valueAtIndex:index ofModel:model], [model valueForKey:@"intProperty"],
+                         @"Codec should box scalars like KVC does.");
+    STAssertEquals([codec longLongValueAtIndex:index ofModel:model], (long long)model.intProperty,
+                   @"Codec should read unboxed scalars.");
+}
+
+- (void) testGetStructValue {
+    NSUInteger index = [codec indexOfPropertyNamed:@"cfProperty"];
+    id value = [codec valueAtIndex:index ofModel:model];
+    STAssertTrue([value isKindOfClass:[NSValue class]], @"Struct properties should be boxed in an NSValue.");
+}
+
+- (void) testCustomGetterAndSetter {
+    NSUInteger index = [codec indexOfPropertyNamed:@"active"];
+    [codec setValue:[NSNumber numberWithBool:YES] atIndex:index ofModel:model];
+    STAssertTrue([model isActive], @"Codec should use the custom setter.");
+    STAssertTrue([[codec valueAtIndex:index ofModel:model] boolValue], @"Codec should use the custom getter.");
+}
+
+- (void) testSetScalarValue {
+    NSUInteger index = [codec indexOfPropertyNamed:@"intProperty"];
+    [codec setValue:[NSNumber numberWithInt:42] atIndex:index ofModel:model];
+    STAssertEquals(model.intProperty, 42, @"Codec should set boxed scalars.");
+    [codec setLongLongValue:7 atIndex:index ofModel:model];
+    STAssertEquals(model.intProperty, 7, @"Codec should set unboxed scalars.");
+    [codec setDoubleValue:3.9 atIndex:index ofModel:model];
+    STAssertEquals(model.intProperty, 3, @"Codec should truncate doubles into int properties.");
+}
+
+- (void) testSetObjectValue {
+    NSUInteger index = [codec indexOfPropertyNamed:@"testModelID"];
+    [codec setValue:@"ABC" atIndex:index ofModel:model];
+    STAssertEqualObjects(model.testModelID, @"ABC", @"Codec should set object properties.");
+    [codec setValue:nil atIndex:index ofModel:model];
+    STAssertNil(model.testModelID, @"Codec should set object properties to nil.");
+}
+
+- (void) testSubclassCodec {
+    TestModelSubclass *subModel = [[TestModelSubclass alloc] init];
+    [subModel populate];
+    JAGClassCodec *subCodec = [JAGClassCodec codecForClass:[TestModelSubclass class]];
+    NSUInteger subIndex = [subCodec indexOfPropertyNamed:@"subclassStringProperty"];
+    NSUInteger index = [subCodec indexOfPropertyNamed:@"stringProperty"];
+    STAssertEqualObjects([subCodec valueAtIndex:subIndex ofModel:subModel], subModel.subclassStringProperty,
+                         @"Subclass codec should read subclass properties.");
+    STAssertEqualObjects([subCodec valueAtIndex:index ofModel:subModel], subModel.stringProperty,
+                         @"Subclass codec should read superclass properties.");
+}
+
+@end
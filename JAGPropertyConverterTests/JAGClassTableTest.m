@@ -0,0 +1,109 @@
+//
+//  JAGClassTableTest.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGClassTableTest.h"
+#import "JAGClassTable.h"
+#import <objc/runtime.h>
+
+@implementation JAGClassTableTest
+{
+@private
+    JAGClassTable table;
+    Class *classes;
+    int classCount;
+}
+
+- (void) setUp {
+    JAGClassTableInit(&table);
+    classCount = objc_getClassList(NULL, 0);
+    classes = (Class *)malloc(sizeof(Class) * classCount);
+    classCount = objc_getClassList(classes, classCount);
+}
+
+- (void) tearDown {
+    JAGClassTableDestroy(&table);
+    free(classes);
+}
+
+- (void) testInsertAndLookup {
+    uintptr_t value;
+    STAssertFalse(JAGClassTableLookup(&table, [NSString class], &value), @"An empty table has nothing.");
+    //Enough classes to grow the table several times.
+    for (int i = 0; i < classCount; i++) {
+        JAGClassTableInsert(&table, classes[i], i);
+    }
+    for (int i = 0; i < classCount; i++) {
+        STAssertTrue(JAGClassTableLookup(&table, classes[i], &value) && value == (uintptr_t)i,
+                     @"Every class should be found with its value.");
+    }
+    JAGClassTableInsert(&table, classes[0], 42);
+    STAssertTrue(JAGClassTableLookup(&table, classes[0], &value) && value == 42, @"Inserting again should replace.");
+
+    JAGClassTableRemoveAll(&table);
+    STAssertFalse(JAGClassTableLookup(&table, classes[0], &value), @"RemoveAll should remove everything.");
+    JAGClassTableReclaim(&table);
+    JAGClassTableInsert(&table, classes[0], 7);
+    STAssertTrue(JAGClassTableLookup(&table, classes[0], &value) && value == 7, @"The table should be usable again.");
+}
+
+- (void) testReclaimIfQuiescent {
+    uintptr_t value;
+    JAGClassTableInsert(&table, classes[0], 1);
+    JAGClassTableBeginRead(&table);
+    STAssertTrue(JAGClassTableLookup(&table, classes[0], &value), nil);
+    JAGClassTableRemoveAll(&table);
+    STAssertFalse(JAGClassTableReclaimIfQuiescent(&table), @"Storage a reader may hold shouldn't be freed.");
+    STAssertTrue(table.retired != NULL, @"The old storage should still be retired.");
+    STAssertTrue(JAGClassTableEndRead(&table), @"The last reader should be told so.");
+    STAssertTrue(JAGClassTableReclaimIfQuiescent(&table), @"With no readers, retired storage should be freed.");
+    STAssertTrue(table.retired == NULL, @"Nothing should be left retired.");
+}
+
+- (void) testConcurrentLookups {
+    __block int32_t failures = 0;
+    JAGClassTable *shared = &table;
+    Class *all = classes;
+    int count = classCount;
+    //Half the threads insert while the others look up; a lookup may miss, but never sees a wrong value.
+    dispatch_apply(8, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t thread) {
+        for (int i = 0; i < count; i++) {
+            if (thread % 2) {
+                JAGClassTableInsert(shared, all[i], i + 1);
+            } else {
+                uintptr_t value;
+                if (JAGClassTableLookup(shared, all[i], &value) && value != (uintptr_t)i + 1) {
+                    __sync_fetch_and_add(&failures, 1);
+                }
+            }
+        }
+    });
+    STAssertEquals(failures, (int32_t)0, @"Lookups should only see whole entries.");
+    for (int i = 0; i < count; i++) {
+        uintptr_t value;
+        STAssertTrue(JAGClassTableLookup(&table, all[i], &value) && value == (uintptr_t)i + 1,
+                     @"Every insert should land.");
+    }
+}
+
+@end
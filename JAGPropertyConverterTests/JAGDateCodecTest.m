@@ -0,0 +1,86 @@
+//
+//  JAGDateCodecTest.m
+//  JAGPropertyConverterTests
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGDateCodecTest.h"
+#import "TestModel.h"
+#import "JAGPropertyConverter.h"
+#import "JAGDateCodec.h"
+
+@implementation JAGDateCodecTest
+
+- (void) testISO8601 {
+    JAGDateCodec *codec = [JAGDateCodec codecWithFormat:kJAGDateFormatISO8601];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1348072200];
+    STAssertEqualObjects([codec valueFromDate:date], @"2012-09-19T16:30:00Z", @"Dates should be formatted in UTC.");
+    STAssertEqualObjects([codec dateFromValue:@"2012-09-19T16:30:00Z"], date, @"Formatted dates should parse back.");
+    STAssertEqualObjects([codec dateFromValue:@"2012-09-19T18:30:00+02:00"], date, @"Offsets should be applied.");
+    STAssertEqualObjects([codec dateFromValue:@"2012-09-19T11:00:00-0530"], date, @"Offsets needn't have colons.");
+    STAssertEqualObjects([codec dateFromValue:@"2012-09-19T16:30:00Z"], date, @"Cached dates should be the same.");
+    STAssertEqualObjects([codec dateFromValue:@"1970-01-01"], [NSDate dateWithTimeIntervalSince1970:0],
+                         @"A date without a time should be midnight UTC.");
+    STAssertNil([codec dateFromValue:@"1999-02-29T00:00:00Z"], @"Invalid days should be rejected.");
+    STAssertNil([codec dateFromValue:@"2012-09-19T16:30:00"], @"Times without a zone should be rejected.");
+    STAssertNil([codec dateFromValue:[NSNumber numberWithInt:0]], @"Numbers aren't ISO 8601.");
+}
+
+- (void) testISO8601FractionalSeconds {
+    JAGDateCodec *codec = [JAGDateCodec codecWithFormat:kJAGDateFormatISO8601FractionalSeconds];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:-0.5];
+    STAssertEqualObjects([codec valueFromDate:date], @"1969-12-31T23:59:59.500Z", @"Milliseconds should be formatted.");
+    STAssertEqualObjects([codec dateFromValue:@"1969-12-31T23:59:59.500Z"], date, @"Milliseconds should be parsed.");
+    STAssertEqualObjects([codec dateFromValue:@"1970-01-01T00:00:00Z"], [NSDate dateWithTimeIntervalSince1970:0],
+                         @"Fractional seconds should be optional.");
+}
+
+- (void) testEpoch {
+    JAGDateCodec *seconds = [JAGDateCodec codecWithFormat:kJAGDateFormatEpochSeconds];
+    JAGDateCodec *milliseconds = [JAGDateCodec codecWithFormat:kJAGDateFormatEpochMilliseconds];
+    NSDate *date = [NSDate dateWithTimeIntervalSince1970:1000000000.5];
+    STAssertEqualObjects([seconds valueFromDate:date], [NSNumber numberWithDouble:1000000000.5], @"Seconds may be fractional.");
+    STAssertEqualObjects([milliseconds valueFromDate:date], [NSNumber numberWithLongLong:1000000000500LL], @"Milliseconds are whole.");
+    STAssertEqualObjects([seconds dateFromValue:@"1000000000.5"], date, @"Numeric strings should be parsed.");
+    STAssertEqualObjects([milliseconds dateFromValue:[NSNumber numberWithLongLong:1000000000500LL]], date,
+                         @"Milliseconds should be parsed.");
+}
+
+- (void) testConverterUsesDateCodec {
+    TestModel *model = [TestModel testModel];
+    model.dateProperty = [NSDate dateWithTimeIntervalSince1970:1348072200];
+    JAGPropertyConverter *converter = [TestModel testConverter];
+    converter.outputType = kJAGJSONOutput;
+    converter.convertFromDate = nil;
+    converter.convertToDate = nil;
+    converter.dateCodec = [JAGDateCodec codecWithFormat:kJAGDateFormatISO8601];
+
+    NSDictionary *dict = [converter convertToDictionary:model];
+    STAssertEqualObjects([dict objectForKey:@"dateProperty"], @"2012-09-19T16:30:00Z", @"Dates should be decomposed by the codec.");
+    TestModel *composed = [converter composeModelFromObject:dict];
+    STAssertEqualObjects(composed.dateProperty, model.dateProperty, @"Dates should be composed by the codec.");
+
+    NSData *json = [converter JSONDataFromObject:model];
+    composed = [converter composeModelFromJSONData:json ofClass:[TestModel class] error:NULL];
+    STAssertEqualObjects(composed.dateProperty, model.dateProperty, @"Streamed JSON should use the codec too.");
+}
+
+@end
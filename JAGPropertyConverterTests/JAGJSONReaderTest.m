@@ -0,0 +1,263 @@
+//
+//  JAGJSONReaderTest.m
+//  JAGPropertyConverterTests
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGJSONReaderTest.h"
+#import "TestModel.h"
+#import "JAGPropertyConverter.h"
+#import "JAGJSONReader.h"
+#import "NumberFormatterTest.h"
+#include <locale.h>
+
+@interface JAGJSONReaderTest () {
+@private
+    TestModel *model;
+    JAGPropertyConverter *converter;
+}
+@end
+
+@implementation JAGJSONReaderTest
+
+- (void) setUp {
+    model = [TestModel testModel];
+    [model populate];
+    converter = [TestModel testConverter];
+    converter.outputType = kJAGJSONOutput;
+}
+
+- (NSData *) dataFromString: (NSString *) string {
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (void) testModelMatchesDictionaryPath {
+    NSData *data = [converter JSONDataFromObject:model];
+    NSDictionary *dictionary = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+    TestModel *expected = [TestModel testModel];
+    [converter setPropertiesOf:expected fromDictionary:dictionary];
+
+    NSError *error = nil;
+    TestModel *actual = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:&error];
+    STAssertNil(error, @"Decoding should not fail, but got %@", error);
+    STAssertEqualObjects([converter decomposeObject:actual], [converter decomposeObject:expected],
+                         @"Decoding JSON directly should match setPropertiesOf:fromDictionary:.");
+    STAssertEquals(actual.intProperty, 5, @"intProperty should be set.");
+    STAssertTrue(actual.boolProperty, @"boolProperty should be set.");
+    STAssertTrue([actual.modelProperty isKindOfClass:[TestModel class]], @"Nested models should be composed.");
+    STAssertEqualObjects(actual.modelProperty.testModelID, @"KOPES56", @"Nested models should be populated.");
+    STAssertTrue([actual.setProperty isKindOfClass:[NSSet class]], @"Arrays should become sets for set properties.");
+    STAssertEqualObjects(actual.urlProperty, model.urlProperty, @"Strings should become URLs for URL properties.");
+}
+
+- (void) testArrayOfModels {
+    NSData *data = [self dataFromString:@"[{\"intProperty\": 1}, {\"intProperty\": 2}]"];
+    NSArray *actual = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:NULL];
+    STAssertEquals([actual count], (NSUInteger)2, @"Each object should become a model.");
+    STAssertEquals([[actual objectAtIndex:1] intProperty], 2, @"Models should be populated in order.");
+}
+
+- (void) testWithoutTargetClassUsesIdentifyDict {
+    NSData *data = [self dataFromString:@"{\"a\": {\"testModelID\": \"ABC\"}, \"b\": [1, \"two\", null]}"];
+    NSDictionary *actual = [converter composeModelFromJSONData:data ofClass:nil error:NULL];
+    STAssertTrue([[actual objectForKey:@"a"] isKindOfClass:[TestModel class]], @"identifyDict should be used.");
+    NSArray *expected = [NSArray arrayWithObjects:[NSNumber numberWithInt:1], @"two", [NSNull null], nil];
+    STAssertEqualObjects([actual objectForKey:@"b"], expected, @"Arrays should be composed element by element.");
+}
+
+- (void) testConvertToDateAndNumberFormatter {
+    converter.convertToDate = ^ id (id value) {
+        return [NSDate dateWithTimeIntervalSince1970:[value doubleValue]];
+    };
+    converter.numberFormatter = [[NSNumberFormatter alloc] init];
+    NSData *data = [self dataFromString:@"{\"dateProperty\": 1000, \"intProperty\": \"42\"}"];
+    TestModel *actual = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:NULL];
+    STAssertEqualObjects(actual.dateProperty, [NSDate dateWithTimeIntervalSince1970:1000], @"Dates should go through convertToDate.");
+    STAssertEquals(actual.intProperty, 42, @"Numeric strings should go through numberFormatter.");
+}
+
+- (void) testUnknownKeysSkipped {
+    NSData *data = [self dataFromString:@"{\"unknown\": {\"deep\": [1, {\"x\": []}]}, \"readOnlyProperty\": \"no\", \"intProperty\": 7}"];
+    TestModel *actual = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:NULL];
+    STAssertEquals(actual.intProperty, 7, @"Properties after skipped values should be set.");
+}
+
+- (void) testMalformedJSON {
+    NSArray *documents = [NSArray arrayWithObjects:
+                          @"{\"intProperty\": 1",
+                          @"{\"intProperty\" 1}",
+                          @"{\"intProperty\": 01}",
+                          @"[1, 2,]",
+                          @"{} {}",
+                          @"\"\\ud800\"",
+                          nil];
+    for (NSString *document in documents) {
+        NSError *error = nil;
+        id actual = [converter composeModelFromJSONData:[self dataFromString:document] ofClass:nil error:&error];
+        STAssertNil(actual, @"%@ should not decode.", document);
+        STAssertEqualObjects([error domain], JAGJSONReaderErrorDomain, @"%@ should report a JSON error.", document);
+    }
+}
+
+- (void) testTokens {
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithData:
+                             [self dataFromString:@" {\"k\": [\"s\\n\\u00e9\\ud83d\\ude00\", -12, 1.5e2, 18446744073709551615, true, null]} "]];
+    STAssertEquals([reader nextToken], JAGJSONTokenBeginObject, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenKey, nil);
+    STAssertEqualObjects([reader stringValue], @"k", nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenBeginArray, nil);
+    STAssertEquals([reader depth], (NSUInteger)2, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenString, nil);
+    STAssertEqualObjects([reader stringValue], @"s\n\u00e9\U0001F600", @"Escapes should be decoded.");
+    STAssertEquals([reader nextToken], JAGJSONTokenNumber, nil);
+    STAssertTrue([reader numberIsInteger], nil);
+    STAssertEquals([reader longLongValue], -12LL, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenNumber, nil);
+    STAssertFalse([reader numberIsInteger], nil);
+    STAssertEquals([reader doubleValue], 150.0, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenNumber, nil);
+    STAssertEqualObjects([reader numberValue], [NSNumber numberWithUnsignedLongLong:ULLONG_MAX], nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenTrue, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenNull, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenEndArray, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenEndObject, nil);
+    STAssertEquals([reader nextToken], JAGJSONTokenEnd, nil);
+}
+
+- (void) testNumbersOutOfRange {
+    NSData *data = [self dataFromString:@"{\"floatProperty\": 18446744073709551615, \"intProperty\": 1e300}"];
+    NumberTestModel *numbers = [converter composeModelFromJSONData:data ofClass:[NumberTestModel class] error:NULL];
+    STAssertEqualsWithAccuracy(numbers.floatProperty, 18446744073709551615.0f, 1e12, @"Unsigned integers should stay positive.");
+    STAssertEquals(numbers.intProperty, 0, @"A number too large for the property should leave it unset.");
+    STAssertEquals([converter diagnosticCountForCode:kJAGDiagnosticUnsettableProperty], (NSUInteger)1, nil);
+}
+
+- (void) testNumbersIgnoreLocale {
+    char *previous = strdup(setlocale(LC_NUMERIC, NULL));
+    if (!setlocale(LC_NUMERIC, "de_DE.UTF-8") && !setlocale(LC_NUMERIC, "de_DE")) {
+        free(previous);
+        return;
+    }
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithData:[self dataFromString:@"3.5000000000000000000001"]];
+    [reader nextToken];
+    double value = [reader doubleValue];
+    setlocale(LC_NUMERIC, previous);
+    free(previous);
+    STAssertEquals(value, 3.5, @"A comma-decimal locale shouldn't change how numbers are read.");
+}
+
+- (void) testStreamMatchesData {
+    NSMutableArray *models = [NSMutableArray array];
+    for (int i = 0; i < 100; i++) {
+        [models addObject:model];
+    }
+    NSData *data = [converter JSONDataFromObject:models];
+    NSArray *expected = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:NULL];
+
+    NSInputStream *stream = [NSInputStream inputStreamWithData:data];
+    [stream open];
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithInputStream:stream bufferSize:7];
+    NSArray *actual = [converter composeModelFromJSONReader:reader ofClass:[TestModel class]];
+    [stream close];
+    STAssertNil(reader.error, @"Reading the stream should not fail, but got %@", reader.error);
+    STAssertEqualObjects([converter decomposeObject:actual], [converter decomposeObject:expected],
+                         @"Small buffers should decode the same as in-memory data.");
+    STAssertEquals([reader offset], [data length], @"The whole stream should be read.");
+}
+
+- (NSString *) writeTemporaryFile: (NSData *) data {
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+    [data writeToFile:path atomically:NO];
+    return path;
+}
+
+- (void) testMappedFileMatchesData {
+    NSMutableArray *models = [NSMutableArray array];
+    for (int i = 0; i < 100; i++) {
+        [models addObject:model];
+    }
+    NSData *data = [converter JSONDataFromObject:models];
+    NSArray *expected = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:NULL];
+    NSString *path = [self writeTemporaryFile:data];
+
+    NSMutableArray *actual = [NSMutableArray array];
+    NSError *error = nil;
+    BOOL succeeded = [converter enumerateModelsInJSONFile:path ofClass:[TestModel class] withBlock:^(id each, BOOL *stop) {
+        [actual addObject:each];
+    } error:&error];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    STAssertTrue(succeeded, @"Enumerating should not fail, but got %@", error);
+    STAssertEqualObjects([converter decomposeObject:actual], [converter decomposeObject:expected],
+                         @"Each element should decode the same as in-memory data.");
+}
+
+- (void) testMappedFileStopsEarly {
+    NSString *path = [self writeTemporaryFile:[self dataFromString:@"[{\"intProperty\": 1}, 7, {\"intProperty\": 2}, {\"intProperty\": 3}, oops]"]];
+    __block NSUInteger count = 0;
+    BOOL succeeded = [converter enumerateModelsInJSONFile:path ofClass:[TestModel class] withBlock:^(id each, BOOL *stop) {
+        count++;
+        if ([each isKindOfClass:[TestModel class]] && [each intProperty] == 2) *stop = YES;
+    } error:NULL];
+    STAssertTrue(succeeded, @"Stopping early should skip the rest of the file.");
+    STAssertEquals(count, (NSUInteger)3, @"No elements should be composed after stopping.");
+
+    NSError *error = nil;
+    succeeded = [converter enumerateModelsInJSONFile:path ofClass:[TestModel class] withBlock:^(id each, BOOL *stop) {
+    } error:&error];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+    STAssertFalse(succeeded, @"Malformed elements should be reported.");
+    STAssertEqualObjects([error domain], JAGJSONReaderErrorDomain, @"The error should come from the reader.");
+}
+
+- (void) testMappedFileErrors {
+    NSError *error = nil;
+    NSString *missing = [NSTemporaryDirectory() stringByAppendingPathComponent:@"JAGJSONReaderTest-missing.json"];
+    STAssertFalse([converter enumerateModelsInJSONFile:missing ofClass:nil withBlock:^(id each, BOOL *stop) {} error:&error],
+                  @"A missing file can't be read.");
+    STAssertEqualObjects([error domain], NSPOSIXErrorDomain, @"A missing file should be an errno error.");
+
+    NSString *path = [self writeTemporaryFile:[self dataFromString:@"{\"intProperty\": 1}"]];
+    error = nil;
+    STAssertFalse([converter enumerateModelsInJSONFile:path ofClass:[TestModel class] withBlock:^(id each, BOOL *stop) {} error:&error],
+                  @"Only arrays can be enumerated.");
+    STAssertEquals([error code], (NSInteger)JAGJSONReaderErrorSyntax, @"A non-array should be a syntax error.");
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+
+    path = [self writeTemporaryFile:[NSData data]];
+    error = nil;
+    STAssertFalse([converter enumerateModelsInJSONFile:path ofClass:[TestModel class] withBlock:^(id each, BOOL *stop) {} error:&error],
+                  @"An empty file isn't JSON.");
+    STAssertEquals([error code], (NSInteger)JAGJSONReaderErrorUnexpectedEnd, @"An empty file should end unexpectedly.");
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+- (void) testUnescapedStringsAreReadInPlace {
+    NSData *data = [self dataFromString:@"[\"plain\", \"esc\\\"aped\"]"];
+    JAGJSONReader *reader = [[JAGJSONReader alloc] initWithData:data];
+    [reader nextToken];
+    STAssertEquals([reader nextToken], JAGJSONTokenString, @"Expected a string.");
+    STAssertTrue([reader stringBytes] == (const char *)[data bytes] + 2, @"A plain string should point into the input.");
+    STAssertEqualObjects([reader stringValue], @"plain", @"A plain string should decode as itself.");
+    STAssertEquals([reader nextToken], JAGJSONTokenString, @"Expected a string.");
+    STAssertEqualObjects([reader stringValue], @"esc\"aped", @"Escapes should still be decoded.");
+}
+
+@end
@@ -0,0 +1,191 @@
+//
+//  JAGJSONWriterTest.m
+//  JAGPropertyConverterTests
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGJSONWriterTest.h"
+#import "TestModel.h"
+#import "JAGPropertyConverter.h"
+#import "JAGJSONWriter.h"
+#import "NumberFormatterTest.h"
+#include <locale.h>
+
+@interface JAGJSONWriterTest () {
+@private
+    TestModel *model;
+    JAGPropertyConverter *converter;
+}
+@end
+
+@implementation JAGJSONWriterTest
+
+- (void) setUp {
+    model = [TestModel testModel];
+    [model populate];
+    converter = [TestModel testConverter];
+    converter.outputType = kJAGJSONOutput;
+}
+
+- (id) parse: (NSData *) data {
+    STAssertNotNil(data, @"JSON data should not be nil.");
+    NSError *error = nil;
+    id object = [NSJSONSerialization JSONObjectWithData:data options:0 error:&error];
+    STAssertNil(error, @"JSON should parse, but got %@", error);
+    return object;
+}
+
+- (void) testModelMatchesDecompose {
+    NSDictionary *expected = [converter decomposeObject:model];
+    NSDictionary *actual = [self parse:[converter JSONDataFromObject:model]];
+    STAssertEqualObjects(actual, expected, @"Writing JSON directly should match decomposeObject:.");
+}
+
+- (void) testIgnoresOutputType {
+    converter.outputType = kJAGFullOutput;
+    NSDictionary *actual = [self parse:[converter JSONDataFromObject:model]];
+    STAssertNil([actual valueForKey:@"dateProperty"], @"JSON should not have a date value.");
+    STAssertNil([actual valueForKey:@"cfProperty"], @"JSON should not have a CF value.");
+    STAssertEqualObjects([actual valueForKey:@"urlProperty"], [model.urlProperty absoluteString], @"URLs should be written as strings.");
+}
+
+- (void) testSetBecomesArray {
+    NSDictionary *actual = [self parse:[converter JSONDataFromObject:model]];
+    id setValue = [actual valueForKey:@"setProperty"];
+    STAssertTrue([setValue isKindOfClass:[NSArray class]], @"setProperty should be written as an array.");
+    STAssertEqualObjects([NSSet setWithArray:setValue], model.setProperty, @"setProperty should have the same objects.");
+}
+
+- (void) testNonFiniteNumbersDropped {
+    NSArray *array = [NSArray arrayWithObjects:
+                      [NSNumber numberWithDouble:1.5],
+                      [NSNumber numberWithDouble:NAN],
+                      [NSNumber numberWithDouble:INFINITY],
+                      nil];
+    NSArray *actual = [self parse:[converter JSONDataFromObject:array]];
+    STAssertEqualObjects(actual, [NSArray arrayWithObject:[NSNumber numberWithDouble:1.5]],
+                         @"NaN and infinity should be dropped.");
+}
+
+- (void) testConvertFromDate {
+    converter.convertFromDate = ^ id (id date) {
+        return [NSNumber numberWithDouble:[date timeIntervalSince1970]];
+    };
+    NSDictionary *actual = [self parse:[converter JSONDataFromObject:model]];
+    STAssertEqualsWithAccuracy([[actual valueForKey:@"dateProperty"] doubleValue],
+                               [model.dateProperty timeIntervalSince1970], 0.001,
+                               @"Dates should go through convertFromDate.");
+}
+
+- (void) testWeakProperty {
+    model.weakProperty = [TestModel testModel];
+    NSDictionary *actual = [self parse:[converter JSONDataFromObject:model]];
+    STAssertNil([actual valueForKey:@"weakProperty"], @"By default, weak properties should not be written.");
+    converter.shouldConvertWeakProperties = YES;
+    actual = [self parse:[converter JSONDataFromObject:model]];
+    STAssertNotNil([actual valueForKey:@"weakProperty"], @"Weak properties should be written when asked.");
+}
+
+- (void) testStringEscaping {
+    NSString *string = @"quote \" backslash \\ newline \n tab \t bell \a snowman ☃";
+    NSArray *actual = [self parse:[converter JSONDataFromObject:[NSArray arrayWithObject:string]]];
+    STAssertEqualObjects([actual objectAtIndex:0], string, @"Strings should survive escaping.");
+}
+
+- (void) testDoublesRoundTrip {
+    NSArray *numbers = [NSArray arrayWithObjects:
+                        [NSNumber numberWithDouble:0.1],
+                        [NSNumber numberWithDouble:1.0/3.0],
+                        [NSNumber numberWithDouble:1e300],
+                        [NSNumber numberWithLongLong:LLONG_MIN],
+                        [NSNumber numberWithUnsignedLongLong:ULLONG_MAX],
+                        nil];
+    NSArray *actual = [self parse:[converter JSONDataFromObject:numbers]];
+    STAssertEqualObjects(actual, numbers, @"Numbers should be written exactly.");
+}
+
+- (void) testFloatsAreNotWidened {
+    NumberTestModel *numbers = [[NumberTestModel alloc] init];
+    numbers.floatProperty = 1.1f;
+    NSString *json = [[NSString alloc] initWithData:[converter JSONDataFromObject:numbers] encoding:NSUTF8StringEncoding];
+    STAssertTrue([json rangeOfString:@"\"floatProperty\":1.1,"].location != NSNotFound
+                 || [json rangeOfString:@"\"floatProperty\":1.1}"].location != NSNotFound,
+                 @"A float property should be written as the float, not the widened double: %@", json);
+    NSData *data = [converter JSONDataFromObject:[NSArray arrayWithObject:[NSNumber numberWithFloat:16777217.0f]]];
+    STAssertEqualObjects([[self parse:data] objectAtIndex:0], [NSNumber numberWithFloat:16777217.0f],
+                         @"Floats that need more digits should still read back exactly.");
+}
+
+- (void) testDoublesIgnoreLocale {
+    char *previous = strdup(setlocale(LC_NUMERIC, NULL));
+    if (!setlocale(LC_NUMERIC, "de_DE.UTF-8") && !setlocale(LC_NUMERIC, "de_DE")) {
+        free(previous);
+        return;
+    }
+    NSData *data = [converter JSONDataFromObject:[NSArray arrayWithObject:[NSNumber numberWithDouble:3.5]]];
+    setlocale(LC_NUMERIC, previous);
+    free(previous);
+    NSString *json = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    STAssertEqualObjects(json, @"[3.5]", @"A comma-decimal locale shouldn't change how numbers are written.");
+}
+
+- (void) testWriterSkipsUnusedKeys {
+    JAGJSONWriter *writer = [[JAGJSONWriter alloc] init];
+    [writer beginObject];
+    [writer writeKey:@"name"];
+    [writer writeString:@"Jane"];
+    [writer writeKey:@"skipped"];
+    [writer writeKey:@"userID"];
+    [writer writeLongLong:1234];
+    [writer writeKey:@"skippedAtEnd"];
+    [writer endObject];
+    NSString *json = [[NSString alloc] initWithData:[writer takeData] encoding:NSUTF8StringEncoding];
+    STAssertEqualObjects(json, @"{\"name\":\"Jane\",\"userID\":1234}", @"Keys without values should not be written.");
+}
+
+- (void) testStreamMatchesData {
+    NSMutableArray *models = [NSMutableArray array];
+    for (int i = 0; i < 100; i++) {
+        [models addObject:model];
+    }
+    NSData *expected = [converter JSONDataFromObject:models];
+
+    NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+    [stream open];
+    JAGJSONWriter *writer = [[JAGJSONWriter alloc] initWithOutputStream:stream chunkSize:256];
+    STAssertTrue([converter writeJSONFromObject:models toWriter:writer], @"Models should be written.");
+    STAssertTrue([writer flush], @"Flushing should succeed.");
+    NSData *actual = [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    [stream close];
+    STAssertEqualObjects(actual, expected, @"Chunked stream output should match the buffered output.");
+    STAssertEquals([writer bytesWritten], [expected length], @"bytesWritten should count flushed bytes.");
+}
+
+- (void) testStreamErrorForUnencodableObject {
+    NSOutputStream *stream = [NSOutputStream outputStreamToMemory];
+    [stream open];
+    NSError *error = nil;
+    STAssertFalse([converter writeJSONFromObject:[NSData data] toStream:stream error:&error], @"NSData can't be written as JSON.");
+    [stream close];
+    STAssertEqualObjects([error domain], JAGJSONWriterErrorDomain, @"The failure should be reported, but got %@", error);
+}
+
+@end
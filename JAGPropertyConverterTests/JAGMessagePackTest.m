@@ -0,0 +1,240 @@
+//
+//  JAGMessagePackTest.m
+//  JAGPropertyConverterTests
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGMessagePackTest.h"
+#import "TestModel.h"
+#import "NumberFormatterTest.h"
+#import "JAGPropertyConverter.h"
+#import "JAGMessagePackWriter.h"
+#import "JAGMessagePackReader.h"
+
+@interface JAGMessagePackTest () {
+@private
+    TestModel *model;
+    JAGPropertyConverter *converter;
+}
+@end
+
+@implementation JAGMessagePackTest
+
+- (void) setUp {
+    model = [TestModel testModel];
+    [model populate];
+    converter = [TestModel testConverter];
+    converter.outputType = kJAGMessagePackOutput;
+}
+
+- (id) roundTrip: (id) object {
+    JAGMessagePackWriter *writer = [[JAGMessagePackWriter alloc] init];
+    STAssertTrue([converter writeMessagePackFromObject:object toWriter:writer], @"%@ should be written.", object);
+    JAGMessagePackReader *reader = [[JAGMessagePackReader alloc] initWithData:[writer takeData]];
+    id result = [reader readEntireObject];
+    STAssertNil(reader.error, @"Reading should not fail, but got %@", reader.error);
+    return result;
+}
+
+- (void) testModelRoundTrip {
+    NSData *data = [converter messagePackDataFromObject:model];
+    STAssertNotNil(data, @"Model should be encoded.");
+    NSError *error = nil;
+    TestModel *actual = [converter composeModelFromMessagePackData:data ofClass:[TestModel class] error:&error];
+    STAssertNil(error, @"Decoding should not fail, but got %@", error);
+    STAssertEqualObjects(actual.testModelID, model.testModelID, @"Strings should round-trip.");
+    STAssertEquals(actual.intProperty, model.intProperty, @"Integers should round-trip.");
+    STAssertTrue(actual.boolProperty, @"Booleans should round-trip.");
+    STAssertEqualObjects(actual.arrayProperty, model.arrayProperty, @"Arrays should round-trip.");
+    STAssertEqualObjects(actual.setProperty, model.setProperty, @"Sets should round-trip through arrays.");
+    STAssertEqualObjects(actual.dictionaryProperty, model.dictionaryProperty, @"Dictionaries should round-trip.");
+    STAssertEqualObjects(actual.urlProperty, model.urlProperty, @"URLs should round-trip through strings.");
+    STAssertEqualObjects(actual.modelProperty.testModelID, @"KOPES56", @"Nested models should round-trip.");
+    STAssertTrue([actual.dateProperty isKindOfClass:[NSDate class]], @"Dates should be kept without convertToDate.");
+    STAssertEqualsWithAccuracy([actual.dateProperty timeIntervalSinceDate:model.dateProperty], 0.0, 1e-6,
+                               @"Dates should round-trip to the microsecond.");
+}
+
+- (void) testArrayOfModels {
+    TestModel *other = [TestModel testModel];
+    other.intProperty = 2;
+    NSData *data = [converter messagePackDataFromObject:[NSArray arrayWithObjects:model, other, nil]];
+    NSArray *actual = [converter composeModelFromMessagePackData:data ofClass:[TestModel class] error:NULL];
+    STAssertEquals([actual count], (NSUInteger)2, @"Each map should become a model.");
+    STAssertEquals([[actual objectAtIndex:1] intProperty], 2, @"Models should be populated in order.");
+}
+
+- (void) testValuesJSONDrops {
+    NSData *bytes = [NSData dataWithBytes:"\x00\xff\x10" length:3];
+    NSArray *values = [NSArray arrayWithObjects:bytes,
+                       [NSNumber numberWithDouble:NAN],
+                       [NSNumber numberWithDouble:INFINITY],
+                       [NSNumber numberWithDouble:-INFINITY],
+                       nil];
+    NSArray *actual = [self roundTrip:values];
+    STAssertEquals([actual count], (NSUInteger)4, @"No value should be dropped.");
+    STAssertEqualObjects([actual objectAtIndex:0], bytes, @"NSData should be kept as binary.");
+    STAssertTrue(isnan([[actual objectAtIndex:1] doubleValue]), @"NaN should be kept.");
+    STAssertEquals([[actual objectAtIndex:2] doubleValue], (double)INFINITY, @"Infinity should be kept.");
+    STAssertEquals([[actual objectAtIndex:3] doubleValue], (double)-INFINITY, @"-Infinity should be kept.");
+}
+
+- (void) testIntegers {
+    NSArray *values = [NSArray arrayWithObjects:
+                       [NSNumber numberWithInt:0],
+                       [NSNumber numberWithInt:-32],
+                       [NSNumber numberWithInt:-33],
+                       [NSNumber numberWithInt:300],
+                       [NSNumber numberWithLongLong:LLONG_MIN],
+                       [NSNumber numberWithUnsignedLongLong:ULLONG_MAX],
+                       nil];
+    NSArray *actual = [self roundTrip:values];
+    STAssertEqualObjects(actual, values, @"Integers should round-trip at every width.");
+    STAssertEquals([[actual lastObject] unsignedLongLongValue], ULLONG_MAX, @"Unsigned integers should keep their bits.");
+}
+
+- (void) testDates {
+    NSArray *dates = [NSArray arrayWithObjects:
+                      [NSDate dateWithTimeIntervalSince1970:0],
+                      [NSDate dateWithTimeIntervalSince1970:1.5],
+                      [NSDate dateWithTimeIntervalSince1970:-1.25],
+                      [NSDate dateWithTimeIntervalSince1970:2e10],
+                      nil];
+    NSArray *actual = [self roundTrip:dates];
+    for (NSUInteger i = 0; i < [dates count]; i++) {
+        STAssertEqualsWithAccuracy([[actual objectAtIndex:i] timeIntervalSinceDate:[dates objectAtIndex:i]], 0.0, 1e-6,
+                                   @"Dates should round-trip in each timestamp format.");
+    }
+}
+
+- (void) testCompactHeaders {
+    JAGMessagePackWriter *writer = [[JAGMessagePackWriter alloc] init];
+    [writer beginMap];
+    [writer writeKey:@"a"];
+    [writer writeLongLong:1];
+    [writer writeKey:@"skipped"];
+    [writer writeKey:@"b"];
+    [writer beginArray];
+    [writer writeNil];
+    [writer endArray];
+    [writer endMap];
+    NSData *expected = [NSData dataWithBytes:"\x82\xa1" "a" "\x01\xa1" "b" "\x91\xc0" length:8];
+    STAssertEqualObjects([writer takeData], expected, @"Small maps, arrays and strings should use fix headers.");
+}
+
+- (void) testLargeContainers {
+    NSMutableArray *values = [NSMutableArray array];
+    for (int i = 0; i < 70000; i++) {
+        [values addObject:[NSNumber numberWithInt:i]];
+    }
+    STAssertEqualObjects([self roundTrip:values], values, @"Large arrays should round-trip.");
+    NSString *string = [@"" stringByPaddingToLength:70000 withString:@"é" startingAtIndex:0];
+    STAssertEqualObjects([self roundTrip:string], string, @"Long strings should round-trip.");
+}
+
+- (void) testMalformedInput {
+    NSData *data = [converter messagePackDataFromObject:model];
+    NSError *error = nil;
+    id actual = [converter composeModelFromMessagePackData:[data subdataWithRange:NSMakeRange(0, [data length] - 1)]
+                                                   ofClass:[TestModel class]
+                                                     error:&error];
+    STAssertNil(actual, @"Truncated input should not be composed.");
+    STAssertEqualObjects([error domain], JAGMessagePackReaderErrorDomain, @"The reader's error should be returned.");
+    STAssertEquals([error code], (NSInteger)JAGMessagePackReaderErrorUnexpectedEnd, @"Truncation should be reported.");
+}
+
+#pragma mark - Compact Models
+
+- (NSArray *) testModels: (NSUInteger) count ofClass: (Class) modelClass {
+    NSMutableArray *models = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        TestModel *each = [[modelClass alloc] init];
+        [each populate];
+        each.intProperty = -(int)i;
+        //Exactly representable, so that decomposed models compare equal.
+        each.dateProperty = [NSDate dateWithTimeIntervalSince1970:1000000000.5];
+        [models addObject:each];
+    }
+    return models;
+}
+
+- (void) testCompactRoundTrip {
+    NSArray *models = [self testModels:100 ofClass:[TestModel class]];
+    NSData *data = [converter compactDataFromModels:models ofClass:[TestModel class]];
+    NSError *error = nil;
+    NSArray *actual = [converter composeModelsFromCompactData:data ofClass:[TestModel class] error:&error];
+    STAssertNil(error, @"Decoding should not fail, but got %@", error);
+    STAssertEquals([actual count], [models count], @"Every model should be decoded.");
+    TestModel *last = [actual lastObject];
+    STAssertEquals(last.intProperty, -99, @"Signed integers should round-trip.");
+    STAssertTrue(last.boolProperty, @"Booleans should round-trip.");
+    STAssertNil(last.idProperty, @"nil properties should stay nil.");
+    STAssertEqualObjects([converter decomposeObject:last], [converter decomposeObject:[models lastObject]],
+                         @"Compact records should match the models.");
+    STAssertTrue([data length] < [[converter messagePackDataFromObject:models] length],
+                 @"Compact data should be smaller than keyed MessagePack.");
+}
+
+- (void) testCompactSchemaChanges {
+    NSArray *subclassModels = [self testModels:2 ofClass:[TestModelSubclass class]];
+    NSData *data = [converter compactDataFromModels:subclassModels ofClass:[TestModelSubclass class]];
+    NSArray *actual = [converter composeModelsFromCompactData:data ofClass:[TestModel class] error:NULL];
+    STAssertEquals([actual count], (NSUInteger)2, @"Removed properties should be skipped.");
+    STAssertEquals([[actual objectAtIndex:1] intProperty], -1, @"Remaining properties should be set.");
+
+    data = [converter compactDataFromModels:[self testModels:2 ofClass:[TestModel class]] ofClass:[TestModel class]];
+    TestModelSubclass *added = [[converter composeModelsFromCompactData:data ofClass:[TestModelSubclass class] error:NULL] lastObject];
+    STAssertNil(added.subclassStringProperty, @"Added properties should be left unset.");
+    STAssertEqualObjects(added.stringProperty, @"Hello Kitty!", @"Existing properties should be set.");
+}
+
+- (void) testCompactMalformedInput {
+    NSError *error = nil;
+    NSData *messagePack = [converter messagePackDataFromObject:model];
+    STAssertNil([converter composeModelsFromCompactData:messagePack ofClass:[TestModel class] error:&error],
+                @"Other data should not be decoded.");
+    STAssertEquals([error code], (NSInteger)JAGMessagePackReaderErrorInvalidHeader, @"A bad header should be reported.");
+
+    NSData *data = [converter compactDataFromModels:[self testModels:3 ofClass:[TestModel class]] ofClass:[TestModel class]];
+    STAssertNil([converter composeModelsFromCompactData:[data subdataWithRange:NSMakeRange(0, [data length] - 1)]
+                                                ofClass:[TestModel class]
+                                                  error:&error],
+                @"Truncated data should not be decoded.");
+}
+
+- (void) testCompactColumnTypeChanges {
+    //A record written when floatProperty was unsigned long long and intProperty was double.
+    const uint8_t bytes[] = {
+        'J', 'A', 'G', 'S', 1,
+        2, 13, 'f', 'l', 'o', 'a', 't', 'P', 'r', 'o', 'p', 'e', 'r', 't', 'y', 'u',
+        11, 'i', 'n', 't', 'P', 'r', 'o', 'p', 'e', 'r', 't', 'y', 'd',
+        1,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x9c, 0x75, 0x00, 0x88, 0x3c, 0xe4, 0x37, 0x7e     //1e300
+    };
+    NSData *data = [NSData dataWithBytes:bytes length:sizeof(bytes)];
+    NumberTestModel *numbers = [[converter composeModelsFromCompactData:data ofClass:[NumberTestModel class] error:NULL] lastObject];
+    STAssertEqualsWithAccuracy(numbers.floatProperty, 18446744073709551615.0f, 1e12, @"Unsigned columns should stay positive.");
+    STAssertEquals(numbers.intProperty, 0, @"A number too large for the property should leave it unset.");
+    STAssertEquals([converter diagnosticCountForCode:kJAGDiagnosticUnsettableProperty], (NSUInteger)1, nil);
+}
+
+@end
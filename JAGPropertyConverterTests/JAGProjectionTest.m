@@ -0,0 +1,140 @@
+//
+//  JAGProjectionTest.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGProjectionTest.h"
+#import "JAGProjection.h"
+#import "JAGPropertyConverter.h"
+#import "TestModel.h"
+
+static int gSecretReads = 0;
+
+//A model that counts calls to one of its getters.
+@interface JAGProjectionCountingModel : NSObject
+@property (copy) NSString *name;
+@property (copy) NSString *secret;
+@end
+
+@implementation JAGProjectionCountingModel
+@synthesize name = _name;
+@synthesize secret = _secret;
+
+- (NSString *) secret {
+    gSecretReads++;
+    return _secret;
+}
+
+@end
+
+@interface JAGProjectionTest () {
+@private
+    TestModel *model;
+    JAGPropertyConverter *converter;
+}
+@end
+
+@implementation JAGProjectionTest
+
+- (void) setUp {
+    model = [TestModel testModel];
+    [model populate];
+    converter = [TestModel testConverter];
+}
+
+- (JAGProjection *) projectionWithKeyPaths: (NSString *) keyPaths {
+    return [JAGProjection projectionWithKeyPaths:[keyPaths componentsSeparatedByString:@" "]];
+}
+
+- (void) testCompile {
+    JAGProjection *projection = [self projectionWithKeyPaths:@"name invitedBy.userID invitedBy friends.*.name *.id"];
+    STAssertEquals(projection, [self projectionWithKeyPaths:@"*.id friends.*.name invitedBy.userID invitedBy name"],
+                   @"The same key paths should share a compiled projection.");
+    STAssertTrue([[projection projectionForKey:@"name"] isFull], @"A path should select everything at its end.");
+    STAssertTrue([[projection projectionForKey:@"invitedBy"] isFull], @"A shorter path should win over a longer one.");
+    STAssertNotNil([[projection projectionForKey:@"name"] projectionForKey:@"anything"], @"Everything is selected below a full projection.");
+
+    JAGProjection *friends = [projection projectionForKey:@"friends"];
+    STAssertFalse([friends isFull], @"friends is only partly selected.");
+    STAssertNotNil([friends projectionForKey:@"id"], @"The top-level wildcard should be merged into friends.");
+    STAssertTrue([[[friends elementProjection] projectionForKey:@"name"] isFull], @"* should stand for elements.");
+    STAssertNil([[friends elementProjection] projectionForKey:@"age"], @"Unselected keys should be nil.");
+
+    JAGProjection *other = [projection projectionForKey:@"other"];
+    STAssertNotNil([other projectionForKey:@"id"], @"* should match any other key.");
+    STAssertNil([other projectionForKey:@"name"], @"Only the wildcard's selection applies to other keys.");
+    STAssertEquals([other elementProjection], other, @"Without *, elements are selected like their collection.");
+}
+
+- (void) testConvertToDictionary {
+    JAGProjection *projection = [self projectionWithKeyPaths:@"intProperty modelProperty.testModelID dictionaryProperty.one"];
+    NSDictionary *values = [converter convertToDictionary:model projection:projection];
+    STAssertEquals([values count], (NSUInteger)3, @"Only the selected properties should be converted, but got %@", values);
+    STAssertEqualObjects([values objectForKey:@"intProperty"], [NSNumber numberWithInt:5], @"Selected values should be converted.");
+    STAssertEqualObjects([values objectForKey:@"modelProperty"], [NSDictionary dictionaryWithObject:@"KOPES56" forKey:@"testModelID"],
+                         @"Nested models should be projected.");
+    STAssertEqualObjects([values objectForKey:@"dictionaryProperty"], [NSDictionary dictionaryWithObject:[NSNumber numberWithInt:1] forKey:@"one"],
+                         @"Dictionaries should be projected.");
+
+    STAssertEqualObjects([converter convertToDictionary:model projection:nil], [converter convertToDictionary:model],
+                         @"A nil projection should convert everything.");
+}
+
+- (void) testUnselectedGettersAreNotCalled {
+    JAGProjectionCountingModel *counting = [[JAGProjectionCountingModel alloc] init];
+    counting.name = @"Ann";
+    counting.secret = @"hunter2";
+    gSecretReads = 0;
+    NSDictionary *values = [converter convertToDictionary:counting projection:[self projectionWithKeyPaths:@"name"]];
+    STAssertEqualObjects(values, [NSDictionary dictionaryWithObject:@"Ann" forKey:@"name"], @"Only name should be converted.");
+    STAssertEquals(gSecretReads, 0, @"The getters of unselected properties shouldn't be called.");
+}
+
+- (void) testCollectionElements {
+    TestModel *first = [TestModel testModel];
+    [first populate];
+    model.arrayProperty = [NSArray arrayWithObjects:first, first.modelProperty, nil];
+    NSDictionary *values = [converter convertToDictionary:model projection:[self projectionWithKeyPaths:@"arrayProperty.*.testModelID"]];
+    NSArray *expected = [NSArray arrayWithObjects:
+                         [NSDictionary dictionaryWithObject:@"XYZZ1" forKey:@"testModelID"],
+                         [NSDictionary dictionaryWithObject:@"KOPES56" forKey:@"testModelID"], nil];
+    STAssertEqualObjects([values objectForKey:@"arrayProperty"], expected, @"Each element should be projected.");
+}
+
+- (void) testSetPropertiesFromDictionary {
+    NSDictionary *nested = [NSDictionary dictionaryWithObjectsAndKeys:
+                            @"KOPES56", @"testModelID",
+                            [NSNumber numberWithInt:7], @"intProperty", nil];
+    NSDictionary *dictionary = [NSDictionary dictionaryWithObjectsAndKeys:
+                                [NSNumber numberWithInt:3], @"intProperty",
+                                @"Unselected", @"stringProperty",
+                                nested, @"modelProperty", nil];
+    TestModel *composed = [TestModel testModel];
+    [converter setPropertiesOf:composed fromDictionary:dictionary
+                    projection:[self projectionWithKeyPaths:@"intProperty modelProperty.intProperty"]];
+    STAssertEquals(composed.intProperty, 3, @"Selected properties should be set.");
+    STAssertNil(composed.stringProperty, @"Unselected keys should be ignored.");
+    STAssertEquals(composed.modelProperty.intProperty, 7, @"Selected nested properties should be set.");
+    STAssertNil(composed.modelProperty.testModelID, @"Unselected nested keys should be ignored.");
+}
+
+@end
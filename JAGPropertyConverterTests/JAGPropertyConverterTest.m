@@ -26,6 +26,10 @@
 #import "JAGPropertyConverterTest.h"
 #import "TestModel.h"
 #import "JAGPropertyConverter.h"
+#import "JAGLazyHydrator.h"
+#import "JAGModelPool.h"
+#import "JAGGeneratedCodec.h"
+#import <objc/runtime.h>
 
 @interface JAGPropertyConverterTest () {
 @private
@@ -35,6 +39,63 @@
 
 @end
 
+//Counts its live instances, to see how many temporaries a conversion keeps alive.
+static NSInteger gLiveTemporaries = 0;
+
+@interface JAGTemporary : NSObject
+@end
+
+@implementation JAGTemporary
+
+- (id) init {
+    self = [super init];
+    if (self) gLiveTemporaries++;
+    return self;
+}
+
+- (void) dealloc {
+    gLiveTemporaries--;
+}
+
+@end
+
+//A model whose getter returns a new autoreleased JAGTemporary on each call.
+@interface JAGTemporaryModel : NSObject
+@property (nonatomic, readonly) id temporary;
+@end
+
+@implementation JAGTemporaryModel
+
+- (id) temporary {
+    JAGTemporary * __autoreleasing temporary = [[JAGTemporary alloc] init];
+    return temporary;
+}
+
+@end
+
+//A model whose registered codec was generated before it gained a property.
+@interface JAGStaleCodecModel : NSObject
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, copy) NSString *addedProperty;
+@end
+
+@implementation JAGStaleCodecModel
+@synthesize name = _name;
+@synthesize addedProperty = _addedProperty;
+@end
+
+static const JAGGeneratedProperty gStaleCodecProperties[] = { { "name", 0 } };
+static const JAGGeneratedCodec gStaleCodec = { "JAGStaleCodecModel", gStaleCodecProperties, 1, NULL, NULL };
+
+//A converter subclass with configuration of its own.
+@interface JAGPrefixingConverter : JAGPropertyConverter
+@property (nonatomic, copy) NSString *prefix;
+@end
+
+@implementation JAGPrefixingConverter
+@synthesize prefix = _prefix;
+@end
+
 @implementation JAGPropertyConverterTest
 
 - (void) setUp {
@@ -178,6 +239,27 @@
     STAssertNotNil([dict valueForKey:@"weakProperty"], @"By default, converter should not convert weak properties");
 }
 
+- (void) testReassigningOutputType {
+    converter.outputType = kJAGFullOutput;
+    NSDictionary *dict = [converter convertToDictionary:model];
+    STAssertNotNil([dict valueForKey:@"dateProperty"], @"Full Dictionary should have a date value.");
+    converter.outputType = kJAGJSONOutput;
+    dict = [converter convertToDictionary:model];
+    STAssertNil([dict valueForKey:@"dateProperty"], @"JSON Dictionary should not have a date value after reassigning outputType.");
+}
+
+- (void) testReassigningClassesToConvert {
+    converter.outputType = kJAGPropertyListOutput;
+    NSDictionary *dict = [converter convertToDictionary:model];
+    STAssertTrue([[dict valueForKey:@"modelProperty"] isKindOfClass:[NSDictionary class]], @"modelProperty should be converted.");
+    converter.classesToConvert = [NSSet set];
+    dict = [converter convertToDictionary:model];
+    STAssertNil([dict valueForKey:@"modelProperty"], @"modelProperty should be dropped once TestModel is no longer converted.");
+    converter.classesToConvert = [NSSet setWithObject:[TestModel class]];
+    dict = [converter convertToDictionary:model];
+    STAssertTrue([[dict valueForKey:@"modelProperty"] isKindOfClass:[NSDictionary class]], @"modelProperty should be converted again.");
+}
+
 - (void) testNSArrayWithNSNumberWithBoolFalse {
     NSNumber *falseNum = [NSNumber numberWithBool:NO];
     NSNumber *zeroNum = [NSNumber numberWithInt:0];
@@ -201,4 +283,459 @@
     STAssertTrue([composed count] == 2, @"Dict should have two elements after composing.");
 }
 
+- (void) testBatchMatchesSerial {
+    converter.outputType = kJAGPropertyListOutput;
+    NSMutableArray *models = [NSMutableArray array];
+    for (int i = 0; i < 5000; i++) {
+        TestModel *element = [TestModel testModel];
+        [element populate];
+        element.intProperty = i;
+        [models addObject:element];
+    }
+    converter.batchThreshold = 0;
+    NSArray *serial = [converter convertToDictionaries:models];
+    converter.batchThreshold = 100;
+    NSArray *parallel = [converter convertToDictionaries:models];
+    STAssertEqualObjects(parallel, serial, @"Parallel conversion should match serial conversion, in order.");
+
+    NSArray *composed = [converter composeModelsFromArray:parallel ofClass:[TestModel class]];
+    STAssertEquals([composed count], [models count], @"Each dictionary should become a model.");
+    for (NSUInteger i = 0; i < [composed count]; i++) {
+        [self assert:[composed objectAtIndex:i] isEqualTo:[parallel objectAtIndex:i]];
+    }
+}
+
+- (void) testBatchSharesIdentityMap {
+    converter.shouldPreserveIdentity = YES;
+    converter.batchThreshold = 1;
+    TestModel *shared = [TestModel testModel];
+    shared.testModelID = @"SHARED";
+    TestModel *other = [TestModel testModel];
+    model.modelProperty = shared;
+    other.modelProperty = shared;
+    NSArray *dicts = [converter convertToDictionaries:[NSArray arrayWithObjects:model, other, nil]];
+    STAssertTrue([[dicts objectAtIndex:0] objectForKey:@"modelProperty"] == [[dicts objectAtIndex:1] objectForKey:@"modelProperty"],
+                 @"A model shared between elements should be decomposed once.");
+
+    NSArray *composed = [converter composeModelsFromArray:dicts ofClass:[TestModel class]];
+    STAssertTrue([[composed objectAtIndex:0] modelProperty] == [[composed objectAtIndex:1] modelProperty],
+                 @"A dictionary shared between elements should be composed once.");
+}
+
+- (void) testBatchUsesIdentifyDict {
+    converter.identifyDict = ^ Class (NSDictionary *dict) {
+        return [dict objectForKey:@"subclassStringProperty"] ? [TestModelSubclass class] : nil;
+    };
+    NSArray *dicts = [NSArray arrayWithObjects:
+                      [NSDictionary dictionaryWithObject:@"sub" forKey:@"subclassStringProperty"],
+                      [NSDictionary dictionaryWithObject:@"plain" forKey:@"stringProperty"],
+                      nil];
+    NSArray *composed = [converter composeModelsFromArray:dicts ofClass:[TestModel class]];
+    STAssertEqualObjects([[composed objectAtIndex:0] class], [TestModelSubclass class], @"identifyDict should choose the class.");
+    STAssertEqualObjects([[composed objectAtIndex:1] class], [TestModel class], @"Unidentified dictionaries should become modelClass.");
+}
+
+- (void) testSharedModelDecomposedOnce {
+    converter.shouldPreserveIdentity = YES;
+    TestModel *shared = [TestModel testModel];
+    shared.testModelID = @"SHARED";
+    model.modelProperty = shared;
+    model.arrayProperty = [NSArray arrayWithObject:shared];
+    NSDictionary *dict = [converter convertToDictionary:model];
+    STAssertTrue([dict valueForKey:@"modelProperty"] == [[dict valueForKey:@"arrayProperty"] objectAtIndex:0],
+                 @"A shared model should be decomposed into a single dictionary.");
+
+    TestModel *composed = [converter composeModelFromObject:dict];
+    STAssertTrue(composed.modelProperty == [composed.arrayProperty objectAtIndex:0],
+                 @"A shared dictionary should be composed into a single model.");
+}
+
+- (void) testStrongCycle {
+    converter.shouldPreserveIdentity = YES;
+    TestModel *child = [TestModel testModel];
+    child.testModelID = @"CHILD";
+    model.modelProperty = child;
+    child.modelProperty = model;
+    NSDictionary *dict = [converter convertToDictionary:model];
+    NSDictionary *reference = [dict valueForKeyPath:@"modelProperty.modelProperty"];
+    STAssertNotNil([dict objectForKey:JAGIdentityKey], @"The start of a cycle should get an identifier.");
+    STAssertEqualObjects([reference objectForKey:JAGReferenceKey], [dict objectForKey:JAGIdentityKey],
+                         @"The end of a cycle should be a reference.");
+
+    TestModel *composed = [converter composeModelFromObject:dict];
+    STAssertTrue(composed.modelProperty.modelProperty == composed, @"The cycle should be restored.");
+    child.modelProperty = nil;
+}
+
+- (void) testStrongCycleThroughJSON {
+    converter.shouldPreserveIdentity = YES;
+    converter.outputType = kJAGJSONOutput;
+    TestModel *child = [TestModel testModel];
+    child.testModelID = @"CHILD";
+    model.modelProperty = child;
+    child.modelProperty = model;
+    NSData *data = [converter JSONDataFromObject:model];
+    child.modelProperty = nil;
+
+    TestModel *composed = [converter composeModelFromJSONData:data ofClass:[TestModel class] error:NULL];
+    STAssertEqualObjects(composed.modelProperty.testModelID, @"CHILD", @"The child should be decoded.");
+    STAssertTrue(composed.modelProperty.modelProperty == composed, @"The cycle should be restored.");
+    composed.modelProperty.modelProperty = nil;
+}
+
+- (void) testDiagnostics {
+    converter.outputType = kJAGJSONOutput;
+    __block NSUInteger handled = 0;
+    __block NSString *description = nil;
+    converter.diagnosticHandler = ^ (JAGDiagnosticCode code, id value, id context) {
+        handled++;
+        if (code == kJAGDiagnosticBadKeyType) {
+            description = JAGDiagnosticDescription(code, value, context);
+        }
+    };
+    NSDictionary *dict = [NSDictionary dictionaryWithObjectsAndKeys:
+                          @"value", [NSNumber numberWithInt:1],
+                          [NSData data], @"data",
+                          nil];
+    [converter decomposeObject:dict];
+    STAssertEquals([converter diagnosticCountForCode:kJAGDiagnosticBadKeyType], (NSUInteger)1, @"The numeric key should be reported.");
+    STAssertEquals([converter diagnosticCountForCode:kJAGDiagnosticDroppedValue], (NSUInteger)1, @"The NSData should be reported.");
+    STAssertEquals(handled, (NSUInteger)2, @"The handler should see each diagnostic.");
+    STAssertTrue([description rangeOfString:@"string keys"].location != NSNotFound, @"Descriptions should be formatted on request.");
+
+    [converter resetDiagnosticCounts];
+    STAssertEquals([converter diagnosticCountForCode:kJAGDiagnosticBadKeyType], (NSUInteger)0, @"Counts should reset.");
+}
+
+- (void) testLazyComposition {
+    converter.outputType = kJAGPropertyListOutput;
+    converter.shouldComposeLazily = YES;
+    NSDictionary *dict = [converter decomposeObject:model];
+    TestModel *composed = [TestModel testModel];
+    [converter setPropertiesOf:composed fromDictionary:dict];
+    STAssertTrue([JAGLazyHydrator hasDeferredProperties:composed], @"Nested models and arrays should be deferred.");
+    STAssertEquals([composed class], [TestModel class], @"The lazy subclass should be hidden.");
+    STAssertEquals(composed.intProperty, 5, @"Scalars should be set right away.");
+    [self assert:composed isEqualTo:dict];
+    STAssertTrue([composed.modelProperty isKindOfClass:[TestModel class]], @"Nested models should be composed on access.");
+    STAssertTrue([composed.setProperty isKindOfClass:[NSSet class]], @"Sets should be composed on access.");
+    STAssertFalse([JAGLazyHydrator hasDeferredProperties:composed], @"Every deferred property has been read.");
+    STAssertEquals(object_getClass(composed), [TestModel class], @"A hydrated model should get its class back.");
+
+    TestModel *overwritten = [TestModel testModel];
+    [converter setPropertiesOf:overwritten fromDictionary:dict];
+    overwritten.modelProperty = nil;
+    STAssertNil(overwritten.modelProperty, @"Setting a property should discard its deferred value.");
+
+    TestModel *shared = [TestModel testModel];
+    [converter setPropertiesOf:shared fromDictionary:dict];
+    __strong id *children = (__strong id *)calloc(16, sizeof(id));
+    dispatch_apply(16, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        children[i] = shared.modelProperty;
+    });
+    for (int i = 0; i < 16; i++) {
+        STAssertTrue(children[i] == children[0], @"Every thread should see the same composed model.");
+        children[i] = nil;
+    }
+    free(children);
+}
+
+- (void) testLazyCompositionUsesDecodeTimeConfiguration {
+    __weak JAGPropertyConverter *weakConverter = nil;
+    TestModel *composed = [TestModel testModel];
+    NSDictionary *dict = nil;
+    @autoreleasepool {
+        JAGPropertyConverter *lazyConverter = [[JAGPropertyConverter alloc] initWithOutputType:kJAGPropertyListOutput];
+        lazyConverter.classesToConvert = converter.classesToConvert;
+        lazyConverter.identifyDict = converter.identifyDict;
+        lazyConverter.shouldComposeLazily = YES;
+        dict = [lazyConverter decomposeObject:model];
+        [lazyConverter setPropertiesOf:composed fromDictionary:dict];
+        lazyConverter.identifyDict = ^Class (NSDictionary *dictionary) { return nil; };
+        lazyConverter.classesToConvert = [NSSet set];
+        weakConverter = lazyConverter;
+    }
+    STAssertNil(weakConverter, @"A deferred property shouldn't keep the converter alive.");
+    STAssertTrue([JAGLazyHydrator hasDeferredProperties:composed], @"Nested models should be deferred.");
+    STAssertTrue([composed.modelProperty isKindOfClass:[TestModel class]],
+                 @"Deferred properties should be composed with the configuration they were decoded with.");
+    [self assert:composed isEqualTo:dict];
+}
+
+- (void) testPatch {
+    converter.outputType = kJAGPropertyListOutput;
+    STAssertNil([converter patchForModel:model], @"There is no patch without a baseline.");
+    [converter recordBaselineForModel:model];
+    STAssertEquals([[converter patchForModel:model] count], (NSUInteger)0, @"Nothing has changed yet.");
+
+    TestModel *copy = [converter composeModelFromObject:[converter convertToDictionary:model]];
+    model.stringProperty = @"Goodbye Kitty!";
+    model.intProperty = 6;
+    model.modelProperty.testModelID = @"CHANGED";
+    model.arrayProperty = nil;
+    NSDictionary *patch = [converter patchForModel:model];
+    NSDictionary *expected = [NSDictionary dictionaryWithObjectsAndKeys:
+                              @"Goodbye Kitty!", @"stringProperty",
+                              [NSNumber numberWithInt:6], @"intProperty",
+                              [NSDictionary dictionaryWithObject:@"CHANGED" forKey:@"testModelID"], @"modelProperty",
+                              [NSNull null], @"arrayProperty",
+                              nil];
+    STAssertEqualObjects(patch, expected, @"Only changed properties should be in the patch.");
+
+    TestModel *nested = copy.modelProperty;
+    [converter applyPatch:patch toModel:copy];
+    STAssertTrue(copy.modelProperty == nested, @"Nested patches should change the existing model.");
+    STAssertNil(copy.arrayProperty, @"NSNull should remove a value.");
+    STAssertEqualObjects([converter convertToDictionary:copy], [converter convertToDictionary:model],
+                         @"Applying the patch should reproduce the changes.");
+}
+
+- (void) testPatchArrayElements {
+    converter.outputType = kJAGPropertyListOutput;
+    TestModel *first = [TestModel testModel];
+    TestModel *second = [TestModel testModel];
+    first.testModelID = @"FIRST";
+    second.testModelID = @"SECOND";
+    model.arrayProperty = [NSArray arrayWithObjects:first, second, @"third", nil];
+    [converter recordBaselineForModel:model];
+    TestModel *copy = [converter composeModelFromObject:[converter convertToDictionary:model]];
+
+    second.intProperty = 7;
+    model.arrayProperty = [NSArray arrayWithObjects:first, second, @"changed", nil];
+    NSDictionary *elements = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSDictionary dictionaryWithObject:[NSNumber numberWithInt:7] forKey:@"intProperty"], @"1",
+                              @"changed", @"2",
+                              nil];
+    NSDictionary *patch = [converter patchForModel:model];
+    STAssertEqualObjects(patch, [NSDictionary dictionaryWithObject:[NSDictionary dictionaryWithObject:elements forKey:JAGPatchElementsKey]
+                                                            forKey:@"arrayProperty"],
+                         @"Only changed elements should be in the patch.");
+
+    TestModel *firstCopy = [copy.arrayProperty objectAtIndex:0];
+    [converter applyPatch:patch toModel:copy];
+    STAssertTrue([copy.arrayProperty objectAtIndex:0] == firstCopy, @"Unchanged elements should be kept.");
+    STAssertEquals([[copy.arrayProperty objectAtIndex:1] intProperty], 7, @"Nested patches should change elements.");
+    STAssertEqualObjects([copy.arrayProperty objectAtIndex:2], @"changed", @"New values should replace elements.");
+}
+
+- (void) testPatchWithIdentity {
+    converter.outputType = kJAGPropertyListOutput;
+    converter.shouldPreserveIdentity = YES;
+    TestModel *child = [TestModel testModel];
+    model.modelProperty = child;
+    child.modelProperty = model;
+    [converter recordBaselineForModel:model];
+    STAssertEquals([[converter patchForModel:model] count], (NSUInteger)0,
+                   @"References in the baseline should match the models they refer to.");
+
+    child.stringProperty = @"Changed";
+    NSDictionary *expected = [NSDictionary dictionaryWithObject:[NSDictionary dictionaryWithObject:@"Changed" forKey:@"stringProperty"]
+                                                         forKey:@"modelProperty"];
+    STAssertEqualObjects([converter patchForModel:model], expected, @"The cycle back to model should not be compared again.");
+    child.modelProperty = nil;
+}
+
+static NSInteger gObservedChanges = 0;
+
+- (void) observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+    gObservedChanges++;
+}
+
+- (void) testMergeInPlace {
+    converter.outputType = kJAGPropertyListOutput;
+    converter.shouldMergeInPlace = YES;
+    converter.mergeKey = @"testModelID";
+    TestModel *first = [TestModel testModel];
+    first.testModelID = @"first";
+    TestModel *second = [TestModel testModel];
+    second.testModelID = @"second";
+    model.arrayProperty = [NSArray arrayWithObjects:first, second, nil];
+    TestModel *nested = model.modelProperty;
+    NSArray *array = model.arrayProperty;
+
+    NSMutableDictionary *dict = [[converter convertToDictionary:model] mutableCopy];
+    [model addObserver:self forKeyPath:@"intProperty" options:0 context:NULL];
+    [model addObserver:self forKeyPath:@"arrayProperty" options:0 context:NULL];
+    gObservedChanges = 0;
+    [converter setPropertiesOf:model fromDictionary:dict];
+    STAssertEquals(gObservedChanges, (NSInteger)0, @"Unchanged values should not be set.");
+    STAssertTrue(model.modelProperty == nested, @"The nested model should be reused.");
+    STAssertTrue(model.arrayProperty == array, @"An unchanged array should be kept.");
+
+    NSDictionary *changedSecond = [NSDictionary dictionaryWithObjectsAndKeys:
+                                   @"second", @"testModelID", [NSNumber numberWithInt:7], @"intProperty", nil];
+    NSDictionary *third = [NSDictionary dictionaryWithObject:@"third" forKey:@"testModelID"];
+    [dict setObject:[NSArray arrayWithObjects:changedSecond, third, nil] forKey:@"arrayProperty"];
+    [dict setObject:[NSDictionary dictionaryWithObject:@"CHANGED" forKey:@"testModelID"] forKey:@"modelProperty"];
+    [dict setObject:[NSNumber numberWithInt:model.intProperty + 1] forKey:@"intProperty"];
+    [converter setPropertiesOf:model fromDictionary:dict];
+    [model removeObserver:self forKeyPath:@"intProperty"];
+    [model removeObserver:self forKeyPath:@"arrayProperty"];
+    STAssertEquals(gObservedChanges, (NSInteger)2, @"Only the changed int and array should be set.");
+    STAssertTrue(model.modelProperty == nested, @"The nested model should be updated in place.");
+    STAssertEqualObjects(nested.testModelID, @"CHANGED", @"The nested model should be updated.");
+    STAssertEquals([model.arrayProperty count], (NSUInteger)2, @"The array should have the new elements.");
+    STAssertTrue([model.arrayProperty objectAtIndex:0] == second, @"Matching elements should be reused.");
+    STAssertEquals(second.intProperty, 7, @"Matching elements should be updated.");
+    STAssertEqualObjects([[model.arrayProperty objectAtIndex:1] testModelID], @"third", @"New elements should be composed.");
+}
+
+- (void) testModelPool {
+    converter.outputType = kJAGPropertyListOutput;
+    converter.modelPool = [[JAGModelPool alloc] init];
+    NSDictionary *dict = [converter convertToDictionary:model];
+    TestModel *composed = [converter composeModelFromObject:dict];
+    TestModel *nested = composed.modelProperty;
+
+    [converter recycleModel:composed];
+    STAssertEquals([converter.modelPool countOfModelsOfClass:[TestModel class]], (NSUInteger)2,
+                   @"The model and its nested model should be pooled.");
+    STAssertNil(composed.stringProperty, @"Recycled models should be reset.");
+    STAssertEquals(composed.intProperty, 0, @"Recycled models should be reset.");
+    STAssertNil(composed.modelProperty, @"Recycled models should be reset.");
+    [converter recycleModel:composed];
+    STAssertEquals([converter.modelPool countOfModelsOfClass:[TestModel class]], (NSUInteger)2,
+                   @"A model should only be pooled once.");
+
+    TestModel *reused = [converter composeModelFromObject:dict];
+    STAssertTrue(reused == composed || reused == nested, @"Composing should reuse pooled models.");
+    STAssertTrue(reused.modelProperty == composed || reused.modelProperty == nested, @"Nested models should be reused too.");
+    STAssertEquals([converter.modelPool countOfModelsOfClass:[TestModel class]], (NSUInteger)0, @"The pool should be drained.");
+    STAssertEqualObjects([converter convertToDictionary:reused], dict, @"Reused models should be composed fully.");
+}
+
+- (void) testStaleGeneratedCodecIsReported {
+    JAGRegisterGeneratedCodecs(&gStaleCodec, 1);
+    converter.classesToConvert = [NSSet setWithObject:[JAGStaleCodecModel class]];
+    JAGStaleCodecModel *stale = [[JAGStaleCodecModel alloc] init];
+    stale.addedProperty = @"added";
+    NSDictionary *dict = [converter convertToDictionary:stale];
+    STAssertEqualObjects([dict objectForKey:@"addedProperty"], @"added", @"A stale codec should fall back to reflection.");
+    [converter convertToDictionary:stale];
+    STAssertEquals([converter diagnosticCountForCode:kJAGDiagnosticStaleGeneratedCodec], (NSUInteger)2,
+                   @"Each fallback should be reported.");
+}
+
+- (void) testGeneratedCodecMatchesReflection {
+    //TestModel+JAGCodec.m is generated from TestModel.h and TestModel.m by Tools/jagcodegen.py.
+    STAssertTrue(JAGGeneratedCodecForClass([TestModel class], nil) != NULL, @"TestModel should have a generated codec.");
+    STAssertTrue(JAGGeneratedCodecForClass([TestModelSubclass class], nil) != NULL, @"TestModelSubclass should have a generated codec.");
+    model.weakProperty = [TestModel testModel];
+    JAGPropertyConverter *reflective = [[JAGPropertyConverter alloc] init];
+    reflective.shouldUseGeneratedCodecs = NO;
+    for (NSNumber *outputType in [NSArray arrayWithObjects:[NSNumber numberWithInt:kJAGPropertyListOutput],
+                                  [NSNumber numberWithInt:kJAGJSONOutput], nil]) {
+        for (NSNumber *convertWeak in [NSArray arrayWithObjects:[NSNumber numberWithBool:NO], [NSNumber numberWithBool:YES], nil]) {
+            converter.outputType = reflective.outputType = [outputType intValue];
+            converter.shouldConvertWeakProperties = reflective.shouldConvertWeakProperties = [convertWeak boolValue];
+            NSDictionary *dict = [reflective convertToDictionary:model];
+            STAssertEqualObjects([converter convertToDictionary:model], dict,
+                                 @"Generated codecs should decompose like reflection.");
+
+            TestModel *generatedModel = [[TestModel alloc] init];
+            TestModel *reflectedModel = [[TestModel alloc] init];
+            [converter setPropertiesOf:generatedModel fromDictionary:dict];
+            [reflective setPropertiesOf:reflectedModel fromDictionary:dict];
+            STAssertEqualObjects([reflective convertToDictionary:generatedModel], [reflective convertToDictionary:reflectedModel],
+                                 @"Generated codecs should compose like reflection.");
+        }
+    }
+
+    //Values off the fast path go through reflection.
+    NSDictionary *strings = [NSDictionary dictionaryWithObjectsAndKeys:@"42", @"intProperty", @"string", @"modelProperty", nil];
+    TestModel *stringModel = [[TestModel alloc] init];
+    converter.shouldParseNumericStrings = YES;
+    [converter setPropertiesOf:stringModel fromDictionary:strings];
+    STAssertEquals(stringModel.intProperty, 42, @"Numeric strings should still be parsed.");
+    STAssertNil(stringModel.modelProperty, @"Mismatched values should still be refused.");
+}
+
+- (void) testFrozenCopy {
+    converter.outputType = kJAGJSONOutput;
+    converter.shouldConvertWeakProperties = YES;
+    model.weakProperty = [TestModel testModel];
+    JAGPropertyConverter *frozen = [converter frozenCopy];
+    STAssertTrue([frozen isFrozen], @"frozenCopy should return a frozen converter.");
+    STAssertFalse([converter isFrozen], @"The original should stay unfrozen.");
+    STAssertTrue([frozen frozenCopy] == frozen, @"A frozen converter is its own frozen copy.");
+    STAssertEquals(frozen.outputType, kJAGJSONOutput, @"The configuration should be copied.");
+    STAssertEqualObjects(frozen.classesToConvert, converter.classesToConvert, @"The configuration should be copied.");
+    STAssertTrue(frozen.shouldConvertWeakProperties, @"The configuration should be copied.");
+    NSDictionary *dict = [converter convertToDictionary:model];
+    STAssertEqualObjects([frozen convertToDictionary:model], dict, @"A frozen copy should convert the same way.");
+    STAssertEqualObjects([frozen convertToDictionary:[frozen composeModelFromObject:dict]], dict,
+                         @"A frozen copy should compose the same way.");
+
+    STAssertThrowsSpecificNamed(frozen.outputType = kJAGFullOutput, NSException, NSInternalInconsistencyException,
+                                @"Reconfiguring a frozen converter is an error.");
+    STAssertThrowsSpecificNamed(frozen.identifyDict = nil, NSException, NSInternalInconsistencyException,
+                                @"Reconfiguring a frozen converter is an error.");
+    STAssertEquals(frozen.outputType, kJAGJSONOutput, @"A refused setter should change nothing.");
+    STAssertNotNil(frozen.identifyDict, @"A refused setter should change nothing.");
+    converter.outputType = kJAGFullOutput;
+    STAssertEquals(frozen.outputType, kJAGJSONOutput, @"Reconfiguring the original shouldn't change the copy.");
+}
+
+- (void) testFrozenCopyOfSubclass {
+    JAGPrefixingConverter *prefixing = [[JAGPrefixingConverter alloc] init];
+    prefixing.prefix = @"user.";
+    prefixing.numberFormatter = [[NSNumberFormatter alloc] init];
+    prefixing.modelPool = [[JAGModelPool alloc] init];
+    prefixing.modelPool.capacity = 8;
+    JAGPrefixingConverter *frozen = (JAGPrefixingConverter *)[prefixing frozenCopy];
+    STAssertEqualObjects([frozen class], [JAGPrefixingConverter class], @"The copy should keep the receiver's class.");
+    STAssertEqualObjects(frozen.prefix, @"user.", @"A subclass's configuration should be copied.");
+    STAssertNotNil(frozen.numberFormatter, @"The number formatter should be copied.");
+    STAssertFalse(frozen.numberFormatter == prefixing.numberFormatter, @"The copy should have its own number formatter.");
+    STAssertFalse(frozen.modelPool == prefixing.modelPool, @"The copy should have its own model pool.");
+    STAssertEquals(frozen.modelPool.capacity, (NSUInteger)8, @"The model pool's capacity should be copied.");
+}
+
+- (void) testFrozenConverterIsThreadSafe {
+    converter.outputType = kJAGPropertyListOutput;
+    JAGPropertyConverter *frozen = [converter frozenCopy];
+    TestModel *shared = model;
+    NSDictionary *expected = [converter convertToDictionary:shared];
+    __block int32_t failures = 0;
+    dispatch_apply(64, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        for (int n = 0; n < 50; n++) {
+            @autoreleasepool {
+                NSDictionary *dict = [frozen convertToDictionary:shared];
+                TestModel *composed = [frozen composeModelFromObject:dict];
+                if (![dict isEqual:expected] || ![[frozen convertToDictionary:composed] isEqual:expected]) {
+                    __sync_fetch_and_add(&failures, 1);
+                }
+            }
+        }
+    });
+    STAssertEquals(failures, (int32_t)0, @"Threads sharing a frozen converter should all get the same results.");
+}
+
+- (void) testAutoreleaseIntervalBoundsTemporaries {
+    converter.outputType = kJAGPropertyListOutput;
+    converter.classesToConvert = [NSSet setWithObject:[JAGTemporaryModel class]];
+    //JAGTemporaries aren't PropertyList values, so each one is dropped and left to its pool.
+    converter.diagnosticHandler = ^ (JAGDiagnosticCode code, id value, id context) {};
+    NSMutableArray *models = [NSMutableArray array];
+    for (int i = 0; i < 10000; i++) {
+        [models addObject:[[JAGTemporaryModel alloc] init]];
+    }
+
+    converter.autoreleaseInterval = 0;
+    @autoreleasepool {
+        [converter decomposeObject:models];
+        STAssertEquals(gLiveTemporaries, (NSInteger)10000, @"Without draining, every temporary outlives the call.");
+    }
+    STAssertEquals(gLiveTemporaries, (NSInteger)0, @"The caller's pool frees the temporaries.");
+
+    converter.autoreleaseInterval = 100;
+    @autoreleasepool {
+        [converter decomposeObject:models];
+        STAssertTrue(gLiveTemporaries <= 100, @"At most one interval of temporaries should be alive, not %ld.",
+                     (long)gLiveTemporaries);
+        [converter decomposeObject:[NSSet setWithArray:models]];
+        STAssertTrue(gLiveTemporaries <= 200, @"Sets should be drained too, not %ld.", (long)gLiveTemporaries);
+    }
+}
+
 @end
@@ -28,6 +28,7 @@
 #import "TestModel.h"
 #import "JAGPropertyFinder.h"
 #import "JAGProperty.h"
+#import <objc/runtime.h>
 
 @implementation JAGPropertyFinderTest
 
@@ -61,4 +62,50 @@
     STAssertNotNil(stringProp, @"StringProp should be found.");
 }
 
+- (void) testPropertyForUnknownName {
+    JAGProperty* unknownProp = [JAGPropertyFinder propertyForName:@"noSuchProperty"
+                                                          inClass:[TestModelSubclass class]];
+    STAssertNil(unknownProp, @"Unknown properties should not be found.");
+}
+
+- (void) testPropertiesForClassAreCached {
+    NSArray *properties = [JAGPropertyFinder propertiesForClass:[TestModel class]];
+    NSArray *properties2 = [JAGPropertyFinder propertiesForClass:[TestModel class]];
+    STAssertTrue(properties == properties2, @"Repeated lookups should return the cached properties.");
+    JAGProperty* stringProp = [JAGPropertyFinder propertyForName:@"stringProperty" inClass:[TestModel class]];
+    STAssertTrue([properties indexOfObjectIdenticalTo:stringProp] != NSNotFound,
+                 @"propertyForName:inClass: should return the cached JAGProperty.");
+}
+
+- (void) testPropertyNamesForClass {
+    NSArray *properties = [JAGPropertyFinder propertiesForClass:[TestModelSubclass class]];
+    NSArray *propertyNames = [JAGPropertyFinder propertyNamesForClass:[TestModelSubclass class]];
+    STAssertEquals([properties count], [propertyNames count], @"There should be a name for each property.");
+    STAssertEqualObjects([propertyNames objectAtIndex:0], @"subclassStringProperty",
+                         @"Subclass properties should come first.");
+    STAssertTrue([propertyNames containsObject:@"stringProperty"], @"Superclass properties should be included.");
+}
+
+- (void) testInvalidatePropertyCache {
+    NSArray *properties = [JAGPropertyFinder propertiesForClass:[TestModel class]];
+    [JAGPropertyFinder invalidatePropertyCache];
+    NSArray *properties2 = [JAGPropertyFinder propertiesForClass:[TestModel class]];
+    STAssertFalse(properties == properties2, @"Invalidating should rebuild the cached properties.");
+    STAssertEqualObjects(properties, properties2, @"Rebuilt properties should be equal to the old ones.");
+}
+
+- (void) testPropertiesAddedAtRuntime {
+    Class runtimeClass = objc_getClass("JAGFinderRuntimeModel");
+    if (!runtimeClass) {
+        runtimeClass = objc_allocateClassPair([NSObject class], "JAGFinderRuntimeModel", 0);
+        objc_registerClassPair(runtimeClass);
+    }
+    STAssertEquals([[JAGPropertyFinder propertiesForClass:runtimeClass] count], (NSUInteger)0, nil);
+    objc_property_attribute_t attributes[] = { { "T", "@\"NSString\"" }, { "C", "" } };
+    class_addProperty(runtimeClass, "addedProperty", attributes, 2);
+    [JAGPropertyFinder invalidatePropertyCache];
+    STAssertEqualObjects([JAGPropertyFinder propertyNamesForClass:runtimeClass], [NSArray arrayWithObject:@"addedProperty"],
+                         @"Invalidating should pick up properties added at runtime.");
+}
+
 @end
@@ -28,6 +28,7 @@
 #import "JAGPropertyConverter.h"
 #import "JAGPropertyFinder.h"
 #import "JAGProperty.h"
+#import <objc/runtime.h>
 
 @interface JAGPropertyTest () {
     @private
@@ -94,6 +95,22 @@
     STAssertFalse([modelProp isId], @"ModelProeprty should not be isId");
 }
 
+- (void) testScalarKind {
+    STAssertEquals([intProp scalarKind], JAGPropertyScalarKindInt, @"intProperty should have an int scalarKind.");
+    STAssertEquals([stringProp scalarKind], JAGPropertyScalarKindObject, @"stringProperty should have an object scalarKind.");
+    STAssertEquals([idProperty scalarKind], JAGPropertyScalarKindObject, @"idProperty should have an object scalarKind.");
+    STAssertEquals([blockProperty scalarKind], JAGPropertyScalarKindBlock, @"blockProperty should have a block scalarKind.");
+    JAGProperty *cfProp = [JAGPropertyFinder propertyForName:@"cfProperty" inClass:[TestModel class]];
+    STAssertEquals([cfProp scalarKind], JAGPropertyScalarKindOther, @"Struct properties should have an other scalarKind.");
+    STAssertFalse([cfProp isNumber], @"Struct properties should not be numbers.");
+}
+
+- (void) testAttributeEncodings {
+    STAssertEqualObjects([stringProp attributeEncodings], @"C,N", @"stringProperty should be copy, nonatomic.");
+    STAssertEqualObjects([activeProp attributeEncodings], @"GisActive,SmakeActive:",
+                         @"active should only have its custom getter and setter.");
+}
+
 #pragma mark - Tests for propertyClass
 
 - (void) testStringProperty {
@@ -117,6 +134,25 @@
     
 }
 
+- (void) testPropertyClassLoadedLater {
+    Class holder = objc_getClass("JAGLaterClassHolder");
+    if (!holder) {
+        holder = objc_allocateClassPair([NSObject class], "JAGLaterClassHolder", 0);
+        objc_property_attribute_t attributes[] = { { "T", "@\"JAGLaterLoadedArray\"" }, { "&", "" } };
+        class_addProperty(holder, "later", attributes, 2);
+        objc_registerClassPair(holder);
+    }
+    JAGProperty *laterProp = [JAGProperty propertyWithObjCProperty:class_getProperty(holder, "later")];
+    if (!objc_getClass("JAGLaterLoadedArray")) {
+        STAssertNil([laterProp propertyClass], @"The class isn't loaded yet.");
+        STAssertFalse([laterProp isCollection], @"An unknown class isn't a collection.");
+        objc_registerClassPair(objc_allocateClassPair([NSArray class], "JAGLaterLoadedArray", 0));
+    }
+    STAssertEquals([laterProp propertyClass], objc_getClass("JAGLaterLoadedArray"),
+                   @"A class loaded after the property was read should be found.");
+    STAssertTrue([laterProp isCollection], @"The class should be checked for collections once found.");
+}
+
 - (void) testDictionaryProperty {
     STAssertTrue([dictProp isObject], @"Property should be Object.");
     STAssertEquals([dictProp propertyClass], [NSDictionary class], 
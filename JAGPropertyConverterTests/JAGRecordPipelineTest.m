@@ -0,0 +1,198 @@
+//
+//  JAGRecordPipelineTest.m
+//  JAGPropertyConverter
+//
+// Copyright (c) 2012 James A. Gill
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "JAGRecordPipelineTest.h"
+#import "JAGRecordPipeline.h"
+#import "JAGPropertyConverter.h"
+#import "TestModel.h"
+#include <unistd.h>
+
+@interface JAGRecordPipelineTest () {
+@private
+    JAGRecordPipeline *pipeline;
+    NSMutableArray *models;
+    JAGRecordPipelineStatistics statistics;
+    NSError *error;
+}
+@end
+
+@implementation JAGRecordPipelineTest
+
+- (void) setUp {
+    pipeline = [[JAGRecordPipeline alloc] initWithConverter:[TestModel testConverter]
+                                                 modelClass:[TestModel class]];
+    pipeline.batchSize = 3;
+    pipeline.workerCount = 4;
+    models = [NSMutableArray array];
+    error = nil;
+}
+
+//Lines of {"intProperty": i} for i in [0, count).
+- (NSData *) recordsWithCount: (int) count {
+    NSMutableString *string = [NSMutableString string];
+    for (int i = 0; i < count; i++) {
+        [string appendFormat:@"{\"intProperty\": %d}\n", i];
+    }
+    return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+//Process stream, and wait until it completes.
+- (void) processStream: (NSInputStream *) stream {
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    [stream open];
+    [pipeline processStream:stream consumer:^(NSArray *batch) {
+        [models addObjectsFromArray:batch];
+    } completion:^(JAGRecordPipelineStatistics completed, NSError *completedError) {
+        statistics = completed;
+        error = completedError;
+        dispatch_semaphore_signal(done);
+    }];
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    [stream close];
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(done);
+#endif
+}
+
+- (void) testStream {
+    NSString *string = @"{\"intProperty\": 1, \"stringProperty\": \"one\"}\n"
+                       @"\n"
+                       @"{\"intProperty\": 2}\r\n"
+                       @"  \t\n"
+                       @"{\"intProperty\": \n"
+                       @"{\"intProperty\": 3}";
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    [self processStream:[NSInputStream inputStreamWithData:data]];
+
+    STAssertNil(error, @"The input ended normally, but got %@", error);
+    STAssertEquals([models count], (NSUInteger)3, @"Each valid line should become a model.");
+    STAssertEquals([[models objectAtIndex:0] intProperty], 1, @"Models should be in order.");
+    STAssertEqualObjects([[models objectAtIndex:0] stringProperty], @"one", @"Models should be populated.");
+    STAssertEquals([[models objectAtIndex:1] intProperty], 2, @"A \\r before the newline should be ignored.");
+    STAssertEquals([[models lastObject] intProperty], 3, @"The last line needn't end with a newline.");
+    STAssertEquals(statistics.byteCount, (unsigned long long)[data length], @"Every byte should be read.");
+    STAssertEquals(statistics.recordCount, (NSUInteger)4, @"Blank lines aren't records.");
+    STAssertEquals(statistics.modelCount, (NSUInteger)3, @"modelCount should count the models.");
+    STAssertEquals(statistics.failedRecordCount, (NSUInteger)1, @"Invalid JSON should be counted and dropped.");
+    STAssertEquals(statistics.batchCount, (NSUInteger)2, @"Records should be batched by batchSize.");
+    STAssertEquals([pipeline.converter diagnosticCountForCode:kJAGDiagnosticDroppedValue], (NSUInteger)1,
+                   @"Dropped records should be reported.");
+}
+
+- (void) testFileDescriptor {
+    NSData *data = [self recordsWithCount:1000];
+    int fds[2];
+    STAssertEquals(pipe(fds), 0, @"Unable to make a pipe.");
+    //Write from another thread, since the pipe holds less than the whole input.
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        const uint8_t *bytes = [data bytes];
+        NSUInteger written = 0;
+        while (written < [data length]) {
+            //Odd sizes, so records are split across reads.
+            ssize_t count = write(fds[1], bytes + written, MIN((NSUInteger)777, [data length] - written));
+            if (count <= 0) break;
+            written += count;
+        }
+        close(fds[1]);
+    });
+
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    [pipeline processFileDescriptor:fds[0] consumer:^(NSArray *batch) {
+        [models addObjectsFromArray:batch];
+    } completion:^(JAGRecordPipelineStatistics completed, NSError *completedError) {
+        statistics = completed;
+        error = completedError;
+        dispatch_semaphore_signal(done);
+    }];
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    close(fds[0]);
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(done);
+#endif
+
+    STAssertNil(error, @"The input ended normally, but got %@", error);
+    STAssertEquals([models count], (NSUInteger)1000, @"Every record should become a model.");
+    for (int i = 0; i < 1000 && i < (int)[models count]; i++) {
+        STAssertEquals([[models objectAtIndex:i] intProperty], i, @"Models should be in the order of the input.");
+    }
+}
+
+- (void) testUnorderedDelivery {
+    pipeline.shouldPreserveOrder = NO;
+    [self processStream:[NSInputStream inputStreamWithData:[self recordsWithCount:500]]];
+    STAssertEquals([models count], (NSUInteger)500, @"Every record should become a model.");
+    NSMutableIndexSet *seen = [NSMutableIndexSet indexSet];
+    for (TestModel *model in models) {
+        [seen addIndex:model.intProperty];
+    }
+    STAssertEquals([seen count], (NSUInteger)500, @"Each record should be delivered once.");
+}
+
+- (void) testSlowConsumerHoldsBackReader {
+    pipeline.queueCapacity = 2;
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    NSInputStream *stream = [NSInputStream inputStreamWithData:[self recordsWithCount:60]];
+    [stream open];
+    [pipeline processStream:stream consumer:^(NSArray *batch) {
+        [models addObjectsFromArray:batch];
+        usleep(5000);
+    } completion:^(JAGRecordPipelineStatistics completed, NSError *completedError) {
+        statistics = completed;
+        dispatch_semaphore_signal(done);
+    }];
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    [stream close];
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(done);
+#endif
+
+    STAssertEquals([models count], (NSUInteger)60, @"Every record should become a model.");
+    STAssertTrue(statistics.stallTime > 0, @"The reader should wait for the consumer.");
+    STAssertTrue(statistics.consumeTime >= 20 * 0.005, @"consumeTime should include the consumer.");
+}
+
+- (void) testCancel {
+    dispatch_semaphore_t done = dispatch_semaphore_create(0);
+    NSInputStream *stream = [NSInputStream inputStreamWithData:[self recordsWithCount:3000]];
+    [stream open];
+    JAGRecordPipeline *cancelled = pipeline;
+    [pipeline processStream:stream consumer:^(NSArray *batch) {
+        [models addObjectsFromArray:batch];
+        [cancelled cancel];
+    } completion:^(JAGRecordPipelineStatistics completed, NSError *completedError) {
+        error = completedError;
+        dispatch_semaphore_signal(done);
+    }];
+    dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+    [stream close];
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(done);
+#endif
+
+    STAssertEquals([models count], (NSUInteger)3, @"Nothing should be delivered after cancelling.");
+    STAssertEqualObjects([error domain], NSCocoaErrorDomain, @"Cancelling should be reported.");
+    STAssertEquals([error code], (NSInteger)NSUserCancelledError, @"Cancelling should be reported.");
+}
+
+@end
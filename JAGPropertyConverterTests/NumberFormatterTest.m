@@ -68,5 +68,41 @@ JAGPropertyConverter *converter;
     STAssertEqualObjects(@"4", model.stringProperty, @"stringProperty should not be converted.");
 }
 
+- (void) testParseNumericStrings
+{
+    converter.numberFormatter = nil;
+    converter.shouldParseNumericStrings = YES;
+    NSDictionary *dict = [NSDictionary dictionaryWithObjectsAndKeys:
+                          @"-12", @"intProperty",
+                          @"6.8", @"floatProperty",
+                          @"9007199254740993", @"numberProperty",
+                          @"4", @"stringProperty",
+                          nil];
+    [converter setPropertiesOf:model fromDictionary:dict];
+    STAssertEquals(-12, model.intProperty, @"intProperty should be parsed.");
+    STAssertEquals(6.8f, model.floatProperty, @"floatProperty should be parsed to the nearest float.");
+    STAssertEquals([model.numberProperty longLongValue], 9007199254740993LL, @"Integers should be parsed exactly.");
+    STAssertEqualObjects(@"4", model.stringProperty, @"stringProperty should not be converted.");
+
+    dict = [NSDictionary dictionaryWithObjectsAndKeys:@"1.5", @"intProperty", @"1,000", @"floatProperty", nil];
+    [converter setPropertiesOf:model fromDictionary:dict];
+    STAssertEquals(-12, model.intProperty, @"A fraction shouldn't be truncated into an int.");
+    STAssertEquals(6.8f, model.floatProperty, @"Grouping separators aren't accepted.");
+    dict = [NSDictionary dictionaryWithObject:@"3000000000" forKey:@"intProperty"];
+    [converter setPropertiesOf:model fromDictionary:dict];
+    STAssertEquals(-12, model.intProperty, @"Values that overflow the property shouldn't be set.");
+}
+
+- (void) testNumbersFromStrings
+{
+    converter.shouldParseNumericStrings = YES;
+    NSArray *strings = [NSArray arrayWithObjects:@"1", @"2.5", @"18446744073709551615", @"x", nil];
+    NSArray *numbers = [converter numbersFromStrings:strings];
+    STAssertEquals([numbers count], (NSUInteger)4, @"Every string should have a result.");
+    STAssertEqualObjects([numbers objectAtIndex:0], [NSNumber numberWithInt:1], @"Integers should be parsed.");
+    STAssertEqualObjects([numbers objectAtIndex:1], [NSNumber numberWithDouble:2.5], @"Doubles should be parsed.");
+    STAssertEquals([[numbers objectAtIndex:2] unsignedLongLongValue], ULLONG_MAX, @"Large integers should be exact.");
+    STAssertEqualObjects([numbers objectAtIndex:3], [NSNull null], @"Non-numbers should be NSNull.");
+}
 
 @end
@@ -0,0 +1,347 @@
+//
+//  TestModel+JAGCodec.m
+//
+//  Generated by jagcodegen.py from TestModel.h, TestModel.m.
+//  Do not edit; regenerate it when the models change.
+//
+
+#import "JAGGeneratedCodec.h"
+#import "JAGPropertyConverter.h"
+#import "TestModel.h"
+
+#pragma mark - TestModel
+
+static const JAGGeneratedProperty JAGProperties_TestModel[] = {
+    { "testModelID", 0 },
+    { "intProperty", 0 },
+    { "stringProperty", 0 },
+    { "modelProperty", 0 },
+    { "arrayProperty", 0 },
+    { "setProperty", 0 },
+    { "dictionaryProperty", 0 },
+    { "dateProperty", 0 },
+    { "boolProperty", 0 },
+    { "cfProperty", 0 },
+    { "urlProperty", 0 },
+    { "readOnlyProperty", 0 },
+    { "active", 0 },
+    { "weakProperty", JAGGeneratedPropertyWeak },
+    { "blockProperty", 0 },
+    { "idProperty", 0 },
+};
+
+static void JAGEncode_TestModel(JAGPropertyConverter *converter, id object, NSMutableDictionary *values) {
+    TestModel *model = object;
+    JAGGeneratedEncodeValue(converter, values, @"testModelID", [model testModelID]);
+    JAGGeneratedEncodeValue(converter, values, @"intProperty", JAGGeneratedBox([model intProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"stringProperty", [model stringProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"modelProperty", [model modelProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"arrayProperty", [model arrayProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"setProperty", [model setProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dictionaryProperty", [model dictionaryProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dateProperty", [model dateProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"boolProperty", JAGGeneratedBox([model boolProperty]));
+    JAGGeneratedEncodeReflected(converter, values, model, @"cfProperty");
+    JAGGeneratedEncodeValue(converter, values, @"urlProperty", [model urlProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"readOnlyProperty", [model readOnlyProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"active", JAGGeneratedBox([model isActive]));
+    if (JAGGeneratedShouldConvertWeakProperties(converter)) {
+        JAGGeneratedEncodeValue(converter, values, @"weakProperty", [model weakProperty]);
+    }
+    JAGGeneratedEncodeValue(converter, values, @"blockProperty", [model blockProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"idProperty", [model idProperty]);
+}
+
+static void JAGDecode_TestModel(JAGPropertyConverter *converter, id object, NSDictionary *dictionary) {
+    TestModel *model = object;
+    id value;
+    if ((value = [dictionary objectForKey:@"testModelID"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setTestModelID:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"testModelID", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"intProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setIntProperty:JAGGeneratedUnbox([model intProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"intProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"stringProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setStringProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"stringProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"modelProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [TestModel class]);
+        if ([composed isKindOfClass:[TestModel class]]) {
+            [model setModelProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"modelProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"arrayProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSArray class]);
+        if ([composed isKindOfClass:[NSArray class]]) {
+            [model setArrayProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"arrayProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"setProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSSet class]);
+        if ([composed isKindOfClass:[NSSet class]]) {
+            [model setSetProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"setProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dictionaryProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDictionary class]);
+        if ([composed isKindOfClass:[NSDictionary class]]) {
+            [model setDictionaryProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dictionaryProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dateProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDate class]);
+        if ([composed isKindOfClass:[NSDate class]]) {
+            [model setDateProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dateProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"boolProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setBoolProperty:JAGGeneratedUnbox([model boolProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"boolProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"cfProperty"])) {
+        JAGGeneratedDecodeReflected(converter, model, @"cfProperty", value);
+    }
+    if ((value = [dictionary objectForKey:@"urlProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSURL class]);
+        if ([composed isKindOfClass:[NSURL class]]) {
+            [model setUrlProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"urlProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"readOnlyProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setReadOnlyProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"readOnlyProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"active"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model makeActive:JAGGeneratedUnbox([model isActive], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"active", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"weakProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [TestModel class]);
+        if ([composed isKindOfClass:[TestModel class]]) {
+            [model setWeakProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"weakProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"blockProperty"])) {
+        JAGGeneratedDecodeReflected(converter, model, @"blockProperty", value);
+    }
+    if ((value = [dictionary objectForKey:@"idProperty"])) {
+        [model setIdProperty:JAGGeneratedCompose(converter, value, Nil)];
+    }
+}
+
+#pragma mark - TestModelSubclass
+
+static const JAGGeneratedProperty JAGProperties_TestModelSubclass[] = {
+    { "subclassStringProperty", 0 },
+    { "testModelID", 0 },
+    { "intProperty", 0 },
+    { "stringProperty", 0 },
+    { "modelProperty", 0 },
+    { "arrayProperty", 0 },
+    { "setProperty", 0 },
+    { "dictionaryProperty", 0 },
+    { "dateProperty", 0 },
+    { "boolProperty", 0 },
+    { "cfProperty", 0 },
+    { "urlProperty", 0 },
+    { "readOnlyProperty", 0 },
+    { "active", 0 },
+    { "weakProperty", JAGGeneratedPropertyWeak },
+    { "blockProperty", 0 },
+    { "idProperty", 0 },
+};
+
+static void JAGEncode_TestModelSubclass(JAGPropertyConverter *converter, id object, NSMutableDictionary *values) {
+    TestModelSubclass *model = object;
+    JAGGeneratedEncodeValue(converter, values, @"subclassStringProperty", [model subclassStringProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"testModelID", [model testModelID]);
+    JAGGeneratedEncodeValue(converter, values, @"intProperty", JAGGeneratedBox([model intProperty]));
+    JAGGeneratedEncodeValue(converter, values, @"stringProperty", [model stringProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"modelProperty", [model modelProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"arrayProperty", [model arrayProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"setProperty", [model setProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dictionaryProperty", [model dictionaryProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"dateProperty", [model dateProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"boolProperty", JAGGeneratedBox([model boolProperty]));
+    JAGGeneratedEncodeReflected(converter, values, model, @"cfProperty");
+    JAGGeneratedEncodeValue(converter, values, @"urlProperty", [model urlProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"readOnlyProperty", [model readOnlyProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"active", JAGGeneratedBox([model isActive]));
+    if (JAGGeneratedShouldConvertWeakProperties(converter)) {
+        JAGGeneratedEncodeValue(converter, values, @"weakProperty", [model weakProperty]);
+    }
+    JAGGeneratedEncodeValue(converter, values, @"blockProperty", [model blockProperty]);
+    JAGGeneratedEncodeValue(converter, values, @"idProperty", [model idProperty]);
+}
+
+static void JAGDecode_TestModelSubclass(JAGPropertyConverter *converter, id object, NSDictionary *dictionary) {
+    TestModelSubclass *model = object;
+    id value;
+    if ((value = [dictionary objectForKey:@"subclassStringProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setSubclassStringProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"subclassStringProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"testModelID"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setTestModelID:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"testModelID", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"intProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setIntProperty:JAGGeneratedUnbox([model intProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"intProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"stringProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setStringProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"stringProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"modelProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [TestModel class]);
+        if ([composed isKindOfClass:[TestModel class]]) {
+            [model setModelProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"modelProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"arrayProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSArray class]);
+        if ([composed isKindOfClass:[NSArray class]]) {
+            [model setArrayProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"arrayProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"setProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSSet class]);
+        if ([composed isKindOfClass:[NSSet class]]) {
+            [model setSetProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"setProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dictionaryProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDictionary class]);
+        if ([composed isKindOfClass:[NSDictionary class]]) {
+            [model setDictionaryProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dictionaryProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"dateProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSDate class]);
+        if ([composed isKindOfClass:[NSDate class]]) {
+            [model setDateProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"dateProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"boolProperty"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model setBoolProperty:JAGGeneratedUnbox([model boolProperty], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"boolProperty", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"cfProperty"])) {
+        JAGGeneratedDecodeReflected(converter, model, @"cfProperty", value);
+    }
+    if ((value = [dictionary objectForKey:@"urlProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSURL class]);
+        if ([composed isKindOfClass:[NSURL class]]) {
+            [model setUrlProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"urlProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"readOnlyProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [NSString class]);
+        if ([composed isKindOfClass:[NSString class]]) {
+            [model setReadOnlyProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"readOnlyProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"active"])) {
+        if ([value isKindOfClass:[NSNumber class]]) {
+            [model makeActive:JAGGeneratedUnbox([model isActive], value)];
+        } else {
+            JAGGeneratedDecodeReflected(converter, model, @"active", value);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"weakProperty"])) {
+        id composed = JAGGeneratedCompose(converter, value, [TestModel class]);
+        if ([composed isKindOfClass:[TestModel class]]) {
+            [model setWeakProperty:composed];
+        } else {
+            JAGGeneratedAssign(converter, model, @"weakProperty", composed);
+        }
+    }
+    if ((value = [dictionary objectForKey:@"blockProperty"])) {
+        JAGGeneratedDecodeReflected(converter, model, @"blockProperty", value);
+    }
+    if ((value = [dictionary objectForKey:@"idProperty"])) {
+        [model setIdProperty:JAGGeneratedCompose(converter, value, Nil)];
+    }
+}
+
+#pragma mark - Registration
+
+static const JAGGeneratedCodec JAGCodecs[] = {
+    { "TestModel", JAGProperties_TestModel, 16, JAGEncode_TestModel, JAGDecode_TestModel },
+    { "TestModelSubclass", JAGProperties_TestModelSubclass, 17, JAGEncode_TestModelSubclass, JAGDecode_TestModelSubclass },
+};
+
+__attribute__((constructor)) static void JAGRegisterCodecs(void) {
+    JAGRegisterGeneratedCodecs(JAGCodecs, sizeof(JAGCodecs) / sizeof(JAGCodecs[0]));
+}
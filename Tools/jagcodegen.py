@@ -0,0 +1,405 @@
+#!/usr/bin/env python
+#
+#  jagcodegen.py
+#  JAGPropertyConverter
+#
+# Copyright (c) 2012 James A. Gill
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+"""
+Generate JAGPropertyConverter codecs from the @interface declarations of
+model classes.  See JAGGeneratedCodec.h.
+
+    python Tools/jagcodegen.py -o Models+JAGCodec.m Model.h OtherModel.h [Model.m ...]
+
+Headers (.h) declare the classes to generate codecs for, and are imported by
+the output.  Implementation files (.m) are only read for class extensions and
+categories, whose properties the runtime sees too; since their accessors
+aren't visible to the output, those properties go through the reflective path.
+
+Codecs are generated for every class declared in a header whose superclasses
+are NSObject or also declared in the inputs.  Only the standard library
+is needed, so this runs wherever Python 2.6+ or 3 does.
+"""
+
+import os
+import re
+import sys
+from optparse import OptionParser
+
+NUMERIC_TYPES = set("""
+    char signed_char unsigned_char short unsigned_short short_int int signed unsigned unsigned_int
+    long unsigned_long long_int long_long unsigned_long_long float double BOOL bool _Bool
+    NSInteger NSUInteger CGFloat NSTimeInterval
+    int8_t int16_t int32_t int64_t uint8_t uint16_t uint32_t uint64_t
+""".split())
+
+ROOT_CLASSES = set(["NSObject"])
+
+QUALIFIERS = set("""
+    __weak __strong __unsafe_unretained __autoreleasing __kindof IBOutlet IBInspectable
+    nullable nonnull _Nullable _Nonnull __nullable __nonnull const volatile
+""".split())
+
+
+def strip_comments_and_preprocessor(text):
+    """Remove comments and preprocessor lines, leaving string literals intact."""
+    out = []
+    i, n = 0, len(text)
+    at_line_start = True
+    while i < n:
+        c = text[i]
+        if at_line_start and c == '#':
+            #Skip the directive, including continuation lines.
+            while i < n and text[i] != '\n':
+                if text[i] == '\\' and i + 1 < n and text[i + 1] == '\n':
+                    i += 1
+                i += 1
+            continue
+        if c == '/' and text.startswith('//', i):
+            while i < n and text[i] != '\n':
+                i += 1
+            continue
+        if c == '/' and text.startswith('/*', i):
+            end = text.find('*/', i + 2)
+            i = n if end < 0 else end + 2
+            out.append(' ')
+            continue
+        if c in '"\'':
+            j = i + 1
+            while j < n and text[j] != c:
+                j += 2 if text[j] == '\\' else 1
+            out.append(text[i:j + 1])
+            i = j + 1
+            at_line_start = False
+            continue
+        out.append(c)
+        if c == '\n':
+            at_line_start = True
+        elif not c.isspace():
+            at_line_start = False
+        i += 1
+    return ''.join(out)
+
+
+class Property(object):
+    def __init__(self, name, type_name, stars, is_block, attributes):
+        self.name = name
+        self.type_name = type_name
+        self.stars = stars
+        self.is_block = is_block
+        self.attributes = attributes
+        self.is_public = True
+        self.is_readonly = 'readonly' in attributes
+        self.getter = attributes.get('getter', name)
+        self.setter = attributes.get('setter', 'set%s%s:' % (name[0].upper(), name[1:]))
+
+    @property
+    def kind(self):
+        """'block', 'id', 'object', 'number' or 'other'."""
+        if self.is_block:
+            return 'block'
+        if self.stars == 0 and self.type_name == 'id':
+            return 'id'
+        if self.stars == 1 and re.match(r'^[A-Z_]\w*$', self.type_name):
+            return 'object'
+        if self.stars == 0 and self.type_name in NUMERIC_TYPES:
+            return 'number'
+        return 'other'
+
+    @property
+    def is_weak(self):
+        """Mirrors JAGProperty's isWeak: object properties that don't retain or copy."""
+        if self.kind not in ('id', 'object'):
+            return False
+        attributes = self.attributes
+        if 'weak' in attributes or 'assign' in attributes or 'unsafe_unretained' in attributes:
+            return True
+        #Under ARC, object properties are strong by default.
+        return False
+
+
+class Interface(object):
+    def __init__(self, name, superclass, path):
+        self.name = name
+        self.superclass = superclass
+        self.path = path
+        self.properties = []
+
+
+def parse_attributes(text):
+    attributes = {}
+    for attribute in text.split(','):
+        attribute = attribute.strip()
+        if not attribute:
+            continue
+        if '=' in attribute:
+            key, value = [part.strip() for part in attribute.split('=', 1)]
+            attributes[key] = value
+        else:
+            attributes[attribute] = True
+    return attributes
+
+
+def parse_property(declaration, attributes):
+    """The Properties declared by the text between @property's attributes and ;."""
+    declaration = re.sub(r'<[^<>]*>', '', declaration)
+    block = re.search(r'\(\s*\^\s*(\w+)\s*\)', declaration)
+    if block:
+        return [Property(block.group(1), 'block', 0, True, attributes)]
+    tokens = [token for token in re.findall(r'\w+|\*|,', declaration) if token not in QUALIFIERS]
+    properties = []
+    base = []
+    current = []
+    for token in tokens + [',']:
+        if token != ',':
+            current.append(token)
+            continue
+        words = [t for t in current if t != '*']
+        if not words:
+            current = []
+            continue
+        name = words[-1]
+        if not base:
+            base = words[:-1]
+        stars = current.count('*')
+        type_name = '_'.join(base)
+        properties.append(Property(name, type_name, stars, False, attributes))
+        current = []
+    return properties
+
+
+def parse_file(path):
+    text = strip_comments_and_preprocessor(open(path).read())
+    interfaces = []
+    pattern = re.compile(r'@interface\s+(\w+)\s*(?::\s*(\w+))?\s*(\(\s*\w*\s*\))?(.*?)@end', re.S)
+    for match in pattern.finditer(text):
+        name, superclass, category, body = match.group(1), match.group(2), match.group(3), match.group(4)
+        interface = Interface(name, superclass, path)
+        interface.is_category = category is not None
+        #Drop protocol lists and the ivar block.
+        body = re.sub(r'^\s*<[^>]*>', '', body)
+        body = re.sub(r'^\s*\{.*?\}', '', body, flags=re.S)
+        for attributes_text, declaration in re.findall(r'@property\s*(?:\(([^)]*)\))?\s*([^;]+);', body):
+            interface.properties.extend(parse_property(declaration, parse_attributes(attributes_text or '')))
+        interfaces.append(interface)
+    return interfaces
+
+
+class Model(object):
+    def __init__(self, name, superclass, header):
+        self.name = name
+        self.superclass = superclass
+        self.header = header
+        #Name to Property, merged from the class's declarations.
+        self.own = {}
+        self.order = []
+
+    def declare(self, prop, is_public):
+        existing = self.own.get(prop.name)
+        prop.is_public = is_public
+        if existing is None:
+            self.own[prop.name] = prop
+            self.order.append(prop.name)
+        else:
+            #A redeclaration (readwrite in an extension) changes the runtime property,
+            #but the accessors the output can see are the public ones.
+            existing.is_readonly = existing.is_readonly and prop.is_readonly
+            if not is_public and not prop.is_readonly and existing.is_public and 'readonly' in existing.attributes:
+                existing.setter_is_private = True
+
+
+def collect_models(paths):
+    models = {}
+    extensions = []
+    for path in paths:
+        is_header = path.endswith('.h')
+        for interface in parse_file(path):
+            if interface.is_category:
+                extensions.append((interface, is_header))
+            elif is_header:
+                model = Model(interface.name, interface.superclass, path)
+                for prop in interface.properties:
+                    model.declare(prop, True)
+                models[model.name] = model
+    for interface, is_header in extensions:
+        model = models.get(interface.name)
+        if model is None:
+            continue
+        for prop in interface.properties:
+            model.declare(prop, is_header)
+    return models
+
+
+def all_properties(model, models):
+    """The properties of model and its superclasses, most-derived first, by name."""
+    chain = []
+    current = model
+    while current is not None:
+        chain.append(current)
+        if current.superclass in ROOT_CLASSES:
+            break
+        current = models.get(current.superclass)
+        if current is None:
+            return None
+    seen = set()
+    result = []
+    for m in chain:
+        for name in m.order:
+            if name not in seen:
+                seen.add(name)
+                result.append(m.own[name])
+    return result
+
+
+def send(receiver, selector, argument=None):
+    if argument is None:
+        return '[%s %s]' % (receiver, selector)
+    return '[%s %s%s]' % (receiver, selector, argument)
+
+
+def generate_encode(model, properties):
+    lines = ['static void JAGEncode_%s(JAGPropertyConverter *converter, id object, NSMutableDictionary *values) {' % model.name,
+             '    %s *model = object;' % model.name]
+    for prop in properties:
+        key = '@"%s"' % prop.name
+        kind = prop.kind
+        if not prop.is_public or kind == 'other':
+            statement = 'JAGGeneratedEncodeReflected(converter, values, model, %s);' % key
+        elif kind == 'number':
+            statement = 'JAGGeneratedEncodeValue(converter, values, %s, JAGGeneratedBox(%s));' % (key, send('model', prop.getter))
+        else:
+            statement = 'JAGGeneratedEncodeValue(converter, values, %s, %s);' % (key, send('model', prop.getter))
+        if prop.is_weak:
+            lines.append('    if (JAGGeneratedShouldConvertWeakProperties(converter)) {')
+            lines.append('        ' + statement)
+            lines.append('    }')
+        else:
+            lines.append('    ' + statement)
+    lines.append('}')
+    return lines
+
+
+def generate_decode(model, properties):
+    lines = ['static void JAGDecode_%s(JAGPropertyConverter *converter, id object, NSDictionary *dictionary) {' % model.name,
+             '    %s *model = object;' % model.name,
+             '    id value;']
+    for prop in properties:
+        if prop.is_readonly:
+            continue
+        key = '@"%s"' % prop.name
+        kind = prop.kind
+        lines.append('    if ((value = [dictionary objectForKey:%s])) {' % key)
+        setter = prop.setter
+        if not prop.is_public or getattr(prop, 'setter_is_private', False) or kind in ('other', 'block'):
+            lines.append('        JAGGeneratedDecodeReflected(converter, model, %s, value);' % key)
+        elif kind == 'number':
+            lines.append('        if ([value isKindOfClass:[NSNumber class]]) {')
+            lines.append('            %s;' % send('model', setter, 'JAGGeneratedUnbox(%s, value)' % send('model', prop.getter)))
+            lines.append('        } else {')
+            lines.append('            JAGGeneratedDecodeReflected(converter, model, %s, value);' % key)
+            lines.append('        }')
+        elif kind == 'id':
+            lines.append('        %s;' % send('model', setter, 'JAGGeneratedCompose(converter, value, Nil)'))
+        else:
+            target = '[%s class]' % prop.type_name
+            lines.append('        id composed = JAGGeneratedCompose(converter, value, %s);' % target)
+            lines.append('        if ([composed isKindOfClass:%s]) {' % target)
+            lines.append('            %s;' % send('model', setter, 'composed'))
+            lines.append('        } else {')
+            lines.append('            JAGGeneratedAssign(converter, model, %s, composed);' % key)
+            lines.append('        }')
+        lines.append('    }')
+    lines.append('}')
+    return lines
+
+
+def generate(paths, output_name):
+    models = collect_models(paths)
+    headers = []
+    for path in paths:
+        if path.endswith('.h') and os.path.basename(path) not in headers:
+            headers.append(os.path.basename(path))
+    out = ['//',
+           '//  %s' % output_name,
+           '//',
+           '//  Generated by jagcodegen.py from %s.' % ', '.join(os.path.basename(p) for p in paths),
+           '//  Do not edit; regenerate it when the models change.',
+           '//',
+           '',
+           '#import "JAGGeneratedCodec.h"',
+           '#import "JAGPropertyConverter.h"']
+    out.extend('#import "%s"' % header for header in headers)
+    entries = []
+    for name in sorted(models):
+        model = models[name]
+        properties = all_properties(model, models)
+        if properties is None:
+            sys.stderr.write('jagcodegen: skipping %s; its superclass %s is not in the inputs.\n' % (name, model.superclass))
+            continue
+        out.append('')
+        out.append('#pragma mark - %s' % name)
+        out.append('')
+        out.append('static const JAGGeneratedProperty JAGProperties_%s[] = {' % name)
+        for prop in properties:
+            flags = []
+            if prop.is_readonly:
+                flags.append('JAGGeneratedPropertyReadOnly')
+            if prop.is_weak:
+                flags.append('JAGGeneratedPropertyWeak')
+            out.append('    { "%s", %s },' % (prop.name, ' | '.join(flags) or '0'))
+        out.append('};')
+        out.append('')
+        out.extend(generate_encode(model, properties))
+        out.append('')
+        out.extend(generate_decode(model, properties))
+        entries.append('    { "%s", JAGProperties_%s, %d, JAGEncode_%s, JAGDecode_%s },'
+                       % (name, name, len(properties), name, name))
+    out.append('')
+    out.append('#pragma mark - Registration')
+    out.append('')
+    if entries:
+        out.append('static const JAGGeneratedCodec JAGCodecs[] = {')
+        out.extend(entries)
+        out.append('};')
+        out.append('')
+        out.append('__attribute__((constructor)) static void JAGRegisterCodecs(void) {')
+        out.append('    JAGRegisterGeneratedCodecs(JAGCodecs, sizeof(JAGCodecs) / sizeof(JAGCodecs[0]));')
+        out.append('}')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    parser = OptionParser(usage='%prog [-o OUTPUT] FILE.h [FILE.h|FILE.m ...]')
+    parser.add_option('-o', '--output', help='write to OUTPUT instead of stdout')
+    options, paths = parser.parse_args()
+    if not paths:
+        parser.error('no input files')
+    output_name = os.path.basename(options.output) if options.output else 'JAGCodecs.m'
+    code = generate(paths, output_name)
+    if options.output:
+        open(options.output, 'w').write(code)
+    else:
+        sys.stdout.write(code)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())